@@ -0,0 +1,636 @@
+/*
+ * Tridme UI Benchmark
+ *
+ * Headless frame benchmark. Runs scripted scenes against a GL context
+ * created through EGL (surfaceless, no window or display server needed) or
+ * against the software backend, and prints per-scene results as JSON.
+ *
+ * Usage:
+ *   tridme-ui-bench [--backend gl|soft|none] [--scene name] [--frames n]
+ *                   [--warmup n] [--width w] [--height h] [--out file]
+ *                   [--trace prefix] [--replay log]
+ *
+ * --trace enables the scope profiler and writes <prefix><scene>.json Chrome
+ * traces of the measured frames (profiling adds its own overhead to them).
+ *
+ * --replay drives the scenes with an input log written by ui_record_begin
+ * (see ui_record.h) instead of their scripted input: the measured frames are
+ * the log's frames, at the log's size and delta times, and every scene also
+ * reports its per-frame times in order. The input still drives the bench's
+ * own scenes, not the application it was recorded from, so the times only
+ * match the recorded session as far as its widgets line up with the scene's.
+ * Warmup frames get no input and do not advance the context's time, so the
+ * measured frames run from time 0 with the log's delta times (a session
+ * recorded after startup was at a later time, which animations can show).
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_core.h>
+#include <ui_widgets.h>
+#include <ui_layout.h>
+#include <ui_draw.h>
+#include <ui_font.h>
+#include <ui_backend.h>
+#include <ui_backend_gl.h>
+#include <ui_backend_soft.h>
+#include <ui_profile.h>
+#include <ui_input.h>
+#include <ui_record.h>
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_FRAMES 100000
+
+/*
+ * Allocation counting
+ */
+
+typedef struct {
+  uint64_t allocations;
+  uint64_t bytes;
+} bench_alloc_stats;
+
+static void* counting_alloc(size_t size, void* user) {
+  bench_alloc_stats* stats = (bench_alloc_stats*)user;
+  stats->allocations++;
+  stats->bytes += size;
+  return malloc(size);
+}
+
+static void counting_free(void* ptr, void* user) {
+  (void)user;
+  free(ptr);
+}
+
+/*
+ * Headless GL through EGL
+ */
+
+typedef struct {
+  EGLDisplay display;
+  EGLContext context;
+  unsigned int fbo, color;
+} bench_gl;
+
+static bool gl_init(bench_gl* gl, int width, int height) {
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+    (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+  gl->display = get_platform_display ?
+    get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) :
+    eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  EGLint major, minor;
+  if (gl->display == EGL_NO_DISPLAY || !eglInitialize(gl->display, &major, &minor)) {
+    fprintf(stderr, "Failed to initialize EGL\n");
+    return false;
+  }
+
+  eglBindAPI(EGL_OPENGL_API);
+  const EGLint attribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+
+  // Surfaceless: no config and no surface, rendering goes to our own FBO
+  gl->context = eglCreateContext(gl->display, (EGLConfig)0, EGL_NO_CONTEXT, attribs);
+  if (gl->context == EGL_NO_CONTEXT ||
+      !eglMakeCurrent(gl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, gl->context)) {
+    fprintf(stderr, "Failed to create a surfaceless GL 3.3 context\n");
+    eglTerminate(gl->display);
+    return false;
+  }
+
+  glewExperimental = GL_TRUE;
+  GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  // GLX builds of GLEW can't find a display on EGL-only setups, the GL entry points are loaded anyway
+  if (err == GLEW_ERROR_NO_GLX_DISPLAY) err = GLEW_OK;
+#endif
+  if (err != GLEW_OK) {
+    fprintf(stderr, "Failed to initialize GLEW: %s\n", glewGetErrorString(err));
+    return false;
+  }
+
+  glGenFramebuffers(1, &gl->fbo);
+  glGenRenderbuffers(1, &gl->color);
+  glBindFramebuffer(GL_FRAMEBUFFER, gl->fbo);
+  glBindRenderbuffer(GL_RENDERBUFFER, gl->color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, gl->color);
+  glViewport(0, 0, width, height);
+
+  return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void gl_shutdown(bench_gl* gl) {
+  glDeleteRenderbuffers(1, &gl->color);
+  glDeleteFramebuffers(1, &gl->fbo);
+  eglMakeCurrent(gl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(gl->display, gl->context);
+  eglTerminate(gl->display);
+}
+
+/*
+ * Scenes. Every scene is a pure function of the frame number, so runs are
+ * reproducible across machines and changes.
+ */
+
+typedef struct {
+  char text_inputs[64][256];
+  bool checks[32];
+  float sliders[32];
+} bench_state;
+
+typedef void (*bench_scene_fn)(UIContext* ctx, bench_state* state, int frame);
+typedef void (*bench_input_fn)(UIContext* ctx, int frame);
+
+// Mouse sweeps the window in a fixed pattern and clicks every 8th frame
+static void input_sweep(UIContext* ctx, int frame) {
+  float x = (float)((frame * 37) % ctx->width);
+  float y = (float)((frame * 23) % ctx->height);
+  ui_set_mouse_position(ctx, x, y);
+  ui_set_mouse_button(ctx, 0, frame % 8 == 0);
+}
+
+static void scene_buttons(UIContext* ctx, bench_state* state, int frame) {
+  (void)state;
+  (void)frame;
+
+  // 1000 buttons in a 40 x 25 grid
+  char label[16];
+  float w = ctx->width / 40.0f, h = ctx->height / 25.0f;
+  for (int i = 0; i < 1000; i++) {
+    snprintf(label, sizeof(label), "B%d", i);
+    rect bounds = {{(i % 40) * w + 1, (i / 40) * h + 1}, {w - 2, h - 2}};
+    ui_button(ctx, label, bounds);
+  }
+}
+
+static void scene_text(UIContext* ctx, bench_state* state, int frame) {
+  (void)state;
+
+  static const char words[] = "the quick brown fox jumps over the lazy dog 0123456789 ";
+  char line[101];
+
+  // 10000 characters as 100 lines of 100, scrolling by a pixel per frame
+  rect pane = {{10, 10}, {ctx->width - 20.0f, ctx->height - 20.0f}};
+  ui_draw_rect(ctx, pane, (color){0.08f, 0.08f, 0.1f, 1.0f});
+  ui_push_clip(ctx, pane);
+  for (int l = 0; l < 100; l++) {
+    for (int c = 0; c < 100; c++) {
+      line[c] = words[(l * 7 + c) % (sizeof(words) - 1)];
+    }
+    line[100] = '\0';
+
+    float y = pane.pos.y + 20 + l * (ctx->font_size + 2) - (frame % 200);
+    ui_draw_text(ctx, line, (vec2){pane.pos.x + 4, y}, (color){0.9f, 0.9f, 0.9f, 1.0f});
+  }
+  ui_pop_clip(ctx);
+}
+
+static void scene_vboxes(UIContext* ctx, bench_state* state, int frame) {
+  (void)frame;
+
+  // 6 columns, each a vbox holding 4 nested vboxes of mixed widgets
+  char id[32], label[32];
+  float column_width = ctx->width / 6.0f;
+  VBoxConfig outer = {.spacing = 6, .padding_top = 4, .padding_left = 4, .padding_right = 4,
+                      .clip_overflow = true};
+  VBoxConfig inner = {.spacing = 2, .padding_left = 8};
+
+  for (int c = 0; c < 6; c++) {
+    snprintf(id, sizeof(id), "col%d", c);
+    rect column = {{c * column_width, 0}, {column_width, (float)ctx->height}};
+    ui_vbox_begin_ex(ctx, id, column, &outer);
+
+    for (int n = 0; n < 4; n++) {
+      char inner_id[32];
+      snprintf(inner_id, sizeof(inner_id), "col%d.%d", c, n);
+      rect slot = ui_vbox_next(ctx, id, 150);
+      ui_vbox_begin_ex(ctx, inner_id, slot, &inner);
+
+      int k = c * 4 + n;
+      snprintf(label, sizeof(label), "Group %d", k);
+      ui_label(ctx, label, ui_vbox_next(ctx, inner_id, 20), (color){1, 1, 1, 1});
+      snprintf(label, sizeof(label), "Check %d", k);
+      ui_checkbox(ctx, label, ui_vbox_next(ctx, inner_id, 20), &state->checks[k % 32]);
+      snprintf(label, sizeof(label), "slider%d", k);
+      ui_slider_float(ctx, label, ui_vbox_next(ctx, inner_id, 20), &state->sliders[k % 32], 0, 1);
+      snprintf(label, sizeof(label), "Action %d", k);
+      ui_button(ctx, label, ui_vbox_next(ctx, inner_id, 24));
+
+      ui_vbox_end(ctx, inner_id);
+    }
+
+    ui_vbox_end(ctx, id);
+  }
+}
+
+static void scene_flex(UIContext* ctx, bench_state* state, int frame) {
+  // Toolbar of auto-sized buttons over a 6 x 4 grid of panels, each a column
+  // holding a row of label, slider and button; every 64 frames a label
+  // changes length, the rest of the time the layouts are cached
+  char id[32], label[32];
+  UILayoutDesc root = {.direction = UI_LAYOUT_COLUMN, .gap = 4, .padding = 4};
+  UILayoutDesc toolbar = {.direction = UI_LAYOUT_ROW, .gap = 4, .align = UI_ALIGN_CENTER};
+  UILayoutDesc grid = {.direction = UI_LAYOUT_GRID, .columns = 6, .gap = 6};
+  UILayoutDesc panel = {.direction = UI_LAYOUT_COLUMN, .gap = 2, .padding = 4,
+                        .justify = UI_JUSTIFY_SPACE_BETWEEN, .clip = true};
+  UILayoutDesc line = {.direction = UI_LAYOUT_ROW, .gap = 4, .align = UI_ALIGN_CENTER};
+
+  ui_layout_begin(ctx, "root", (rect){{0, 0}, {(float)ctx->width, (float)ctx->height}}, &root);
+
+  ui_layout_begin(ctx, "toolbar", ui_layout_item(ctx, "toolbar", &(UILayoutItem){0}), &toolbar);
+  for (int i = 0; i < 12; i++) {
+    snprintf(label, sizeof(label), (frame / 64 + i) % 4 ? "Tool %d" : "Longer tool %d", i);
+    snprintf(id, sizeof(id), "tool%d", i);
+    ui_button(ctx, label, ui_layout_item(ctx, id, &(UILayoutItem){.text = label, .shrink = 1}));
+  }
+  ui_layout_end(ctx);
+
+  ui_layout_begin(ctx, "grid", ui_layout_item(ctx, "grid", &(UILayoutItem){.grow = 1}), &grid);
+  for (int p = 0; p < 24; p++) {
+    snprintf(id, sizeof(id), "panel%d", p);
+    ui_layout_begin(ctx, id, ui_layout_item(ctx, id, &(UILayoutItem){.grow = 1}), &panel);
+    for (int n = 0; n < 4; n++) {
+      int k = p * 4 + n;
+      snprintf(id, sizeof(id), "line%d", n);
+      ui_layout_begin(ctx, id, ui_layout_item(ctx, id, &(UILayoutItem){.size = {0, 24}}), &line);
+      snprintf(label, sizeof(label), "Value %d", k);
+      ui_label(ctx, label, ui_layout_item(ctx, "label", &(UILayoutItem){.text = label}),
+        (color){1, 1, 1, 1});
+      snprintf(label, sizeof(label), "flex_slider%d", k);
+      ui_slider_float(ctx, label, ui_layout_item(ctx, "slider", &(UILayoutItem){.grow = 1}),
+        &state->sliders[k % 32], 0, 1);
+      snprintf(label, sizeof(label), "Set %d", k);
+      ui_button(ctx, label, ui_layout_item(ctx, "button", &(UILayoutItem){.text = label}));
+      ui_layout_end(ctx);
+    }
+    ui_layout_end(ctx);
+  }
+  ui_layout_end(ctx);
+
+  ui_layout_end(ctx);
+}
+
+// Click into a different field every 16 frames, then type into it
+static void input_typing(UIContext* ctx, int frame) {
+  float w = ctx->width / 4.0f, h = ctx->height / 16.0f;
+  int focus = (frame / 16) % 64;
+  float fx = (focus % 4) * w + w * 0.5f, fy = (focus / 4) * h + h * 0.5f;
+
+  ui_set_mouse_position(ctx, fx, fy);
+  ui_set_mouse_button(ctx, 0, frame % 16 == 0);
+  for (int i = 0; i < 8; i++) {
+    ui_input_char(ctx, 'a' + (frame + i) % 26);
+  }
+  if (frame % 5 == 0) {
+    ui_set_key(ctx, UI_KEY_BACKSPACE, true);
+  }
+}
+
+static void scene_text_input(UIContext* ctx, bench_state* state, int frame) {
+  float w = ctx->width / 4.0f, h = ctx->height / 16.0f;
+  char id[16];
+  for (int i = 0; i < 64; i++) {
+    snprintf(id, sizeof(id), "input%d", i);
+    rect bounds = {{(i % 4) * w + 4, (i / 4) * h + 4}, {w - 8, h - 8}};
+    ui_text_input(ctx, id, bounds, state->text_inputs[i], sizeof(state->text_inputs[i]));
+  }
+
+  // Keep the buffers from saturating so typing always does work
+  if (frame % 200 == 199) {
+    memset(state->text_inputs, 0, sizeof(state->text_inputs));
+  }
+}
+
+// Input is queued before ui_begin_frame, the way a host feeds it
+typedef struct {
+  const char* name;
+  bench_input_fn input;
+  bench_scene_fn fn;
+} bench_scene;
+
+static const bench_scene scenes[] = {
+  {"buttons_1k", input_sweep, scene_buttons},
+  {"text_10k", input_sweep, scene_text},
+  {"nested_vboxes", input_sweep, scene_vboxes},
+  {"flex_layout", input_sweep, scene_flex},
+  {"text_input", input_typing, scene_text_input},
+};
+
+/*
+ * Measurement
+ */
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static int compare_double(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int count, double p) {
+  int index = (int)(p * (count - 1) + 0.5);
+  return sorted[index];
+}
+
+typedef struct {
+  const char* backend;
+  int width, height;
+  int frames, warmup;
+  const char* trace_prefix;   // Write <prefix><scene>.json Chrome traces when set
+  UIReplay* replay;           // Input log replacing the scenes' scripted input, NULL: none
+} bench_config;
+
+// Returns false, having written nothing, if the scene could not run
+static bool run_scene(FILE* out, const bench_config* config, const bench_scene* scene,
+  UIFont* font, bool first) {
+  bench_alloc_stats alloc_stats = {0};
+  UIAllocator allocator = {counting_alloc, counting_free, &alloc_stats};
+
+  UIRenderBackend* backend = NULL;
+  if (strcmp(config->backend, "gl") == 0) {
+    backend = ui_backend_gl_create(&allocator, NULL);
+  } else if (strcmp(config->backend, "soft") == 0) {
+    backend = ui_backend_soft_create(config->width, config->height, NULL, &allocator);
+  }
+  if (!backend && strcmp(config->backend, "none") != 0) {
+    fprintf(stderr, "Failed to create the %s backend\n", config->backend);
+    return false;
+  }
+
+  UIContextDesc desc = {
+    .width = config->width,
+    .height = config->height,
+    .allocator = &allocator,
+    .font = font,
+    .backend = backend,
+    .headless = backend == NULL,
+    .profile_events = config->trace_prefix ? 1u << 18 : 0
+  };
+  if (config->replay) {
+    // Every event of a recorded frame has to fit in the queue at once
+    uint32_t max_events = ui_replay_info(config->replay).max_frame_events;
+    desc.input_events = max_events > 1024 ? max_events : 1024;
+    ui_replay_rewind(config->replay);
+  }
+  UIContext* ctx = ui_create_context_ex(&desc);
+  if (!ctx) {
+    if (backend) backend->destroy(backend);
+    return false;
+  }
+
+  bench_state* state = (bench_state*)calloc(1, sizeof(bench_state));
+  double* times = (double*)malloc(sizeof(double) * config->frames);
+  if (!state || !times) {
+    fprintf(stderr, "Failed to allocate the %s scene's state\n", scene->name);
+    free(times);
+    free(state);
+    ui_destroy_context(ctx);
+    if (backend) backend->destroy(backend);
+    return false;
+  }
+  UIBackendCounters start = {0}, end = {0};
+  uint64_t vertices = 0, indices = 0, commands = 0;
+  uint64_t glyphs = 0, widgets = 0, culled = 0, state_changes = 0;
+  uint64_t start_allocations = 0;
+
+  for (int frame = 0; frame < config->warmup + config->frames; frame++) {
+    bool measured = frame >= config->warmup;
+    if (frame == config->warmup) {
+      if (backend && backend->get_counters) backend->get_counters(backend->user, &start);
+      start_allocations = alloc_stats.allocations;
+    }
+
+    if (backend == NULL) {
+      // Nothing to clear
+    } else if (strcmp(config->backend, "gl") == 0) {
+      glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT);
+    } else {
+      ui_backend_soft_clear(backend, (color){0.1f, 0.1f, 0.1f, 1.0f});
+    }
+
+    // Warmup frames of a replay get no input and no time, the log starts with
+    // the measured ones
+    float delta_time = 1.0f / 60.0f;
+    double t0 = now_ms();
+    if (!config->replay) {
+      scene->input(ctx, frame);
+    } else if (measured) {
+      ui_replay_frame(config->replay, ctx, &delta_time);
+    } else {
+      delta_time = 0.0f;
+    }
+    ui_begin_frame(ctx, delta_time);
+    scene->fn(ctx, state, frame);
+    ui_end_frame(ctx);
+    double t1 = now_ms();
+
+    // Keep the GPU from queuing frames up, outside of the timed region
+    if (backend && strcmp(config->backend, "gl") == 0) glFinish();
+
+    if (measured) {
+      UIDrawData data = ui_get_draw_data(ctx);
+      times[frame - config->warmup] = t1 - t0;
+      vertices += data.vertex_count;
+      indices += data.index_count;
+      commands += data.command_count;
+
+      UIFrameStats stats = ui_get_frame_stats(ctx);
+      glyphs += stats.glyphs_drawn;
+      widgets += stats.widgets_processed;
+      culled += stats.widgets_culled;
+      state_changes += stats.texture_changes + stats.program_changes + stats.scissor_changes;
+    }
+  }
+
+  if (backend && backend->get_counters) backend->get_counters(backend->user, &end);
+  uint64_t allocations = alloc_stats.allocations - start_allocations;
+
+  double total = 0;
+  for (int i = 0; i < config->frames; i++) total += times[i];
+
+  fprintf(out, "%s    {\n", first ? "" : ",\n");
+  fprintf(out, "      \"name\": \"%s\",\n", scene->name);
+
+  // A replayed session is looked at frame by frame, keep the times in order
+  if (config->replay) {
+    fprintf(out, "      \"frame_times_ms\": [");
+    for (int i = 0; i < config->frames; i++) {
+      fprintf(out, "%s%.4f", i % 10 == 0 ? (i ? ",\n        " : "\n        ") : ", ", times[i]);
+    }
+    fprintf(out, "\n      ],\n");
+  }
+  qsort(times, config->frames, sizeof(double), compare_double);
+
+  // Per-frame averages over the measured frames
+  double n = (double)config->frames;
+  fprintf(out, "      \"frame_ms\": {\"p50\": %.4f, \"p99\": %.4f, \"mean\": %.4f, \"max\": %.4f},\n",
+    percentile(times, config->frames, 0.50), percentile(times, config->frames, 0.99),
+    total / n, times[config->frames - 1]);
+  fprintf(out, "      \"draw_calls\": %.1f,\n", (end.draw_calls - start.draw_calls) / n);
+  fprintf(out, "      \"gl_calls\": %.1f,\n", (end.api_calls - start.api_calls) / n);
+  fprintf(out, "      \"bytes_uploaded\": %.1f,\n", (end.bytes_uploaded - start.bytes_uploaded) / n);
+  fprintf(out, "      \"allocations\": %.2f,\n", allocations / n);
+  fprintf(out, "      \"commands\": %.1f,\n", commands / n);
+  fprintf(out, "      \"vertices\": %.1f,\n", vertices / n);
+  fprintf(out, "      \"indices\": %.1f,\n", indices / n);
+  fprintf(out, "      \"state_changes\": %.1f,\n", state_changes / n);
+  fprintf(out, "      \"glyphs\": %.1f,\n", glyphs / n);
+  fprintf(out, "      \"widgets\": %.1f,\n", widgets / n);
+  fprintf(out, "      \"widgets_culled\": %.1f,\n", culled / n);
+  fprintf(out, "      \"arena_high_water\": %zu\n", ctx->frame_arena.high_water);
+  fprintf(out, "    }");
+
+  if (config->trace_prefix) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s.json", config->trace_prefix, scene->name);
+    ui_profile_write_chrome_trace(ctx, path, config->frames);
+  }
+
+  free(times);
+  free(state);
+  ui_destroy_context(ctx);
+  if (backend) backend->destroy(backend);
+  return true;
+}
+
+static void usage(void) {
+  fprintf(stderr,
+    "usage: tridme-ui-bench [--backend gl|soft|none] [--scene name] [--frames n]\n"
+    "                       [--warmup n] [--width w] [--height h] [--out file]\n"
+    "                       [--trace prefix] [--replay log]\n"
+    "scenes:");
+  for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+    fprintf(stderr, " %s", scenes[i].name);
+  }
+  fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+  bench_config config = {"gl", 1280, 720, 300, 30, NULL, NULL};
+  const char* scene_name = NULL;
+  const char* out_path = NULL;
+  const char* replay_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (!value) {
+      usage();
+      return 1;
+    } else if (strcmp(arg, "--backend") == 0) {
+      config.backend = value;
+    } else if (strcmp(arg, "--scene") == 0) {
+      scene_name = value;
+    } else if (strcmp(arg, "--frames") == 0) {
+      config.frames = atoi(value);
+    } else if (strcmp(arg, "--warmup") == 0) {
+      config.warmup = atoi(value);
+    } else if (strcmp(arg, "--width") == 0) {
+      config.width = atoi(value);
+    } else if (strcmp(arg, "--height") == 0) {
+      config.height = atoi(value);
+    } else if (strcmp(arg, "--out") == 0) {
+      out_path = value;
+    } else if (strcmp(arg, "--trace") == 0) {
+      config.trace_prefix = value;
+    } else if (strcmp(arg, "--replay") == 0) {
+      replay_path = value;
+    } else {
+      usage();
+      return 1;
+    }
+    i++;
+  }
+
+  // The log decides the frames and the size
+  if (replay_path) {
+    config.replay = ui_replay_open(replay_path, NULL);
+    if (!config.replay) return 1;
+
+    UIReplayInfo info = ui_replay_info(config.replay);
+    config.width = info.width;
+    config.height = info.height;
+    config.frames = (int)info.frame_count;
+  }
+
+  if (config.frames <= 0 || config.frames > BENCH_MAX_FRAMES || config.warmup < 0 ||
+      config.width <= 0 || config.height <= 0) {
+    usage();
+    return 1;
+  }
+
+  bench_gl gl = {0};
+  bool use_gl = strcmp(config.backend, "gl") == 0;
+  if (use_gl && !gl_init(&gl, config.width, config.height)) {
+    return 1;
+  }
+
+  // Shared by every scene so font loading stays out of the numbers
+  UIFont* font = ui_font_create(NULL, 16.0f, NULL);
+  if (!font) {
+    if (use_gl) gl_shutdown(&gl);
+    return 1;
+  }
+
+  FILE* out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "Failed to open %s\n", out_path);
+    ui_font_destroy(font);
+    if (use_gl) gl_shutdown(&gl);
+    return 1;
+  }
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"backend\": \"%s\",\n", config.backend);
+  if (use_gl) {
+    fprintf(out, "  \"renderer\": \"%s\",\n", (const char*)glGetString(GL_RENDERER));
+  }
+  fprintf(out, "  \"width\": %d,\n  \"height\": %d,\n", config.width, config.height);
+  fprintf(out, "  \"frames\": %d,\n  \"warmup\": %d,\n", config.frames, config.warmup);
+  if (replay_path) fprintf(out, "  \"replay\": \"%s\",\n", replay_path);
+  fprintf(out, "  \"scenes\": [\n");
+
+  bool ok = true, first = true, found = false;
+  for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+    if (scene_name && strcmp(scene_name, scenes[i].name) != 0) continue;
+    found = true;
+    // A scene that failed wrote nothing, the next one still opens the list
+    if (run_scene(out, &config, &scenes[i], font, first)) {
+      first = false;
+    } else {
+      ok = false;
+    }
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+  if (out != stdout) fclose(out);
+
+  if (!found) {
+    fprintf(stderr, "Unknown scene %s\n", scene_name);
+    usage();
+    ok = false;
+  }
+
+  ui_replay_close(config.replay);
+  ui_font_destroy(font);
+  if (use_gl) gl_shutdown(&gl);
+  return ok ? 0 : 1;
+}
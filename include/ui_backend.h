@@ -0,0 +1,74 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_BACKEND_H
+#define UI_BACKEND_H
+
+#include <ui_core.h>
+#include <ui_draw.h>
+
+typedef enum UITextureFormat {
+  UI_TEXTURE_A8 = 0,      // One byte per pixel, sampled as coverage
+  UI_TEXTURE_RGBA8        // Four bytes per pixel, non-premultiplied
+} UITextureFormat;
+
+/*
+ * Running totals kept by a backend since it was created. Callers diff two
+ * snapshots to get per-frame numbers.
+ */
+typedef struct UIBackendCounters {
+  uint64_t draw_calls;        // Draw submissions (one per non-empty UIDrawCmd)
+  uint64_t api_calls;         // Graphics API entry points called (0 for CPU backends)
+  uint64_t bytes_uploaded;    // Vertex, index and texture bytes sent to the target
+  uint64_t texture_changes;   // Texture binds between draws
+  uint64_t program_changes;   // Shader program / pipeline switches
+  uint64_t scissor_changes;   // Scissor rect updates
+} UIBackendCounters;
+
+// GPU time spent on one earlier frame (see UIDrawData.time_gpu)
+typedef struct UIGpuTiming {
+  uint64_t frame;
+  uint64_t duration_ns;
+} UIGpuTiming;
+
+/*
+ * Render backend interface.
+ *
+ * The core library only produces UIDrawData; a backend owns every graphics
+ * API object (textures, buffers, programs) and turns draw data into pixels.
+ * Texture ids handed out by create_texture are opaque to the library and
+ * come back unchanged in UIDrawCmd.textures.
+ *
+ * All callbacks are invoked on the thread that owns the context using the
+ * backend (see the threading contract in ui_core.h).
+ */
+typedef struct UIRenderBackend {
+  void* user;
+
+  ui_texture_id (*create_texture)(void* user, int width, int height, UITextureFormat format,
+    const void* pixels);
+  void (*destroy_texture)(void* user, ui_texture_id texture);
+
+  // Replace a sub-rectangle of a texture, rows of pixels are stride bytes apart.
+  // pixels is only read during the call; the GPU copy may complete later but
+  // must be ordered before the next render (may be NULL: textures are immutable)
+  void (*update_texture)(void* user, ui_texture_id texture, UITextureFormat format,
+    int x, int y, int width, int height, const void* pixels, int stride);
+
+  // Render one frame into whatever target the backend has bound
+  void (*render)(void* user, const UIDrawData* data);
+
+  // Copy the running counters into out (may be NULL if the backend keeps none)
+  void (*get_counters)(void* user, UIBackendCounters* out);
+
+  // Collect GPU timings that finished since the last call, returns how many
+  // were written to out. Must never wait for the GPU (may be NULL)
+  int (*read_gpu_timings)(void* user, UIGpuTiming* out, int max);
+
+  // Release the backend and everything it owns (may be NULL)
+  void (*destroy)(struct UIRenderBackend* backend);
+} UIRenderBackend;
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_BACKEND_GL_H
+#define UI_BACKEND_GL_H
+
+#include <ui_backend.h>
+
+/*
+ * @brief Create the OpenGL 3.3 core render backend
+ *
+ * Needs a current GL context with a function loader initialized. The backend
+ * draws into the currently bound framebuffer. Destroy it with
+ * backend->destroy(backend) while the GL context is still current.
+ *
+ * @param allocator Allocator for the backend's CPU-side state, or NULL for malloc/free
+ * @param shader_cache_dir Directory for linked program binaries, NULL for the
+ *        per-user default, "" to always compile (see ui_compile_shader_cached)
+ * @return The backend, or NULL on failure
+ */
+UI_API UIRenderBackend* ui_backend_gl_create(const UIAllocator* allocator, const char* shader_cache_dir);
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_BACKEND_SOFT_H
+#define UI_BACKEND_SOFT_H
+
+#include <ui_backend.h>
+#include <ui_jobs.h>
+
+/*
+ * CPU render backend, rasterizes UIDrawData into an RGBA8 buffer without any
+ * GPU. Meant for headless rendering (CI, thumbnails, servers).
+ *
+ * Axis-aligned quads (rects and glyphs, i.e. almost every UI primitive) go
+ * through SSE2 span kernels, anything else through a generic triangle path.
+ * The target is split into horizontal bands of tiles that are rasterized in
+ * parallel through the job system. Sampling and blending follow the GL
+ * backend (bilinear filtering, pixel-center coverage, SRC_ALPHA /
+ * ONE_MINUS_SRC_ALPHA on all four channels).
+ *
+ * Example of usage:
+ *   UIRenderBackend* soft = ui_backend_soft_create(1920, 1080, NULL, NULL);
+ *   UIContextDesc desc = { .width = 1920, .height = 1080, .backend = soft };
+ *   UIContext* ui = ui_create_context_ex(&desc);
+ *   ui_backend_soft_clear(soft, (color){0.1f, 0.1f, 0.1f, 1.0f});
+ *   ... build a frame, ui_end_frame(ui) ...
+ *   const unsigned char* rgba = ui_backend_soft_pixels(soft, NULL, NULL);
+ */
+
+/*
+ * @brief Create the software render backend and its target buffer
+ *
+ * @param width Target width in pixels
+ * @param height Target height in pixels
+ * @param jobs Job system used to rasterize bands in parallel, or NULL for
+ *             single-threaded rendering. Must outlive the backend.
+ * @param allocator Allocator for the target, textures and per-frame data, or NULL
+ * @return The backend, destroy it with backend->destroy(backend)
+ */
+UI_API UIRenderBackend* ui_backend_soft_create(int width, int height, const UIJobSystem* jobs,
+  const UIAllocator* allocator);
+
+/*
+ * @brief Fill the whole target with one color
+ *
+ * @param backend A backend created by ui_backend_soft_create
+ * @param c Clear color
+ * @return void
+ */
+UI_API void ui_backend_soft_clear(UIRenderBackend* backend, color c);
+
+/*
+ * @brief Access the target pixels
+ *
+ * Rows are top to bottom, tightly packed (stride = width * 4), RGBA8.
+ *
+ * @param backend A backend created by ui_backend_soft_create
+ * @param width Receives the target width (may be NULL)
+ * @param height Receives the target height (may be NULL)
+ * @return Pointer to the pixels, owned by the backend
+ */
+UI_API const unsigned char* ui_backend_soft_pixels(UIRenderBackend* backend, int* width, int* height);
+
+#endif
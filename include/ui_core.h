@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <ui_memory.h>
 
 #ifdef _WIN32  
   #define UI_API __declspec(dllexport)
@@ -21,6 +22,9 @@ typedef struct { float x, y; } vec2;
 typedef struct { float r, g, b, a; } color;
 typedef struct { vec2 pos; vec2 size; } rect;
 
+// Backend texture handle, opaque to the library (see ui_backend.h)
+typedef uintptr_t ui_texture_id;
+
 
 // Font glyph info (internal use)
 typedef struct {
@@ -30,43 +34,154 @@ typedef struct {
   float offset_x, offset_y;
 } ui_glyph_info;
 
-// UI Context
-typedef struct {
+struct UIFont;
+struct VBoxState;
+struct UIDrawList;
+struct UIRenderBackend;
+struct UIProfiler;
+struct UIInputQueue;
+struct UIInputEvent;
+struct UIRecorder;
+struct UIHitRect;
+struct UIHitIndex;
+struct UIUploadQueue;
+struct UIImageAtlas;
+struct UILayoutCache;
+
+#define UI_MAX_VBOXES 32
+#define UI_MAX_REGIONS 16
+
+/*
+ * Counters for one frame, read with ui_get_frame_stats.
+ *
+ * Collecting them costs a few integer adds per widget and glyph plus six
+ * clock reads per frame. Define UI_DISABLE_STATS when building the library
+ * to compile all of it out (ui_get_frame_stats then returns zeros).
+ */
+typedef struct UIFrameStats {
+  // Geometry submitted (regions included)
+  uint32_t commands;
+  uint32_t vertices;
+  uint32_t indices;
+
+  // Backend work, zero when the backend keeps no counters
+  uint32_t draw_calls;
+  uint32_t api_calls;
+  uint32_t texture_changes;
+  uint32_t program_changes;
+  uint32_t scissor_changes;
+  uint64_t bytes_uploaded;
+  uint32_t uploads_deferred;  // Dirty texture rects the upload budget left for later frames
+
+  // Text
+  uint32_t glyphs_drawn;
+  uint32_t glyph_misses;      // Characters with no glyph in the atlas (skipped)
+
+  // Widgets
+  uint32_t widgets_processed; // Every widget call, culled ones included
+  uint32_t widgets_culled;    // Outside the clip rect: input handled, nothing drawn
+
+  // Input
+  uint32_t input_events;      // Events drained by ui_begin_frame
+  uint32_t input_dropped;     // Events lost to a full input queue since the last frame
+
+  // Frame arena
+  size_t arena_used;
+  size_t arena_high_water;
+
+  // CPU time in milliseconds
+  double begin_frame_ms;      // Inside ui_begin_frame
+  double widgets_ms;          // Between ui_begin_frame and ui_end_frame
+  double end_frame_ms;        // Inside ui_end_frame, region merge and submission included
+} UIFrameStats;
+
+#ifndef UI_DISABLE_STATS
+  #define UI_STAT_ADD(ctx, field, n) ((ctx)->frame_stats.field += (n))
+#else
+  #define UI_STAT_ADD(ctx, field, n) ((void)0)
+#endif
+
+/*
+ * UI Context
+ *
+ * Threading contract:
+ *   - The library keeps no mutable global state. Everything a frame touches
+ *     lives in the UIContext, so independent contexts can be used from
+ *     different threads at the same time without locking.
+ *   - A single context is not thread-safe. All calls for one context must be
+ *     made by one thread at a time. With the GL backend, its OpenGL context
+ *     must be current on that thread for context creation, ui_end_frame and
+ *     destruction; widget code itself never touches the GPU.
+ *   - A UIFont is immutable after creation and may be shared by contexts on
+ *     any thread (see ui_font.h). It must outlive every context using it.
+ */
+typedef struct UIContext {
   // Window dimensions
   int width, height;
   
-  // Input state
+  // Input state after this frame's events
   vec2 mouse_pos;
   bool mouse_buttons[3];
   bool prev_mouse_buttons[3];
   float scroll_offset;
   
-  // Keyboard input
-  char input_chars[32];
-  int input_char_count;
-  bool key_backspace;
-  bool key_delete;
-  bool key_left;
-  bool key_right;
+  // Input events (see ui_input.h)
+  struct UIInputQueue* input_queue;   // Fed by ui_set_* and ui_input_char, NULL on regions
+  const struct UIInputEvent* events;  // This frame's events, in order (frame arena)
+  int event_count;
+  struct UIRecorder* recorder;        // Input log being written, NULL unless recording (see ui_record.h)
   
   // Render state
-  unsigned int shader;
-  unsigned int vao, vbo, ebo;
-  unsigned int texture_atlas;
-  unsigned int white_texture;
+  struct UIRenderBackend* backend; // NULL for record-only contexts
+  bool owns_backend;
+  ui_texture_id texture_atlas;     // Font atlas, also used for solid rects
+  vec2 white_uv;                   // Fully covered texel of texture_atlas
   
   // Font data
-  ui_glyph_info glyphs[128];
+  const struct UIFont* font; // Shared, read-only
+  bool owns_font;            // Font was loaded by this context and is destroyed with it
+  bool atlas_pending;        // texture_atlas is a placeholder until the font is ready
+  struct UIUploadQueue* uploads;   // Textures with dirty rects to upload, NULL until one is tracked
+  size_t upload_budget;             // Bytes per frame for non-urgent texture uploads
+  struct UIImageAtlas* images;     // Runtime image pages, NULL until an image is created
   float font_size;
   
   // Widget state
   uint32_t hot_widget;
   uint32_t active_widget;
   uint32_t focused_widget;
+  uint32_t frame_focused_widget; // focused_widget at ui_begin_frame
+  int focus_event;               // Event of the press that last moved focus this frame, -1: none
   
   // Layout stack
   vec2 layout_stack[32];
   int layout_stack_size;
+  struct VBoxState* vboxes; // UI_MAX_VBOXES slots, see ui_layout.h
+  struct UILayoutCache* layout_cache; // Flex/grid layout nodes, NULL until a layout begins
+
+  // Clip stack (see ui_draw.h)
+  rect clip_stack[32];
+  int clip_stack_size;
+
+  // Hit testing (see ui_hit.h)
+  struct UIHitRect* hit_rects;     // Interactive rects recorded this frame, z-order (frame arena)
+  int hit_count, hit_capacity;
+  struct UIHitIndex* hit_index;    // Last frame's rects, shared read-only with regions
+  uint32_t hover_id;               // Topmost widget under the mouse, 0: none
+
+  // Geometry recorded this frame, rendered in ui_end_frame
+  struct UIDrawList* draw_list;
+
+  // Regions recorded this frame, merged in ui_end_frame (see ui_region.h)
+  struct UIContext* regions[UI_MAX_REGIONS];
+  int region_count;
+
+  // Set on region contexts only
+  struct UIContext* parent;
+  int region_insert_at;     // Parent command index the region is drawn before
+  int region_hit_insert_at; // Parent hit rect index the region's rects go before
+  uint32_t region_start_ids[3]; // hot/active/focused when the region began
+  bool region_open;
   
   // Time
   float time;
@@ -75,17 +190,52 @@ typedef struct {
   // State
   vec2  last_pos;
   float margin;
+
+  // Memory
+  UIAllocator allocator;  // Host allocator, used for everything the context owns
+  UIArena frame_arena;    // Per-frame transient data, rewound in ui_begin_frame
+
+  // Statistics
+  UIFrameStats frame_stats; // Being collected for the current frame
+  UIFrameStats last_stats;  // Last finished frame
+  double stats_mark;        // Time ui_begin_frame returned, in milliseconds
+
+  // Profiling (see ui_profile.h), NULL when disabled
+  struct UIProfiler* profiler;
+  uint64_t frame_index;     // Incremented by ui_begin_frame
 } UIContext;
 
+// Context creation parameters, zero-initialize and fill what you need
+typedef struct UIContextDesc {
+  int width, height;
+  const UIAllocator* allocator; // NULL: malloc/free
+  size_t frame_arena_size;      // Size of each frame arena block (default: 64 KiB)
+  bool frame_arena_fixed;       // Fail allocations instead of chaining blocks when full
+  const struct UIFont* font;    // Shared font, NULL: the context loads the default font
+  struct UIRenderBackend* backend; // Host backend (not owned), NULL: OpenGL 3.3 backend
+  bool headless;                // With no backend: record only, read ui_get_draw_data.
+                                // Commands then use (ui_texture_id)font for the font atlas
+  uint32_t profile_events;      // Scope events kept per thread, 0: profiler off (see ui_profile.h)
+  uint32_t input_events;        // Input events buffered between frames (default: 1024)
+  const char* shader_cache_dir; // GL program binary cache, NULL: per-user default, "": off
+  size_t upload_budget;         // Texture bytes uploaded per frame, urgent ones aside (default: 1 MiB)
+} UIContextDesc;
+
 // Function prototypes
 UI_API UIContext* ui_create_context(int width, int height);
+UI_API UIContext* ui_create_context_ex(const UIContextDesc* desc);
 UI_API void ui_destroy_context(UIContext* ctx);
 
+// CPU-side context state without GPU resources (internal use)
+UI_API bool ui_context_init_state(UIContext* ctx, const UIAllocator* allocator,
+  size_t frame_arena_size, bool frame_arena_growth);
+UI_API void ui_context_release_state(UIContext* ctx);
+
 // Frame Management
 UI_API void ui_begin_frame(UIContext* ctx, float delta_time);
 UI_API void ui_end_frame(UIContext* ctx);
 
-// Input Handling
+// Input Handling, events are queued and applied by the next ui_begin_frame (see ui_input.h)
 UI_API void ui_set_mouse_position(UIContext* ctx, float x, float y);
 UI_API void ui_set_mouse_button(UIContext* ctx, int button, bool pressed);
 UI_API void ui_set_key(UIContext* ctx, int key, bool pressed);
@@ -95,11 +245,41 @@ UI_API void ui_input_char(UIContext* ctx, unsigned int codepoint);
 // Drawing
 UI_API void ui_draw_rect(UIContext* ctx, rect r, color c);
 UI_API void ui_draw_text(UIContext* ctx, const char* text, vec2 position, color c);
+
+/*
+ * @brief Draw at most `length` bytes of text that need not be NUL-terminated
+ *
+ * @param ctx The UI context
+ * @param text The text, drawing also stops at a NUL byte
+ * @param length Number of bytes to draw
+ * @param position Baseline start, as for ui_draw_text
+ * @param c Text color
+ * @return void
+ */
+UI_API void ui_draw_text_n(UIContext* ctx, const char* text, size_t length, vec2 position, color c);
 UI_API float ui_measure_text(UIContext* ctx, const char* text);
 
 // State 
 UI_API bool ui_is_hovered(UIContext* ctx, rect r);
 UI_API bool ui_is_clicked(UIContext* ctx, rect r, int button);
+
+/*
+ * @brief Count this frame's presses of a mouse button inside an area
+ *
+ * @param ctx The UI context
+ * @param r Area to test, with the mouse position at the time of each press
+ * @param button Mouse button (0 left, 1 right, 2 middle)
+ * @return Number of presses, can exceed one when frames are slow
+ */
+UI_API int ui_click_count(UIContext* ctx, rect r, int button);
 UI_API vec2 ui_get_mouse_position(UIContext* ctx);
 
+/*
+ * @brief Get the counters of the last finished frame
+ *
+ * @param ctx The UI context
+ * @return The counters filled in by the last ui_end_frame
+ */
+UI_API UIFrameStats ui_get_frame_stats(UIContext* ctx);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_DECODE_H
+#define UI_DECODE_H
+
+#include <ui_memory.h>
+#include <stddef.h>
+
+/*
+ * Image file decoding into RGBA8: non-premultiplied, rows tightly packed,
+ * top row first. Safe to call from any thread.
+ *
+ * PNG: every color type, bit depths 1 to 16 (16-bit samples keep their high
+ * byte), tRNS transparency, non-interlaced only. The zlib stream is inflated
+ * by FreeType, which must be built with zlib (the default).
+ * TGA: true-color, grayscale and color-mapped, raw or RLE, either origin.
+ *
+ * Images larger than UI_DECODE_MAX_SIZE on a side are rejected.
+ */
+
+#define UI_DECODE_MAX_SIZE 16384
+
+/*
+ * @brief Decode a PNG or TGA file held in memory, picked by its content
+ *
+ * @param data The file
+ * @param size Size of the file
+ * @param allocator Allocator for the pixels, or NULL for malloc/free
+ * @param width Receives the width
+ * @param height Receives the height
+ * @return The pixels (free with the allocator), or NULL if the file cannot be decoded
+ */
+UI_API unsigned char* ui_decode_image(const void* data, size_t size, const UIAllocator* allocator,
+  int* width, int* height);
+
+/*
+ * @brief Decode a PNG file held in memory
+ *
+ * @param data The file
+ * @param size Size of the file
+ * @param allocator Allocator for the pixels, or NULL for malloc/free
+ * @param width Receives the width
+ * @param height Receives the height
+ * @return The pixels (free with the allocator), or NULL on failure
+ */
+UI_API unsigned char* ui_decode_png(const void* data, size_t size, const UIAllocator* allocator,
+  int* width, int* height);
+
+/*
+ * @brief Decode a TGA file held in memory
+ *
+ * @param data The file
+ * @param size Size of the file
+ * @param allocator Allocator for the pixels, or NULL for malloc/free
+ * @param width Receives the width
+ * @param height Receives the height
+ * @return The pixels (free with the allocator), or NULL on failure
+ */
+UI_API unsigned char* ui_decode_tga(const void* data, size_t size, const UIAllocator* allocator,
+  int* width, int* height);
+
+#endif
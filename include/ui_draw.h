@@ -0,0 +1,143 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_DRAW_H
+#define UI_DRAW_H
+
+#include <ui_core.h>
+
+#define UI_DRAW_MAX_TEXTURES 8   // Textures one command samples, bound to units 0..7
+
+// Vertex structure for UI rendering
+typedef struct {
+  vec2 position;
+  vec2 texcoord;
+  color col;
+  uint32_t slot;          // Texture and pipeline, see UI_VERTEX_SLOT (set by ui_draw_list_add_quad)
+} ui_vertex;
+
+// How a texture is combined with the vertex color
+typedef enum UIPipeline {
+  UI_PIPELINE_ALPHA = 0,  // Texture red channel is coverage: out = vertex color * (1, 1, 1, r)
+  UI_PIPELINE_RGBA        // Texture is color: out = vertex color * texel
+} UIPipeline;
+
+// A vertex samples textures[index] of its command, combined with pipeline
+#define UI_VERTEX_SLOT(index, pipeline) (((uint32_t)(index) << 1) | (uint32_t)(pipeline))
+#define UI_VERTEX_TEXTURE(slot)  ((int)((slot) >> 1))
+#define UI_VERTEX_PIPELINE(slot) ((UIPipeline)((slot) & 1))
+
+/*
+ * One draw call: a range of the list's index buffer drawn with one clip
+ * rectangle (window pixels, top-left origin). Each vertex picks one of the
+ * command's textures through its slot, so content from up to
+ * UI_DRAW_MAX_TEXTURES textures (font atlas, image pages, user textures)
+ * shares a draw; a command only ends when the clip changes or a texture
+ * would not fit.
+ */
+typedef struct UIDrawCmd {
+  rect clip;
+  ui_texture_id textures[UI_DRAW_MAX_TEXTURES];
+  int texture_count;
+  uint32_t index_offset;
+  uint32_t index_count;
+} UIDrawCmd;
+
+/*
+ * Per-context list of everything drawn this frame. All arrays live in the
+ * owning context's frame arena and are rebuilt every frame; rendering happens
+ * once in ui_end_frame.
+ */
+typedef struct UIDrawList {
+  ui_vertex* vertices;
+  uint32_t vertex_count;
+  uint32_t vertex_capacity;
+
+  uint32_t* indices;
+  uint32_t index_count;
+  uint32_t index_capacity;
+
+  UIDrawCmd* commands;
+  int command_count;
+  int command_capacity;
+
+  bool split;             // Next primitive must start a new command
+} UIDrawList;
+
+/*
+ * Everything needed to render one frame, independent of any graphics API.
+ * Triangles are indexed (32-bit) and drawn in command order with standard
+ * "source alpha, one minus source alpha" blending. Coordinates are window
+ * pixels with a top-left origin.
+ *
+ * Returned by ui_get_draw_data, it stays valid until the next ui_begin_frame
+ * on the same context.
+ */
+typedef struct UIDrawData {
+  vec2 display_size;
+  const ui_vertex* vertices;
+  uint32_t vertex_count;
+  const uint32_t* indices;
+  uint32_t index_count;
+  const UIDrawCmd* commands;
+  int command_count;
+
+  uint64_t frame;         // Frame index of the producing context
+  bool time_gpu;          // Profiling is on: measure this frame's GPU time if possible
+} UIDrawData;
+
+/*
+ * @brief Get the geometry recorded for the last finished frame
+ *
+ * Call after ui_end_frame to submit the UI through your own renderer, or to
+ * keep it for later (copy it, the memory belongs to the frame arena).
+ *
+ * @param ctx The UI context
+ * @return The frame's draw data
+ */
+UI_API UIDrawData ui_get_draw_data(UIContext* ctx);
+
+/*
+ * @brief Push a clip rectangle, intersected with the current one
+ *
+ * Everything drawn until the matching ui_pop_clip is clipped to the
+ * rectangle. The stack holds up to 32 entries.
+ *
+ * @param ctx The UI context
+ * @param r The clip rectangle in window pixels
+ * @return void
+ */
+UI_API void ui_push_clip(UIContext* ctx, rect r);
+
+/*
+ * @brief Pop the most recent clip rectangle
+ *
+ * @param ctx The UI context
+ * @return void
+ */
+UI_API void ui_pop_clip(UIContext* ctx);
+
+/*
+ * @brief Get the clip rectangle currently in effect
+ *
+ * @param ctx The UI context
+ * @return The top of the clip stack, or the whole window when it is empty
+ */
+UI_API rect ui_current_clip(UIContext* ctx);
+
+// Draw list helpers (internal use)
+UI_API void ui_draw_list_reset(UIDrawList* list, UIArena* arena);
+UI_API bool ui_draw_list_reserve(UIDrawList* list, UIArena* arena, uint32_t vertex_count,
+  uint32_t index_count);
+UI_API bool ui_draw_list_push_command(UIDrawList* list, UIArena* arena, const UIDrawCmd* cmd);
+UI_API bool ui_draw_list_append(UIDrawList* dst, UIArena* arena, const UIDrawList* src);
+UI_API void ui_draw_list_add_quad(UIContext* ctx, ui_texture_id texture, UIPipeline pipeline,
+  const ui_vertex quad[4]);
+// Append a triangle strip of count vertices, returned for the caller to fill
+// all but their slot (NULL on failure)
+UI_API ui_vertex* ui_draw_list_add_strip(UIContext* ctx, ui_texture_id texture, UIPipeline pipeline,
+  uint32_t count);
+
+#endif
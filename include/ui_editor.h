@@ -0,0 +1,179 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_EDITOR_H
+#define UI_EDITOR_H
+
+#include <ui_core.h>
+
+/*
+ * Multi-line text editor.
+ *
+ * The text lives in a gap buffer, so typing at the caret moves no more than
+ * the gap. Line starts are kept in a second gap buffer placed at the caret
+ * line: starts before it are absolute offsets, starts after it are distances
+ * from the end of the text, so inserting or deleting never rewrites the lines
+ * below. Finding the line of an offset is a binary search.
+ *
+ * Horizontal positions come from per-line prefix sums of glyph advances,
+ * cached for the lines that were drawn or clicked and dropped on every edit.
+ * Click-to-caret and up/down movement are a binary search in them, and only
+ * the visible part of the visible lines is laid out and drawn, so the cost
+ * of a keystroke or a frame does not depend on the size of the document.
+ *
+ * Text is UTF-8 bytes, printable ASCII is typed, tabs advance four spaces.
+ *
+ * Example of usage:
+ *   UITextEditor* editor = ui_editor_create(NULL);
+ *   ui_editor_set_text(editor, source, source_length);
+ *   ...
+ *   if (ui_text_editor(ui, "script", (rect){{10, 10}, {600, 400}}, editor)) {
+ *     ... text changed ...
+ *   }
+ */
+
+#define UI_EDITOR_LINE_CACHE 64
+#define UI_EDITOR_TAB_SPACES 4
+
+// Prefix sums of one line's advances, prefix[i] is the x of byte i
+typedef struct UIEditorLine {
+  int line;               // -1: unused
+  uint32_t revision;
+  float* prefix;          // count + 1 entries
+  uint32_t count, capacity;
+} UIEditorLine;
+
+typedef struct UITextEditor {
+  UIAllocator allocator;
+
+  // Text is buffer[0, gap_start) followed by buffer[gap_end, capacity)
+  char* buffer;
+  size_t capacity, gap_start, gap_end;
+
+  // Line starts: absolute before the gap, distance from the end after it
+  size_t* lines;
+  int line_capacity, line_gap_start, line_gap_end;
+
+  // Selection is [min(caret, anchor), max(caret, anchor))
+  size_t caret, anchor;
+  float preferred_x;      // Kept while moving up and down
+  vec2 scroll;
+  bool dragging;
+
+  // Layout cache, direct mapped by line number
+  uint32_t revision;      // Bumped by every edit
+  const struct UIFont* font;
+  bool font_ready;        // Layout was measured with the final glyphs
+  UIEditorLine cache[UI_EDITOR_LINE_CACHE];
+} UITextEditor;
+
+/*
+ * @brief Create an empty editor
+ *
+ * @param allocator Allocator for the editor, or NULL for malloc/free
+ * @return The editor, or NULL on failure
+ */
+UI_API UITextEditor* ui_editor_create(const UIAllocator* allocator);
+
+/*
+ * @brief Destroy an editor
+ *
+ * @param editor The editor (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_editor_destroy(UITextEditor* editor);
+
+/*
+ * @brief Replace the whole text, the caret goes to the start
+ *
+ * @param editor The editor
+ * @param text The text (need not be NUL-terminated)
+ * @param length Length of text in bytes
+ * @return false if memory ran out, the text is then unchanged
+ */
+UI_API bool ui_editor_set_text(UITextEditor* editor, const char* text, size_t length);
+
+/*
+ * @brief Insert text, moving the caret and anchor if they are at or after pos
+ *
+ * @param editor The editor
+ * @param pos Byte offset, clamped to the length
+ * @param text The text to insert
+ * @param length Length of text in bytes
+ * @return false if memory ran out
+ */
+UI_API bool ui_editor_insert(UITextEditor* editor, size_t pos, const char* text, size_t length);
+
+/*
+ * @brief Delete the bytes in [start, end)
+ *
+ * @param editor The editor
+ * @param start First byte to delete
+ * @param end One past the last byte, clamped to the length
+ * @return void
+ */
+UI_API void ui_editor_delete(UITextEditor* editor, size_t start, size_t end);
+
+/*
+ * @brief Length of the text in bytes
+ *
+ * @param editor The editor
+ * @return The length
+ */
+UI_API size_t ui_editor_length(const UITextEditor* editor);
+
+/*
+ * @brief Number of lines, an empty text has one
+ *
+ * @param editor The editor
+ * @return The line count
+ */
+UI_API int ui_editor_line_count(const UITextEditor* editor);
+
+/*
+ * @brief Byte offset where a line starts
+ *
+ * @param editor The editor
+ * @param line Line number, clamped to the valid range
+ * @return The offset
+ */
+UI_API size_t ui_editor_line_start(const UITextEditor* editor, int line);
+
+/*
+ * @brief Line holding a byte offset
+ *
+ * @param editor The editor
+ * @param pos Byte offset
+ * @return The line number
+ */
+UI_API int ui_editor_line_of(const UITextEditor* editor, size_t pos);
+
+/*
+ * @brief Copy text out of the editor
+ *
+ * @param editor The editor
+ * @param start First byte to copy
+ * @param out Destination, always NUL-terminated when out_size > 0
+ * @param out_size Size of out
+ * @return Number of bytes copied, without the terminator
+ */
+UI_API size_t ui_editor_copy(const UITextEditor* editor, size_t start, char* out, size_t out_size);
+
+/*
+ * @brief Render an editor and handle its input
+ *
+ * Click to focus and place the caret, drag or shift+arrows to select.
+ * Arrows, Home/End, Page Up/Down, Backspace/Delete, Enter and Tab edit;
+ * the mouse wheel scrolls.
+ *
+ * @param ctx The UI context
+ * @param id Unique id for focus tracking
+ * @param bounds The editor area
+ * @param editor The editor state, owned by the caller
+ * @return true if the text changed this frame
+ */
+UI_API bool ui_text_editor(UIContext* ctx, const char* id, rect bounds, UITextEditor* editor);
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_FONT_H
+#define UI_FONT_H
+
+#include <ui_core.h>
+
+/*
+ * A rasterized font: glyph metrics plus an A8 coverage atlas in CPU memory.
+ *
+ * Glyphs are rasterized in the background. ui_font_create_async returns as
+ * soon as the font file is loaded; worker threads, each with its own FreeType
+ * instance, rasterize disjoint slices of the requested codepoints, and the
+ * last one to finish packs them into the atlas and marks the font ready.
+ * Until then contexts draw a box per character with placeholder_advance
+ * and upload the atlas on the first ui_begin_frame after it is ready, so the
+ * first frame does not wait for the glyph set however large it is.
+ *
+ * Once ready a font is immutable, so a single font can be shared by any
+ * number of contexts on any number of threads. Every context uploads its own
+ * GPU copy of the atlas. Before then only the fields marked below are valid;
+ * go through ui_font_ready, ui_font_glyph and ui_font_advance.
+ */
+
+#define UI_FONT_MAX_THREADS 16
+
+// Inclusive range of codepoints to rasterize
+typedef struct UIFontRange {
+  uint32_t first, last;
+} UIFontRange;
+
+typedef struct UIFontDesc {
+  const char* path;             // Font file FreeType can read, NULL: the bundled font
+  float pixel_size;
+  const UIFontRange* ranges;    // NULL: printable ASCII
+  int range_count;
+  int threads;                  // Rasterizer threads, 0: one per core
+  const UIAllocator* allocator; // Thread-safe, the workers allocate from it. NULL: malloc/free
+} UIFontDesc;
+
+typedef struct UIFont {
+  float size;                   // Pixel size the glyphs were rasterized at (always valid)
+  float placeholder_advance;    // Width of a character until ready (always valid)
+  int atlas_width;
+  int atlas_height;
+  unsigned char* atlas_pixels;  // atlas_width * atlas_height coverage values
+  ui_glyph_info glyphs[128];    // ASCII glyphs, UVs are normalized to the atlas
+  uint32_t* codepoints;         // Glyphs past ASCII, sorted for binary search
+  ui_glyph_info* extra_glyphs;
+  int extra_count;
+  vec2 white_uv;                // UV of a fully covered texel, used for solid rects
+  UIAllocator allocator;
+  struct UIFontBuild* build;    // Rasterization state, threads are joined on destroy
+} UIFont;
+
+/*
+ * @brief Load a font file and rasterize its ASCII glyphs, waiting for the atlas
+ *
+ * @param path Path to a font file FreeType can read, or NULL to search the
+ *             default locations of the bundled font
+ * @param pixel_size Pixel size to rasterize at
+ * @param allocator Allocator for the font and its atlas, or NULL for malloc/free
+ * @return The font, or NULL if it could not be loaded
+ */
+UI_API UIFont* ui_font_create(const char* path, float pixel_size, const UIAllocator* allocator);
+
+/*
+ * @brief Load a font file and rasterize its glyphs on worker threads
+ *
+ * @param desc Font file, size, codepoint ranges and thread count
+ * @return The font, not ready yet, or NULL if the file could not be loaded
+ */
+UI_API UIFont* ui_font_create_async(const UIFontDesc* desc);
+
+/*
+ * @brief Check whether the atlas and glyph metrics are complete
+ *
+ * @param font The font
+ * @return true once every glyph is rasterized and packed
+ */
+UI_API bool ui_font_ready(const UIFont* font);
+
+/*
+ * @brief Block until the font is ready
+ *
+ * @param font The font
+ * @return void
+ */
+UI_API void ui_font_wait(const UIFont* font);
+
+/*
+ * @brief Look up a glyph
+ *
+ * @param font The font
+ * @param codepoint Unicode codepoint
+ * @return The glyph, or NULL if the font is not ready or has no such glyph
+ */
+UI_API const ui_glyph_info* ui_font_glyph(const UIFont* font, uint32_t codepoint);
+
+/*
+ * @brief Horizontal advance of a character, placeholder_advance until ready
+ *
+ * @param font The font
+ * @param codepoint Unicode codepoint
+ * @return The advance in pixels, 0 for control characters and missing glyphs
+ */
+UI_API float ui_font_advance(const UIFont* font, uint32_t codepoint);
+
+/*
+ * @brief Decode one UTF-8 character
+ *
+ * Malformed input decodes as U+FFFD one byte at a time.
+ *
+ * @param text The text
+ * @param length Bytes available, at least 1
+ * @param codepoint Receives the codepoint
+ * @return Bytes consumed
+ */
+UI_API int ui_utf8_decode(const char* text, size_t length, uint32_t* codepoint);
+
+/*
+ * @brief Encode one codepoint as UTF-8
+ *
+ * @param codepoint Unicode codepoint
+ * @param out Receives up to 4 bytes, not NUL-terminated
+ * @return Bytes written, 0 for surrogates and values past U+10FFFF
+ */
+UI_API int ui_utf8_encode(uint32_t codepoint, char* out);
+
+/*
+ * @brief Destroy a font created with ui_font_create or ui_font_create_async
+ *
+ * Stops rasterization that is still running. No context that references
+ * the font may be alive.
+ *
+ * @param font The font to destroy (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_font_destroy(UIFont* font);
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_HIT_H
+#define UI_HIT_H
+
+#include <ui_core.h>
+
+/*
+ * Hit testing.
+ *
+ * Interactive widgets and panels register the part of their rect that
+ * survives the current clip, in the order they are recorded, which is their
+ * z-order. ui_end_frame bins the rects into a uniform grid, and the next
+ * frame resolves every hover and click against that grid: only the topmost
+ * rect under the point reacts, so a panel or popup recorded over other
+ * widgets stops clicks from reaching them. Lookups visit one cell, O(1) on
+ * average however many widgets there are.
+ *
+ * A point nobody registered last frame (first frame, widgets that just
+ * appeared) falls back to the plain rect test. ui_is_hovered and
+ * ui_is_clicked stay plain rect tests; custom widgets that want topmost
+ * resolution use ui_widget_hovered and ui_widget_click_count with an id.
+ */
+
+#define UI_HIT_CELL_SIZE 32.0f
+
+typedef struct UIHitRect {
+  rect r;
+  uint32_t id;
+} UIHitRect;
+
+// Last frame's rects binned into a grid, cells list rects in ascending z-order
+typedef struct UIHitIndex {
+  UIAllocator allocator;
+  UIHitRect* rects;
+  uint32_t rect_count, rect_capacity;
+  uint32_t* cell_start;     // cols * rows + 1 offsets into cell_items
+  uint32_t* cell_items;     // Indices into rects
+  uint32_t cell_capacity, item_capacity;
+  int cols, rows;
+} UIHitIndex;
+
+/*
+ * @brief Create an empty hit index
+ *
+ * @param allocator Allocator for the index, or NULL for malloc/free
+ * @return The index, or NULL on failure
+ */
+UI_API UIHitIndex* ui_hit_index_create(const UIAllocator* allocator);
+
+/*
+ * @brief Destroy a hit index
+ *
+ * @param index The index (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_hit_index_destroy(UIHitIndex* index);
+
+/*
+ * @brief Rebuild the index from one frame's rects
+ *
+ * @param index The index
+ * @param rects Rects in z-order, bottom first
+ * @param count Number of rects
+ * @param width Width of the area covered by the grid
+ * @param height Height of the area covered by the grid
+ * @return false if memory ran out, the index is then empty
+ */
+UI_API bool ui_hit_index_build(UIHitIndex* index, const UIHitRect* rects, int count,
+  int width, int height);
+
+/*
+ * @brief Register an interactive rect for this frame
+ *
+ * @param ctx The UI context
+ * @param id Widget id
+ * @param r Widget rect, clipped to the current clip rect
+ * @return void
+ */
+UI_API void ui_hit_add(UIContext* ctx, uint32_t id, rect r);
+
+/*
+ * @brief Find the topmost rect registered last frame under a point
+ *
+ * @param ctx The UI context
+ * @param point Point to test
+ * @return The widget id, 0 if nothing was registered there
+ */
+UI_API uint32_t ui_hit_test(UIContext* ctx, vec2 point);
+
+/*
+ * @brief Test a widget against the mouse, honoring whatever was on top of it
+ *
+ * @param ctx The UI context
+ * @param id Widget id
+ * @param r Widget rect
+ * @return true if the mouse is in r and no other widget covers that point
+ */
+UI_API bool ui_widget_hovered(UIContext* ctx, uint32_t id, rect r);
+
+/*
+ * @brief Count this frame's presses that reached a widget
+ *
+ * @param ctx The UI context
+ * @param id Widget id
+ * @param r Widget rect
+ * @param button Mouse button (0 left, 1 right, 2 middle)
+ * @return Number of presses in r that no other widget covered
+ */
+UI_API int ui_widget_click_count(UIContext* ctx, uint32_t id, rect r, int button);
+
+/*
+ * @brief Get whether a widget had keyboard focus when the frame began
+ *
+ * Start of a focusable widget's walk over this frame's events, see
+ * ui_widget_focus_event.
+ *
+ * @param ctx The UI context
+ * @param id Widget id
+ * @return true if the widget was focused at ui_begin_frame
+ */
+UI_API bool ui_widget_focus_begin(UIContext* ctx, uint32_t id);
+
+/*
+ * @brief Follow a focusable widget's focus through one of this frame's events
+ *
+ * A left press on the widget focuses it, a left press anywhere else ends
+ * its focus. Walking the events in order from ui_widget_focus_begin tells
+ * which key and char events belong to the widget, and the press that moved
+ * focus last decides ctx->focused_widget, whatever order widgets run in.
+ *
+ * @param ctx The UI context
+ * @param id Widget id
+ * @param r Widget rect
+ * @param index Index of the event in ctx->events
+ * @param focused Whether the widget was focused before the event
+ * @return Whether the widget is focused after the event
+ */
+UI_API bool ui_widget_focus_event(UIContext* ctx, uint32_t id, rect r, int index, bool focused);
+
+/*
+ * @brief Tell whether a point of a widget is not covered by another widget
+ *
+ * @param ctx The UI context
+ * @param id Widget id
+ * @param point Point inside the widget
+ * @return true if the widget, or nothing, was topmost there last frame
+ */
+UI_API bool ui_hit_is_topmost(UIContext* ctx, uint32_t id, vec2 point);
+
+// Splice the regions' rects into the parent's at their z (internal use)
+UI_API void ui_hit_merge_regions(UIContext* ctx);
+
+#endif
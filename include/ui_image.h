@@ -0,0 +1,115 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_IMAGE_H
+#define UI_IMAGE_H
+
+#include <ui_core.h>
+
+/*
+ * Runtime images: icons, thumbnails and anything else drawn from RGBA pixels.
+ *
+ * ui_image_create copies the pixels into a shared atlas page, packed with a
+ * skyline packer, so many images draw from one texture. Pages are tracked for
+ * incremental uploads (see ui_upload.h): a new image only uploads its own
+ * texels. Every image gets a one texel border repeating its edges, linear
+ * filtering never picks up a neighbour.
+ *
+ * Images are reference counted; the last ui_image_release gives its space
+ * back. A skyline cannot reuse holes, so a page whose released space reaches
+ * UI_IMAGE_COMPACT_WASTE is repacked at the next ui_begin_frame: live images
+ * move (ids stay valid) and the page is uploaded again. When no page has room
+ * and none can be added, ui_image_create repacks right away; images already
+ * drawn in the current frame may then show the wrong texels for that frame.
+ *
+ * The context's backend must implement update_texture. Create and release
+ * images on the thread that owns the context, never while regions record;
+ * ui_image itself may be called from regions.
+ *
+ * Example of usage:
+ *   ui_image_id icon = ui_image_create(ui, rgba, 32, 32, 32 * 4);
+ *   ...
+ *   ui_image(ui, icon, (rect){{8, 8}, {32, 32}}, (color){1, 1, 1, 1});
+ *   ...
+ *   ui_image_release(ui, icon);
+ */
+
+#define UI_IMAGE_PAGE_SIZE     1024  // Pages are square RGBA8 textures
+#define UI_IMAGE_MAX_PAGES     8
+#define UI_IMAGE_COMPACT_WASTE 0.25f // Fraction of a page released before it is repacked
+
+typedef uint32_t ui_image_id;        // 0: no image
+
+/*
+ * @brief Copy RGBA pixels into the image atlas
+ *
+ * @param ctx The UI context
+ * @param pixels Non-premultiplied RGBA8 pixels, only read during the call
+ * @param width Width, at most UI_IMAGE_PAGE_SIZE - 2
+ * @param height Height, at most UI_IMAGE_PAGE_SIZE - 2
+ * @param stride Bytes between rows of pixels
+ * @return The image with one reference, or 0 if it does not fit
+ */
+UI_API ui_image_id ui_image_create(UIContext* ctx, const void* pixels, int width, int height,
+  int stride);
+
+/*
+ * @brief Add a reference to an image
+ *
+ * @param ctx The UI context
+ * @param image The image (stale ids are ignored)
+ * @return void
+ */
+UI_API void ui_image_retain(UIContext* ctx, ui_image_id image);
+
+/*
+ * @brief Drop a reference, the last one frees the image's space
+ *
+ * @param ctx The UI context
+ * @param image The image (stale ids are ignored)
+ * @return void
+ */
+UI_API void ui_image_release(UIContext* ctx, ui_image_id image);
+
+/*
+ * @brief Get the size an image was created with
+ *
+ * @param ctx The UI context
+ * @param image The image
+ * @param width Receives the width (may be NULL)
+ * @param height Receives the height (may be NULL)
+ * @return false if the image does not exist
+ */
+UI_API bool ui_image_size(UIContext* ctx, ui_image_id image, int* width, int* height);
+
+/*
+ * @brief Draw an image stretched over a rectangle
+ *
+ * Shares draws with text, rects and other images as long as the command's
+ * texture slots have room for the page (see UIDrawCmd).
+ *
+ * @param ctx The UI context
+ * @param image The image (nothing is drawn for stale ids)
+ * @param bounds Where to draw it
+ * @param tint Multiplied with every texel, white draws the image as is
+ * @return void
+ */
+UI_API void ui_image(UIContext* ctx, ui_image_id image, rect bounds, color tint);
+
+/*
+ * @brief Repack every page holding released space, call between frames
+ *
+ * @param ctx The UI context
+ * @return Number of pages repacked
+ */
+UI_API int ui_images_defragment(UIContext* ctx);
+
+// Repack pages past UI_IMAGE_COMPACT_WASTE, called by ui_begin_frame (internal use)
+UI_API void ui_images_compact(UIContext* ctx);
+
+// Free every page, called by ui_destroy_context (internal use)
+UI_API void ui_images_destroy(UIContext* ctx);
+
+#endif
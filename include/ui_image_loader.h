@@ -0,0 +1,164 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_IMAGE_LOADER_H
+#define UI_IMAGE_LOADER_H
+
+#include <ui_core.h>
+#include <ui_image.h>
+
+/*
+ * Asynchronous image loading into the image atlas (see ui_image.h).
+ *
+ * ui_image_load returns a request at once. Worker threads read and decode
+ * the file (PNG or TGA, see ui_decode.h, or raw RGBA) and scale it down to
+ * the loader's max_size. ui_image_loader_update then moves decoded images
+ * into the atlas, at most frame_budget bytes per frame, so a screen full of
+ * thumbnails fills in over a few frames instead of stalling one.
+ *
+ * Requests drawn with ui_image_async in the current or previous frame go
+ * first, then higher priorities, then older requests. Cancel a request once
+ * its row scrolls out of view to drop it whatever state it is in.
+ *
+ * Everything but the workers runs on the thread owning the context;
+ * ui_image_async may also be called from regions. Destroy the loader before
+ * the context.
+ *
+ * Example of usage:
+ *   UIImageLoader* loader = ui_image_loader_create(ui, &(UIImageLoaderDesc){.max_size = 128});
+ *   ui_image_request thumb = ui_image_load(loader, "assets/rock.png", 0);
+ *   ...
+ *   ui_begin_frame(ui, dt);
+ *   ui_image_loader_update(loader);
+ *   ui_image_async(ui, loader, thumb, (rect){{8, 8}, {128, 128}}, (color){1, 1, 1, 1});
+ */
+
+#define UI_IMAGE_LOADER_MAX_THREADS 8
+#define UI_IMAGE_LOADER_MAX_PENDING (64 << 20)  // Decoded bytes waiting for the atlas before workers pause
+
+typedef struct UIImageLoader UIImageLoader;
+typedef uint32_t ui_image_request;      // 0: no request
+
+typedef enum UIImageLoadState {
+  UI_IMAGE_LOAD_NONE = 0,   // Unknown or cancelled request
+  UI_IMAGE_LOAD_QUEUED,     // Waiting for a worker
+  UI_IMAGE_LOAD_DECODING,
+  UI_IMAGE_LOAD_DECODED,    // Waiting for its turn in the atlas
+  UI_IMAGE_LOAD_READY,
+  UI_IMAGE_LOAD_FAILED      // Unreadable, undecodable, or the atlas is full
+} UIImageLoadState;
+
+typedef struct UIImageLoaderDesc {
+  int threads;                  // Decoding threads, 0: one per core but the caller's, at most 4
+  int max_size;                 // Larger images are scaled down to fit, 0: the atlas page limit
+  size_t frame_budget;          // Bytes moved into the atlas per frame, 0: the context's upload budget
+  const UIAllocator* allocator; // Thread-safe allocator, NULL: malloc/free
+} UIImageLoaderDesc;
+
+/*
+ * @brief Create a loader feeding a context's image atlas
+ *
+ * @param ctx The UI context, its backend must support images
+ * @param desc Settings, or NULL for the defaults
+ * @return The loader, or NULL on failure
+ */
+UI_API UIImageLoader* ui_image_loader_create(UIContext* ctx, const UIImageLoaderDesc* desc);
+
+/*
+ * @brief Stop the workers and release every image the loader created
+ *
+ * @param loader The loader (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_image_loader_destroy(UIImageLoader* loader);
+
+/*
+ * @brief Queue a PNG or TGA file
+ *
+ * @param loader The loader
+ * @param path File to load, copied
+ * @param priority Higher loads sooner among requests equally visible
+ * @return The request, or 0 on failure
+ */
+UI_API ui_image_request ui_image_load(UIImageLoader* loader, const char* path, int priority);
+
+/*
+ * @brief Queue a file of raw RGBA8 pixels, rows tightly packed
+ *
+ * @param loader The loader
+ * @param path File to load, copied
+ * @param width Width of the image, the file must hold width * height * 4 bytes
+ * @param height Height of the image
+ * @param priority Higher loads sooner among requests equally visible
+ * @return The request, or 0 on failure
+ */
+UI_API ui_image_request ui_image_load_raw(UIImageLoader* loader, const char* path, int width,
+  int height, int priority);
+
+/*
+ * @brief Change the priority of a request still waiting
+ *
+ * @param loader The loader
+ * @param request The request (stale ones are ignored)
+ * @param priority The new priority
+ * @return void
+ */
+UI_API void ui_image_load_set_priority(UIImageLoader* loader, ui_image_request request, int priority);
+
+/*
+ * @brief Drop a request; a loaded image is released, a decode in flight is discarded
+ *
+ * @param loader The loader
+ * @param request The request (stale ones are ignored)
+ * @return void
+ */
+UI_API void ui_image_load_cancel(UIImageLoader* loader, ui_image_request request);
+
+/*
+ * @brief Get where a request stands
+ *
+ * @param loader The loader
+ * @param request The request
+ * @return The state, UI_IMAGE_LOAD_NONE for stale requests
+ */
+UI_API UIImageLoadState ui_image_load_state(UIImageLoader* loader, ui_image_request request);
+
+/*
+ * @brief Get the image of a loaded request
+ *
+ * The loader owns the reference, retain the image to keep it past the request.
+ *
+ * @param loader The loader
+ * @param request The request
+ * @return The image, or 0 until the request is UI_IMAGE_LOAD_READY
+ */
+UI_API ui_image_id ui_image_load_result(UIImageLoader* loader, ui_image_request request);
+
+/*
+ * @brief Move decoded images into the atlas within the frame budget
+ *
+ * Call once per frame after ui_begin_frame, before drawing.
+ *
+ * @param loader The loader
+ * @return void
+ */
+UI_API void ui_image_loader_update(UIImageLoader* loader);
+
+/*
+ * @brief Draw a requested image, or a placeholder until it is loaded
+ *
+ * A visible request is loaded ahead of those not drawn lately.
+ *
+ * @param ctx The UI context or one of its regions
+ * @param loader The loader
+ * @param request The request
+ * @param bounds Where to draw it
+ * @param tint Multiplied with every texel
+ * @return void
+ */
+UI_API void ui_image_async(UIContext* ctx, UIImageLoader* loader, ui_image_request request,
+  rect bounds, color tint);
+
+#endif
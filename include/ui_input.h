@@ -0,0 +1,154 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_INPUT_H
+#define UI_INPUT_H
+
+#include <ui_core.h>
+#include <stdatomic.h>
+
+/*
+ * Input events.
+ *
+ * ui_set_mouse_position, ui_set_mouse_button, ui_set_key, ui_set_scroll and
+ * ui_input_char push timestamped events into a lock-free single-producer /
+ * single-consumer ring owned by the context. ui_begin_frame drains the ring
+ * into this frame's event array, in order, so nothing is lost or merged when
+ * the frame rate drops: two clicks in one frame are two clicks, and typing
+ * interleaved with backspaces is replayed exactly.
+ *
+ * The producer side may run on its own input thread. All input calls for one
+ * context must come from one thread at a time, which does not have to be the
+ * thread running the frames. Events pushed after ui_begin_frame are seen by
+ * the next frame.
+ */
+
+// Key codes understood by the widgets (GLFW values, what hosts already pass)
+#define UI_KEY_ENTER     257
+#define UI_KEY_TAB       258
+#define UI_KEY_BACKSPACE 259
+#define UI_KEY_DELETE    261
+#define UI_KEY_RIGHT     262
+#define UI_KEY_LEFT      263
+#define UI_KEY_DOWN      264
+#define UI_KEY_UP        265
+#define UI_KEY_PAGE_UP   266
+#define UI_KEY_PAGE_DOWN 267
+#define UI_KEY_HOME      268
+#define UI_KEY_END       269
+
+// Modifier flags of UI_EVENT_KEY (GLFW values)
+#define UI_MOD_SHIFT     0x0001
+#define UI_MOD_CONTROL   0x0002
+
+typedef enum UIInputEventType {
+  UI_EVENT_MOUSE_MOVE = 0,
+  UI_EVENT_MOUSE_BUTTON,
+  UI_EVENT_KEY,
+  UI_EVENT_CHAR,
+  UI_EVENT_SCROLL
+} UIInputEventType;
+
+typedef struct UIInputEvent {
+  UIInputEventType type;
+  uint64_t time_ns;       // Monotonic time the event was pushed (or host supplied)
+  vec2 mouse_pos;         // UI_EVENT_MOUSE_MOVE: new position. Once drained, every
+                          // event holds the mouse position at the time it happened
+  int button;             // UI_EVENT_MOUSE_BUTTON: 0 left, 1 right, 2 middle
+  int key;                // UI_EVENT_KEY: key code (see UI_KEY_*)
+  int mods;               // UI_EVENT_KEY: UI_MOD_* flags held
+  bool pressed;           // UI_EVENT_MOUSE_BUTTON / UI_EVENT_KEY
+  unsigned int codepoint; // UI_EVENT_CHAR: Unicode codepoint
+  float scroll;           // UI_EVENT_SCROLL: offset
+} UIInputEvent;
+
+typedef struct UIInputQueue {
+  UIAllocator allocator;
+  UIInputEvent* events;
+  uint32_t capacity;                  // Power of two
+
+  // Producer and consumer counters live on their own cache lines
+  _Alignas(64) _Atomic uint32_t head; // Written by the producer
+  _Alignas(64) _Atomic uint32_t tail; // Written by the consumer
+  _Atomic uint32_t dropped;           // Events lost because the ring was full
+
+  // Producer-only state, repeated polls of an unchanged mouse are not queued
+  _Alignas(64) vec2 last_mouse_pos;
+  bool last_buttons[3];
+  bool has_mouse_pos;
+} UIInputQueue;
+
+/*
+ * @brief Create an input queue
+ *
+ * @param capacity Number of buffered events, rounded up to a power of two
+ * @param allocator Allocator for the queue, or NULL for malloc/free
+ * @return The queue, or NULL on failure
+ */
+UI_API UIInputQueue* ui_input_queue_create(uint32_t capacity, const UIAllocator* allocator);
+
+/*
+ * @brief Destroy an input queue
+ *
+ * @param queue The queue (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_input_queue_destroy(UIInputQueue* queue);
+
+/*
+ * @brief Push one event (producer thread only)
+ *
+ * @param queue The queue
+ * @param event The event to copy in
+ * @return false if the queue was full and the event was dropped
+ */
+UI_API bool ui_input_queue_push(UIInputQueue* queue, const UIInputEvent* event);
+
+/*
+ * @brief Pop events in order (consumer thread only)
+ *
+ * @param queue The queue
+ * @param out Destination array
+ * @param max Size of out
+ * @return Number of events popped
+ */
+UI_API uint32_t ui_input_queue_pop(UIInputQueue* queue, UIInputEvent* out, uint32_t max);
+
+/*
+ * @brief Push a fully described event, e.g. with the host's own timestamp
+ *
+ * @param ctx The UI context
+ * @param event The event, a time_ns of 0 is replaced by the current time
+ * @return false if the event was dropped
+ */
+UI_API bool ui_push_event(UIContext* ctx, const UIInputEvent* event);
+
+/*
+ * @brief Push a key event with modifiers, key repeats are pushed as presses
+ *
+ * @param ctx The UI context
+ * @param key Key code (see UI_KEY_*)
+ * @param pressed Whether the key went down (or repeated)
+ * @param mods UI_MOD_* flags held
+ * @return void
+ */
+UI_API void ui_set_key_mods(UIContext* ctx, int key, bool pressed, int mods);
+
+/*
+ * @brief Get the events of the current frame, in the order they happened
+ *
+ * Valid between ui_begin_frame and the next ui_begin_frame. Region contexts
+ * return their parent's events.
+ *
+ * @param ctx The UI context
+ * @param count Receives the number of events
+ * @return The events
+ */
+UI_API const UIInputEvent* ui_get_events(UIContext* ctx, int* count);
+
+// Drain the queue into this frame's events and update mouse state (internal use)
+UI_API void ui_input_begin_frame(UIContext* ctx);
+
+#endif
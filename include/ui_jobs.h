@@ -0,0 +1,78 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_JOBS_H
+#define UI_JOBS_H
+
+#include <ui_memory.h>
+
+typedef void (*ui_job_fn)(void* arg);
+
+/*
+ * Host job system. The library never creates threads on its own for frame
+ * work, it hands batches of jobs to this interface instead, so an engine can
+ * plug in its own scheduler. ui_thread_pool provides a plain implementation.
+ */
+typedef struct UIJobSystem {
+  // Run fn(args[i]) for every i, possibly in parallel, and return once all finished
+  void (*run)(void* user, ui_job_fn fn, void** args, int count);
+  void* user;
+} UIJobSystem;
+
+typedef struct UIThreadPool UIThreadPool;
+
+/*
+ * @brief Create a pool of worker threads
+ *
+ * The thread calling ui_thread_pool_run also executes jobs, so a pool of
+ * N - 1 workers keeps N cores busy.
+ *
+ * @param thread_count Number of worker threads (0 runs every job on the caller)
+ * @param allocator Allocator for the pool, or NULL for malloc/free
+ * @return The pool, or NULL on failure
+ */
+UI_API UIThreadPool* ui_thread_pool_create(int thread_count, const UIAllocator* allocator);
+
+/*
+ * @brief Stop the workers and destroy the pool
+ *
+ * @param pool The pool to destroy (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_thread_pool_destroy(UIThreadPool* pool);
+
+/*
+ * @brief Run a batch of jobs and wait for all of them
+ *
+ * Batches from different threads are serialized.
+ *
+ * @param pool The pool
+ * @param fn Job function
+ * @param args One argument per job
+ * @param count Number of jobs
+ * @return void
+ */
+UI_API void ui_thread_pool_run(UIThreadPool* pool, ui_job_fn fn, void** args, int count);
+
+/*
+ * @brief Get a UIJobSystem backed by the pool
+ *
+ * @param pool The pool, must outlive the returned interface
+ * @return The job system interface
+ */
+UI_API UIJobSystem ui_thread_pool_jobs(UIThreadPool* pool);
+
+/*
+ * @brief Run a batch through a job system, or serially when it is NULL
+ *
+ * @param jobs The job system, or NULL
+ * @param fn Job function
+ * @param args One argument per job
+ * @param count Number of jobs
+ * @return void
+ */
+UI_API void ui_jobs_run(const UIJobSystem* jobs, ui_job_fn fn, void** args, int count);
+
+#endif
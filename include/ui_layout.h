@@ -24,12 +24,13 @@ typedef struct VBoxConfig {
   float padding_left;
   float padding_right;
   bool expand_width;      // Should widgets expand to fill width? (default: false)
-  float fixed_height;     // If > 0, use fixed height instead of auto (default: 0.0f)
+  float fixed_height;     // If > 0, the vbox's height instead of its bounds' (default: 0.0f)
   bool clip_overflow;     // Clip widgets outside bounds? (default: false)
 } VBoxConfig;
 
 typedef struct VBoxState {
   char* id;
+  rect bounds;            // Bounds given to ui_vbox_begin_ex
   vec2 cursor;            // Current position for next widget
   float max_widget_width; // Maximum widget width seen so far
   float total_height;     // Total height of all widgets + spacing
@@ -47,4 +48,122 @@ UI_API void ui_vbox_end(UIContext* ctx, const char* id);
 #define ui_begin_vbox(ctx, id, bounds) ui_vbox_begin_ex(ctx, id, bounds, NULL)
 #define ui_next_vbox_widget(ctx, id, height) ui_vbox_next(ctx, id, height)
 
+/*
+ * Flex and grid layout.
+ *
+ * A layout places the items declared between ui_layout_begin and
+ * ui_layout_end in a row, a column or a grid. Items have a preferred size,
+ * min/max sizes, and grow/shrink factors sharing out the space left over
+ * or missing along the row or column; across it they align or stretch.
+ *
+ * Widgets are drawn as they are declared, before their siblings are known,
+ * so the work is split in two. Measure: each item's preferred size is
+ * recorded as it is declared; an item with no size takes the size of its
+ * text, measured the way ui_button sizes a label, or of the nested layout
+ * with the same id. Arrange: ui_layout_end places the items for the next
+ * frame, and ui_layout_begin places last frame's items again at once when
+ * only the bounds changed, so resizing never lags. Items hand out the rects
+ * arranged from what was measured last frame; a change in what the items
+ * measure settles a frame later, plus a frame per level of nesting it
+ * passes through, which ui_layout_settled reports.
+ *
+ * Every item and layout is a node, identified by its id within its parent
+ * layout, and nodes are cached across frames: text is measured again only
+ * when it changes, and a layout whose bounds and items measure the same as
+ * last frame skips arranging.
+ *
+ * Example of usage:
+ *   UILayoutDesc toolbar = {.direction = UI_LAYOUT_ROW, .gap = 4, .padding = 4,
+ *                           .align = UI_ALIGN_CENTER};
+ *   ui_layout_begin(ui, "toolbar", (rect){{0, 0}, {800, 40}}, &toolbar);
+ *   if (ui_button(ui, "Open", ui_layout_item(ui, "Open", &(UILayoutItem){.text = "Open"}))) ...
+ *   ui_layout_item(ui, "spacer", &(UILayoutItem){.grow = 1});
+ *   rect search = ui_layout_item(ui, "search", &(UILayoutItem){.size = {200, 24}, .shrink = 1});
+ *   ui_text_input(ui, "search", search, buffer, sizeof(buffer));
+ *   ui_layout_end(ui);
+ */
+
+#define UI_LAYOUT_MAX_DEPTH 32  // Layouts open at once
+
+typedef enum UILayoutDirection {
+  UI_LAYOUT_ROW = 0,      // Left to right
+  UI_LAYOUT_COLUMN,       // Top to bottom
+  UI_LAYOUT_GRID          // Row by row, UILayoutDesc.columns per row
+} UILayoutDirection;
+
+typedef enum UILayoutAlign {
+  UI_ALIGN_DEFAULT = 0,   // Items: the layout's alignment. Layouts: stretch
+  UI_ALIGN_START,
+  UI_ALIGN_CENTER,
+  UI_ALIGN_END,
+  UI_ALIGN_STRETCH
+} UILayoutAlign;
+
+typedef enum UILayoutJustify {
+  UI_JUSTIFY_START = 0,   // Space nothing grew into goes after the items
+  UI_JUSTIFY_CENTER,
+  UI_JUSTIFY_END,
+  UI_JUSTIFY_SPACE_BETWEEN
+} UILayoutJustify;
+
+typedef struct UILayoutDesc {
+  UILayoutDirection direction;
+  float gap;              // Between items, in a grid between rows and columns
+  float padding;          // Inside the bounds
+  UILayoutJustify justify; // Rows and columns: where the items go along the main axis
+  UILayoutAlign align;    // Across the main axis, in a grid within the cells
+  int columns;            // UI_LAYOUT_GRID: cells per row, 0: 1
+  bool clip;              // Clip what the items draw to the bounds
+} UILayoutDesc;
+
+typedef struct UILayoutItem {
+  vec2 size;              // Preferred size, 0 on an axis: measured (text or nested layout)
+  vec2 min_size;
+  vec2 max_size;          // 0 on an axis: unlimited
+  float grow;             // Share of the space left over, in a grid for its row and column
+  float shrink;           // Share of the space missing, weighted by the preferred size
+  UILayoutAlign align;    // Override of the layout's align
+  const char* text;       // Measured when size is 0, as ui_button sizes a label
+} UILayoutItem;
+
+/*
+ * @brief Start a layout, nested in the current one if there is one
+ *
+ * @param ctx The UI context
+ * @param id Unique id within the parent layout, the same as the item it fills
+ * @param bounds The layout's area
+ * @param desc How to place the items
+ * @return void
+ */
+UI_API void ui_layout_begin(UIContext* ctx, const char* id, rect bounds, const UILayoutDesc* desc);
+
+/*
+ * @brief Declare the next item of the current layout
+ *
+ * @param ctx The UI context
+ * @param id Unique id within the layout
+ * @param item Size and placement
+ * @return Where to draw the item
+ */
+UI_API rect ui_layout_item(UIContext* ctx, const char* id, const UILayoutItem* item);
+
+/*
+ * @brief Finish the current layout and arrange its items for the next frame
+ *
+ * @param ctx The UI context
+ * @return void
+ */
+UI_API void ui_layout_end(UIContext* ctx);
+
+/*
+ * @brief Check whether every rect handed out this frame was where its item belongs
+ *
+ * @param ctx The UI context
+ * @return false after items changed size or appeared, the next frame corrects them
+ */
+UI_API bool ui_layout_settled(UIContext* ctx);
+
+// Free the layout nodes, called when the context goes (internal use)
+UI_API void ui_layout_cache_destroy(UIContext* ctx);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_LOGVIEW_H
+#define UI_LOGVIEW_H
+
+#include <ui_core.h>
+
+/*
+ * Read-only log viewer for files of any size.
+ *
+ * Opening maps the file and starts a background thread that scans it for
+ * newlines and keeps following appends, so ui_logview_open returns at once
+ * and lines show up as they are indexed. The index keeps one offset every
+ * UI_LOGVIEW_STRIDE lines; a line is found from its checkpoint with a
+ * memchr over at most that many lines. Memory is the sparse index plus the
+ * visible lines, the file itself stays in the page cache.
+ *
+ * All functions except the indexer run on the UI thread. Pointers into the
+ * mapping stay valid until the next call on the view, which may remap the
+ * file after it grew. A file that shrinks (rotated with copytruncate, or
+ * truncated) is noticed on the next call, which drops what was shown and
+ * indexes the file again from the start. The allocator must be
+ * thread-safe, the indexer allocates from it.
+ *
+ * Example of usage:
+ *   UILogView* log = ui_logview_open("/var/log/server.log", NULL);
+ *   ...
+ *   ui_log_view(ui, "server_log", (rect){{0, 0}, {800, 600}}, log);
+ *   ...
+ *   // Incremental search, a few MiB per frame
+ *   if (ui_logview_find(log, "ERROR", &cursor, 8 << 20) == UI_LOG_SEARCH_FOUND) {
+ *     ui_logview_select(log, cursor, 5);
+ *     cursor++;
+ *   }
+ */
+
+#define UI_LOGVIEW_STRIDE 64   // Lines between index checkpoints
+
+typedef struct UILogView UILogView;
+
+typedef enum UILogSearch {
+  UI_LOG_SEARCH_FOUND = 0,  // Cursor holds the offset of the match
+  UI_LOG_SEARCH_MORE,       // Budget used up, call again with the same cursor
+  UI_LOG_SEARCH_END         // Reached the end of what is indexed so far
+} UILogSearch;
+
+/*
+ * @brief Open a file and start indexing it in the background
+ *
+ * @param path File to view
+ * @param allocator Thread-safe allocator, or NULL for malloc/free
+ * @return The view, or NULL if the file cannot be opened
+ */
+UI_API UILogView* ui_logview_open(const char* path, const UIAllocator* allocator);
+
+/*
+ * @brief Stop the indexer and close the file
+ *
+ * @param view The view (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_logview_close(UILogView* view);
+
+/*
+ * @brief Number of lines indexed so far, an unterminated last line included
+ *
+ * @param view The view
+ * @return The line count
+ */
+UI_API uint64_t ui_logview_line_count(UILogView* view);
+
+/*
+ * @brief Number of bytes indexed so far
+ *
+ * @param view The view
+ * @return The size
+ */
+UI_API uint64_t ui_logview_size(UILogView* view);
+
+/*
+ * @brief Get one line, without its newline
+ *
+ * @param view The view
+ * @param line Line number
+ * @param text Receives a pointer into the mapping (not NUL-terminated)
+ * @return Length of the line, 0 with *text NULL if the line does not exist
+ */
+UI_API size_t ui_logview_line(UILogView* view, uint64_t line, const char** text);
+
+/*
+ * @brief Find the line holding a byte offset
+ *
+ * @param view The view
+ * @param offset Byte offset
+ * @return The line number
+ */
+UI_API uint64_t ui_logview_line_of(UILogView* view, uint64_t offset);
+
+/*
+ * @brief Search the indexed part of the file, at most `budget` bytes per call
+ *
+ * @param view The view
+ * @param needle Text to find
+ * @param cursor In: offset to start at. Out: the match, or where to resume
+ * @param budget Bytes to scan in this call
+ * @return See UILogSearch
+ */
+UI_API UILogSearch ui_logview_find(UILogView* view, const char* needle, uint64_t* cursor,
+  size_t budget);
+
+/*
+ * @brief Scroll a range into view and highlight it
+ *
+ * @param view The view
+ * @param offset First byte of the range
+ * @param length Length of the range, 0 clears the highlight
+ * @return void
+ */
+UI_API void ui_logview_select(UILogView* view, uint64_t offset, size_t length);
+
+/*
+ * @brief Render the visible lines of a log and handle scrolling
+ *
+ * The view sticks to the end of the file while scrolled to the bottom.
+ * Mouse wheel, and Page Up/Down, Home and End once clicked, scroll.
+ *
+ * @param ctx The UI context
+ * @param id Unique id for focus tracking
+ * @param bounds The view area
+ * @param view The log view
+ * @return void
+ */
+UI_API void ui_log_view(UIContext* ctx, const char* id, rect bounds, UILogView* view);
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_MEMORY_H
+#define UI_MEMORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+  #define UI_API __declspec(dllexport)
+#else
+  #define UI_API __attribute__ ((visibility("default")))
+#endif
+
+/*
+ * Host allocator. Every heap allocation made by the library goes through one
+ * of these, so an engine can route UI memory into its own budgets. Passing
+ * NULL wherever an allocator is accepted selects malloc/free.
+ */
+typedef struct UIAllocator {
+  void* (*alloc)(size_t size, void* user);
+  void  (*free)(void* ptr, void* user);
+  void* user;
+} UIAllocator;
+
+// Arena block header (internal use), the payload follows the header
+typedef struct UIArenaBlock {
+  struct UIArenaBlock* next;
+  size_t capacity;
+  size_t used;
+} UIArenaBlock;
+
+/*
+ * Linear frame arena. Allocations are bump-pointer and are never freed one by
+ * one, the whole arena is rewound with ui_arena_reset. When a block is full
+ * the arena chains another one (unless growth is disabled); blocks are kept
+ * across resets so a steady-state frame does not touch the host allocator.
+ */
+typedef struct UIArena {
+  UIAllocator allocator;
+  UIArenaBlock* first;
+  UIArenaBlock* current;
+  size_t block_size;      // Capacity of newly chained blocks
+  size_t used;            // Bytes handed out since the last reset (incl. padding)
+  size_t high_water;      // Largest `used` seen over the arena's lifetime
+  size_t reserved;        // Total capacity of all chained blocks
+  int block_count;
+  bool allow_growth;      // Chain new blocks when full? (false: allocations fail)
+} UIArena;
+
+/*
+ * @brief Get the default allocator (malloc/free)
+ *
+ * @return Pointer to a static, immutable allocator
+ */
+UI_API const UIAllocator* ui_default_allocator(void);
+
+/*
+ * @brief Allocate memory through an allocator
+ *
+ * @param allocator The allocator to use, or NULL for the default one
+ * @param size Number of bytes to allocate
+ * @return The allocated memory or NULL on failure
+ */
+UI_API void* ui_mem_alloc(const UIAllocator* allocator, size_t size);
+
+/*
+ * @brief Release memory obtained from ui_mem_alloc
+ *
+ * @param allocator The allocator the memory came from, or NULL for the default one
+ * @param ptr The memory to free (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_mem_free(const UIAllocator* allocator, void* ptr);
+
+/*
+ * @brief Initialize an arena and reserve its first block
+ *
+ * @param arena The arena to initialize
+ * @param allocator Allocator used for the blocks, or NULL for the default one
+ * @param block_size Capacity of the first block and of every chained block
+ * @param allow_growth Whether to chain new blocks once the current one is full
+ * @return true if the first block could be reserved, false otherwise
+ */
+UI_API bool ui_arena_init(UIArena* arena, const UIAllocator* allocator, size_t block_size,
+  bool allow_growth);
+
+/*
+ * @brief Free every block owned by the arena
+ *
+ * @param arena The arena to release
+ * @return void
+ */
+UI_API void ui_arena_release(UIArena* arena);
+
+/*
+ * @brief Rewind the arena, invalidating every allocation made from it
+ *
+ * Blocks are kept so the next frame can reuse them without allocating.
+ *
+ * @param arena The arena to reset
+ * @return void
+ */
+UI_API void ui_arena_reset(UIArena* arena);
+
+/*
+ * @brief Allocate uninitialized memory from the arena
+ *
+ * @param arena The arena to allocate from
+ * @param size Number of bytes
+ * @param align Alignment in bytes, must be a power of two (0 means pointer alignment)
+ * @return The allocated memory, or NULL if the arena is full and cannot grow
+ */
+UI_API void* ui_arena_alloc(UIArena* arena, size_t size, size_t align);
+
+/*
+ * @brief Grow an allocation made from the arena
+ *
+ * If `ptr` is the most recent allocation and the block has room it is extended
+ * in place, otherwise a new region is allocated and the old contents copied.
+ *
+ * @param arena The arena the allocation belongs to
+ * @param ptr The allocation to grow (NULL behaves like ui_arena_alloc)
+ * @param old_size Current size of the allocation
+ * @param new_size Requested size, smaller sizes return `ptr` unchanged
+ * @param align Alignment used for the original allocation
+ * @return The (possibly moved) allocation, or NULL on failure
+ */
+UI_API void* ui_arena_grow(UIArena* arena, void* ptr, size_t old_size, size_t new_size,
+  size_t align);
+
+/*
+ * @brief Copy a null-terminated string into the arena
+ *
+ * @param arena The arena to allocate from
+ * @param str The string to copy
+ * @return The copy, or NULL on failure
+ */
+UI_API char* ui_arena_strdup(UIArena* arena, const char* str);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_PLOT_H
+#define UI_PLOT_H
+
+#include <ui_core.h>
+#include <ui_series.h>
+
+/*
+ * Line and area plots of large sample arrays.
+ *
+ * Zoomed out past two samples per pixel, the visible samples are decimated
+ * into one min/max envelope per pixel column (SSE2 where available) and the
+ * envelope is drawn as a single triangle strip, so the geometry grows with
+ * the plot's width, never with the sample count. Zoomed further in, the
+ * samples themselves are drawn as a strip.
+ *
+ * A UIPlot caches the envelope across frames. Columns sit on a grid fixed
+ * in sample space, so while the zoom stays the same, panning and appends
+ * only decimate the columns that are new; a frame with unchanged data and
+ * view costs O(width). Modifying samples that were already drawn needs a
+ * new version in UIPlotDesc.
+ *
+ * Samples come from an array, or from a UISeries snapshot for data other
+ * threads keep appending to. A series' columns come from its min/max
+ * pyramid, O(log samples per pixel) each, so even the first frame of a
+ * zoomed-out view stays proportional to the width.
+ *
+ * Samples must be finite. One UIPlot per plot on screen; it may be drawn
+ * from a region, by one thread at a time.
+ *
+ * Example of usage:
+ *   UIPlot* plot = ui_plot_create(NULL);
+ *   ...
+ *   UIPlotDesc desc = {.samples = channel, .count = channel_count,
+ *                      .foreground = {0.3f, 0.8f, 1.0f, 1.0f}};
+ *   ui_plot(ui, plot, (rect){{0, 0}, {1200, 200}}, &desc);
+ */
+
+typedef struct UIPlot UIPlot;
+
+typedef enum UIPlotMode {
+  UI_PLOT_LINE = 0,       // The samples' envelope, at least line_width thick
+  UI_PLOT_AREA            // Filled from the envelope's top down to y_min
+} UIPlotMode;
+
+typedef struct UIPlotDesc {
+  const float* samples;   // Sample i is at x = i
+  size_t count;
+  const UISeriesSnapshot* series; // Instead of samples / count, x is the sample's index
+  uint64_t version;       // Change when drawn samples are modified, appends need nothing
+  double view_start;      // First visible sample, fractional when zoomed in
+  double view_end;        // End of the visible samples, 0: count
+  float y_min, y_max;     // Vertical range, equal values: fit the visible samples
+  UIPlotMode mode;
+  float line_width;       // UI_PLOT_LINE thickness in pixels, 0: 1
+  color foreground;       // Line or area color
+  color background;       // Alpha 0: no background
+} UIPlotDesc;
+
+/*
+ * @brief Create the state of one plot
+ *
+ * @param allocator Allocator for the envelope cache, or NULL for malloc/free
+ * @return The plot, or NULL on failure
+ */
+UI_API UIPlot* ui_plot_create(const UIAllocator* allocator);
+
+/*
+ * @brief Destroy a plot
+ *
+ * @param plot The plot (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_plot_destroy(UIPlot* plot);
+
+/*
+ * @brief Draw samples into a rectangle
+ *
+ * @param ctx The UI context
+ * @param plot The plot's state
+ * @param bounds The plot area, everything drawn is clipped to it
+ * @param desc What to draw
+ * @return void
+ */
+UI_API void ui_plot(UIContext* ctx, UIPlot* plot, rect bounds, const UIPlotDesc* desc);
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_PROFILE_H
+#define UI_PROFILE_H
+
+#include <ui_core.h>
+#include <stdatomic.h>
+
+/*
+ * Scope profiler.
+ *
+ * Every context with profiling enabled (UIContextDesc.profile_events > 0)
+ * records timed, nested scopes into its own ring buffer. A context is only
+ * ever driven by one thread at a time, so each ring has a single writer and
+ * recording never takes a lock; region contexts on worker threads get rings
+ * of their own. The GL backend adds one GL_TIME_ELAPSED query per frame,
+ * read back a few frames later so it never stalls the pipeline.
+ *
+ * Example of usage:
+ *   UI_PROFILE_BEGIN(ui, "sidebar");  <- Name must be a string literal or
+ *   ... widgets ...                      otherwise outlive the context
+ *   UI_PROFILE_END(ui);
+ *   ...
+ *   ui_profile_write_chrome_trace(ui, "ui_trace.json", 60);
+ *
+ * The dump opens in chrome://tracing or https://ui.perfetto.dev. Building
+ * the library with UI_DISABLE_PROFILER compiles every scope out.
+ */
+
+#define UI_PROFILE_MAX_DEPTH 32
+#define UI_PROFILE_TRACK_GPU 0xFFFF   // Track id of GPU timings in the trace
+
+typedef struct UIProfileEvent {
+  const char* name;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  uint64_t frame;
+  uint16_t depth;
+  uint16_t track;         // 0: the context's own thread, 1..: regions, UI_PROFILE_TRACK_GPU
+} UIProfileEvent;
+
+typedef struct UIProfiler {
+  UIAllocator allocator;
+  uint16_t track;
+
+  // Single-producer ring, head counts every event ever written
+  UIProfileEvent* events;
+  uint32_t capacity;        // Power of two
+  _Atomic uint64_t head;
+
+  // Open scopes, only touched by the writer
+  struct {
+    const char* name;
+    uint64_t start_ns;
+  } stack[UI_PROFILE_MAX_DEPTH];
+  int depth;
+  uint64_t frame;
+
+  // CPU time each recent frame was submitted, GPU timings are placed there
+  uint64_t submit_ns[8];
+
+  // Region profilers, published with release so a dump on another thread sees them
+  _Atomic(struct UIProfiler*) children[UI_MAX_REGIONS];
+} UIProfiler;
+
+#ifndef UI_DISABLE_PROFILER
+  #define UI_PROFILE_BEGIN(ctx, name) \
+    do { if ((ctx)->profiler) ui_profile_begin((ctx)->profiler, name); } while (0)
+  #define UI_PROFILE_END(ctx) \
+    do { if ((ctx)->profiler) ui_profile_end((ctx)->profiler); } while (0)
+#else
+  #define UI_PROFILE_BEGIN(ctx, name) ((void)0)
+  #define UI_PROFILE_END(ctx) ((void)0)
+#endif
+
+/*
+ * @brief Create a profiler
+ *
+ * @param capacity Number of events kept, rounded up to a power of two
+ * @param track Track id written into every event
+ * @param allocator Allocator for the profiler, or NULL for malloc/free
+ * @return The profiler, or NULL on failure
+ */
+UI_API UIProfiler* ui_profiler_create(uint32_t capacity, uint16_t track, const UIAllocator* allocator);
+
+/*
+ * @brief Destroy a profiler and every region profiler attached to it
+ *
+ * @param profiler The profiler (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_profiler_destroy(UIProfiler* profiler);
+
+/*
+ * @brief Current time of the profiler clock
+ *
+ * @return Monotonic time in nanoseconds
+ */
+UI_API uint64_t ui_profile_now_ns(void);
+
+/*
+ * @brief Open a scope, use UI_PROFILE_BEGIN instead of calling this directly
+ *
+ * @param profiler The profiler of the calling context
+ * @param name Scope name, must outlive the profiler (string literals do)
+ * @return void
+ */
+UI_API void ui_profile_begin(UIProfiler* profiler, const char* name);
+
+/*
+ * @brief Close the innermost scope and record it
+ *
+ * @param profiler The profiler of the calling context
+ * @return void
+ */
+UI_API void ui_profile_end(UIProfiler* profiler);
+
+/*
+ * @brief Record a finished event directly
+ *
+ * @param profiler The profiler to write to (writer thread only)
+ * @param event The event, its track is kept as given
+ * @return void
+ */
+UI_API void ui_profile_record(UIProfiler* profiler, const UIProfileEvent* event);
+
+/*
+ * @brief Copy the events of the last frames out of a profiler
+ *
+ * Safe to call from any thread while the owner keeps recording; events
+ * overwritten during the copy are dropped.
+ *
+ * @param profiler The profiler to read
+ * @param out Destination array
+ * @param max Size of out
+ * @param min_frame Oldest frame to keep
+ * @return Number of events copied
+ */
+UI_API uint32_t ui_profile_read(UIProfiler* profiler, UIProfileEvent* out, uint32_t max,
+  uint64_t min_frame);
+
+/*
+ * @brief Write the last frames of a context (and its regions) as Chrome trace JSON
+ *
+ * @param ctx A context created with profiling enabled
+ * @param path Output file path
+ * @param frames Number of most recent frames to write
+ * @return true if the file was written
+ */
+UI_API bool ui_profile_write_chrome_trace(UIContext* ctx, const char* path, int frames);
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_RECORD_H
+#define UI_RECORD_H
+
+#include <ui_core.h>
+
+/*
+ * Input recording and replay.
+ *
+ * While a context records, every ui_begin_frame appends its delta_time and
+ * the input events it drained (see ui_input.h) to a binary log. Events are
+ * stored as ui_begin_frame saw them, so a replay puts each one in the same
+ * frame it landed in originally, whatever thread or rate produced them.
+ *
+ * A replay feeds the log back frame by frame: ui_replay_frame queues the
+ * next frame's events, with their original timestamps, and hands out its
+ * delta_time for ui_begin_frame. Drawing the same UI then goes through the
+ * same states, which turns a captured session into a repeatable workload
+ * (see the --replay option of the benchmark).
+ *
+ * The log is little-endian: a 16 byte header ("TUIR", version, width,
+ * height), then per frame a varint event count and the float delta_time,
+ * then per event a type byte, a zigzag varint of the nanoseconds since the
+ * previous event and the type's payload. A typical event takes 3 to 10 bytes.
+ *
+ * Example of usage:
+ *   ui_record_begin(ui, "session.tuir");
+ *   ...                          // frames as usual
+ *   ui_record_end(ui);
+ *
+ *   UIReplay* replay = ui_replay_open("session.tuir", NULL);
+ *   float dt;
+ *   while (ui_replay_frame(replay, ui, &dt)) {
+ *     ui_begin_frame(ui, dt);
+ *     ...
+ *     ui_end_frame(ui);
+ *   }
+ *   ui_replay_close(replay);
+ */
+
+#define UI_RECORD_VERSION 1
+
+typedef struct UIReplay UIReplay;
+
+typedef struct UIReplayInfo {
+  int width, height;          // Size of the recorded context
+  uint32_t frame_count;       // Complete frames in the log
+  uint32_t max_frame_events;  // Most events in one frame, the replaying queue needs room for them
+  uint64_t event_count;
+} UIReplayInfo;
+
+/*
+ * @brief Start writing a context's input to a log file, replacing any log being written
+ *
+ * @param ctx The UI context (not a region)
+ * @param path File to create
+ * @return false if the file cannot be created
+ */
+UI_API bool ui_record_begin(UIContext* ctx, const char* path);
+
+/*
+ * @brief Stop recording and close the log
+ *
+ * @param ctx The UI context (nothing happens when it does not record)
+ * @return false if writing the log failed at some point
+ */
+UI_API bool ui_record_end(UIContext* ctx);
+
+/*
+ * @brief Load a log written by ui_record_begin
+ *
+ * A log cut short (e.g. the recording process crashed) replays up to its
+ * last complete frame.
+ *
+ * @param path The log
+ * @param allocator Allocator for the replay, or NULL for malloc/free
+ * @return The replay, or NULL if the file cannot be read or is not a log
+ */
+UI_API UIReplay* ui_replay_open(const char* path, const UIAllocator* allocator);
+
+/*
+ * @brief Free a replay
+ *
+ * @param replay The replay (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_replay_close(UIReplay* replay);
+
+/*
+ * @brief Describe a replay
+ *
+ * @param replay The replay
+ * @return What the log holds
+ */
+UI_API UIReplayInfo ui_replay_info(const UIReplay* replay);
+
+/*
+ * @brief Queue the next frame's events into a context
+ *
+ * Call before ui_begin_frame and pass it the returned delta_time. The
+ * context's input queue must hold max_frame_events (see UIContextDesc).
+ *
+ * @param replay The replay
+ * @param ctx The UI context to feed
+ * @param delta_time Receives the frame's delta_time
+ * @return false once every frame has been replayed
+ */
+UI_API bool ui_replay_frame(UIReplay* replay, UIContext* ctx, float* delta_time);
+
+/*
+ * @brief Go back to the first frame
+ *
+ * @param replay The replay
+ * @return void
+ */
+UI_API void ui_replay_rewind(UIReplay* replay);
+
+// Append this frame's delta_time and events to the log, called by ui_begin_frame (internal use)
+UI_API void ui_record_frame(UIContext* ctx);
+
+#endif
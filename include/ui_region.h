@@ -0,0 +1,84 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_REGION_H
+#define UI_REGION_H
+
+#include <ui_core.h>
+#include <ui_jobs.h>
+
+/*
+ * Regions, independent parts of a screen recorded on other threads.
+ *
+ * A region is a child context with its own frame arena, draw list, clip and
+ * layout stacks. It sees a read-only snapshot of the parent's input and widget
+ * state taken by ui_region_begin, so the normal widget API works on it from a
+ * worker thread while the parent (and other regions) record concurrently.
+ *
+ * Example of usage:
+ *   UIContext* props = ui_region_begin(ui, (rect){{0, 0}, {300, 600}});
+ *   UIContext* tree  = ui_region_begin(ui, (rect){{300, 0}, {300, 600}});
+ *   ... hand `props` and `tree` to worker threads, record widgets, then
+ *       call ui_region_end on each from the thread that recorded it ...
+ *   ... wait for the workers ...
+ *   ui_end_frame(ui);
+ *
+ * Merging is deterministic: ui_end_frame draws each region right where its
+ * ui_region_begin was called in the parent's draw order, regions in the order
+ * they were begun. Widget state changes (hot/active/focused) are applied in
+ * the same order, a later region wins if two regions claim the same state.
+ */
+
+typedef void (*ui_region_fn)(UIContext* region, void* user);
+
+typedef struct UIRegionDesc {
+  rect bounds;            // Region area, also its clip rect and layout origin
+  ui_region_fn build;     // Records the region's widgets
+  void* user;
+} UIRegionDesc;
+
+/*
+ * @brief Start a region of the current frame
+ *
+ * Must be called on the parent's thread between ui_begin_frame and
+ * ui_end_frame. The returned context is valid until the parent's
+ * ui_end_frame and may be used from exactly one (any) thread.
+ *
+ * @param ctx The parent context
+ * @param bounds The region area in window pixels
+ * @return The region context, or NULL if UI_MAX_REGIONS are already in use
+ */
+UI_API UIContext* ui_region_begin(UIContext* ctx, rect bounds);
+
+/*
+ * @brief Finish recording a region
+ *
+ * Called on the thread that recorded the region. The parent must not reach
+ * ui_end_frame before every region has ended.
+ *
+ * @param region The region context returned by ui_region_begin
+ * @return void
+ */
+UI_API void ui_region_end(UIContext* region);
+
+/*
+ * @brief Record several regions in parallel and wait for them
+ *
+ * Begins every region in array order, runs each `build` callback as one job
+ * and ends the regions.
+ *
+ * @param ctx The parent context
+ * @param regions The regions to record
+ * @param count Number of regions
+ * @param jobs Job system to run on, or NULL to record serially
+ * @return void
+ */
+UI_API void ui_build_regions(UIContext* ctx, const UIRegionDesc* regions, int count,
+  const UIJobSystem* jobs);
+
+// Merge finished regions into the parent's draw list (internal use)
+UI_API void ui_regions_merge(UIContext* ctx);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_REMOTE_H
+#define UI_REMOTE_H
+
+#include <ui_backend.h>
+#include <ui_input.h>
+
+/*
+ * Out-of-process rendering over POSIX shared memory.
+ *
+ * A tool process builds its UI with a normal UIContext whose backend comes
+ * from ui_backend_remote_create. That backend renders nothing; it writes
+ * texture edits and frames into a ring in a shared-memory segment. The
+ * engine process owns the segment (ui_remote_server_create) and the real
+ * backend, applies the texture edits to it and renders the latest frame.
+ * The font atlas and image pages reach the engine the same way, as texture
+ * edits, once. Input goes the other way through a second ring.
+ *
+ * Draw data format: a frame is one message holding its commands (texture
+ * ids are the tool's, mapped by the engine), then the vertices and indices
+ * as the context recorded them. The engine renders straight out of the
+ * segment, so the vertex payload is written once, by the tool, and never
+ * copied again. Frames are sent as deltas: a vertex or index array equal to
+ * the previous frame's is not sent again, the engine keeps using the one it
+ * has, and a frame equal to the previous one is not sent at all.
+ *
+ * A crash or stall of the tool never blocks the engine. ui_remote_server_update
+ * only takes what has been published and validates every message; the
+ * engine keeps drawing the last good frame until a new one arrives, and
+ * ui_remote_server_connected tells whether the tool is still alive. If the
+ * engine lags, the tool drops frames rather than wait; only texture edits
+ * wait for room.
+ *
+ * A malformed message makes the engine drop everything the tool sent. The
+ * segment counts these resets, and the tool keeps a copy of every texture
+ * to send again when it sees one, so the tool's UI comes back by itself.
+ *
+ * Signalling goes through futexes in the segment on Linux (short sleeps
+ * elsewhere), and only when the other side is actually waiting.
+ *
+ * Example of usage (engine):
+ *   UIRemoteServer* server = ui_remote_server_create("/tool-ui", gl_backend, NULL);
+ *   ... spawn the tool, then every frame:
+ *   ui_remote_server_push_event(server, &event);   // input meant for the tool
+ *   ui_remote_server_update(server);
+ *   ui_remote_server_render(server);
+ *
+ * Example of usage (tool):
+ *   UIRenderBackend* remote = ui_backend_remote_create("/tool-ui", NULL);
+ *   UIContextDesc desc = {.width = 800, .height = 600, .backend = remote};
+ *   UIContext* ui = ui_create_context_ex(&desc);
+ *   while (ui_backend_remote_connected(remote)) {
+ *     ui_backend_remote_wait(remote, 16);
+ *     ui_backend_remote_poll_input(remote, ui);
+ *     ui_begin_frame(ui, dt);
+ *     ...
+ *     ui_end_frame(ui);
+ *   }
+ */
+
+#define UI_REMOTE_VERSION      2
+#define UI_REMOTE_DEFAULT_RING (32 << 20) // Bytes of messages in flight, frames may take half
+#define UI_REMOTE_MAX_TEXTURES 4096       // Textures a tool may have at once
+
+typedef struct UIRemoteServer UIRemoteServer;
+
+typedef struct UIRemoteDesc {
+  size_t ring_size;             // Draw ring size, 0: UI_REMOTE_DEFAULT_RING
+  uint32_t input_events;        // Input events buffered toward the tool, 0: 1024
+  const UIAllocator* allocator; // NULL: malloc/free
+} UIRemoteDesc;
+
+/*
+ * @brief Create the shared-memory segment a tool connects to
+ *
+ * A segment left behind by a crashed engine under the same name is replaced.
+ *
+ * @param name POSIX shared-memory name, e.g. "/tool-ui"
+ * @param backend Backend the tool's textures and frames go to (not owned)
+ * @param desc Settings, or NULL for the defaults
+ * @return The server, or NULL on failure
+ */
+UI_API UIRemoteServer* ui_remote_server_create(const char* name, UIRenderBackend* backend,
+  const UIRemoteDesc* desc);
+
+/*
+ * @brief Destroy the tool's textures and remove the segment
+ *
+ * @param server The server (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_remote_server_destroy(UIRemoteServer* server);
+
+/*
+ * @brief Apply everything the tool published, never waits
+ *
+ * @param server The server
+ * @return true if a new frame arrived
+ */
+UI_API bool ui_remote_server_update(UIRemoteServer* server);
+
+/*
+ * @brief Drop the tool's textures and frame and have the tool send them again
+ *
+ * For when the backend's textures are gone, e.g. after a lost GL context.
+ * A malformed message resets the same way. The tool notices on its next
+ * texture edit or frame and sends every texture and a whole frame again;
+ * until that frame arrives there is nothing to render.
+ *
+ * @param server The server
+ * @return void
+ */
+UI_API void ui_remote_server_reset(UIRemoteServer* server);
+
+/*
+ * @brief Render the latest frame through the backend, if there is one
+ *
+ * @param server The server
+ * @return void
+ */
+UI_API void ui_remote_server_render(UIRemoteServer* server);
+
+/*
+ * @brief Send an input event to the tool
+ *
+ * @param server The server
+ * @param event The event, a time_ns of 0 is replaced by the current time
+ * @return false if the tool's input ring is full
+ */
+UI_API bool ui_remote_server_push_event(UIRemoteServer* server, const UIInputEvent* event);
+
+/*
+ * @brief Check whether a tool is attached and its process alive
+ *
+ * @param server The server
+ * @return true while a tool is connected
+ */
+UI_API bool ui_remote_server_connected(UIRemoteServer* server);
+
+/*
+ * @brief Block until the tool publishes something, for a dedicated render thread
+ *
+ * @param server The server
+ * @param timeout_ms Longest wait
+ * @return true if there is something to update
+ */
+UI_API bool ui_remote_server_wait(UIRemoteServer* server, int timeout_ms);
+
+/*
+ * @brief Connect to an engine's segment and get a backend writing to it
+ *
+ * Only one tool may be connected to a segment at a time. The backend keeps
+ * a CPU copy of every texture, to send it again after an engine reset.
+ *
+ * @param name The name the engine created the segment with
+ * @param allocator Allocator for the backend, or NULL for malloc/free
+ * @return The backend, destroy it with backend->destroy(backend) after the context
+ */
+UI_API UIRenderBackend* ui_backend_remote_create(const char* name, const UIAllocator* allocator);
+
+/*
+ * @brief Push the input the engine sent into a context, call before ui_begin_frame
+ *
+ * @param backend A backend created by ui_backend_remote_create
+ * @param ctx The context to feed
+ * @return Number of events pushed
+ */
+UI_API int ui_backend_remote_poll_input(UIRenderBackend* backend, UIContext* ctx);
+
+/*
+ * @brief Block until the engine sends input
+ *
+ * @param backend A backend created by ui_backend_remote_create
+ * @param timeout_ms Longest wait
+ * @return true if input is waiting
+ */
+UI_API bool ui_backend_remote_wait(UIRenderBackend* backend, int timeout_ms);
+
+/*
+ * @brief Check whether the engine side is still alive
+ *
+ * @param backend A backend created by ui_backend_remote_create
+ * @return false once the engine has gone
+ */
+UI_API bool ui_backend_remote_connected(UIRenderBackend* backend);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_SERIES_H
+#define UI_SERIES_H
+
+#include <ui_core.h>
+
+/*
+ * Lock-free time series: a ring of float samples that a producer thread
+ * appends to while any number of readers (plots, readouts) look at it.
+ *
+ * Alongside the samples the ring keeps a min/max pyramid: level k holds the
+ * minimum and maximum of every aligned block of 2^k samples, filled in as
+ * blocks complete, so appending stays O(1) amortized and the min/max of any
+ * range costs O(log length). Zoomed-out plots of hours of data read a few
+ * pyramid entries per pixel column instead of the samples.
+ *
+ * Samples are numbered from 0 since creation. Readers take a snapshot, a
+ * range of samples that stays in the ring while the producer keeps going,
+ * read it in place (no copy) and may check afterwards that the producer did
+ * not lap them. The newest 1/16 of the ring is kept free for that, so a
+ * reader has that many appends' worth of time before its data is reused.
+ *
+ * One producer per series; appending from several threads at once needs one
+ * series each or a lock around the appends. Samples must be finite.
+ *
+ * Example of usage:
+ *   UISeries* series = ui_series_create(1 << 24, NULL);
+ *   ... producer thread:
+ *   ui_series_push(series, value);
+ *   ... UI thread:
+ *   UISeriesSnapshot snapshot = ui_series_snapshot(series);
+ *   UIPlotDesc desc = {.series = &snapshot, .view_start = snapshot.end - 100000.0, ...};
+ *   ui_plot(ui, plot, bounds, &desc);
+ */
+
+typedef struct UISeries UISeries;
+
+typedef struct UISeriesSnapshot {
+  const UISeries* series;
+  uint64_t begin;         // Oldest sample readable
+  uint64_t end;           // One past the newest sample
+} UISeriesSnapshot;
+
+/*
+ * @brief Create a series
+ *
+ * @param capacity Samples kept, rounded up to a power of two (at least 64)
+ * @param allocator Allocator for the ring and pyramid, or NULL for malloc/free
+ * @return The series, or NULL on failure
+ */
+UI_API UISeries* ui_series_create(size_t capacity, const UIAllocator* allocator);
+
+/*
+ * @brief Destroy a series, once no thread uses it anymore
+ *
+ * @param series The series (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_series_destroy(UISeries* series);
+
+/*
+ * @brief Append one sample (producer thread only)
+ *
+ * @param series The series
+ * @param value The sample
+ * @return void
+ */
+UI_API void ui_series_push(UISeries* series, float value);
+
+/*
+ * @brief Append samples (producer thread only)
+ *
+ * @param series The series
+ * @param values The samples
+ * @param count Number of samples
+ * @return void
+ */
+UI_API void ui_series_push_many(UISeries* series, const float* values, size_t count);
+
+/*
+ * @brief Get the samples currently readable, from any thread
+ *
+ * @param series The series
+ * @return The snapshot, empty (begin == end) before the first sample
+ */
+UI_API UISeriesSnapshot ui_series_snapshot(const UISeries* series);
+
+/*
+ * @brief Check that nothing read from a snapshot has been overwritten since it was taken
+ *
+ * @param snapshot The snapshot
+ * @return false if the producer lapped the reader, what was read is then unreliable
+ */
+UI_API bool ui_series_snapshot_valid(const UISeriesSnapshot* snapshot);
+
+/*
+ * @brief Get the samples from index on that are contiguous in memory
+ *
+ * @param snapshot The snapshot
+ * @param index First sample wanted, in [begin, end)
+ * @param samples Receives a pointer to sample index
+ * @return Number of samples at *samples, up to the ring's wrap or the snapshot's end
+ */
+UI_API size_t ui_series_span(const UISeriesSnapshot* snapshot, uint64_t index, const float** samples);
+
+/*
+ * @brief Get the minimum and maximum of samples [first, last) through the pyramid
+ *
+ * @param snapshot The snapshot
+ * @param first First sample, at least snapshot->begin
+ * @param last One past the last sample, at most snapshot->end and above first
+ * @param out_min Receives the minimum
+ * @param out_max Receives the maximum
+ * @return void
+ */
+UI_API void ui_series_min_max(const UISeriesSnapshot* snapshot, uint64_t first, uint64_t last,
+  float* out_min, float* out_max);
+
+#endif
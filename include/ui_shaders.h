@@ -7,16 +7,39 @@
   #define UI_API __attribute__ ((visibility("default")))
 #endif
 #include <stdbool.h>  
+#include <ui_memory.h>
 
-// Shader compilation
+// Shader compilation, cached in the per-user directory (see ui_compile_shader_cached)
 UI_API unsigned int ui_compile_shader(const char* vertex_src, const char* fragment_src);
 UI_API unsigned int ui_compile_shader_from_files(const char* vertex_file, const char* fragment_file);
 
-// Predefined shaders
-UI_API unsigned int ui_create_ui_shader(void);
-UI_API unsigned int ui_create_solid_shader(void);
-UI_API unsigned int ui_create_rounded_shader(void);
-UI_API unsigned int ui_create_batch_shader(void);
+/*
+ * @brief Compile a shader program, keeping linked programs on disk for later runs
+ *
+ * The program is loaded with glProgramBinary when a binary for the same
+ * sources and driver exists in cache_dir, and compiled and saved there
+ * otherwise. Without GL 4.1 or ARB_get_program_binary it is always
+ * compiled. Nothing is kept between calls, so threads with their own GL
+ * contexts may use different directories.
+ *
+ * The default directory is per user: %LOCALAPPDATA%\TridmeUI on Windows,
+ * $XDG_CACHE_HOME/tridme-ui or ~/.cache/tridme-ui elsewhere, created when
+ * missing. Without it programs are compiled uncached.
+ *
+ * @param vertex_src Vertex shader source
+ * @param fragment_src Fragment shader source
+ * @param cache_dir Existing directory for the binaries, NULL for the default, "" to compile without a cache
+ * @param allocator Allocator for binaries being read or written, or NULL for malloc/free
+ * @return The program, 0 on failure
+ */
+UI_API unsigned int ui_compile_shader_cached(const char* vertex_src, const char* fragment_src,
+  const char* cache_dir, const UIAllocator* allocator);
+
+// Predefined shaders, cache_dir and allocator as for ui_compile_shader_cached
+UI_API unsigned int ui_create_ui_shader(const char* cache_dir, const UIAllocator* allocator);
+UI_API unsigned int ui_create_solid_shader(const char* cache_dir, const UIAllocator* allocator);
+UI_API unsigned int ui_create_rounded_shader(const char* cache_dir, const UIAllocator* allocator);
+UI_API unsigned int ui_create_batch_shader(const char* cache_dir, const UIAllocator* allocator);
 
 // Uniform setters
 UI_API void ui_set_uniform_mat4(unsigned int shader, const char* name, const float* matrix);
@@ -0,0 +1,147 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_TABLE_H
+#define UI_TABLE_H
+
+#include <ui_core.h>
+
+/*
+ * Tables of any size, virtualized in both directions.
+ *
+ * Cells are not stored: each frame the table asks the host's cell callback
+ * for the text of the cells in view only, so a frame costs what the visible
+ * cells cost, whatever the row and column counts. The header row stays in
+ * place while the rows scroll.
+ *
+ * Columns without a fixed width fit their widest cell. The table measures
+ * every cell of such a column once, a budget of cells per frame, and keeps
+ * the widths; after that, only appended rows and cells reported through
+ * ui_table_cell_changed are measured again. A column shrinks only after a
+ * new pass over it, started when its widest cell changes.
+ *
+ * Clicking a header sorts by that column, clicking again reverses the
+ * order. Sorting permutes an array of row indices, the host's data is never
+ * moved; ui_table_data_row maps a displayed row back to the data. A sorted
+ * table keeps the sort column's keys: appended rows and rows whose sort cell
+ * is reported changed are fetched again and moved into place alone, rows
+ * past a smaller row count just leave the order. Only changing the sort or
+ * reporting every cell changed sorts all rows again.
+ *
+ * Example of usage:
+ *   static size_t cell(void* user, uint32_t row, uint32_t column, char* buffer, size_t size) {
+ *     return (size_t)snprintf(buffer, size, "%g", values[row][column]);
+ *   }
+ *   UITable* table = ui_table_create(NULL);
+ *   ...
+ *   UITableColumn columns[50] = {{"Name", 0.0f}, ...};
+ *   UITableDesc desc = {.columns = columns, .column_count = 50, .row_count = 100000,
+ *                       .cell = cell};
+ *   ui_table(ui, "results", (rect){{0, 0}, {1200, 800}}, table, &desc);
+ */
+
+#define UI_TABLE_MAX_CELL   256    // Longest cell text in bytes, longer text is cut
+#define UI_TABLE_FIT_BUDGET 4096   // Cells measured per frame for auto-fit widths
+#define UI_TABLE_NONE       UINT32_MAX
+
+typedef struct UITable UITable;
+
+/*
+ * Cell text callback: write the text of a cell into buffer (size bytes,
+ * NUL not needed) and return its length. Called only for visible cells,
+ * cells being measured and, while sorting, the cells of the sort column.
+ */
+typedef size_t (*UITableCellFn)(void* user, uint32_t row, uint32_t column, char* buffer, size_t size);
+
+/*
+ * Optional row comparison for sorting, <0, 0 or >0 like strcmp. Without
+ * it, cells compare as numbers when both parse as one, as text otherwise.
+ */
+typedef int (*UITableCompareFn)(void* user, uint32_t row_a, uint32_t row_b, uint32_t column);
+
+typedef struct UITableColumn {
+  const char* title;
+  float width;            // Pixels, 0: fit the widest cell
+} UITableColumn;
+
+typedef struct UITableDesc {
+  const UITableColumn* columns;
+  uint32_t column_count;
+  uint32_t row_count;
+  UITableCellFn cell;
+  UITableCompareFn compare; // NULL: compare cell text
+  void* user;
+} UITableDesc;
+
+/*
+ * @brief Create the state of one table
+ *
+ * @param allocator Allocator for the row order and column caches, or NULL for malloc/free
+ * @return The table, or NULL on failure
+ */
+UI_API UITable* ui_table_create(const UIAllocator* allocator);
+
+/*
+ * @brief Destroy a table
+ *
+ * @param table The table (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_table_destroy(UITable* table);
+
+/*
+ * @brief Report that a cell's text changed, so its column width and the sort stay right
+ *
+ * @param table The table
+ * @param row Data row, or UI_TABLE_NONE when any cell may have changed
+ * @param column Column, or UI_TABLE_NONE for every column of the row
+ * @return void
+ */
+UI_API void ui_table_cell_changed(UITable* table, uint32_t row, uint32_t column);
+
+/*
+ * @brief Sort by a column, applied on the next ui_table
+ *
+ * @param table The table
+ * @param column Column to sort by, or UI_TABLE_NONE for the data order
+ * @param descending Largest first
+ * @return void
+ */
+UI_API void ui_table_sort(UITable* table, uint32_t column, bool descending);
+
+/*
+ * @brief Map a displayed row to the data row shown there
+ *
+ * @param table The table
+ * @param display_row Row as displayed, after sorting
+ * @return The data row
+ */
+UI_API uint32_t ui_table_data_row(const UITable* table, uint32_t display_row);
+
+/*
+ * @brief Get the selected row
+ *
+ * @param table The table
+ * @return The data row last clicked, or UI_TABLE_NONE
+ */
+UI_API uint32_t ui_table_selection(const UITable* table);
+
+/*
+ * @brief Render the visible cells of a table and handle scrolling, sorting and selection
+ *
+ * The mouse wheel scrolls the rows, or the columns over the header. Once
+ * clicked, arrow keys, Page Up/Down, Home and End scroll too.
+ *
+ * @param ctx The UI context
+ * @param id Unique id for focus tracking
+ * @param bounds The table area
+ * @param table The table's state
+ * @param desc Columns and rows to show
+ * @return void
+ */
+UI_API void ui_table(UIContext* ctx, const char* id, rect bounds, UITable* table,
+  const UITableDesc* desc);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_TREE_H
+#define UI_TREE_H
+
+#include <ui_core.h>
+
+/*
+ * Tree view over a hierarchy the host owns, of any size.
+ *
+ * The tree never enumerates children. The host answers how many children
+ * a node has and which node is the child at an index, on demand, so
+ * expanding a node with 100k children costs one child count; only the rows
+ * in view ever have their node and label fetched.
+ *
+ * Expansion state lives in the UITree, keyed by node id. For every expanded
+ * node it keeps the number of rows below it, updated along the path to the
+ * root when a node expands or collapses, so finding the node on a given
+ * row costs the depth times the expanded siblings on the way, and a frame
+ * costs the visible rows, never the whole tree. Collapsing a node keeps
+ * the expansion of the nodes below it for when it opens again.
+ *
+ * Node ids must be unique in the tree and stable. When the children of an
+ * expanded node change, report it with ui_tree_node_changed.
+ *
+ * Example of usage:
+ *   static uint32_t child_count(void* user, uint64_t node) { return scene_child_count(node); }
+ *   static uint64_t child(void* user, uint64_t node, uint32_t index) { ... }
+ *   static size_t label(void* user, uint64_t node, char* buffer, size_t size) { ... }
+ *   UITree* tree = ui_tree_create(NULL);
+ *   ...
+ *   UITreeDesc desc = {.root = scene_root, .child_count = child_count, .child = child,
+ *                      .label = label};
+ *   ui_tree(ui, "outliner", (rect){{0, 0}, {300, 800}}, tree, &desc);
+ */
+
+#define UI_TREE_MAX_LABEL 256         // Longest label in bytes, longer labels are cut
+#define UI_TREE_NONE      UINT64_MAX
+
+typedef struct UITree UITree;
+
+typedef struct UITreeDesc {
+  uint64_t root;          // Not shown, its children are the top-level rows
+  uint32_t (*child_count)(void* user, uint64_t node);
+  uint64_t (*child)(void* user, uint64_t node, uint32_t index);
+  size_t (*label)(void* user, uint64_t node, char* buffer, size_t size); // Length written, no NUL needed
+  void* user;
+} UITreeDesc;
+
+/*
+ * @brief Create the state of one tree view
+ *
+ * @param allocator Allocator for the expansion state, or NULL for malloc/free
+ * @return The tree, or NULL on failure
+ */
+UI_API UITree* ui_tree_create(const UIAllocator* allocator);
+
+/*
+ * @brief Destroy a tree view
+ *
+ * @param tree The tree (NULL is ignored)
+ * @return void
+ */
+UI_API void ui_tree_destroy(UITree* tree);
+
+/*
+ * @brief Report that a node's children changed, applied on the next ui_tree
+ *
+ * @param tree The tree
+ * @param node The node whose children were added, removed or reordered,
+ *             or UI_TREE_NONE when any node may have changed
+ * @return void
+ */
+UI_API void ui_tree_node_changed(UITree* tree, uint64_t node);
+
+/*
+ * @brief Check whether a node is expanded
+ *
+ * @param tree The tree
+ * @param node The node
+ * @return true if the node is expanded
+ */
+UI_API bool ui_tree_expanded(const UITree* tree, uint64_t node);
+
+/*
+ * @brief Get the selected node
+ *
+ * @param tree The tree
+ * @return The node last clicked, or UI_TREE_NONE
+ */
+UI_API uint64_t ui_tree_selection(const UITree* tree);
+
+/*
+ * @brief Render the visible rows of a tree and handle scrolling, expansion and selection
+ *
+ * Clicking a row selects its node, clicking its arrow or double-clicking
+ * it expands or collapses it. The mouse wheel scrolls; once clicked,
+ * Up/Down, Page Up/Down, Home and End scroll too.
+ *
+ * @param ctx The UI context
+ * @param id Unique id for focus tracking
+ * @param bounds The tree area
+ * @param tree The tree's state
+ * @param desc The hierarchy to show
+ * @return void
+ */
+UI_API void ui_tree(UIContext* ctx, const char* id, rect bounds, UITree* tree, const UITreeDesc* desc);
+
+#endif
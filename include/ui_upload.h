@@ -0,0 +1,115 @@
+/*
+ * Part of Tridme Engine Project
+ * (C) Kincir Angin Studio 2025
+ */
+
+#ifndef UI_UPLOAD_H
+#define UI_UPLOAD_H
+
+#include <ui_core.h>
+#include <ui_backend.h>
+
+/*
+ * Incremental texture uploads.
+ *
+ * A texture whose pixels stay in CPU memory, an atlas that gains glyphs or
+ * images at runtime for instance, is registered with ui_texture_track. Edits
+ * to the CPU copy are reported as dirty rectangles; touching or overlapping
+ * ones are merged. ui_end_frame uploads them through the backend's
+ * update_texture (glTexSubImage2D from a ring of pixel buffers with the GL
+ * backend) before rendering, so only changed texels travel.
+ *
+ * Every frame may upload up to the context's budget (UIContextDesc.
+ * upload_budget). Urgent rectangles, texels this frame draws with, always go
+ * out in full. The rest are uploaded oldest first, row by row, and whatever
+ * does not fit waits for the next frame, so a large edit is spread out
+ * instead of causing a hitch. At least one row moves per frame.
+ *
+ * Call these from the thread that owns the context, between or during frames.
+ *
+ * Example of usage:
+ *   ui_texture_track(ui, atlas_texture, UI_TEXTURE_RGBA8, atlas, 1024, 1024, 1024 * 4);
+ *   ...
+ *   blit_image(atlas, x, y, w, h);
+ *   ui_texture_mark_dirty(ui, atlas_texture, x, y, w, h, false);
+ */
+
+#define UI_UPLOAD_MAX_TEXTURES 16
+#define UI_UPLOAD_MAX_RECTS    16     // Per texture, more are merged into the closest
+#define UI_UPLOAD_DEFAULT_BUDGET (1 << 20)
+
+typedef struct UIDirtyRect {
+  int x, y, width, height;
+  bool urgent;
+} UIDirtyRect;
+
+typedef struct UITrackedTexture {
+  ui_texture_id texture;
+  UITextureFormat format;
+  const unsigned char* pixels;  // CPU copy, read when uploading
+  int width, height, stride;
+  UIDirtyRect dirty[UI_UPLOAD_MAX_RECTS];  // Oldest first
+  int dirty_count;
+} UITrackedTexture;
+
+typedef struct UIUploadQueue {
+  UIAllocator allocator;
+  UITrackedTexture textures[UI_UPLOAD_MAX_TEXTURES];
+  int texture_count;
+  int next_texture;             // Deferred work starts here, rotating every frame
+} UIUploadQueue;
+
+/*
+ * @brief Register the CPU copy of a texture for incremental uploads
+ *
+ * @param ctx The UI context, its backend must implement update_texture
+ * @param texture Texture created by the context's backend
+ * @param format Pixel format of the texture and of pixels
+ * @param pixels CPU copy, must stay valid while tracked
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param stride Bytes between rows of pixels
+ * @return false if the backend cannot update textures or too many are tracked
+ */
+UI_API bool ui_texture_track(UIContext* ctx, ui_texture_id texture, UITextureFormat format,
+  const void* pixels, int width, int height, int stride);
+
+/*
+ * @brief Stop tracking a texture, pending uploads are dropped
+ *
+ * @param ctx The UI context
+ * @param texture The texture
+ * @return void
+ */
+UI_API void ui_texture_untrack(UIContext* ctx, ui_texture_id texture);
+
+/*
+ * @brief Report changed texels of a tracked texture
+ *
+ * @param ctx The UI context
+ * @param texture The texture
+ * @param x Left edge
+ * @param y Top edge
+ * @param width Width, clipped to the texture
+ * @param height Height, clipped to the texture
+ * @param urgent Upload before this frame renders regardless of the budget
+ * @return void
+ */
+UI_API void ui_texture_mark_dirty(UIContext* ctx, ui_texture_id texture, int x, int y,
+  int width, int height, bool urgent);
+
+/*
+ * @brief Bytes still waiting to be uploaded
+ *
+ * @param ctx The UI context
+ * @return The byte count
+ */
+UI_API size_t ui_texture_pending_bytes(UIContext* ctx);
+
+// Upload within the frame budget, called by ui_end_frame (internal use)
+UI_API void ui_uploads_flush(UIContext* ctx);
+
+// Free the queue, called by ui_destroy_context (internal use)
+UI_API void ui_upload_queue_destroy(UIUploadQueue* queue);
+
+#endif
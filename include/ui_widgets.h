@@ -7,6 +7,26 @@
 // Widget IDs
 typedef uint32_t ui_id;
 
+/*
+ * @brief Hash a widget's string id, as every built-in widget does
+ *
+ * @param str The id or label
+ * @return The widget id
+ */
+UI_API ui_id ui_get_id(const char* str);
+
+/*
+ * @brief Count a widget in the frame stats and test it against the clip rect
+ *
+ * For widgets living outside this file: handle input first, then skip
+ * drawing when this returns false.
+ *
+ * @param ctx The UI context
+ * @param extent Everything the widget draws into
+ * @return true if any of extent is visible
+ */
+UI_API bool ui_widget_visible(UIContext* ctx, rect extent);
+
 /*
  * @brief Render a button widget and handle interaction
  *
@@ -20,6 +40,15 @@ typedef uint32_t ui_id;
  */
 UI_API bool ui_button(UIContext* ctx, const char* label, rect bounds);
 
+/*
+ * @brief Get the size ui_button gives itself when its bounds are zero
+ *
+ * @param ctx The UI context
+ * @param label The button's label
+ * @return The label's width and the font size, plus padding
+ */
+UI_API vec2 ui_button_size(UIContext* ctx, const char* label);
+
 /*
  * @brief Draw a simple centered text label
  *
@@ -0,0 +1,357 @@
+/*
+ * Tridme UI OpenGL Backend
+ *
+ * OpenGL 3.3 core implementation of UIRenderBackend.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_backend_gl.h>
+#include <ui_shaders.h>
+#include <GL/glew.h>
+#include <string.h>
+#include <stdio.h>
+
+#define UI_GL_TIMER_QUERIES 4
+#define UI_GL_UPLOAD_BUFFERS 3          // Pixel unpack buffers cycled through
+#define UI_GL_UPLOAD_BUFFER_SIZE (1 << 20)
+
+typedef struct {
+  UIRenderBackend base;
+  UIAllocator allocator;
+
+  unsigned int shader;
+  char* shader_cache_dir; // Copy of the program binary cache directory, NULL: the default
+  unsigned int vao, vbo, ebo;
+
+  // Uniform locations, looked up once
+  int loc_projection;
+  int loc_color;
+  int loc_textures;
+
+  UIBackendCounters counters;
+
+  // Texture updates are staged in pixel unpack buffers that are orphaned
+  // before reuse, so writing one never waits for a copy still in flight
+  unsigned int upload_buffers[UI_GL_UPLOAD_BUFFERS];
+  size_t upload_sizes[UI_GL_UPLOAD_BUFFERS];
+  size_t upload_offset;             // Next free byte in the current buffer
+  int upload_current;
+
+  // GL_TIME_ELAPSED queries in flight, oldest first. Results are read once
+  // available (usually 2-3 frames later); with all slots busy a frame is
+  // simply not timed rather than waiting on the GPU.
+  unsigned int timer_queries[UI_GL_TIMER_QUERIES];
+  uint64_t timer_frames[UI_GL_TIMER_QUERIES];
+  int timer_head;
+  int timer_count;
+} ui_gl_backend;
+
+// GL calls made through the backend are counted, the totals feed benchmarks and stats
+#define GL_COUNTED(gl, call) do { (gl)->counters.api_calls++; call; } while (0)
+
+static ui_texture_id gl_create_texture(void* user, int width, int height, UITextureFormat format,
+  const void* pixels) {
+  ui_gl_backend* gl = (ui_gl_backend*)user;
+
+  unsigned int texture;
+  GL_COUNTED(gl, glGenTextures(1, &texture));
+  GL_COUNTED(gl, glBindTexture(GL_TEXTURE_2D, texture));
+
+  if (format == UI_TEXTURE_A8) {
+    GL_COUNTED(gl, glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_COUNTED(gl, glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels));
+    GL_COUNTED(gl, glPixelStorei(GL_UNPACK_ALIGNMENT, 4)); // Reset to default
+  } else {
+    GL_COUNTED(gl, glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+  }
+  if (pixels) {
+    gl->counters.bytes_uploaded += (uint64_t)width * height * (format == UI_TEXTURE_A8 ? 1 : 4);
+  }
+
+  GL_COUNTED(gl, glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+  GL_COUNTED(gl, glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+  GL_COUNTED(gl, glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+  GL_COUNTED(gl, glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+  return (ui_texture_id)texture;
+}
+
+static void gl_destroy_texture(void* user, ui_texture_id texture) {
+  ui_gl_backend* gl = (ui_gl_backend*)user;
+  unsigned int name = (unsigned int)texture;
+  GL_COUNTED(gl, glDeleteTextures(1, &name));
+}
+
+// Room for `bytes` in a staging buffer, moving to the next one when the current is full
+static size_t reserve_upload(ui_gl_backend* gl, size_t bytes) {
+  size_t offset = (gl->upload_offset + 3) & ~(size_t)3;
+  int current = gl->upload_current;
+
+  if (!gl->upload_buffers[0]) {
+    GL_COUNTED(gl, glGenBuffers(UI_GL_UPLOAD_BUFFERS, gl->upload_buffers));
+    offset = gl->upload_sizes[current] = 0;
+  }
+
+  GL_COUNTED(gl, glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->upload_buffers[current]));
+  if (offset + bytes > gl->upload_sizes[current]) {
+    if (gl->upload_sizes[current] > 0) {
+      current = gl->upload_current = (current + 1) % UI_GL_UPLOAD_BUFFERS;
+      GL_COUNTED(gl, glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->upload_buffers[current]));
+    }
+    size_t size = bytes > UI_GL_UPLOAD_BUFFER_SIZE ? bytes : UI_GL_UPLOAD_BUFFER_SIZE;
+    GL_COUNTED(gl, glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_DRAW));
+    gl->upload_sizes[current] = size;
+    offset = 0;
+  }
+
+  gl->upload_offset = offset + bytes;
+  return offset;
+}
+
+static void gl_update_texture(void* user, ui_texture_id texture, UITextureFormat format,
+  int x, int y, int width, int height, const void* pixels, int stride) {
+  ui_gl_backend* gl = (ui_gl_backend*)user;
+  size_t bpp = format == UI_TEXTURE_A8 ? 1 : 4;
+  size_t row_bytes = (size_t)width * bpp;
+  size_t bytes = row_bytes * height;
+  if (bytes == 0) return;
+
+  size_t offset = reserve_upload(gl, bytes);
+
+  // Only untouched bytes of a freshly orphaned buffer are mapped, no sync needed
+  unsigned char* staging = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, (GLintptr)offset,
+    (GLsizeiptr)bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  gl->counters.api_calls++;
+  if (!staging) {
+    fprintf(stderr, "Failed to map the texture upload buffer\n");
+    GL_COUNTED(gl, glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    return;
+  }
+  for (int row = 0; row < height; row++) {
+    memcpy(staging + row * row_bytes, (const unsigned char*)pixels + (size_t)row * stride, row_bytes);
+  }
+  GL_COUNTED(gl, glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+  // The copy into the texture runs from the buffer on the GPU timeline
+  GL_COUNTED(gl, glBindTexture(GL_TEXTURE_2D, (unsigned int)texture));
+  if (format == UI_TEXTURE_A8) {
+    GL_COUNTED(gl, glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_COUNTED(gl, glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RED, GL_UNSIGNED_BYTE,
+      (const void*)offset));
+    GL_COUNTED(gl, glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+  } else {
+    GL_COUNTED(gl, glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+      (const void*)offset));
+  }
+  GL_COUNTED(gl, glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+  gl->counters.bytes_uploaded += bytes;
+}
+
+static void gl_render(void* user, const UIDrawData* data) {
+  ui_gl_backend* gl = (ui_gl_backend*)user;
+  if (data->command_count == 0) return;
+
+  int width = (int)data->display_size.x;
+  int height = (int)data->display_size.y;
+
+  bool timed = data->time_gpu && gl->timer_count < UI_GL_TIMER_QUERIES;
+  if (timed) {
+    if (gl->timer_queries[0] == 0) {
+      GL_COUNTED(gl, glGenQueries(UI_GL_TIMER_QUERIES, gl->timer_queries));
+    }
+    int slot = (gl->timer_head + gl->timer_count) % UI_GL_TIMER_QUERIES;
+    gl->timer_frames[slot] = data->frame;
+    GL_COUNTED(gl, glBeginQuery(GL_TIME_ELAPSED, gl->timer_queries[slot]));
+  }
+
+  // Enable blending for UI
+  GL_COUNTED(gl, glEnable(GL_BLEND));
+  GL_COUNTED(gl, glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+  GL_COUNTED(gl, glDisable(GL_DEPTH_TEST));
+  GL_COUNTED(gl, glEnable(GL_SCISSOR_TEST));
+
+  GL_COUNTED(gl, glUseProgram(gl->shader));
+  gl->counters.program_changes++;
+
+  // Create orthographic projection matrix (column-major)
+  float ortho[16] = {
+    2.0f / width, 0.0f, 0.0f, 0.0f,
+    0.0f, -2.0f / height, 0.0f, 0.0f,
+    0.0f, 0.0f, -1.0f, 0.0f,
+    -1.0f, 1.0f, 0.0f, 1.0f
+  };
+  GL_COUNTED(gl, glUniformMatrix4fv(gl->loc_projection, 1, GL_FALSE, ortho));
+
+  // Colors travel with the vertices, the uniform only tints the whole UI
+  GL_COUNTED(gl, glUniform4f(gl->loc_color, 1.0f, 1.0f, 1.0f, 1.0f));
+
+  // Command texture slot i is always sampled from unit i
+  static const int units[UI_DRAW_MAX_TEXTURES] = {0, 1, 2, 3, 4, 5, 6, 7};
+  GL_COUNTED(gl, glUniform1iv(gl->loc_textures, UI_DRAW_MAX_TEXTURES, units));
+
+  // Upload the whole frame once
+  GL_COUNTED(gl, glBindVertexArray(gl->vao));
+  GL_COUNTED(gl, glBindBuffer(GL_ARRAY_BUFFER, gl->vbo));
+  GL_COUNTED(gl, glBufferData(GL_ARRAY_BUFFER, sizeof(ui_vertex) * data->vertex_count, data->vertices, GL_STREAM_DRAW));
+
+  GL_COUNTED(gl, glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl->ebo));
+  GL_COUNTED(gl, glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * data->index_count, data->indices, GL_STREAM_DRAW));
+  gl->counters.bytes_uploaded += sizeof(ui_vertex) * data->vertex_count + sizeof(uint32_t) * data->index_count;
+
+  // Only touch state that actually changes between commands
+  ui_texture_id bound_textures[UI_DRAW_MAX_TEXTURES] = {0};
+  int active_unit = -1;
+  rect bound_clip = {{-1, -1}, {-1, -1}};
+
+  for (int i = 0; i < data->command_count; i++) {
+    const UIDrawCmd* cmd = &data->commands[i];
+    if (cmd->index_count == 0 || cmd->clip.size.x <= 0 || cmd->clip.size.y <= 0) continue;
+
+    for (int unit = 0; unit < cmd->texture_count; unit++) {
+      if (cmd->textures[unit] == bound_textures[unit]) continue;
+      if (unit != active_unit) {
+        GL_COUNTED(gl, glActiveTexture(GL_TEXTURE0 + unit));
+        active_unit = unit;
+      }
+      GL_COUNTED(gl, glBindTexture(GL_TEXTURE_2D, (unsigned int)cmd->textures[unit]));
+      bound_textures[unit] = cmd->textures[unit];
+      gl->counters.texture_changes++;
+    }
+
+    if (memcmp(&cmd->clip, &bound_clip, sizeof(rect)) != 0) {
+      // Clip rects are top-left based, GL scissor is bottom-left based
+      GL_COUNTED(gl, glScissor((int)cmd->clip.pos.x,
+                               (int)(height - (cmd->clip.pos.y + cmd->clip.size.y)),
+                               (int)cmd->clip.size.x,
+                               (int)cmd->clip.size.y));
+      bound_clip = cmd->clip;
+      gl->counters.scissor_changes++;
+    }
+
+    GL_COUNTED(gl, glDrawElements(GL_TRIANGLES, cmd->index_count, GL_UNSIGNED_INT,
+                                  (void*)(sizeof(uint32_t) * cmd->index_offset)));
+    gl->counters.draw_calls++;
+  }
+
+  GL_COUNTED(gl, glDisable(GL_SCISSOR_TEST));
+  if (active_unit > 0) GL_COUNTED(gl, glActiveTexture(GL_TEXTURE0));
+
+  if (timed) {
+    GL_COUNTED(gl, glEndQuery(GL_TIME_ELAPSED));
+    gl->timer_count++;
+  }
+}
+
+static int gl_read_gpu_timings(void* user, UIGpuTiming* out, int max) {
+  ui_gl_backend* gl = (ui_gl_backend*)user;
+  int count = 0;
+
+  while (gl->timer_count > 0 && count < max) {
+    unsigned int query = gl->timer_queries[gl->timer_head];
+    int available = 0;
+    GL_COUNTED(gl, glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available));
+    if (!available) break;
+
+    GLuint64 elapsed = 0;
+    GL_COUNTED(gl, glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed));
+    out[count].frame = gl->timer_frames[gl->timer_head];
+    out[count].duration_ns = elapsed;
+    count++;
+
+    gl->timer_head = (gl->timer_head + 1) % UI_GL_TIMER_QUERIES;
+    gl->timer_count--;
+  }
+  return count;
+}
+
+static void gl_get_counters(void* user, UIBackendCounters* out) {
+  ui_gl_backend* gl = (ui_gl_backend*)user;
+  *out = gl->counters;
+}
+
+static void gl_destroy(UIRenderBackend* backend) {
+  ui_gl_backend* gl = (ui_gl_backend*)backend;
+
+  glDeleteBuffers(1, &gl->vbo);
+  glDeleteBuffers(1, &gl->ebo);
+  glDeleteVertexArrays(1, &gl->vao);
+  glDeleteProgram(gl->shader);
+  ui_mem_free(&gl->allocator, gl->shader_cache_dir);
+  if (gl->upload_buffers[0]) {
+    glDeleteBuffers(UI_GL_UPLOAD_BUFFERS, gl->upload_buffers);
+  }
+  if (gl->timer_queries[0]) {
+    glDeleteQueries(UI_GL_TIMER_QUERIES, gl->timer_queries);
+  }
+
+  UIAllocator allocator = gl->allocator;
+  ui_mem_free(&allocator, gl);
+}
+
+UIRenderBackend* ui_backend_gl_create(const UIAllocator* allocator, const char* shader_cache_dir) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  ui_gl_backend* gl = (ui_gl_backend*)ui_mem_alloc(allocator, sizeof(ui_gl_backend));
+  if (!gl) return NULL;
+  memset(gl, 0, sizeof(ui_gl_backend));
+
+  gl->allocator = *allocator;
+  gl->base.user = gl;
+  gl->base.create_texture = gl_create_texture;
+  gl->base.destroy_texture = gl_destroy_texture;
+  gl->base.update_texture = gl_update_texture;
+  gl->base.render = gl_render;
+  gl->base.get_counters = gl_get_counters;
+  gl->base.read_gpu_timings = gl_read_gpu_timings;
+  gl->base.destroy = gl_destroy;
+
+  if (shader_cache_dir) {
+    size_t length = strlen(shader_cache_dir) + 1;
+    gl->shader_cache_dir = (char*)ui_mem_alloc(allocator, length);
+    if (!gl->shader_cache_dir) {
+      ui_mem_free(allocator, gl);
+      return NULL;
+    }
+    memcpy(gl->shader_cache_dir, shader_cache_dir, length);
+  }
+
+  gl->shader = ui_create_ui_shader(gl->shader_cache_dir, allocator);
+  if (!gl->shader) {
+    fprintf(stderr, "Failed to create the UI shader\n");
+    ui_mem_free(allocator, gl->shader_cache_dir);
+    ui_mem_free(allocator, gl);
+    return NULL;
+  }
+
+  gl->loc_projection = glGetUniformLocation(gl->shader, "projection");
+  gl->loc_color = glGetUniformLocation(gl->shader, "color");
+  gl->loc_textures = glGetUniformLocation(gl->shader, "textures");
+
+  // Setup buffers
+  glGenVertexArrays(1, &gl->vao);
+  glGenBuffers(1, &gl->vbo);
+  glGenBuffers(1, &gl->ebo);
+
+  glBindVertexArray(gl->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, gl->vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl->ebo);
+
+  // Vertex attributes
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ui_vertex), (void*)0);
+
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ui_vertex),
+                        (void*)offsetof(ui_vertex, texcoord));
+
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ui_vertex),
+                        (void*)offsetof(ui_vertex, col));
+
+  glEnableVertexAttribArray(3);
+  glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(ui_vertex),
+                         (void*)offsetof(ui_vertex, slot));
+
+  return &gl->base;
+}
@@ -0,0 +1,782 @@
+/*
+ * Tridme UI Software Backend
+ *
+ * CPU rasterizer for UIDrawData. Quads are classified once per frame
+ * (solid, 1:1 glyph, scaled/textured) and binned into horizontal bands;
+ * each band is then rasterized independently, so bands can run on
+ * different threads without synchronization.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_backend_soft.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+  #define UI_SOFT_SSE2 1
+#endif
+
+#define SOFT_BAND_HEIGHT 64
+
+typedef struct {
+  UITextureFormat format;
+  int width, height;
+  unsigned char* pixels;
+} soft_texture;
+
+enum {
+  PRIM_SOLID,       // Constant color rect
+  PRIM_GLYPH,       // A8 quad mapped 1:1 to pixels, bilinear weights are constant
+  PRIM_QUAD,        // Any other axis-aligned textured quad
+  PRIM_TRIANGLE     // Everything else
+};
+
+typedef struct {
+  int kind;
+  int x0, y0, x1, y1;         // Pixels to visit, already clipped: [x0, x1) x [y0, y1)
+  const soft_texture* tex;
+  UIPipeline pipeline;
+  unsigned char rgba[4];      // Quad color (solid color for PRIM_SOLID)
+
+  // PRIM_GLYPH: texel of pixel (0, 0) and 8-bit bilinear weights
+  int base_u, base_v;
+  int w00, w10, w01, w11;
+
+  // PRIM_QUAD: texel coordinate at the center of pixel (0, 0) and per pixel step
+  float tu, tv, du, dv;
+
+  // PRIM_TRIANGLE: first of three indices
+  uint32_t first_index;
+} soft_prim;
+
+typedef struct {
+  UIRenderBackend base;
+  UIAllocator allocator;
+  const UIJobSystem* jobs;
+
+  int width, height;
+  unsigned char* pixels;
+
+  // Per-frame data: classified primitives and per-band index lists
+  UIArena frame_arena;
+  const UIDrawData* data;
+  soft_prim* prims;
+  uint32_t** band_prims;
+  uint32_t* band_counts;
+  int band_count;
+
+  UIBackendCounters counters;
+} ui_soft_backend;
+
+typedef struct {
+  ui_soft_backend* soft;
+  int band;
+} soft_band_job;
+
+// Exact rounding division by 255 for values up to 255 * 255 * 2
+static inline int div255(int x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+static inline unsigned char to_u8(float f) {
+  if (f <= 0.0f) return 0;
+  if (f >= 1.0f) return 255;
+  return (unsigned char)(f * 255.0f + 0.5f);
+}
+
+static inline void blend_pixel(unsigned char* d, int r, int g, int b, int a) {
+  int ia = 255 - a;
+  d[0] = (unsigned char)div255(r * a + d[0] * ia);
+  d[1] = (unsigned char)div255(g * a + d[1] * ia);
+  d[2] = (unsigned char)div255(b * a + d[2] * ia);
+  d[3] = (unsigned char)div255(a * a + d[3] * ia);
+}
+
+/*
+ * Span kernels
+ */
+
+// Blend a constant color over n pixels
+static void blend_span_solid(unsigned char* dst, int n, const unsigned char c[4]) {
+  int a = c[3];
+  if (a == 0) return;
+
+  if (a == 255) {
+    uint32_t packed;
+    memcpy(&packed, c, 4);
+    for (int i = 0; i < n; i++) memcpy(dst + i * 4, &packed, 4);
+    return;
+  }
+
+  int i = 0;
+#ifdef UI_SOFT_SSE2
+  // out = (src * a + dst * (255 - a)) / 255 on 16-bit lanes, two pixels per half register
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i k = _mm_setr_epi16(c[0] * a, c[1] * a, c[2] * a, a * a,
+                                   c[0] * a, c[1] * a, c[2] * a, a * a);
+  const __m128i ia = _mm_set1_epi16((short)(255 - a));
+  const __m128i bias = _mm_set1_epi16(128);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+    __m128i lo = _mm_unpacklo_epi8(d, zero);
+    __m128i hi = _mm_unpackhi_epi8(d, zero);
+
+    lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, ia), k), bias);
+    hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, ia), k), bias);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+    _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+  }
+#endif
+
+  for (; i < n; i++) {
+    blend_pixel(dst + i * 4, c[0], c[1], c[2], a);
+  }
+}
+
+// Blend a constant color with per-pixel alpha over n pixels
+static void blend_span_alpha(unsigned char* dst, const unsigned char* alpha, int n,
+  const unsigned char c[4]) {
+  int i = 0;
+#ifdef UI_SOFT_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rgb = _mm_setr_epi16(c[0], c[1], c[2], 0, c[0], c[1], c[2], 0);
+  const __m128i amask = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+  const __m128i full = _mm_set1_epi16(255);
+  const __m128i bias = _mm_set1_epi16(128);
+
+  for (; i + 4 <= n; i += 4) {
+    uint32_t a4;
+    memcpy(&a4, alpha + i, 4);
+    if (a4 == 0) continue;
+
+    // Broadcast each pixel's alpha to its four channels
+    __m128i a16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)a4), zero);
+    __m128i a_pairs = _mm_unpacklo_epi16(a16, a16);
+    __m128i a_lo = _mm_unpacklo_epi32(a_pairs, a_pairs);
+    __m128i a_hi = _mm_unpackhi_epi32(a_pairs, a_pairs);
+
+    // Source alpha channel is the coverage-scaled alpha itself
+    __m128i s_lo = _mm_or_si128(rgb, _mm_and_si128(a_lo, amask));
+    __m128i s_hi = _mm_or_si128(rgb, _mm_and_si128(a_hi, amask));
+
+    __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+    __m128i d_lo = _mm_unpacklo_epi8(d, zero);
+    __m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, a_lo),
+                               _mm_mullo_epi16(d_lo, _mm_sub_epi16(full, a_lo)));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, a_hi),
+                               _mm_mullo_epi16(d_hi, _mm_sub_epi16(full, a_hi)));
+    lo = _mm_add_epi16(lo, bias);
+    hi = _mm_add_epi16(hi, bias);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+    _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+  }
+#endif
+
+  for (; i < n; i++) {
+    if (alpha[i]) blend_pixel(dst + i * 4, c[0], c[1], c[2], alpha[i]);
+  }
+}
+
+/*
+ * Bilinear A8 coverage of n consecutive texels with constant weights (sum 256),
+ * scaled by the color alpha: out = cov * color_a / 255. Needs t0[n] and t1[n].
+ */
+static void glyph_span_alpha(unsigned char* out, const unsigned char* t0, const unsigned char* t1,
+  int n, int w00, int w10, int w01, int w11, int color_a) {
+  int i = 0;
+#ifdef UI_SOFT_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i vw00 = _mm_set1_epi16((short)w00);
+  const __m128i vw10 = _mm_set1_epi16((short)w10);
+  const __m128i vw01 = _mm_set1_epi16((short)w01);
+  const __m128i vw11 = _mm_set1_epi16((short)w11);
+  const __m128i vca = _mm_set1_epi16((short)color_a);
+  const __m128i bias = _mm_set1_epi16(128);
+
+  for (; i + 8 <= n; i += 8) {
+    __m128i a0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(t0 + i)), zero);
+    __m128i a1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(t0 + i + 1)), zero);
+    __m128i b0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(t1 + i)), zero);
+    __m128i b1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(t1 + i + 1)), zero);
+
+    // Weights sum to 256 so the weighted sum stays below 65536
+    __m128i cov = _mm_add_epi16(_mm_mullo_epi16(a0, vw00), _mm_mullo_epi16(a1, vw10));
+    cov = _mm_add_epi16(cov, _mm_mullo_epi16(b0, vw01));
+    cov = _mm_add_epi16(cov, _mm_mullo_epi16(b1, vw11));
+    cov = _mm_srli_epi16(_mm_add_epi16(cov, bias), 8);
+
+    __m128i a = _mm_add_epi16(_mm_mullo_epi16(cov, vca), bias);
+    a = _mm_srli_epi16(_mm_add_epi16(a, _mm_srli_epi16(a, 8)), 8);
+
+    _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(a, zero));
+  }
+#endif
+
+  for (; i < n; i++) {
+    int cov = (t0[i] * w00 + t0[i + 1] * w10 + t1[i] * w01 + t1[i + 1] * w11 + 128) >> 8;
+    out[i] = (unsigned char)div255(cov * color_a);
+  }
+}
+
+/*
+ * Texture sampling (scalar paths)
+ */
+
+static inline const unsigned char* texel(const soft_texture* t, int x, int y) {
+  if (x < 0) x = 0; else if (x >= t->width) x = t->width - 1;
+  if (y < 0) y = 0; else if (y >= t->height) y = t->height - 1;
+  int bpp = t->format == UI_TEXTURE_A8 ? 1 : 4;
+  return t->pixels + ((size_t)y * t->width + x) * bpp;
+}
+
+// Bilinear sample at texel coordinates (texel centers at integers), result in 0..255
+static void sample_bilinear(const soft_texture* t, float tu, float tv, float out[4]) {
+  float fu = floorf(tu), fv = floorf(tv);
+  int x = (int)fu, y = (int)fv;
+  float ax = tu - fu, ay = tv - fv;
+
+  const unsigned char* p00 = texel(t, x, y);
+  const unsigned char* p10 = texel(t, x + 1, y);
+  const unsigned char* p01 = texel(t, x, y + 1);
+  const unsigned char* p11 = texel(t, x + 1, y + 1);
+
+  if (t->format == UI_TEXTURE_A8) {
+    // Red-only texture reads as (r, 0, 0, 1) like GL_R8
+    float r = (p00[0] * (1 - ax) + p10[0] * ax) * (1 - ay) + (p01[0] * (1 - ax) + p11[0] * ax) * ay;
+    out[0] = r; out[1] = 0; out[2] = 0; out[3] = 255;
+    return;
+  }
+
+  for (int c = 0; c < 4; c++) {
+    out[c] = (p00[c] * (1 - ax) + p10[c] * ax) * (1 - ay) + (p01[c] * (1 - ax) + p11[c] * ax) * ay;
+  }
+}
+
+// Combine a texel (0..255) with a color (0..1) according to the pipeline
+static inline void shade(UIPipeline pipeline, const float tex[4], const float col[4], int out[4]) {
+  if (pipeline == UI_PIPELINE_RGBA) {
+    for (int c = 0; c < 4; c++) out[c] = (int)(tex[c] * col[c] + 0.5f);
+  } else {
+    out[0] = (int)(col[0] * 255.0f + 0.5f);
+    out[1] = (int)(col[1] * 255.0f + 0.5f);
+    out[2] = (int)(col[2] * 255.0f + 0.5f);
+    out[3] = (int)(tex[0] * col[3] + 0.5f);
+  }
+  for (int c = 0; c < 4; c++) {
+    if (out[c] < 0) out[c] = 0; else if (out[c] > 255) out[c] = 255;
+  }
+}
+
+/*
+ * Primitive classification
+ */
+
+static void scissor_bounds(const ui_soft_backend* soft, rect clip, int* x0, int* y0, int* x1, int* y1) {
+  // Same integer truncation as the GL backend's glScissor call
+  int sx = (int)clip.pos.x;
+  int sw = (int)clip.size.x;
+  int gy = (int)(soft->height - (clip.pos.y + clip.size.y));
+  int sh = (int)clip.size.y;
+
+  *x0 = sx;
+  *x1 = sx + sw;
+  *y0 = soft->height - gy - sh;
+  *y1 = soft->height - gy;
+
+  if (*x0 < 0) *x0 = 0;
+  if (*y0 < 0) *y0 = 0;
+  if (*x1 > soft->width) *x1 = soft->width;
+  if (*y1 > soft->height) *y1 = soft->height;
+}
+
+/*
+ * First column whose center lies at or right of `edge`, and first row whose
+ * center lies strictly below it. GL applies its top-left rule in y-up window
+ * space, so on screen bottom edges own the pixel centers they pass through.
+ */
+static inline int pixel_start_x(float edge) {
+  return (int)ceilf(edge - 0.5f);
+}
+
+static inline int pixel_start_y(float edge) {
+  return (int)floorf(edge - 0.5f) + 1;
+}
+
+// Detect the a, b, c, c, d, a axis-aligned quad pattern emitted by ui_draw_list_add_quad
+static bool match_quad(const UIDrawData* data, uint32_t first, const ui_vertex** out) {
+  if (first + 6 > data->index_count) return false;
+
+  const uint32_t* idx = data->indices + first;
+  if (idx[3] != idx[2] || idx[5] != idx[0]) return false;
+
+  const ui_vertex* a = &data->vertices[idx[0]];
+  const ui_vertex* b = &data->vertices[idx[1]];
+  const ui_vertex* c = &data->vertices[idx[2]];
+  const ui_vertex* d = &data->vertices[idx[4]];
+
+  if (a->position.y != b->position.y || b->position.x != c->position.x ||
+      c->position.y != d->position.y || d->position.x != a->position.x) return false;
+  if (a->texcoord.y != b->texcoord.y || b->texcoord.x != c->texcoord.x ||
+      c->texcoord.y != d->texcoord.y || d->texcoord.x != a->texcoord.x) return false;
+  if (!(a->position.x < b->position.x) || !(a->position.y < d->position.y)) return false;
+  if (memcmp(&a->col, &b->col, sizeof(color)) != 0 || memcmp(&a->col, &c->col, sizeof(color)) != 0 ||
+      memcmp(&a->col, &d->col, sizeof(color)) != 0) return false;
+  if (a->slot != b->slot || a->slot != c->slot || a->slot != d->slot) return false;
+
+  out[0] = a;
+  out[1] = c;
+  return true;
+}
+
+static void classify_quad(ui_soft_backend* soft, soft_prim* prim, const UIDrawCmd* cmd,
+  const ui_vertex* tl, const ui_vertex* br) {
+  const soft_texture* tex = prim->tex;
+  float qx0 = tl->position.x, qy0 = tl->position.y;
+  float qx1 = br->position.x, qy1 = br->position.y;
+
+  int cx0, cy0, cx1, cy1;
+  scissor_bounds(soft, cmd->clip, &cx0, &cy0, &cx1, &cy1);
+
+  prim->x0 = pixel_start_x(qx0); prim->x1 = pixel_start_x(qx1);
+  prim->y0 = pixel_start_y(qy0); prim->y1 = pixel_start_y(qy1);
+  if (prim->x0 < cx0) prim->x0 = cx0;
+  if (prim->y0 < cy0) prim->y0 = cy0;
+  if (prim->x1 > cx1) prim->x1 = cx1;
+  if (prim->y1 > cy1) prim->y1 = cy1;
+
+  color col = tl->col;
+  float colf[4] = {col.r, col.g, col.b, col.a};
+  prim->rgba[0] = to_u8(col.r);
+  prim->rgba[1] = to_u8(col.g);
+  prim->rgba[2] = to_u8(col.b);
+  prim->rgba[3] = to_u8(col.a);
+
+  float tw = (float)tex->width, th = (float)tex->height;
+  float u0 = tl->texcoord.x * tw, v0 = tl->texcoord.y * th;
+  float u1 = br->texcoord.x * tw, v1 = br->texcoord.y * th;
+
+  // Degenerate UVs: one texel for the whole quad, fold it into the color
+  if (u0 == u1 && v0 == v1) {
+    float t[4];
+    int shaded[4];
+    sample_bilinear(tex, u0 - 0.5f, v0 - 0.5f, t);
+    shade(prim->pipeline, t, colf, shaded);
+    for (int c = 0; c < 4; c++) prim->rgba[c] = (unsigned char)shaded[c];
+    prim->kind = PRIM_SOLID;
+    return;
+  }
+
+  prim->du = (u1 - u0) / (qx1 - qx0);
+  prim->dv = (v1 - v0) / (qy1 - qy0);
+  prim->tu = u0 + (0.5f - qx0) * prim->du - 0.5f;
+  prim->tv = v0 + (0.5f - qy0) * prim->dv - 0.5f;
+
+  if (prim->pipeline == UI_PIPELINE_ALPHA && tex->format == UI_TEXTURE_A8 &&
+      fabsf(prim->du - 1.0f) < 1e-4f && fabsf(prim->dv - 1.0f) < 1e-4f) {
+    float fu = floorf(prim->tu), fv = floorf(prim->tv);
+    int wu = (int)((prim->tu - fu) * 256.0f + 0.5f);
+    int wv = (int)((prim->tv - fv) * 256.0f + 0.5f);
+
+    prim->kind = PRIM_GLYPH;
+    prim->base_u = (int)fu;
+    prim->base_v = (int)fv;
+    prim->w00 = ((256 - wu) * (256 - wv) + 128) >> 8;
+    prim->w10 = (wu * (256 - wv) + 128) >> 8;
+    prim->w01 = ((256 - wu) * wv + 128) >> 8;
+    prim->w11 = 256 - prim->w00 - prim->w10 - prim->w01;
+    return;
+  }
+
+  prim->kind = PRIM_QUAD;
+}
+
+static void classify_triangle(ui_soft_backend* soft, soft_prim* prim, const UIDrawCmd* cmd,
+  uint32_t first) {
+  const UIDrawData* data = soft->data;
+  float minx = 1e30f, miny = 1e30f, maxx = -1e30f, maxy = -1e30f;
+  for (int k = 0; k < 3; k++) {
+    vec2 p = data->vertices[data->indices[first + k]].position;
+    if (p.x < minx) minx = p.x;
+    if (p.y < miny) miny = p.y;
+    if (p.x > maxx) maxx = p.x;
+    if (p.y > maxy) maxy = p.y;
+  }
+
+  int cx0, cy0, cx1, cy1;
+  scissor_bounds(soft, cmd->clip, &cx0, &cy0, &cx1, &cy1);
+
+  prim->kind = PRIM_TRIANGLE;
+  prim->first_index = first;
+  prim->x0 = pixel_start_x(minx); prim->x1 = pixel_start_x(maxx) + 1;
+  prim->y0 = pixel_start_y(miny); prim->y1 = pixel_start_y(maxy) + 1;
+  if (prim->x0 < cx0) prim->x0 = cx0;
+  if (prim->y0 < cy0) prim->y0 = cy0;
+  if (prim->x1 > cx1) prim->x1 = cx1;
+  if (prim->y1 > cy1) prim->y1 = cy1;
+}
+
+/*
+ * Rasterization of one primitive restricted to rows [band_y0, band_y1)
+ */
+
+static void raster_solid(ui_soft_backend* soft, const soft_prim* p, int y0, int y1) {
+  int n = p->x1 - p->x0;
+  for (int y = y0; y < y1; y++) {
+    blend_span_solid(soft->pixels + ((size_t)y * soft->width + p->x0) * 4, n, p->rgba);
+  }
+}
+
+static void raster_glyph(ui_soft_backend* soft, const soft_prim* p, int y0, int y1) {
+  const soft_texture* t = p->tex;
+  int n = p->x1 - p->x0;
+  unsigned char alpha[256];
+  unsigned char row0[258], row1[258];
+
+  int u_start = p->base_u + p->x0;
+  bool inside_x = u_start >= 0 && u_start + n < t->width;
+
+  for (int y = y0; y < y1; y++) {
+    int v = p->base_v + y;
+    int va = v < 0 ? 0 : (v >= t->height ? t->height - 1 : v);
+    int vb = v + 1 < 0 ? 0 : (v + 1 >= t->height ? t->height - 1 : v + 1);
+    unsigned char* dst = soft->pixels + ((size_t)y * soft->width + p->x0) * 4;
+
+    for (int x = 0; x < n; x += 256) {
+      int span = n - x < 256 ? n - x : 256;
+      const unsigned char* t0;
+      const unsigned char* t1;
+
+      if (inside_x) {
+        t0 = t->pixels + (size_t)va * t->width + u_start + x;
+        t1 = t->pixels + (size_t)vb * t->width + u_start + x;
+      } else {
+        // Clamp to edge into scratch rows
+        for (int i = 0; i <= span; i++) {
+          row0[i] = *texel(t, u_start + x + i, va);
+          row1[i] = *texel(t, u_start + x + i, vb);
+        }
+        t0 = row0;
+        t1 = row1;
+      }
+
+      glyph_span_alpha(alpha, t0, t1, span, p->w00, p->w10, p->w01, p->w11, p->rgba[3]);
+      blend_span_alpha(dst + x * 4, alpha, span, p->rgba);
+    }
+  }
+}
+
+static void raster_quad(ui_soft_backend* soft, const soft_prim* p, int y0, int y1) {
+  float colf[4] = {p->rgba[0] / 255.0f, p->rgba[1] / 255.0f, p->rgba[2] / 255.0f, p->rgba[3] / 255.0f};
+
+  for (int y = y0; y < y1; y++) {
+    unsigned char* dst = soft->pixels + ((size_t)y * soft->width) * 4;
+    float tv = p->tv + y * p->dv;
+    for (int x = p->x0; x < p->x1; x++) {
+      float t[4];
+      int s[4];
+      sample_bilinear(p->tex, p->tu + x * p->du, tv, t);
+      shade(p->pipeline, t, colf, s);
+      if (s[3]) blend_pixel(dst + x * 4, s[0], s[1], s[2], s[3]);
+    }
+  }
+}
+
+static inline float edge_fn(vec2 a, vec2 b, float px, float py) {
+  return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+}
+
+static inline bool top_left(vec2 a, vec2 b) {
+  // Triangles are made clockwise on screen: left edges run up, bottom edges run
+  // left (GL's "top" edge, since its window space is y-up)
+  float dx = b.x - a.x, dy = b.y - a.y;
+  return (dy == 0 && dx < 0) || dy < 0;
+}
+
+static void raster_triangle(ui_soft_backend* soft, const soft_prim* p, int y0, int y1) {
+  const UIDrawData* data = soft->data;
+  const ui_vertex* v0 = &data->vertices[data->indices[p->first_index + 0]];
+  const ui_vertex* v1 = &data->vertices[data->indices[p->first_index + 1]];
+  const ui_vertex* v2 = &data->vertices[data->indices[p->first_index + 2]];
+
+  float area = edge_fn(v0->position, v1->position, v2->position.x, v2->position.y);
+  if (area == 0) return;
+  if (area < 0) {
+    const ui_vertex* tmp = v1; v1 = v2; v2 = tmp;
+    area = -area;
+  }
+
+  bool tl0 = top_left(v1->position, v2->position);
+  bool tl1 = top_left(v2->position, v0->position);
+  bool tl2 = top_left(v0->position, v1->position);
+  float tw = (float)p->tex->width, th = (float)p->tex->height;
+
+  for (int y = y0; y < y1; y++) {
+    float py = y + 0.5f;
+    unsigned char* dst = soft->pixels + ((size_t)y * soft->width) * 4;
+
+    for (int x = p->x0; x < p->x1; x++) {
+      float px = x + 0.5f;
+      float e0 = edge_fn(v1->position, v2->position, px, py);
+      float e1 = edge_fn(v2->position, v0->position, px, py);
+      float e2 = edge_fn(v0->position, v1->position, px, py);
+
+      if (e0 < 0 || e1 < 0 || e2 < 0) continue;
+      if ((e0 == 0 && !tl0) || (e1 == 0 && !tl1) || (e2 == 0 && !tl2)) continue;
+
+      float l0 = e0 / area, l1 = e1 / area, l2 = e2 / area;
+      float u = v0->texcoord.x * l0 + v1->texcoord.x * l1 + v2->texcoord.x * l2;
+      float v = v0->texcoord.y * l0 + v1->texcoord.y * l1 + v2->texcoord.y * l2;
+      float col[4] = {
+        v0->col.r * l0 + v1->col.r * l1 + v2->col.r * l2,
+        v0->col.g * l0 + v1->col.g * l1 + v2->col.g * l2,
+        v0->col.b * l0 + v1->col.b * l1 + v2->col.b * l2,
+        v0->col.a * l0 + v1->col.a * l1 + v2->col.a * l2
+      };
+
+      float t[4];
+      int s[4];
+      sample_bilinear(p->tex, u * tw - 0.5f, v * th - 0.5f, t);
+      shade(p->pipeline, t, col, s);
+      if (s[3]) blend_pixel(dst + x * 4, s[0], s[1], s[2], s[3]);
+    }
+  }
+}
+
+static void raster_band(void* arg) {
+  soft_band_job* job = (soft_band_job*)arg;
+  ui_soft_backend* soft = job->soft;
+
+  int band_y0 = job->band * SOFT_BAND_HEIGHT;
+  int band_y1 = band_y0 + SOFT_BAND_HEIGHT;
+  if (band_y1 > soft->height) band_y1 = soft->height;
+
+  const uint32_t* list = soft->band_prims[job->band];
+  for (uint32_t i = 0; i < soft->band_counts[job->band]; i++) {
+    const soft_prim* p = &soft->prims[list[i]];
+    int y0 = p->y0 > band_y0 ? p->y0 : band_y0;
+    int y1 = p->y1 < band_y1 ? p->y1 : band_y1;
+    if (y0 >= y1) continue;
+
+    switch (p->kind) {
+      case PRIM_SOLID:    raster_solid(soft, p, y0, y1); break;
+      case PRIM_GLYPH:    raster_glyph(soft, p, y0, y1); break;
+      case PRIM_QUAD:     raster_quad(soft, p, y0, y1); break;
+      case PRIM_TRIANGLE: raster_triangle(soft, p, y0, y1); break;
+    }
+  }
+}
+
+/*
+ * Backend interface
+ */
+
+static ui_texture_id soft_create_texture(void* user, int width, int height, UITextureFormat format,
+  const void* pixels) {
+  ui_soft_backend* soft = (ui_soft_backend*)user;
+  size_t size = (size_t)width * height * (format == UI_TEXTURE_A8 ? 1 : 4);
+
+  soft_texture* tex = (soft_texture*)ui_mem_alloc(&soft->allocator, sizeof(soft_texture) + size);
+  if (!tex) return 0;
+
+  tex->format = format;
+  tex->width = width;
+  tex->height = height;
+  tex->pixels = (unsigned char*)(tex + 1);
+  if (pixels) {
+    memcpy(tex->pixels, pixels, size);
+    soft->counters.bytes_uploaded += size;
+  } else {
+    memset(tex->pixels, 0, size);
+  }
+  return (ui_texture_id)tex;
+}
+
+static void soft_update_texture(void* user, ui_texture_id texture, UITextureFormat format,
+  int x, int y, int width, int height, const void* pixels, int stride) {
+  ui_soft_backend* soft = (ui_soft_backend*)user;
+  soft_texture* tex = (soft_texture*)texture;
+  if (format != tex->format) {
+    // Rows would be copied with the wrong pixel size
+    fprintf(stderr, "Texture update format does not match the texture\n");
+    return;
+  }
+  size_t bpp = format == UI_TEXTURE_A8 ? 1 : 4;
+  size_t row_bytes = (size_t)width * bpp;
+
+  for (int row = 0; row < height; row++) {
+    memcpy(tex->pixels + ((size_t)(y + row) * tex->width + x) * bpp,
+      (const unsigned char*)pixels + (size_t)row * stride, row_bytes);
+  }
+  soft->counters.bytes_uploaded += row_bytes * height;
+}
+
+static void soft_destroy_texture(void* user, ui_texture_id texture) {
+  ui_soft_backend* soft = (ui_soft_backend*)user;
+  ui_mem_free(&soft->allocator, (void*)texture);
+}
+
+static void soft_render(void* user, const UIDrawData* data) {
+  ui_soft_backend* soft = (ui_soft_backend*)user;
+  UIArena* arena = &soft->frame_arena;
+
+  ui_arena_reset(arena);
+  soft->data = data;
+
+  // Classify every primitive once (quads take one slot, triangles one each)
+  uint32_t max_prims = data->index_count / 3;
+  soft->prims = (soft_prim*)ui_arena_alloc(arena, sizeof(soft_prim) * (max_prims + 1), 0);
+  if (!soft->prims) return;
+
+  uint32_t prim_count = 0;
+  for (int c = 0; c < data->command_count; c++) {
+    const UIDrawCmd* cmd = &data->commands[c];
+    if (cmd->index_count == 0 || cmd->clip.size.x <= 0 || cmd->clip.size.y <= 0) continue;
+    soft->counters.draw_calls++;
+
+    uint32_t end = cmd->index_offset + cmd->index_count;
+    for (uint32_t i = cmd->index_offset; i + 3 <= end; ) {
+      soft_prim* prim = &soft->prims[prim_count];
+      const ui_vertex* corners[2];
+
+      // GL takes the flat slot from a triangle's last vertex, so does this
+      uint32_t slot = data->vertices[data->indices[i + 2]].slot;
+      int unit = UI_VERTEX_TEXTURE(slot);
+      prim->tex = unit < cmd->texture_count ? (const soft_texture*)cmd->textures[unit] : NULL;
+      prim->pipeline = UI_VERTEX_PIPELINE(slot);
+      if (!prim->tex) {
+        i += 3;
+        continue;
+      }
+
+      if (i + 6 <= end && match_quad(data, i, corners)) {
+        classify_quad(soft, prim, cmd, corners[0], corners[1]);
+        i += 6;
+      } else {
+        classify_triangle(soft, prim, cmd, i);
+        i += 3;
+      }
+
+      if (prim->x0 < prim->x1 && prim->y0 < prim->y1) {
+        prim_count++;
+      }
+    }
+  }
+
+  // Bin primitives into bands, keeping submission order inside each band
+  int band_count = (soft->height + SOFT_BAND_HEIGHT - 1) / SOFT_BAND_HEIGHT;
+  soft->band_count = band_count;
+  soft->band_counts = (uint32_t*)ui_arena_alloc(arena, sizeof(uint32_t) * band_count, 0);
+  soft->band_prims = (uint32_t**)ui_arena_alloc(arena, sizeof(uint32_t*) * band_count, 0);
+  soft_band_job* jobs = (soft_band_job*)ui_arena_alloc(arena, sizeof(soft_band_job) * band_count, 0);
+  void** args = (void**)ui_arena_alloc(arena, sizeof(void*) * band_count, 0);
+  if (!soft->band_counts || !soft->band_prims || !jobs || !args) return;
+
+  memset(soft->band_counts, 0, sizeof(uint32_t) * band_count);
+  for (uint32_t i = 0; i < prim_count; i++) {
+    const soft_prim* p = &soft->prims[i];
+    for (int b = p->y0 / SOFT_BAND_HEIGHT; b <= (p->y1 - 1) / SOFT_BAND_HEIGHT; b++) {
+      soft->band_counts[b]++;
+    }
+  }
+
+  for (int b = 0; b < band_count; b++) {
+    soft->band_prims[b] = (uint32_t*)ui_arena_alloc(arena, sizeof(uint32_t) * (soft->band_counts[b] + 1), 0);
+    if (!soft->band_prims[b]) return;
+    soft->band_counts[b] = 0;
+  }
+
+  for (uint32_t i = 0; i < prim_count; i++) {
+    const soft_prim* p = &soft->prims[i];
+    for (int b = p->y0 / SOFT_BAND_HEIGHT; b <= (p->y1 - 1) / SOFT_BAND_HEIGHT; b++) {
+      soft->band_prims[b][soft->band_counts[b]++] = i;
+    }
+  }
+
+  // Bands touch disjoint rows, so they rasterize without any synchronization
+  int job_count = 0;
+  for (int b = 0; b < band_count; b++) {
+    if (soft->band_counts[b] == 0) continue;
+    jobs[job_count].soft = soft;
+    jobs[job_count].band = b;
+    args[job_count] = &jobs[job_count];
+    job_count++;
+  }
+
+  ui_jobs_run(soft->jobs, raster_band, args, job_count);
+  soft->data = NULL;
+}
+
+static void soft_get_counters(void* user, UIBackendCounters* out) {
+  ui_soft_backend* soft = (ui_soft_backend*)user;
+  *out = soft->counters;
+}
+
+static void soft_destroy(UIRenderBackend* backend) {
+  ui_soft_backend* soft = (ui_soft_backend*)backend;
+  UIAllocator allocator = soft->allocator;
+
+  ui_arena_release(&soft->frame_arena);
+  ui_mem_free(&allocator, soft->pixels);
+  ui_mem_free(&allocator, soft);
+}
+
+UIRenderBackend* ui_backend_soft_create(int width, int height, const UIJobSystem* jobs,
+  const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  ui_soft_backend* soft = (ui_soft_backend*)ui_mem_alloc(allocator, sizeof(ui_soft_backend));
+  if (!soft) return NULL;
+  memset(soft, 0, sizeof(ui_soft_backend));
+
+  soft->allocator = *allocator;
+  soft->jobs = jobs;
+  soft->width = width;
+  soft->height = height;
+  soft->base.user = soft;
+  soft->base.create_texture = soft_create_texture;
+  soft->base.destroy_texture = soft_destroy_texture;
+  soft->base.update_texture = soft_update_texture;
+  soft->base.render = soft_render;
+  soft->base.get_counters = soft_get_counters;
+  soft->base.destroy = soft_destroy;
+
+  soft->pixels = (unsigned char*)ui_mem_alloc(allocator, (size_t)width * height * 4);
+  if (!soft->pixels || !ui_arena_init(&soft->frame_arena, allocator, 256 * 1024, true)) {
+    fprintf(stderr, "Failed to allocate the software render target\n");
+    soft_destroy(&soft->base);
+    return NULL;
+  }
+  memset(soft->pixels, 0, (size_t)width * height * 4);
+
+  return &soft->base;
+}
+
+void ui_backend_soft_clear(UIRenderBackend* backend, color c) {
+  ui_soft_backend* soft = (ui_soft_backend*)backend;
+  unsigned char rgba[4] = {to_u8(c.r), to_u8(c.g), to_u8(c.b), to_u8(c.a)};
+
+  uint32_t packed;
+  memcpy(&packed, rgba, 4);
+  size_t count = (size_t)soft->width * soft->height;
+  for (size_t i = 0; i < count; i++) {
+    memcpy(soft->pixels + i * 4, &packed, 4);
+  }
+}
+
+const unsigned char* ui_backend_soft_pixels(UIRenderBackend* backend, int* width, int* height) {
+  ui_soft_backend* soft = (ui_soft_backend*)backend;
+  if (width) *width = soft->width;
+  if (height) *height = soft->height;
+  return soft->pixels;
+}
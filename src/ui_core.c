@@ -1,181 +1,178 @@
 /* 
  * Tridme UI Core Rendering
  * 
- * OpenGL Implementation for Rendering Shapes and Event Handling.
+ * Shape recording and Event Handling. Rendering is delegated to a
+ * UIRenderBackend (see ui_backend.h).
  * 
  * (C) Kincir Angin Studio
  */
 
 #include <ui_core.h>
-#include <ui_shaders.h>
 #include <ui_widgets.h>
-#include <GL/glew.h>
+#include <ui_layout.h>
+#include <ui_font.h>
+#include <ui_draw.h>
+#include <ui_region.h>
+#include <ui_backend.h>
+#include <ui_backend_gl.h>
+#include <ui_shaders.h>
+#include <ui_profile.h>
+#include <ui_input.h>
+#include <ui_record.h>
+#include <ui_hit.h>
+#include <ui_upload.h>
+#include <ui_image.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
-// Vertex structure for UI rendering
-typedef struct {
-  vec2 position;
-  vec2 texcoord;
-  color col;
-} ui_vertex;
-
-static unsigned int create_texture_atlas(UIContext* ctx) {
-  // Initialize FreeType
-  FT_Library ft;
-  if (FT_Init_FreeType(&ft)) {
-    fprintf(stderr, "Could not init FreeType Library\n");
-    return 0;
-  }
-  
-  // Load font
-  FT_Face face;
-  const char* font_paths[] = {
-    "HelveticaNeueRoman.otf",
-    "../HelveticaNeueRoman.otf",
-    "../../HelveticaNeueRoman.otf",
-    "/home/naufal/Documents/Projects/C_CXX_Projects/tridme-uic/HelveticaNeueRoman.otf"
+#include <time.h>
+
+#ifndef UI_DISABLE_STATS
+static double stats_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+#endif
+
+UIContext* ui_create_context(int window_width, int window_height) {
+  UIContextDesc desc = {
+    .width = window_width,
+    .height = window_height
   };
-  
-  int loaded = 0;
-  for (int i = 0; i < 4; i++) {
-    if (FT_New_Face(ft, font_paths[i], 0, &face) == 0) {
-      loaded = 1;
-      break;
-    }
+  return ui_create_context_ex(&desc);
+}
+
+bool ui_context_init_state(UIContext* ctx, const UIAllocator* allocator,
+  size_t frame_arena_size, bool frame_arena_growth) {
+  memset(ctx, 0, sizeof(UIContext));
+  ctx->allocator = *allocator;
+
+  if (!ui_arena_init(&ctx->frame_arena, allocator, frame_arena_size, frame_arena_growth)) {
+    return false;
   }
-  
-  if (!loaded) {
-    fprintf(stderr, "Failed to load font from any path\\n");
-    FT_Done_FreeType(ft);
-    return 0;
+
+  ctx->vboxes = (VBoxState*) ui_mem_alloc(allocator, sizeof(VBoxState) * UI_MAX_VBOXES);
+  ctx->draw_list = (UIDrawList*) ui_mem_alloc(allocator, sizeof(UIDrawList));
+  if (!ctx->vboxes || !ctx->draw_list) {
+    ui_context_release_state(ctx);
+    return false;
   }
-  
-  // Set pixel size
-  FT_Set_Pixel_Sizes(face, 0, 16);
-  
-  // Create atlas dimensions
-  const int atlas_width = 512;
-  const int atlas_height = 512;
-  unsigned char* atlas_data = (unsigned char*)calloc(atlas_width * atlas_height, 1);
-  
-  // Render ASCII characters to atlas
-  int pen_x = 0;
-  int pen_y = 0;
-  int row_height = 0;
-  
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-  
-  for (unsigned char c = 32; c < 128; c++) {
-    // Load character glyph
-    if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-      fprintf(stderr, "Failed to load Glyph %c\n", c);
-      continue;
-    }
-    
-    FT_GlyphSlot g = face->glyph;
-    
-    // If we go past atlas width, move to next row
-    if (pen_x + g->bitmap.width >= atlas_width) {
-      pen_x = 0;
-      pen_y += row_height;
-      row_height = 0;
-    }
-    
-    // Copy glyph bitmap to atlas
-    for (unsigned int y = 0; y < g->bitmap.rows; y++) {
-      for (unsigned int x = 0; x < g->bitmap.width; x++) {
-        int atlas_x = pen_x + x;
-        int atlas_y = pen_y + y;
-        if (atlas_x < atlas_width && atlas_y < atlas_height) {
-          atlas_data[atlas_y * atlas_width + atlas_x] = g->bitmap.buffer[y * g->bitmap.width + x];
-        }
-      }
+  memset(ctx->vboxes, 0, sizeof(VBoxState) * UI_MAX_VBOXES);
+  memset(ctx->draw_list, 0, sizeof(UIDrawList));
+
+  ctx->margin = 10;
+  return true;
+}
+
+void ui_context_release_state(UIContext* ctx) {
+  for (int i = 0; i < UI_MAX_REGIONS; i++) {
+    if (ctx->regions[i]) {
+      ui_context_release_state(ctx->regions[i]);
+      ui_mem_free(&ctx->allocator, ctx->regions[i]);
+      ctx->regions[i] = NULL;
     }
-    
-    // Store glyph info
-    ctx->glyphs[c].x = (float)pen_x / atlas_width;
-    ctx->glyphs[c].y = (float)pen_y / atlas_height;
-    ctx->glyphs[c].width = (float)g->bitmap.width / atlas_width;
-    ctx->glyphs[c].height = (float)g->bitmap.rows / atlas_height;
-    ctx->glyphs[c].advance = g->advance.x >> 6; // Convert from 1/64th pixels
-    ctx->glyphs[c].offset_x = g->bitmap_left;
-    ctx->glyphs[c].offset_y = -g->bitmap_top;
-    
-    // Move pen for next glyph
-    pen_x += g->bitmap.width + 1; // 1 pixel padding
-    if (g->bitmap.rows > row_height) {
-      row_height = g->bitmap.rows + 1;
+  }
+
+  ui_layout_cache_destroy(ctx);
+  ui_mem_free(&ctx->allocator, ctx->draw_list);
+  ui_mem_free(&ctx->allocator, ctx->vboxes);
+  ui_arena_release(&ctx->frame_arena);
+  ctx->draw_list = NULL;
+  ctx->vboxes = NULL;
+}
+
+// Replace the placeholder texture with the font atlas once it is rasterized
+static void upload_font_atlas(UIContext* ctx) {
+  if (!ctx->atlas_pending || !ui_font_ready(ctx->font)) return;
+  ctx->atlas_pending = false;
+  if (!ctx->font->atlas_pixels) return;
+
+  UI_PROFILE_BEGIN(ctx, "atlas_upload");
+  ui_texture_id atlas = ctx->backend->create_texture(ctx->backend->user, ctx->font->atlas_width,
+    ctx->font->atlas_height, UI_TEXTURE_A8, ctx->font->atlas_pixels);
+  if (atlas) {
+    if (ctx->texture_atlas) {
+      ctx->backend->destroy_texture(ctx->backend->user, ctx->texture_atlas);
     }
+    ctx->texture_atlas = atlas;
+    ctx->white_uv = ctx->font->white_uv;
   }
-  
-  ctx->font_size = 16.0f;
-  
-  // Clean up FreeType
-  FT_Done_Face(face);
-  FT_Done_FreeType(ft);
-  
-  // Create OpenGL texture
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas_width, atlas_height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas_data);
-  
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 4); // Reset to default
-  
-  free(atlas_data);
-  return texture;
+  UI_PROFILE_END(ctx);
 }
 
-UIContext* ui_create_context(int window_width, int window_height) {
-  UIContext* ctx = (UIContext*) calloc(1, sizeof(UIContext));
+UIContext* ui_create_context_ex(const UIContextDesc* desc) {
+  const UIAllocator* allocator = desc->allocator ? desc->allocator : ui_default_allocator();
+
+  UIContext* ctx = (UIContext*) ui_mem_alloc(allocator, sizeof(UIContext));
   if (!ctx) return NULL;
+
+  if (!ui_context_init_state(ctx, allocator, desc->frame_arena_size, !desc->frame_arena_fixed)) {
+    ui_mem_free(allocator, ctx);
+    return NULL;
+  }
+
+  // Use the shared font when given one, otherwise this context loads its own
+  if (desc->font) {
+    ctx->font = desc->font;
+  } else {
+    UIFontDesc font_desc = {0};
+    font_desc.pixel_size = 16.0f;
+    font_desc.allocator = allocator;
+    ctx->font = ui_font_create_async(&font_desc);
+    ctx->owns_font = true;
+  }
+  ctx->font_size = ctx->font ? ctx->font->size : 16.0f;
   
-  ctx->width = window_width;
-  ctx->height = window_height;
-  ctx->shader = ui_create_ui_shader();
-  ctx->margin = 10;
-  
-  // Setup buffers
-  glGenVertexArrays(1, &ctx->vao);
-  glGenBuffers(1, &ctx->vbo);
-  glGenBuffers(1, &ctx->ebo);
-  
-  glBindVertexArray(ctx->vao);
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->vbo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx->ebo);
-  
-  // Vertex attributes
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ui_vertex), (void*)0);
-  
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ui_vertex), 
-                        (void*)offsetof(ui_vertex, texcoord));
-  
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ui_vertex),
-                        (void*)offsetof(ui_vertex, col));
-  
-  // Create texture atlas (must be done after ctx is allocated)
-  ctx->texture_atlas = create_texture_atlas(ctx);
+  ctx->width = desc->width;
+  ctx->height = desc->height;
+  ctx->upload_budget = desc->upload_budget ? desc->upload_budget : UI_UPLOAD_DEFAULT_BUDGET;
+
+  ctx->input_queue = ui_input_queue_create(desc->input_events ? desc->input_events : 1024,
+    allocator);
+  ctx->hit_index = ui_hit_index_create(allocator);
+  if (!ctx->input_queue || !ctx->hit_index) {
+    ui_destroy_context(ctx);
+    return NULL;
+  }
+
+#ifndef UI_DISABLE_PROFILER
+  if (desc->profile_events > 0) {
+    ctx->profiler = ui_profiler_create(desc->profile_events, 0, allocator);
+    if (!ctx->profiler) {
+      ui_destroy_context(ctx);
+      return NULL;
+    }
+  }
+#endif
+  
+  // Backend: the host's, none (record only) or the default GL one
+  if (desc->backend) {
+    ctx->backend = desc->backend;
+  } else if (!desc->headless) {
+    ctx->backend = ui_backend_gl_create(allocator, desc->shader_cache_dir);
+    ctx->owns_backend = true;
+    if (!ctx->backend) {
+      ui_destroy_context(ctx);
+      return NULL;
+    }
+  }
   
-  // Create a white pixel texture for solid colors
-  glGenTextures(1, &ctx->white_texture);
-  glBindTexture(GL_TEXTURE_2D, ctx->white_texture);
-  unsigned char white_pixel[4] = {255, 255, 255, 255};
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white_pixel);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  // Upload this context's copy of the font atlas, it doubles as the solid color texture.
+  // Until the font is rasterized a white texel stands in and text draws as boxes
+  if (ctx->font && !ctx->backend) {
+    // Record-only: the host uploads the atlas itself, it has to be complete
+    ui_font_wait(ctx->font);
+    ctx->white_uv = ctx->font->white_uv;
+    ctx->texture_atlas = (ui_texture_id) ctx->font;
+  } else if (ctx->backend) {
+    unsigned char white_pixel = 255;
+    ctx->white_uv = (vec2){0.5f, 0.5f};
+    ctx->texture_atlas = ctx->backend->create_texture(ctx->backend->user, 1, 1,
+      UI_TEXTURE_A8, &white_pixel);
+    ctx->atlas_pending = ctx->font != NULL;
+    upload_font_atlas(ctx);
+  }
   
   return ctx;
 }
@@ -183,40 +180,69 @@ UIContext* ui_create_context(int window_width, int window_height) {
 void ui_destroy_context(UIContext* ctx) {
   if (!ctx) return;
   
-  glDeleteTextures(1, &ctx->texture_atlas);
-  glDeleteTextures(1, &ctx->white_texture);
-  glDeleteBuffers(1, &ctx->vbo);
-  glDeleteBuffers(1, &ctx->ebo);
-  glDeleteVertexArrays(1, &ctx->vao);
-  glDeleteProgram(ctx->shader);
+  // Image pages are backend textures, freed before the backend goes
+  ui_images_destroy(ctx);
+
+  if (ctx->backend) {
+    if (ctx->texture_atlas) {
+      ctx->backend->destroy_texture(ctx->backend->user, ctx->texture_atlas);
+    }
+    if (ctx->owns_backend && ctx->backend->destroy) {
+      ctx->backend->destroy(ctx->backend);
+    }
+  }
   
-  free(ctx);
+  if (ctx->owns_font) {
+    ui_font_destroy((UIFont*) ctx->font);
+  }
+
+  ui_record_end(ctx);
+
+  // Region profilers are owned by this one
+  ui_profiler_destroy(ctx->profiler);
+  ui_input_queue_destroy(ctx->input_queue);
+  ui_hit_index_destroy(ctx->hit_index);
+  ui_upload_queue_destroy(ctx->uploads);
+  
+  UIAllocator allocator = ctx->allocator;
+  ui_context_release_state(ctx);
+  ui_mem_free(&allocator, ctx);
 }
 
 void ui_begin_frame(UIContext* ctx, float delta_time) {
+#ifndef UI_DISABLE_STATS
+  double begin_start = stats_now_ms();
+  memset(&ctx->frame_stats, 0, sizeof(UIFrameStats));
+#endif
+
+  ctx->frame_index++;
+  if (ctx->profiler) ctx->profiler->frame = ctx->frame_index;
+
+  // "frame" stays open until ui_end_frame, widget scopes nest inside it
+  UI_PROFILE_BEGIN(ctx, "frame");
+  UI_PROFILE_BEGIN(ctx, "ui_begin_frame");
+
   ctx->delta_time = delta_time;
   ctx->time += delta_time;
-  
-  // Reset scroll offset
-  ctx->scroll_offset = 0;
-  
-  // Enable blending for UI
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glDisable(GL_DEPTH_TEST);
-  
-  // Setup shader and projection
-  glUseProgram(ctx->shader);
-  
-  // Create orthographic projection matrix (column-major)
-  float ortho[16] = {
-    2.0f / ctx->width, 0.0f, 0.0f, 0.0f,
-    0.0f, -2.0f / ctx->height, 0.0f, 0.0f,
-    0.0f, 0.0f, -1.0f, 0.0f,
-    -1.0f, 1.0f, 0.0f, 1.0f
-  };
-  
-  ui_set_uniform_mat4(ctx->shader, "projection", ortho);
+  ctx->frame_focused_widget = ctx->focused_widget;
+  ctx->focus_event = -1;
+  upload_font_atlas(ctx);
+
+  // Images may move while nothing drawn with them is recorded yet
+  ui_images_compact(ctx);
+
+  // Everything allocated from the frame arena last frame is gone now
+  ui_arena_reset(&ctx->frame_arena);
+  ui_draw_list_reset(ctx->draw_list, &ctx->frame_arena);
+  ctx->clip_stack_size = 0;
+  ctx->region_count = 0;
+  ctx->hit_rects = NULL;
+  ctx->hit_count = ctx->hit_capacity = 0;
+  
+  // Apply the input queued since the last frame, then resolve it against last frame's widgets
+  ui_input_begin_frame(ctx);
+  if (ctx->recorder) ui_record_frame(ctx);
+  ctx->hover_id = ui_hit_test(ctx, ctx->mouse_pos);
   
   // Reset hot widget if no button is pressed
   bool any_mouse_down = false;
@@ -230,18 +256,113 @@ void ui_begin_frame(UIContext* ctx, float delta_time) {
   if (!any_mouse_down) {
     ctx->hot_widget = 0;
   }
+
+#ifndef UI_DISABLE_STATS
+  ctx->stats_mark = stats_now_ms();
+  ctx->frame_stats.begin_frame_ms = ctx->stats_mark - begin_start;
+#endif
+
+  UI_PROFILE_END(ctx);
+}
+
+#ifndef UI_DISABLE_STATS
+static void collect_backend_stats(UIFrameStats* stats, const UIBackendCounters* before,
+  const UIBackendCounters* after) {
+  stats->draw_calls = (uint32_t)(after->draw_calls - before->draw_calls);
+  stats->api_calls = (uint32_t)(after->api_calls - before->api_calls);
+  stats->texture_changes = (uint32_t)(after->texture_changes - before->texture_changes);
+  stats->program_changes = (uint32_t)(after->program_changes - before->program_changes);
+  stats->scissor_changes = (uint32_t)(after->scissor_changes - before->scissor_changes);
+  stats->bytes_uploaded = after->bytes_uploaded - before->bytes_uploaded;
+}
+#endif
+
+#ifndef UI_DISABLE_PROFILER
+// Turn finished GPU queries of earlier frames into events on the GPU track
+static void collect_gpu_timings(UIContext* ctx) {
+  UIProfiler* profiler = ctx->profiler;
+  UIGpuTiming timings[8];
+  int count = ctx->backend->read_gpu_timings(ctx->backend->user, timings, 8);
+
+  for (int i = 0; i < count; i++) {
+    // Only frames recent enough to still know when they were submitted
+    if (ctx->frame_index - timings[i].frame >= 8) continue;
+
+    UIProfileEvent event = {
+      .name = "gpu_frame",
+      .start_ns = profiler->submit_ns[timings[i].frame % 8],
+      .duration_ns = timings[i].duration_ns,
+      .frame = timings[i].frame,
+      .track = UI_PROFILE_TRACK_GPU
+    };
+    ui_profile_record(profiler, &event);
+  }
 }
+#endif
 
 void ui_end_frame(UIContext* ctx) {
-  // Save current mouse state for next frame's click detection
-  memcpy(ctx->prev_mouse_buttons, ctx->mouse_buttons, sizeof(ctx->mouse_buttons));
-  
-  // Reset keyboard input for next frame
-  ctx->input_char_count = 0;
-  ctx->key_backspace = false;
-  ctx->key_delete = false;
-  ctx->key_left = false;
-  ctx->key_right = false;
+#ifndef UI_DISABLE_STATS
+  double end_start = stats_now_ms();
+  ctx->frame_stats.widgets_ms = end_start - ctx->stats_mark;
+#endif
+  UI_PROFILE_BEGIN(ctx, "ui_end_frame");
+
+  // Fold regions recorded on other threads back into this frame's draw list
+  UI_PROFILE_BEGIN(ctx, "regions_merge");
+  ui_regions_merge(ctx);
+  UI_PROFILE_END(ctx);
+
+  // What was recorded this frame is what the next frame's input hits
+  ui_hit_index_build(ctx->hit_index, ctx->hit_rects, ctx->hit_count, ctx->width, ctx->height);
+  
+  UIDrawData data = ui_get_draw_data(ctx);
+  if (ctx->backend) {
+#ifndef UI_DISABLE_STATS
+    UIBackendCounters before = {0}, after = {0};
+    if (ctx->backend->get_counters) ctx->backend->get_counters(ctx->backend->user, &before);
+#endif
+
+    // Texture edits land before the draws that sample them
+    UI_PROFILE_BEGIN(ctx, "uploads");
+    ui_uploads_flush(ctx);
+    UI_PROFILE_END(ctx);
+
+    UI_PROFILE_BEGIN(ctx, "submit");
+    if (ctx->profiler) ctx->profiler->submit_ns[ctx->frame_index % 8] = ui_profile_now_ns();
+    ctx->backend->render(ctx->backend->user, &data);
+    UI_PROFILE_END(ctx);
+
+#ifndef UI_DISABLE_STATS
+    if (ctx->backend->get_counters) {
+      ctx->backend->get_counters(ctx->backend->user, &after);
+      collect_backend_stats(&ctx->frame_stats, &before, &after);
+    }
+#endif
+
+#ifndef UI_DISABLE_PROFILER
+    if (ctx->profiler && ctx->backend->read_gpu_timings) {
+      collect_gpu_timings(ctx);
+    }
+#endif
+  }
+
+#ifndef UI_DISABLE_STATS
+  UIFrameStats* stats = &ctx->frame_stats;
+  stats->commands = (uint32_t)data.command_count;
+  stats->vertices = data.vertex_count;
+  stats->indices = data.index_count;
+  stats->arena_used = ctx->frame_arena.used;
+  stats->arena_high_water = ctx->frame_arena.high_water;
+  stats->end_frame_ms = stats_now_ms() - end_start;
+  ctx->last_stats = *stats;
+#endif
+
+  UI_PROFILE_END(ctx); // ui_end_frame
+  UI_PROFILE_END(ctx); // frame
+}
+
+UIFrameStats ui_get_frame_stats(UIContext* ctx) {
+  return ctx->last_stats;
 }
 
 bool ui_is_hovered(UIContext* ctx, rect area) {
@@ -251,10 +372,24 @@ bool ui_is_hovered(UIContext* ctx, rect area) {
           ctx->mouse_pos.y <= area.pos.y + area.size.y);
 }
 
+int ui_click_count(UIContext* ctx, rect area, int button) {
+  int count = 0;
+  for (int i = 0; i < ctx->event_count; i++) {
+    const UIInputEvent* event = &ctx->events[i];
+    if (event->type != UI_EVENT_MOUSE_BUTTON || !event->pressed || event->button != button) continue;
+
+    if (event->mouse_pos.x >= area.pos.x &&
+        event->mouse_pos.x <= area.pos.x + area.size.x &&
+        event->mouse_pos.y >= area.pos.y &&
+        event->mouse_pos.y <= area.pos.y + area.size.y) {
+      count++;
+    }
+  }
+  return count;
+}
+
 bool ui_is_clicked(UIContext* ctx, rect area, int button) {
-  return ui_is_hovered(ctx, area) && 
-    ctx->mouse_buttons[button] && 
-    !ctx->prev_mouse_buttons[button];
+  return ui_click_count(ctx, area, button) > 0;
 }
 
 vec2 ui_get_mouse_pos(UIContext* ctx) {
@@ -264,100 +399,65 @@ vec2 ui_get_mouse_pos(UIContext* ctx) {
 // Drawing functions
 void ui_draw_rect(UIContext* ctx, rect r, color c) {
   // Create vertices with complete data (position, texcoord, color)
+  // Solid colors sample the white texels of the font atlas, so rects and text batch together
+  vec2 uv = ctx->white_uv;
   ui_vertex vertices[4] = {
-    {{r.pos.x, r.pos.y}, {0.0f, 0.0f}, c},
-    {{r.pos.x + r.size.x, r.pos.y}, {1.0f, 0.0f}, c},
-    {{r.pos.x + r.size.x, r.pos.y + r.size.y}, {1.0f, 1.0f}, c},
-    {{r.pos.x, r.pos.y + r.size.y}, {0.0f, 1.0f}, c}
+    {{r.pos.x, r.pos.y}, uv, c, 0},
+    {{r.pos.x + r.size.x, r.pos.y}, uv, c, 0},
+    {{r.pos.x + r.size.x, r.pos.y + r.size.y}, uv, c, 0},
+    {{r.pos.x, r.pos.y + r.size.y}, uv, c, 0}
   };
   
-  unsigned int indices[] = {0, 1, 2, 2, 3, 0};
-  
-  // Bind VAO and shader
-  glBindVertexArray(ctx->vao);
-  glUseProgram(ctx->shader);
-  
-  // Upload to GPU
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STREAM_DRAW);
-  
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx->ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STREAM_DRAW);
-  
-  // Set color uniform
-  ui_set_uniform_vec4(ctx->shader, "color", c.r, c.g, c.b, c.a);
-  
-  // Bind white texture for solid colors
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, ctx->white_texture);
-  ui_set_uniform_int(ctx->shader, "tex", 0);
-  
-  // Draw
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  ui_draw_list_add_quad(ctx, ctx->texture_atlas, UI_PIPELINE_ALPHA, vertices);
 }
 
-void ui_set_mouse_position(UIContext* ctx, float x, float y) {
-  ctx->mouse_pos.x = x;
-  ctx->mouse_pos.y = y;
-}
-
-void ui_set_mouse_button(UIContext* ctx, int button, bool pressed) {
-  if (button >= 0 && button < 3) {
-    ctx->mouse_buttons[button] = pressed;
-  }
+void ui_draw_text(UIContext* ctx, const char* text, vec2 position, color c) {
+  ui_draw_text_n(ctx, text, SIZE_MAX, position, c);
 }
 
-void ui_set_key(UIContext* ctx, int key, bool pressed) {
-  if (!pressed) return; // Only handle key press
+void ui_draw_text_n(UIContext* ctx, const char* text, size_t length, vec2 position, color c) {
+  if (!text || length == 0 || !*text || !ctx->font) return;
+  UI_PROFILE_BEGIN(ctx, "text_layout");
   
-  // GLFW key codes
-  if (key == 259) { // GLFW_KEY_BACKSPACE
-    ctx->key_backspace = true;
-  } else if (key == 261) { // GLFW_KEY_DELETE
-    ctx->key_delete = true;
-  } else if (key == 263) { // GLFW_KEY_LEFT
-    ctx->key_left = true;
-  } else if (key == 262) { // GLFW_KEY_RIGHT
-    ctx->key_right = true;
-  }
-}
-
-void ui_set_scroll(UIContext* ctx, float offset) {
-  ctx->scroll_offset = offset;
-}
-
-void ui_input_char(UIContext* ctx, unsigned int codepoint) {
-  if (ctx->input_char_count < 32 && codepoint < 128 && codepoint >= 32) {
-    ctx->input_chars[ctx->input_char_count++] = (char)codepoint;
-  }
-}
-
-void ui_draw_text(UIContext* ctx, const char* text, vec2 position, color c) {
-  if (!text || !*text) return;
+  const UIFont* font = ctx->font;
+  bool ready = ui_font_ready(font);
   
   float x = position.x;
   float y = position.y;
   
-  glBindVertexArray(ctx->vao);
-  glUseProgram(ctx->shader);
-  
-  // Bind font atlas
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, ctx->texture_atlas);
-  ui_set_uniform_int(ctx->shader, "tex", 0);
-  
-  // Set text color (use the provided color)
-  ui_set_uniform_vec4(ctx->shader, "color", c.r, c.g, c.b, c.a);
-  
-  for (const char* p = text; *p; p++) {
-    unsigned char ch = *p;
-    if (ch < 32 || ch >= 128) continue;
+  for (size_t i = 0; i < length && text[i];) {
+    uint32_t ch = (unsigned char)text[i];
+    if (ch < 128) {
+      i++;
+    } else {
+      // Decoding stops at the terminator, it is not a continuation byte
+      i += ui_utf8_decode(text + i, length - i, &ch);
+    }
+    if (ch < 32) {
+      UI_STAT_ADD(ctx, glyph_misses, 1);
+      continue;
+    }
+
+    // Atlas still being rasterized: a faint box per character keeps the layout
+    if (!ready) {
+      if (ch != ' ') {
+        float box = font->placeholder_advance;
+        ui_draw_rect(ctx, (rect){{x + box * 0.1f, y - font->size * 0.6f}, {box * 0.8f, font->size * 0.6f}},
+          (color){c.r, c.g, c.b, c.a * 0.25f});
+      }
+      x += font->placeholder_advance;
+      continue;
+    }
     
-    ui_glyph_info* glyph = &ctx->glyphs[ch];
+    const ui_glyph_info* glyph = ch < 128 ? &font->glyphs[ch] : ui_font_glyph(font, ch);
+    if (!glyph) {
+      UI_STAT_ADD(ctx, glyph_misses, 1);
+      continue;
+    }
     
     // Use actual glyph dimensions from atlas
-    float glyph_width = glyph->width * 512.0f;  // Scale back to pixels (atlas is 512x512)
-    float glyph_height = glyph->height * 512.0f;
+    float glyph_width = glyph->width * font->atlas_width;  // Scale back to pixels
+    float glyph_height = glyph->height * font->atlas_height;
     
     float x0 = x + glyph->offset_x;
     float y0 = y + glyph->offset_y;
@@ -371,35 +471,37 @@ void ui_draw_text(UIContext* ctx, const char* text, vec2 position, color c) {
     
     // Create vertices for this character
     ui_vertex vertices[4] = {
-      {{x0, y0}, {u0, v0}, c},
-      {{x1, y0}, {u1, v0}, c},
-      {{x1, y1}, {u1, v1}, c},
-      {{x0, y1}, {u0, v1}, c}
+      {{x0, y0}, {u0, v0}, c, 0},
+      {{x1, y0}, {u1, v0}, c, 0},
+      {{x1, y1}, {u1, v1}, c, 0},
+      {{x0, y1}, {u0, v1}, c, 0}
     };
     
-    unsigned int indices[] = {0, 1, 2, 2, 3, 0};
-    
-    // Upload and draw
-    glBindBuffer(GL_ARRAY_BUFFER, ctx->vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STREAM_DRAW);
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STREAM_DRAW);
-    
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    ui_draw_list_add_quad(ctx, ctx->texture_atlas, UI_PIPELINE_ALPHA, vertices);
+    UI_STAT_ADD(ctx, glyphs_drawn, 1);
     
     x += glyph->advance;
   }
+  UI_PROFILE_END(ctx);
 }
 
 float ui_measure_text(UIContext* ctx, const char* text) {
-  if (!text || !*text) return 0.0f;
+  if (!text || !*text || !ctx->font) return 0.0f;
   
+  const UIFont* font = ctx->font;
+  bool ready = ui_font_ready(font);
   float width = 0.0f;
-  for (const char* p = text; *p; p++) {
-    unsigned char ch = *p;
-    if (ch < 32 || ch >= 128) continue;
-    width += ctx->glyphs[ch].advance;
+  for (size_t i = 0; text[i];) {
+    uint32_t ch = (unsigned char)text[i];
+    if (ch < 128) i++; else i += ui_utf8_decode(text + i, SIZE_MAX, &ch);
+    if (ch < 32) continue;
+
+    if (!ready) {
+      width += font->placeholder_advance;
+    } else {
+      const ui_glyph_info* glyph = ch < 128 ? &font->glyphs[ch] : ui_font_glyph(font, ch);
+      if (glyph) width += glyph->advance;
+    }
   }
 
   return width;
@@ -0,0 +1,425 @@
+/*
+ * Tridme UI Image Decoding
+ *
+ * PNG and TGA decoders producing RGBA8. PNG inflation goes through
+ * FreeType's bundled zlib, so no extra dependency is needed.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_decode.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GZIP_H
+#include FT_SYSTEM_H
+
+static unsigned char* alloc_pixels(const UIAllocator* allocator, int width, int height) {
+  return (unsigned char*)ui_mem_alloc(allocator, (size_t)width * height * 4);
+}
+
+static bool valid_size(int64_t width, int64_t height) {
+  return width > 0 && height > 0 && width <= UI_DECODE_MAX_SIZE && height <= UI_DECODE_MAX_SIZE;
+}
+
+/*
+ * FreeType memory callbacks over a UIAllocator
+ */
+
+static void* ft_alloc(FT_Memory memory, long size) {
+  return ui_mem_alloc((const UIAllocator*)memory->user, (size_t)size);
+}
+
+static void ft_free(FT_Memory memory, void* block) {
+  ui_mem_free((const UIAllocator*)memory->user, block);
+}
+
+static void* ft_realloc(FT_Memory memory, long current, long size, void* block) {
+  void* grown = ft_alloc(memory, size);
+  if (grown && block) {
+    memcpy(grown, block, (size_t)(current < size ? current : size));
+    ft_free(memory, block);
+  }
+  return grown;
+}
+
+/*
+ * PNG
+ */
+
+static uint32_t read_be32(const unsigned char* p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static int paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+  if (pa <= pb && pa <= pc) return a;
+  return pb <= pc ? b : c;
+}
+
+// Undo the per-row filters in place, rows are stride bytes plus a filter byte
+static bool unfilter(unsigned char* data, int height, size_t stride, int bpp) {
+  unsigned char* prev = NULL;
+  for (int y = 0; y < height; y++) {
+    unsigned char* row = data + (size_t)y * (stride + 1);
+    int filter = row[0];
+    unsigned char* cur = row + 1;
+
+    for (size_t i = 0; i < stride; i++) {
+      int a = i >= (size_t)bpp ? cur[i - bpp] : 0;
+      int b = prev ? prev[i] : 0;
+      int c = prev && i >= (size_t)bpp ? prev[i - bpp] : 0;
+      switch (filter) {
+        case 0: break;
+        case 1: cur[i] = (unsigned char)(cur[i] + a); break;
+        case 2: cur[i] = (unsigned char)(cur[i] + b); break;
+        case 3: cur[i] = (unsigned char)(cur[i] + ((a + b) >> 1)); break;
+        case 4: cur[i] = (unsigned char)(cur[i] + paeth(a, b, c)); break;
+        default: return false;
+      }
+    }
+    prev = cur;
+  }
+  return true;
+}
+
+// Sample i of a row packed at `depth` bits per sample, at full precision
+static inline int png_sample(const unsigned char* row, size_t i, int depth) {
+  switch (depth) {
+    case 16: return row[i * 2] << 8 | row[i * 2 + 1];
+    case 8:  return row[i];
+    default: {
+      size_t bit = i * depth;
+      return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+    }
+  }
+}
+
+// Scale a sample to 8 bits: high byte of 16-bit ones, replicated bits of small ones
+static inline unsigned char png_to_u8(int value, int depth) {
+  if (depth == 16) return (unsigned char)(value >> 8);
+  if (depth == 8) return (unsigned char)value;
+  return (unsigned char)(value * 255 / ((1 << depth) - 1));
+}
+
+unsigned char* ui_decode_png(const void* data, size_t size, const UIAllocator* allocator,
+  int* width, int* height) {
+  static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  const unsigned char* p = (const unsigned char*)data;
+  if (!allocator) allocator = ui_default_allocator();
+  if (size < 8 || memcmp(p, signature, 8) != 0) return NULL;
+
+  int64_t w = 0, h = 0;
+  int depth = 0, color_type = -1, interlace = 0;
+  unsigned char palette[256][4];
+  int palette_size = 0;
+  int trns_key[3] = {-1, -1, -1};
+  bool has_trns_key = false;
+
+  // First pass: header, palette, transparency and the total IDAT size
+  size_t idat_size = 0;
+  bool ended = false;
+  for (size_t at = 8; at + 12 <= size && !ended;) {
+    uint32_t length = read_be32(p + at);
+    const unsigned char* type = p + at + 4;
+    const unsigned char* chunk = p + at + 8;
+    if (length > size - at - 12) {
+      fprintf(stderr, "PNG: truncated chunk\n");
+      return NULL;
+    }
+
+    if (memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+      w = read_be32(chunk);
+      h = read_be32(chunk + 4);
+      depth = chunk[8];
+      color_type = chunk[9];
+      interlace = chunk[12];
+    } else if (memcmp(type, "PLTE", 4) == 0) {
+      palette_size = (int)(length / 3 > 256 ? 256 : length / 3);
+      for (int i = 0; i < palette_size; i++) {
+        palette[i][0] = chunk[i * 3];
+        palette[i][1] = chunk[i * 3 + 1];
+        palette[i][2] = chunk[i * 3 + 2];
+        palette[i][3] = 255;
+      }
+    } else if (memcmp(type, "tRNS", 4) == 0) {
+      if (color_type == 3) {
+        for (uint32_t i = 0; i < length && i < (uint32_t)palette_size; i++) palette[i][3] = chunk[i];
+      } else if (color_type == 0 && length >= 2) {
+        trns_key[0] = chunk[0] << 8 | chunk[1];
+        has_trns_key = true;
+      } else if (color_type == 2 && length >= 6) {
+        for (int c = 0; c < 3; c++) trns_key[c] = chunk[c * 2] << 8 | chunk[c * 2 + 1];
+        has_trns_key = true;
+      }
+    } else if (memcmp(type, "IDAT", 4) == 0) {
+      idat_size += length;
+    } else if (memcmp(type, "IEND", 4) == 0) {
+      ended = true;
+    }
+    at += 12 + (size_t)length;
+  }
+
+  int channels;
+  switch (color_type) {
+    case 0: channels = 1; break;
+    case 2: channels = 3; break;
+    case 3: channels = 1; break;
+    case 4: channels = 2; break;
+    case 6: channels = 4; break;
+    default:
+      fprintf(stderr, "PNG: missing or invalid header\n");
+      return NULL;
+  }
+  bool depth_ok = depth == 8 || depth == 16 ||
+    ((color_type == 0 || color_type == 3) && (depth == 1 || depth == 2 || depth == 4));
+  if (color_type == 3 && depth == 16) depth_ok = false;
+  if (!depth_ok || !valid_size(w, h) || idat_size == 0) {
+    fprintf(stderr, "PNG: unsupported image (%lldx%lld, depth %d)\n", (long long)w, (long long)h, depth);
+    return NULL;
+  }
+  if (interlace) {
+    fprintf(stderr, "PNG: interlaced images are not supported\n");
+    return NULL;
+  }
+  if (color_type == 3 && palette_size == 0) {
+    fprintf(stderr, "PNG: missing palette\n");
+    return NULL;
+  }
+
+  // Gather the zlib stream, then inflate it into filtered rows
+  size_t stride = ((size_t)w * channels * depth + 7) / 8;
+  size_t raw_size = (stride + 1) * (size_t)h;
+  unsigned char* stream = (unsigned char*)ui_mem_alloc(allocator, idat_size);
+  unsigned char* raw = (unsigned char*)ui_mem_alloc(allocator, raw_size);
+  unsigned char* pixels = alloc_pixels(allocator, (int)w, (int)h);
+  if (!stream || !raw || !pixels) {
+    ui_mem_free(allocator, stream);
+    ui_mem_free(allocator, raw);
+    ui_mem_free(allocator, pixels);
+    return NULL;
+  }
+
+  size_t gathered = 0;
+  for (size_t at = 8; at + 12 <= size;) {
+    uint32_t length = read_be32(p + at);
+    if (memcmp(p + at + 4, "IDAT", 4) == 0) {
+      memcpy(stream + gathered, p + at + 8, length);
+      gathered += length;
+    }
+    if (memcmp(p + at + 4, "IEND", 4) == 0) break;
+    at += 12 + (size_t)length;
+  }
+
+  struct FT_MemoryRec_ memory = {(void*)allocator, ft_alloc, ft_free, ft_realloc};
+  FT_ULong inflated = (FT_ULong)raw_size;
+  FT_Error error = FT_Gzip_Uncompress(&memory, raw, &inflated, stream, (FT_ULong)idat_size);
+  ui_mem_free(allocator, stream);
+
+  int bpp = (channels * depth + 7) / 8;
+  if (error || inflated != raw_size || !unfilter(raw, (int)h, stride, bpp)) {
+    if (error == FT_Err_Unimplemented_Feature) {
+      fprintf(stderr, "PNG: FreeType was built without zlib\n");
+    } else {
+      fprintf(stderr, "PNG: corrupt image data\n");
+    }
+    ui_mem_free(allocator, raw);
+    ui_mem_free(allocator, pixels);
+    return NULL;
+  }
+
+  for (int64_t y = 0; y < h; y++) {
+    const unsigned char* row = raw + (size_t)y * (stride + 1) + 1;
+    unsigned char* out = pixels + (size_t)y * w * 4;
+
+    for (int64_t x = 0; x < w; x++, out += 4) {
+      size_t i = (size_t)x * channels;
+      switch (color_type) {
+        case 0: {
+          int g = png_sample(row, i, depth);
+          out[0] = out[1] = out[2] = png_to_u8(g, depth);
+          out[3] = has_trns_key && g == trns_key[0] ? 0 : 255;
+          break;
+        }
+        case 2: {
+          int r = png_sample(row, i, depth);
+          int g = png_sample(row, i + 1, depth);
+          int b = png_sample(row, i + 2, depth);
+          out[0] = png_to_u8(r, depth);
+          out[1] = png_to_u8(g, depth);
+          out[2] = png_to_u8(b, depth);
+          out[3] = has_trns_key && r == trns_key[0] && g == trns_key[1] && b == trns_key[2] ? 0 : 255;
+          break;
+        }
+        case 3: {
+          int index = png_sample(row, i, depth);
+          if (index < palette_size) {
+            memcpy(out, palette[index], 4);
+          } else {
+            memset(out, 0, 4);
+          }
+          break;
+        }
+        case 4:
+          out[0] = out[1] = out[2] = png_to_u8(png_sample(row, i, depth), depth);
+          out[3] = png_to_u8(png_sample(row, i + 1, depth), depth);
+          break;
+        default:
+          for (int c = 0; c < 4; c++) out[c] = png_to_u8(png_sample(row, i + c, depth), depth);
+          break;
+      }
+    }
+  }
+
+  ui_mem_free(allocator, raw);
+  *width = (int)w;
+  *height = (int)h;
+  return pixels;
+}
+
+/*
+ * TGA
+ */
+
+// One pixel of `bytes` bytes (BGR, BGRA, 15/16-bit or gray) to RGBA
+static void tga_pixel(const unsigned char* src, int bytes, bool gray, unsigned char* out) {
+  if (gray) {
+    out[0] = out[1] = out[2] = src[0];
+    out[3] = bytes == 2 ? src[1] : 255;
+    return;
+  }
+  switch (bytes) {
+    case 2: {
+      int v = src[0] | src[1] << 8;
+      out[0] = (unsigned char)(((v >> 10) & 31) * 255 / 31);
+      out[1] = (unsigned char)(((v >> 5) & 31) * 255 / 31);
+      out[2] = (unsigned char)((v & 31) * 255 / 31);
+      out[3] = 255;
+      break;
+    }
+    case 3:
+      out[0] = src[2]; out[1] = src[1]; out[2] = src[0]; out[3] = 255;
+      break;
+    default:
+      out[0] = src[2]; out[1] = src[1]; out[2] = src[0]; out[3] = src[3];
+      break;
+  }
+}
+
+unsigned char* ui_decode_tga(const void* data, size_t size, const UIAllocator* allocator,
+  int* width, int* height) {
+  const unsigned char* p = (const unsigned char*)data;
+  if (!allocator) allocator = ui_default_allocator();
+  if (size < 18) return NULL;
+
+  int id_length = p[0];
+  int map_type = p[1];
+  int image_type = p[2];
+  int map_first = p[3] | p[4] << 8;
+  int map_length = p[5] | p[6] << 8;
+  int map_bits = p[7];
+  int w = p[12] | p[13] << 8;
+  int h = p[14] | p[15] << 8;
+  int bits = p[16];
+  int descriptor = p[17];
+
+  bool rle = image_type >= 9;
+  int kind = rle ? image_type - 8 : image_type;   // 1 color-mapped, 2 true-color, 3 gray
+  bool gray = kind == 3;
+  bool mapped = kind == 1;
+  if (kind < 1 || kind > 3 || (mapped && (map_type != 1 || bits != 8)) ||
+      (gray && bits != 8 && bits != 16) ||
+      (kind == 2 && bits != 15 && bits != 16 && bits != 24 && bits != 32) || !valid_size(w, h)) {
+    fprintf(stderr, "TGA: unsupported image (type %d, %d bits)\n", image_type, bits);
+    return NULL;
+  }
+
+  size_t at = 18 + (size_t)id_length;
+  int bytes = (bits + 7) / 8;
+  int map_bytes = (map_bits + 7) / 8;
+
+  // Color map, converted up front
+  unsigned char palette[256][4];
+  memset(palette, 0, sizeof(palette));
+  if (map_type == 1) {
+    size_t map_size = (size_t)map_length * map_bytes;
+    if (map_bytes < 2 || map_bytes > 4 || at + map_size > size) {
+      fprintf(stderr, "TGA: invalid color map\n");
+      return NULL;
+    }
+    for (int i = 0; i < map_length; i++) {
+      int index = map_first + i;
+      if (index < 256) tga_pixel(p + at + (size_t)i * map_bytes, map_bytes, false, palette[index]);
+    }
+    at += map_size;
+  }
+
+  unsigned char* pixels = alloc_pixels(allocator, w, h);
+  if (!pixels) return NULL;
+
+  // Decode in file order, then place rows according to the origin bits
+  bool top_down = (descriptor & 0x20) != 0;
+  bool right_to_left = (descriptor & 0x10) != 0;
+  size_t total = (size_t)w * h;
+  size_t n = 0;
+  int run = 0;
+  bool repeat = false;
+  unsigned char value[4] = {0};
+
+  while (n < total) {
+    if (rle && run == 0) {
+      if (at >= size) break;
+      int header = p[at++];
+      run = (header & 127) + 1;
+      repeat = (header & 128) != 0;
+      if (repeat) {
+        if (at + bytes > size) break;
+        if (mapped) {
+          memcpy(value, palette[p[at]], 4);
+        } else {
+          tga_pixel(p + at, bytes, gray, value);
+        }
+        at += bytes;
+      }
+    }
+    if (!rle || !repeat) {
+      if (at + bytes > size) break;
+      if (mapped) {
+        memcpy(value, palette[p[at]], 4);
+      } else {
+        tga_pixel(p + at, bytes, gray, value);
+      }
+      at += bytes;
+    }
+    if (rle) run--;
+
+    int x = (int)(n % w), y = (int)(n / w);
+    if (right_to_left) x = w - 1 - x;
+    if (!top_down) y = h - 1 - y;
+    memcpy(pixels + ((size_t)y * w + x) * 4, value, 4);
+    n++;
+  }
+
+  if (n < total) {
+    fprintf(stderr, "TGA: truncated image data\n");
+    ui_mem_free(allocator, pixels);
+    return NULL;
+  }
+
+  *width = w;
+  *height = h;
+  return pixels;
+}
+
+unsigned char* ui_decode_image(const void* data, size_t size, const UIAllocator* allocator,
+  int* width, int* height) {
+  // PNG has a signature; TGA has none, so it is whatever else decodes
+  if (size >= 8 && memcmp(data, "\x89PNG", 4) == 0) {
+    return ui_decode_png(data, size, allocator, width, height);
+  }
+  return ui_decode_tga(data, size, allocator, width, height);
+}
@@ -0,0 +1,229 @@
+/*
+ * Tridme UI Draw Lists
+ *
+ * CPU-side recording of vertices, indices and draw commands. Nothing here
+ * talks to the GPU, so draw lists can be built on any thread.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_draw.h>
+#include <string.h>
+#include <stdio.h>
+
+static bool grow_array(UIArena* arena, void** data, uint32_t* capacity, uint32_t needed,
+  size_t element_size) {
+  if (needed <= *capacity) return true;
+
+  uint32_t new_capacity = *capacity ? *capacity * 2 : 64;
+  while (new_capacity < needed) new_capacity *= 2;
+
+  void* grown = ui_arena_grow(arena, *data, (size_t)*capacity * element_size,
+    (size_t)new_capacity * element_size, 16);
+  if (!grown) return false;
+
+  *data = grown;
+  *capacity = new_capacity;
+  return true;
+}
+
+void ui_draw_list_reset(UIDrawList* list, UIArena* arena) {
+  // Last frame's counts are the best guess for this frame, reserving them up front
+  // keeps a steady-state frame from growing (and copying) inside the arena
+  uint32_t vertex_hint = list->vertex_count;
+  uint32_t index_hint = list->index_count;
+  uint32_t command_hint = (uint32_t)list->command_count;
+
+  memset(list, 0, sizeof(*list));
+  ui_draw_list_reserve(list, arena, vertex_hint, index_hint);
+
+  uint32_t command_capacity = 0;
+  grow_array(arena, (void**)&list->commands, &command_capacity, command_hint, sizeof(UIDrawCmd));
+  list->command_capacity = (int)command_capacity;
+}
+
+bool ui_draw_list_reserve(UIDrawList* list, UIArena* arena, uint32_t vertex_count,
+  uint32_t index_count) {
+  if (!grow_array(arena, (void**)&list->vertices, &list->vertex_capacity,
+        list->vertex_count + vertex_count, sizeof(ui_vertex))) {
+    return false;
+  }
+  return grow_array(arena, (void**)&list->indices, &list->index_capacity,
+    list->index_count + index_count, sizeof(uint32_t));
+}
+
+bool ui_draw_list_push_command(UIDrawList* list, UIArena* arena, const UIDrawCmd* cmd) {
+  uint32_t capacity = (uint32_t)list->command_capacity;
+  if (!grow_array(arena, (void**)&list->commands, &capacity, list->command_count + 1,
+        sizeof(UIDrawCmd))) {
+    return false;
+  }
+  list->command_capacity = (int)capacity;
+  list->commands[list->command_count++] = *cmd;
+  return true;
+}
+
+static inline bool same_rect(rect a, rect b) {
+  return a.pos.x == b.pos.x && a.pos.y == b.pos.y &&
+         a.size.x == b.size.x && a.size.y == b.size.y;
+}
+
+// Command the next primitive goes into: the last one while the clip stays the
+// same and the texture is already one of its slots, or a slot is free
+static UIDrawCmd* command_for(UIContext* ctx, ui_texture_id texture, int* slot) {
+  UIDrawList* list = ctx->draw_list;
+
+  rect clip = ui_current_clip(ctx);
+  UIDrawCmd* cmd = list->command_count ? &list->commands[list->command_count - 1] : NULL;
+  *slot = -1;
+  if (cmd && !list->split && same_rect(cmd->clip, clip)) {
+    for (int i = 0; i < cmd->texture_count; i++) {
+      if (cmd->textures[i] == texture) {
+        *slot = i;
+        return cmd;
+      }
+    }
+    if (cmd->texture_count < UI_DRAW_MAX_TEXTURES) {
+      *slot = cmd->texture_count++;
+      cmd->textures[*slot] = texture;
+      return cmd;
+    }
+  }
+
+  UIDrawCmd fresh = { .clip = clip, .textures = { texture }, .texture_count = 1,
+                      .index_offset = list->index_count };
+  if (!ui_draw_list_push_command(list, &ctx->frame_arena, &fresh)) return NULL;
+  list->split = false;
+  *slot = 0;
+  return &list->commands[list->command_count - 1];
+}
+
+void ui_draw_list_add_quad(UIContext* ctx, ui_texture_id texture, UIPipeline pipeline,
+  const ui_vertex quad[4]) {
+  UIDrawList* list = ctx->draw_list;
+
+  if (!ui_draw_list_reserve(list, &ctx->frame_arena, 4, 6)) return;
+
+  int slot;
+  UIDrawCmd* cmd = command_for(ctx, texture, &slot);
+  if (!cmd) return;
+
+  uint32_t base = list->vertex_count;
+  ui_vertex* v = list->vertices + base;
+  memcpy(v, quad, sizeof(ui_vertex) * 4);
+  uint32_t vertex_slot = UI_VERTEX_SLOT(slot, pipeline);
+  v[0].slot = v[1].slot = v[2].slot = v[3].slot = vertex_slot;
+  list->vertex_count += 4;
+
+  uint32_t* idx = list->indices + list->index_count;
+  idx[0] = base + 0; idx[1] = base + 1; idx[2] = base + 2;
+  idx[3] = base + 2; idx[4] = base + 3; idx[5] = base + 0;
+  list->index_count += 6;
+
+  cmd->index_count += 6;
+}
+
+ui_vertex* ui_draw_list_add_strip(UIContext* ctx, ui_texture_id texture, UIPipeline pipeline,
+  uint32_t count) {
+  UIDrawList* list = ctx->draw_list;
+  if (count < 3) return NULL;
+
+  uint32_t triangles = count - 2;
+  if (!ui_draw_list_reserve(list, &ctx->frame_arena, count, triangles * 3)) return NULL;
+
+  int slot;
+  UIDrawCmd* cmd = command_for(ctx, texture, &slot);
+  if (!cmd) return NULL;
+
+  uint32_t base = list->vertex_count;
+  ui_vertex* v = list->vertices + base;
+  uint32_t vertex_slot = UI_VERTEX_SLOT(slot, pipeline);
+  for (uint32_t i = 0; i < count; i++) v[i].slot = vertex_slot;
+  list->vertex_count += count;
+
+  // Strip order, every other triangle flipped to keep one winding
+  uint32_t* idx = list->indices + list->index_count;
+  for (uint32_t i = 0; i < triangles; i++) {
+    uint32_t odd = i & 1;
+    idx[0] = base + i + odd;
+    idx[1] = base + i + 1 - odd;
+    idx[2] = base + i + 2;
+    idx += 3;
+  }
+  list->index_count += triangles * 3;
+
+  cmd->index_count += triangles * 3;
+  return v;
+}
+
+bool ui_draw_list_append(UIDrawList* dst, UIArena* arena, const UIDrawList* src) {
+  if (!ui_draw_list_reserve(dst, arena, src->vertex_count, src->index_count)) return false;
+
+  uint32_t vertex_base = dst->vertex_count;
+  uint32_t index_base = dst->index_count;
+
+  memcpy(dst->vertices + vertex_base, src->vertices, sizeof(ui_vertex) * src->vertex_count);
+  dst->vertex_count += src->vertex_count;
+
+  for (uint32_t i = 0; i < src->index_count; i++) {
+    dst->indices[index_base + i] = src->indices[i] + vertex_base;
+  }
+  dst->index_count += src->index_count;
+
+  for (int i = 0; i < src->command_count; i++) {
+    UIDrawCmd cmd = src->commands[i];
+    cmd.index_offset += index_base;
+    if (!ui_draw_list_push_command(dst, arena, &cmd)) return false;
+  }
+
+  dst->split = true;
+  return true;
+}
+
+UIDrawData ui_get_draw_data(UIContext* ctx) {
+  const UIDrawList* list = ctx->draw_list;
+  UIDrawData data = {
+    .display_size = {(float)ctx->width, (float)ctx->height},
+    .vertices = list->vertices,
+    .vertex_count = list->vertex_count,
+    .indices = list->indices,
+    .index_count = list->index_count,
+    .commands = list->commands,
+    .command_count = list->command_count,
+    .frame = ctx->frame_index,
+    .time_gpu = ctx->profiler != NULL
+  };
+  return data;
+}
+
+// Clip stack
+rect ui_current_clip(UIContext* ctx) {
+  if (ctx->clip_stack_size > 0) {
+    return ctx->clip_stack[ctx->clip_stack_size - 1];
+  }
+  return (rect){{0, 0}, {(float)ctx->width, (float)ctx->height}};
+}
+
+void ui_push_clip(UIContext* ctx, rect r) {
+  if (ctx->clip_stack_size >= 32) {
+    fprintf(stderr, "UI clip stack overflow\n");
+    return;
+  }
+
+  rect parent = ui_current_clip(ctx);
+  float x0 = r.pos.x > parent.pos.x ? r.pos.x : parent.pos.x;
+  float y0 = r.pos.y > parent.pos.y ? r.pos.y : parent.pos.y;
+  float x1 = r.pos.x + r.size.x < parent.pos.x + parent.size.x ?
+    r.pos.x + r.size.x : parent.pos.x + parent.size.x;
+  float y1 = r.pos.y + r.size.y < parent.pos.y + parent.size.y ?
+    r.pos.y + r.size.y : parent.pos.y + parent.size.y;
+
+  rect clipped = {{x0, y0}, {x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0}};
+  ctx->clip_stack[ctx->clip_stack_size++] = clipped;
+}
+
+void ui_pop_clip(UIContext* ctx) {
+  if (ctx->clip_stack_size > 0) {
+    ctx->clip_stack_size--;
+  }
+}
@@ -0,0 +1,686 @@
+/*
+ * Tridme UI Text Editor
+ *
+ * Gap buffer text storage with a gap-buffered line index, cached per-line
+ * advance prefix sums and a multi-line editor widget that only lays out
+ * what is visible.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_editor.h>
+#include <ui_widgets.h>
+#include <ui_font.h>
+#include <ui_draw.h>
+#include <ui_hit.h>
+#include <ui_input.h>
+#include <ui_profile.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#define EDITOR_PADDING 5.0f
+
+/*
+ * Storage
+ */
+
+static size_t gap_size(const UITextEditor* editor) {
+  return editor->gap_end - editor->gap_start;
+}
+
+static char char_at(const UITextEditor* editor, size_t pos) {
+  return pos < editor->gap_start ? editor->buffer[pos] : editor->buffer[pos + gap_size(editor)];
+}
+
+static int line_gap_size(const UITextEditor* editor) {
+  return editor->line_gap_end - editor->line_gap_start;
+}
+
+static size_t line_start_raw(const UITextEditor* editor, int line) {
+  if (line < editor->line_gap_start) return editor->lines[line];
+  return ui_editor_length(editor) - editor->lines[line + line_gap_size(editor)];
+}
+
+// End of a line, not counting its newline
+static size_t line_end(const UITextEditor* editor, int line) {
+  if (line + 1 < ui_editor_line_count(editor)) return line_start_raw(editor, line + 1) - 1;
+  return ui_editor_length(editor);
+}
+
+static void move_gap(UITextEditor* editor, size_t pos) {
+  if (pos < editor->gap_start) {
+    size_t n = editor->gap_start - pos;
+    memmove(editor->buffer + editor->gap_end - n, editor->buffer + pos, n);
+    editor->gap_start -= n;
+    editor->gap_end -= n;
+  } else if (pos > editor->gap_start) {
+    size_t n = pos - editor->gap_start;
+    memmove(editor->buffer + editor->gap_start, editor->buffer + editor->gap_end, n);
+    editor->gap_start += n;
+    editor->gap_end += n;
+  }
+}
+
+// Put the line gap before `line`, converting the starts that cross it
+static void move_line_gap(UITextEditor* editor, int line) {
+  size_t length = ui_editor_length(editor);
+  while (editor->line_gap_start > line) {
+    editor->line_gap_start--;
+    editor->line_gap_end--;
+    editor->lines[editor->line_gap_end] = length - editor->lines[editor->line_gap_start];
+  }
+  while (editor->line_gap_start < line) {
+    editor->lines[editor->line_gap_start] = length - editor->lines[editor->line_gap_end];
+    editor->line_gap_start++;
+    editor->line_gap_end++;
+  }
+}
+
+static bool reserve_text(UITextEditor* editor, size_t n) {
+  if (gap_size(editor) >= n) return true;
+
+  size_t length = ui_editor_length(editor);
+  size_t capacity = editor->capacity * 2;
+  if (capacity < length + n + 256) capacity = length + n + 256;
+
+  char* grown = (char*)ui_mem_alloc(&editor->allocator, capacity);
+  if (!grown) return false;
+
+  size_t tail = editor->capacity - editor->gap_end;
+  memcpy(grown, editor->buffer, editor->gap_start);
+  memcpy(grown + capacity - tail, editor->buffer + editor->gap_end, tail);
+  ui_mem_free(&editor->allocator, editor->buffer);
+
+  editor->buffer = grown;
+  editor->gap_end = capacity - tail;
+  editor->capacity = capacity;
+  return true;
+}
+
+static bool reserve_lines(UITextEditor* editor, int n) {
+  if (line_gap_size(editor) >= n) return true;
+
+  int count = ui_editor_line_count(editor);
+  int capacity = editor->line_capacity * 2;
+  if (capacity < count + n + 64) capacity = count + n + 64;
+
+  size_t* grown = (size_t*)ui_mem_alloc(&editor->allocator, sizeof(size_t) * capacity);
+  if (!grown) return false;
+
+  int tail = editor->line_capacity - editor->line_gap_end;
+  memcpy(grown, editor->lines, sizeof(size_t) * editor->line_gap_start);
+  memcpy(grown + capacity - tail, editor->lines + editor->line_gap_end, sizeof(size_t) * tail);
+  ui_mem_free(&editor->allocator, editor->lines);
+
+  editor->lines = grown;
+  editor->line_gap_end = capacity - tail;
+  editor->line_capacity = capacity;
+  return true;
+}
+
+UITextEditor* ui_editor_create(const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  UITextEditor* editor = (UITextEditor*)ui_mem_alloc(allocator, sizeof(UITextEditor));
+  if (!editor) return NULL;
+  memset(editor, 0, sizeof(UITextEditor));
+  editor->allocator = *allocator;
+
+  editor->capacity = 256;
+  editor->line_capacity = 64;
+  editor->buffer = (char*)ui_mem_alloc(allocator, editor->capacity);
+  editor->lines = (size_t*)ui_mem_alloc(allocator, sizeof(size_t) * editor->line_capacity);
+  if (!editor->buffer || !editor->lines) {
+    ui_editor_destroy(editor);
+    return NULL;
+  }
+
+  // Empty text: one line starting at 0
+  editor->gap_end = editor->capacity;
+  editor->lines[0] = 0;
+  editor->line_gap_start = 1;
+  editor->line_gap_end = editor->line_capacity;
+
+  for (int i = 0; i < UI_EDITOR_LINE_CACHE; i++) {
+    editor->cache[i].line = -1;
+  }
+  return editor;
+}
+
+void ui_editor_destroy(UITextEditor* editor) {
+  if (!editor) return;
+
+  UIAllocator allocator = editor->allocator;
+  for (int i = 0; i < UI_EDITOR_LINE_CACHE; i++) {
+    ui_mem_free(&allocator, editor->cache[i].prefix);
+  }
+  ui_mem_free(&allocator, editor->buffer);
+  ui_mem_free(&allocator, editor->lines);
+  ui_mem_free(&allocator, editor);
+}
+
+size_t ui_editor_length(const UITextEditor* editor) {
+  return editor->capacity - gap_size(editor);
+}
+
+int ui_editor_line_count(const UITextEditor* editor) {
+  return editor->line_capacity - line_gap_size(editor);
+}
+
+size_t ui_editor_line_start(const UITextEditor* editor, int line) {
+  int count = ui_editor_line_count(editor);
+  if (line < 0) line = 0;
+  if (line >= count) line = count - 1;
+  return line_start_raw(editor, line);
+}
+
+int ui_editor_line_of(const UITextEditor* editor, size_t pos) {
+  int lo = 0, hi = ui_editor_line_count(editor) - 1;
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (line_start_raw(editor, mid) <= pos) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+bool ui_editor_insert(UITextEditor* editor, size_t pos, const char* text, size_t length) {
+  if (length == 0) return true;
+
+  size_t old_length = ui_editor_length(editor);
+  if (pos > old_length) pos = old_length;
+
+  int newlines = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] == '\n') newlines++;
+  }
+
+  if (!reserve_text(editor, length) || !reserve_lines(editor, newlines)) {
+    fprintf(stderr, "Failed to grow the text editor buffer\n");
+    return false;
+  }
+
+  // Starts after the line stay valid as distances from the end
+  move_line_gap(editor, ui_editor_line_of(editor, pos) + 1);
+  move_gap(editor, pos);
+  memcpy(editor->buffer + editor->gap_start, text, length);
+  editor->gap_start += length;
+
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] == '\n') editor->lines[editor->line_gap_start++] = pos + i + 1;
+  }
+
+  if (editor->caret >= pos) editor->caret += length;
+  if (editor->anchor >= pos) editor->anchor += length;
+  editor->revision++;
+  return true;
+}
+
+void ui_editor_delete(UITextEditor* editor, size_t start, size_t end) {
+  size_t length = ui_editor_length(editor);
+  if (end > length) end = length;
+  if (start >= end) return;
+
+  // Drop the lines that started inside the deleted range, the rest keep their distance from the end
+  move_line_gap(editor, ui_editor_line_of(editor, start) + 1);
+  while (editor->line_gap_end < editor->line_capacity &&
+         length - editor->lines[editor->line_gap_end] <= end) {
+    editor->line_gap_end++;
+  }
+
+  move_gap(editor, start);
+  editor->gap_end += end - start;
+
+  size_t n = end - start;
+  if (editor->caret >= end) editor->caret -= n; else if (editor->caret > start) editor->caret = start;
+  if (editor->anchor >= end) editor->anchor -= n; else if (editor->anchor > start) editor->anchor = start;
+  editor->revision++;
+}
+
+bool ui_editor_set_text(UITextEditor* editor, const char* text, size_t length) {
+  int newlines = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] == '\n') newlines++;
+  }
+
+  // Room first, so a failure leaves the old text in place
+  if (!reserve_text(editor, length) || !reserve_lines(editor, newlines)) {
+    fprintf(stderr, "Failed to grow the text editor buffer\n");
+    return false;
+  }
+
+  editor->gap_start = 0;
+  editor->gap_end = editor->capacity;
+  editor->line_gap_start = 1;
+  editor->line_gap_end = editor->line_capacity;
+  editor->caret = editor->anchor = 0;
+  editor->scroll = (vec2){0, 0};
+  editor->preferred_x = 0;
+  editor->revision++;
+
+  ui_editor_insert(editor, 0, text, length);
+  editor->caret = editor->anchor = 0;
+  return true;
+}
+
+size_t ui_editor_copy(const UITextEditor* editor, size_t start, char* out, size_t out_size) {
+  if (out_size == 0) return 0;
+
+  size_t length = ui_editor_length(editor);
+  if (start > length) start = length;
+  size_t n = length - start;
+  if (n > out_size - 1) n = out_size - 1;
+
+  // Up to two pieces, before and after the gap
+  size_t copied = 0;
+  if (start < editor->gap_start) {
+    copied = editor->gap_start - start;
+    if (copied > n) copied = n;
+    memcpy(out, editor->buffer + start, copied);
+  }
+  if (copied < n) {
+    memcpy(out + copied, editor->buffer + start + copied + gap_size(editor), n - copied);
+  }
+  out[n] = '\0';
+  return n;
+}
+
+/*
+ * Layout
+ */
+
+// Advance of the byte at pos: a UTF-8 sequence is measured on its lead byte
+static float char_advance(const UITextEditor* editor, size_t pos, size_t end) {
+  unsigned char c = (unsigned char)char_at(editor, pos);
+  if (c == '\t') return ui_font_advance(editor->font, ' ') * UI_EDITOR_TAB_SPACES;
+  if (c < 128) return ui_font_advance(editor->font, c);
+  if (c < 0xC0) return 0.0f;
+
+  char bytes[4];
+  size_t n = end - pos < 4 ? end - pos : 4;
+  for (size_t i = 0; i < n; i++) {
+    bytes[i] = char_at(editor, pos + i);
+  }
+  uint32_t codepoint;
+  ui_utf8_decode(bytes, n, &codepoint);
+  return ui_font_advance(editor->font, codepoint);
+}
+
+// Prefix sums of a line, rebuilt when the text or font changed since they were cached
+static const UIEditorLine* line_layout(UITextEditor* editor, int line) {
+  UIEditorLine* cached = &editor->cache[line % UI_EDITOR_LINE_CACHE];
+  if (cached->line == line && cached->revision == editor->revision) return cached;
+
+  size_t start = line_start_raw(editor, line);
+  uint32_t count = (uint32_t)(line_end(editor, line) - start);
+  if (count + 1 > cached->capacity) {
+    uint32_t capacity = cached->capacity ? cached->capacity : 128;
+    while (capacity < count + 1) capacity <<= 1;
+
+    float* grown = (float*)ui_mem_alloc(&editor->allocator, sizeof(float) * capacity);
+    if (!grown) return NULL;
+    ui_mem_free(&editor->allocator, cached->prefix);
+    cached->prefix = grown;
+    cached->capacity = capacity;
+  }
+
+  cached->prefix[0] = 0.0f;
+  for (uint32_t i = 0; i < count; i++) {
+    cached->prefix[i + 1] = cached->prefix[i] + char_advance(editor, start + i, start + count);
+  }
+  cached->line = line;
+  cached->revision = editor->revision;
+  cached->count = count;
+  return cached;
+}
+
+// Column whose boundary is nearest to x
+static uint32_t column_at(const UIEditorLine* layout, float x) {
+  uint32_t lo = 0, hi = layout->count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if ((layout->prefix[mid] + layout->prefix[mid + 1]) * 0.5f > x) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+// UTF-8 continuation bytes (10xxxxxx) never start a character, the caret skips them
+static bool continuation_at(const UITextEditor* editor, size_t pos) {
+  return pos < ui_editor_length(editor) && ((unsigned char)char_at(editor, pos) & 0xC0) == 0x80;
+}
+
+static size_t prev_char(const UITextEditor* editor, size_t pos) {
+  if (pos == 0) return 0;
+  pos--;
+  while (pos > 0 && continuation_at(editor, pos)) pos--;
+  return pos;
+}
+
+static size_t next_char(const UITextEditor* editor, size_t pos) {
+  size_t length = ui_editor_length(editor);
+  if (pos >= length) return length;
+  pos++;
+  while (continuation_at(editor, pos)) pos++;
+  return pos;
+}
+
+static size_t offset_in_line(UITextEditor* editor, int line, float x) {
+  const UIEditorLine* layout = line_layout(editor, line);
+  size_t pos = line_start_raw(editor, line) + (layout ? column_at(layout, x) : 0);
+
+  // Continuation bytes have no width, a boundary among them is the character's end
+  while (continuation_at(editor, pos)) pos++;
+  return pos;
+}
+
+static float caret_x(UITextEditor* editor, size_t pos) {
+  int line = ui_editor_line_of(editor, pos);
+  const UIEditorLine* layout = line_layout(editor, line);
+  return layout ? layout->prefix[pos - line_start_raw(editor, line)] : 0.0f;
+}
+
+static size_t offset_at_point(UITextEditor* editor, rect view, float line_height, vec2 point) {
+  int line = (int)floorf((point.y - view.pos.y + editor->scroll.y) / line_height);
+  int count = ui_editor_line_count(editor);
+  if (line < 0) line = 0;
+  if (line >= count) line = count - 1;
+  return offset_in_line(editor, line, point.x - view.pos.x + editor->scroll.x);
+}
+
+/*
+ * Editing
+ */
+
+static bool replace_selection(UITextEditor* editor, const char* text, size_t length) {
+  size_t sel_min = editor->caret < editor->anchor ? editor->caret : editor->anchor;
+  size_t sel_max = editor->caret < editor->anchor ? editor->anchor : editor->caret;
+  bool changed = sel_min != sel_max;
+
+  ui_editor_delete(editor, sel_min, sel_max);
+  if (length > 0 && ui_editor_insert(editor, editor->caret, text, length)) changed = true;
+  return changed;
+}
+
+static bool handle_key(UITextEditor* editor, const UIInputEvent* event, int page_lines) {
+  bool shift = (event->mods & UI_MOD_SHIFT) != 0;
+  size_t sel_min = editor->caret < editor->anchor ? editor->caret : editor->anchor;
+  size_t sel_max = editor->caret < editor->anchor ? editor->anchor : editor->caret;
+  bool has_selection = sel_min != sel_max;
+  int line = ui_editor_line_of(editor, editor->caret);
+  int target = line;
+  bool changed = false;
+
+  switch (event->key) {
+    case UI_KEY_LEFT:
+      if (has_selection && !shift) editor->caret = sel_min;
+      else editor->caret = prev_char(editor, editor->caret);
+      break;
+    case UI_KEY_RIGHT:
+      if (has_selection && !shift) editor->caret = sel_max;
+      else editor->caret = next_char(editor, editor->caret);
+      break;
+    case UI_KEY_UP:        target = line - 1; break;
+    case UI_KEY_DOWN:      target = line + 1; break;
+    case UI_KEY_PAGE_UP:   target = line - page_lines; break;
+    case UI_KEY_PAGE_DOWN: target = line + page_lines; break;
+    case UI_KEY_HOME:
+      editor->caret = line_start_raw(editor, line);
+      break;
+    case UI_KEY_END:
+      editor->caret = line_end(editor, line);
+      break;
+    case UI_KEY_BACKSPACE:
+      if (!has_selection) editor->anchor = prev_char(editor, editor->caret);
+      return replace_selection(editor, NULL, 0);
+    case UI_KEY_DELETE:
+      if (!has_selection && editor->caret >= ui_editor_length(editor)) return false;
+      if (!has_selection) editor->anchor = next_char(editor, editor->caret);
+      changed = replace_selection(editor, NULL, 0);
+      editor->anchor = editor->caret;
+      return changed;
+    case UI_KEY_ENTER:
+      return replace_selection(editor, "\n", 1);
+    case UI_KEY_TAB:
+      return replace_selection(editor, "\t", 1);
+    default:
+      return false;
+  }
+
+  // Vertical moves keep the column the caret had before they started
+  if (target != line) {
+    int count = ui_editor_line_count(editor);
+    if (target < 0) target = 0;
+    if (target >= count) target = count - 1;
+    editor->caret = offset_in_line(editor, target, editor->preferred_x);
+  } else {
+    editor->preferred_x = caret_x(editor, editor->caret);
+  }
+
+  if (!shift) editor->anchor = editor->caret;
+  return false;
+}
+
+static void scroll_to_caret(UITextEditor* editor, rect view, float line_height) {
+  float y = ui_editor_line_of(editor, editor->caret) * line_height;
+  if (y < editor->scroll.y) editor->scroll.y = y;
+  if (y + line_height > editor->scroll.y + view.size.y) editor->scroll.y = y + line_height - view.size.y;
+
+  float x = caret_x(editor, editor->caret);
+  if (x < editor->scroll.x) editor->scroll.x = x;
+  if (x + 2.0f > editor->scroll.x + view.size.x) editor->scroll.x = x + 2.0f - view.size.x;
+}
+
+/*
+ * Widget
+ */
+
+static bool point_in_rect(vec2 p, rect r) {
+  return p.x >= r.pos.x && p.x <= r.pos.x + r.size.x &&
+         p.y >= r.pos.y && p.y <= r.pos.y + r.size.y;
+}
+
+static void draw_line(UIContext* ctx, UITextEditor* editor, int line, rect view,
+  float top, float line_height) {
+  const UIEditorLine* layout = line_layout(editor, line);
+  if (!layout || layout->count == 0) return;
+
+  // Only the columns inside the view
+  float left = editor->scroll.x, right = editor->scroll.x + view.size.x;
+  uint32_t lo = 0, hi = layout->count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (layout->prefix[mid + 1] > left) hi = mid; else lo = mid + 1;
+  }
+  uint32_t first = lo;
+  hi = layout->count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (layout->prefix[mid] >= right) hi = mid; else lo = mid + 1;
+  }
+  uint32_t last = lo;
+  if (last <= first) return;
+
+  char* text = (char*)ui_arena_alloc(&ctx->frame_arena,
+    (last - first) * UI_EDITOR_TAB_SPACES + 1, 0);
+  if (!text) return;
+
+  size_t start = line_start_raw(editor, line);
+  size_t n = 0;
+  for (uint32_t i = first; i < last; i++) {
+    char ch = char_at(editor, start + i);
+    if (ch == '\t') {
+      for (int s = 0; s < UI_EDITOR_TAB_SPACES; s++) text[n++] = ' ';
+    } else {
+      text[n++] = ch;
+    }
+  }
+  text[n] = '\0';
+
+  vec2 position = {
+    view.pos.x - editor->scroll.x + layout->prefix[first],
+    top + line_height * 0.5f + 4.0f
+  };
+  ui_draw_text(ctx, text, position, (color){1.0f, 1.0f, 1.0f, 1.0f});
+}
+
+bool ui_text_editor(UIContext* ctx, const char* id, rect bounds, UITextEditor* editor) {
+  if (!ctx->font) return false;
+  UI_PROFILE_BEGIN(ctx, "ui_text_editor");
+  ui_id widget_id = ui_get_id(id);
+  bool changed = false;
+
+  // Placeholder widths are dropped once the font finishes rasterizing
+  bool font_ready = ui_font_ready(ctx->font);
+  if (editor->font != ctx->font || editor->font_ready != font_ready) {
+    editor->font = ctx->font;
+    editor->font_ready = font_ready;
+    editor->revision++;
+  }
+
+  ui_hit_add(ctx, widget_id, bounds);
+  bool hovered = ui_widget_hovered(ctx, widget_id, bounds);
+
+  float line_height = ctx->font_size + 4.0f;
+  rect view = {
+    {bounds.pos.x + EDITOR_PADDING, bounds.pos.y + EDITOR_PADDING},
+    {bounds.size.x - EDITOR_PADDING * 2, bounds.size.y - EDITOR_PADDING * 2}
+  };
+  int page_lines = (int)(view.size.y / line_height);
+  if (page_lines < 1) page_lines = 1;
+  bool follow_caret = false;
+
+  // Events in the order they happened, a press on the editor or elsewhere
+  // moves focus half way through
+  bool focused = ui_widget_focus_begin(ctx, widget_id);
+  for (int i = 0; i < ctx->event_count; i++) {
+    const UIInputEvent* event = &ctx->events[i];
+    focused = ui_widget_focus_event(ctx, widget_id, bounds, i, focused);
+
+    switch (event->type) {
+      case UI_EVENT_MOUSE_BUTTON:
+        if (event->button != 0) break;
+        if (!event->pressed || !focused) {
+          editor->dragging = false;
+        } else {
+          editor->caret = editor->anchor = offset_at_point(editor, view, line_height, event->mouse_pos);
+          editor->preferred_x = caret_x(editor, editor->caret);
+          editor->dragging = true;
+        }
+        break;
+      case UI_EVENT_MOUSE_MOVE:
+        if (editor->dragging && focused) {
+          editor->caret = offset_at_point(editor, view, line_height, event->mouse_pos);
+          editor->preferred_x = caret_x(editor, editor->caret);
+          follow_caret = true;
+        }
+        break;
+      case UI_EVENT_SCROLL:
+        if (point_in_rect(event->mouse_pos, bounds) && ui_hit_is_topmost(ctx, widget_id, event->mouse_pos)) {
+          editor->scroll.y -= event->scroll * line_height * 3.0f;
+        }
+        break;
+      case UI_EVENT_KEY:
+        if (focused && event->pressed) {
+          changed |= handle_key(editor, event, page_lines);
+          follow_caret = true;
+        }
+        break;
+      case UI_EVENT_CHAR:
+        if (focused && event->codepoint >= 32 && event->codepoint != 127) {
+          char bytes[4];
+          int length = ui_utf8_encode(event->codepoint, bytes);
+          if (length == 0) break;
+          changed |= replace_selection(editor, bytes, (size_t)length);
+          editor->preferred_x = caret_x(editor, editor->caret);
+          follow_caret = true;
+        }
+        break;
+    }
+  }
+  if (!ctx->mouse_buttons[0]) editor->dragging = false;
+
+  if (follow_caret) scroll_to_caret(editor, view, line_height);
+
+  int line_count = ui_editor_line_count(editor);
+  float max_scroll = line_count * line_height - view.size.y;
+  if (editor->scroll.y > max_scroll) editor->scroll.y = max_scroll;
+  if (editor->scroll.y < 0.0f) editor->scroll.y = 0.0f;
+  if (editor->scroll.x < 0.0f) editor->scroll.x = 0.0f;
+
+  bool is_focused = ctx->focused_widget == widget_id;
+  rect border = {{bounds.pos.x - 1, bounds.pos.y - 1}, {bounds.size.x + 2, bounds.size.y + 2}};
+  if (!ui_widget_visible(ctx, border)) {
+    UI_PROFILE_END(ctx);
+    return changed;
+  }
+
+  ui_draw_rect(ctx, border, is_focused ?
+    (color){0.3f, 0.3f, 0.8f, 1.0f} :
+    (color){0.0f, 0.0f, 0.0f, 1.0f});
+
+  color bg_color = {0.15f, 0.15f, 0.15f, 1.0f};
+  if (is_focused) {
+    bg_color.r += 0.05f;
+    bg_color.g += 0.05f;
+    bg_color.b += 0.15f;
+  } else if (hovered) {
+    bg_color.r += 0.05f;
+    bg_color.g += 0.05f;
+    bg_color.b += 0.05f;
+  }
+  ui_draw_rect(ctx, bounds, bg_color);
+
+  ui_push_clip(ctx, view);
+
+  size_t sel_min = editor->caret < editor->anchor ? editor->caret : editor->anchor;
+  size_t sel_max = editor->caret < editor->anchor ? editor->anchor : editor->caret;
+  float newline_width = ui_font_advance(ctx->font, ' ');
+
+  int first = (int)(editor->scroll.y / line_height);
+  int last = (int)((editor->scroll.y + view.size.y) / line_height);
+  if (last >= line_count) last = line_count - 1;
+
+  for (int line = first; line <= last; line++) {
+    float top = view.pos.y + line * line_height - editor->scroll.y;
+
+    // Selection behind the text, a selected newline shows as one space
+    if (sel_min != sel_max) {
+      size_t start = line_start_raw(editor, line);
+      size_t end = line_end(editor, line);
+      const UIEditorLine* layout = line_layout(editor, line);
+      if (layout && sel_min <= end && sel_max > start) {
+        float x0 = layout->prefix[(sel_min > start ? sel_min : start) - start];
+        float x1 = sel_max > end ? layout->prefix[layout->count] + newline_width :
+          layout->prefix[sel_max - start];
+        ui_draw_rect(ctx, (rect){{view.pos.x - editor->scroll.x + x0, top}, {x1 - x0, line_height}},
+          (color){0.25f, 0.35f, 0.6f, 1.0f});
+      }
+    }
+
+    draw_line(ctx, editor, line, view, top, line_height);
+  }
+
+  // Blinking caret
+  if (is_focused && ((int)(ctx->time * 2)) % 2 == 0) {
+    int line = ui_editor_line_of(editor, editor->caret);
+    rect caret = {
+      {view.pos.x - editor->scroll.x + caret_x(editor, editor->caret),
+       view.pos.y + line * line_height - editor->scroll.y + 2.0f},
+      {2.0f, line_height - 4.0f}
+    };
+    ui_draw_rect(ctx, caret, (color){1.0f, 1.0f, 1.0f, 1.0f});
+  }
+
+  ui_pop_clip(ctx);
+
+  UI_PROFILE_END(ctx);
+  return changed;
+}
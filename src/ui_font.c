@@ -0,0 +1,607 @@
+/*
+ * Tridme UI Fonts
+ *
+ * FreeType glyph rasterization into a CPU-side atlas, spread over worker
+ * threads that each own a FreeType instance.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_font.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_ADVANCES_H
+
+#define UI_FONT_MAX_ATLAS 4096
+
+static const char* default_font_paths[] = {
+  "HelveticaNeueRoman.otf",
+  "../HelveticaNeueRoman.otf",
+  "../../HelveticaNeueRoman.otf",
+  "/home/naufal/Documents/Projects/C_CXX_Projects/tridme-uic/HelveticaNeueRoman.otf"
+};
+
+// One glyph rasterized by a worker, packed by whoever finishes last
+typedef struct {
+  uint32_t codepoint;
+  bool found;
+  int width, rows;
+  int left, top;
+  float advance;
+  int worker;
+  size_t offset;              // Bitmap in the worker's pixel storage
+  int atlas_x, atlas_y;       // Packed position, -1 when the atlas was full
+} font_raster;
+
+typedef struct {
+  struct UIFontBuild* build;
+  int index;
+  uint32_t first, count;      // Slice of the build's rasters
+  unsigned char* pixels;      // Bitmaps of the slice, rows packed tightly
+  size_t used, capacity;
+  pthread_t thread;
+  bool started;
+} font_worker;
+
+typedef struct UIFontBuild {
+  UIFont* font;
+  unsigned char* file_data;   // Font file, shared read-only by every worker's face
+  size_t file_size;
+  font_raster* rasters;       // Sorted by codepoint
+  uint32_t raster_count;
+  font_worker workers[UI_FONT_MAX_THREADS];
+  int worker_count;
+
+  _Atomic int remaining;      // Workers still rasterizing
+  _Atomic bool cancel;
+  _Atomic bool ready;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t done;
+  bool finished;
+} UIFontBuild;
+
+static bool read_file(const char* path, const UIAllocator* allocator, unsigned char** data, size_t* size) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  *data = length > 0 ? (unsigned char*)ui_mem_alloc(allocator, (size_t)length) : NULL;
+  bool ok = *data && fread(*data, 1, (size_t)length, file) == (size_t)length;
+  fclose(file);
+
+  if (!ok) {
+    ui_mem_free(allocator, *data);
+    return false;
+  }
+  *size = (size_t)length;
+  return true;
+}
+
+static bool load_font_file(const char* path, const UIAllocator* allocator, unsigned char** data, size_t* size) {
+  if (path) {
+    return read_file(path, allocator, data, size);
+  }
+
+  int count = (int)(sizeof(default_font_paths) / sizeof(default_font_paths[0]));
+  for (int i = 0; i < count; i++) {
+    if (read_file(default_font_paths[i], allocator, data, size)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int compare_codepoints(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+  return x < y ? -1 : x > y;
+}
+
+static int compare_heights(const void* a, const void* b) {
+  const font_raster* x = *(const font_raster* const*)a;
+  const font_raster* y = *(const font_raster* const*)b;
+  return y->rows - x->rows;
+}
+
+/*
+ * Rasterization
+ */
+
+static bool store_bitmap(font_worker* worker, const FT_Bitmap* bitmap, font_raster* raster) {
+  size_t bytes = (size_t)bitmap->width * bitmap->rows;
+  if (worker->used + bytes > worker->capacity) {
+    size_t capacity = worker->capacity ? worker->capacity * 2 : 16384;
+    while (capacity < worker->used + bytes) capacity *= 2;
+
+    unsigned char* grown = (unsigned char*)ui_mem_alloc(&worker->build->font->allocator, capacity);
+    if (!grown) return false;
+    if (worker->used) memcpy(grown, worker->pixels, worker->used);
+    ui_mem_free(&worker->build->font->allocator, worker->pixels);
+    worker->pixels = grown;
+    worker->capacity = capacity;
+  }
+
+  for (unsigned int y = 0; y < bitmap->rows; y++) {
+    memcpy(worker->pixels + worker->used + (size_t)y * bitmap->width,
+      bitmap->buffer + (ptrdiff_t)y * bitmap->pitch, bitmap->width);
+  }
+  raster->offset = worker->used;
+  worker->used += bytes;
+  return true;
+}
+
+static void finish_build(UIFontBuild* build);
+
+static void* rasterize_slice(void* arg) {
+  font_worker* worker = (font_worker*)arg;
+  UIFontBuild* build = worker->build;
+
+  // FreeType objects are not shared between threads, every worker opens its own
+  FT_Library ft;
+  FT_Face face;
+  if (FT_Init_FreeType(&ft)) {
+    fprintf(stderr, "Could not init FreeType Library\n");
+  } else if (FT_New_Memory_Face(ft, build->file_data, (FT_Long)build->file_size, 0, &face)) {
+    fprintf(stderr, "Failed to load font in rasterizer thread\n");
+    FT_Done_FreeType(ft);
+  } else {
+    FT_Set_Pixel_Sizes(face, 0, (FT_UInt)build->font->size);
+
+    for (uint32_t i = 0; i < worker->count; i++) {
+      if (atomic_load_explicit(&build->cancel, memory_order_relaxed)) break;
+
+      font_raster* raster = &build->rasters[worker->first + i];
+      FT_UInt index = FT_Get_Char_Index(face, raster->codepoint);
+      if (index == 0 && raster->codepoint >= 128) continue;   // ASCII keeps .notdef
+
+      if (FT_Load_Glyph(face, index, FT_LOAD_RENDER)) {
+        fprintf(stderr, "Failed to load Glyph U+%04X\n", (unsigned)raster->codepoint);
+        continue;
+      }
+
+      FT_GlyphSlot g = face->glyph;
+      if (!store_bitmap(worker, &g->bitmap, raster)) {
+        fprintf(stderr, "Failed to allocate glyph bitmaps\n");
+        break;
+      }
+      raster->found = true;
+      raster->width = (int)g->bitmap.width;
+      raster->rows = (int)g->bitmap.rows;
+      raster->left = g->bitmap_left;
+      raster->top = g->bitmap_top;
+      raster->advance = (float)(g->advance.x >> 6); // Convert from 1/64th pixels
+      raster->worker = worker->index;
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+  }
+
+  if (atomic_fetch_sub_explicit(&build->remaining, 1, memory_order_acq_rel) == 1) {
+    finish_build(build);
+  }
+  return NULL;
+}
+
+/*
+ * Packing, on the last worker to finish
+ */
+
+static void pack_atlas(UIFontBuild* build) {
+  UIFont* font = build->font;
+  const UIAllocator* allocator = &font->allocator;
+
+  font_raster** order = (font_raster**)ui_mem_alloc(allocator, sizeof(font_raster*) * (build->raster_count + 1));
+  if (!order) {
+    fprintf(stderr, "Failed to allocate the font atlas\n");
+    return;
+  }
+
+  int found = 0, extra = 0;
+  size_t area = 25;
+  for (uint32_t i = 0; i < build->raster_count; i++) {
+    font_raster* raster = &build->rasters[i];
+    if (!raster->found) continue;
+    order[found++] = raster;
+    area += (size_t)(raster->width + 1) * (raster->rows + 1);
+    if (raster->codepoint >= 128) extra++;
+  }
+
+  // Tallest first keeps the shelves tight
+  qsort(order, (size_t)found, sizeof(font_raster*), compare_heights);
+
+  int atlas_width = 256;
+  while (atlas_width < UI_FONT_MAX_ATLAS && (size_t)atlas_width * atlas_width < area * 2) {
+    atlas_width *= 2;
+  }
+
+  // Shelf packing, a white block is reserved in the corner so solid rects
+  // can sample the same texture as text and stay in one draw call
+  int pen_x = 5;
+  int pen_y = 0;
+  int row_height = 5;
+  int packed = 0;
+  for (; packed < found; packed++) {
+    font_raster* raster = order[packed];
+    if (pen_x + raster->width >= atlas_width) {
+      pen_x = 0;
+      pen_y += row_height;
+      row_height = 0;
+    }
+    if (pen_y + raster->rows > UI_FONT_MAX_ATLAS) {
+      fprintf(stderr, "Font atlas is full, %d glyphs dropped\n", found - packed);
+      break;
+    }
+    raster->atlas_x = pen_x;
+    raster->atlas_y = pen_y;
+
+    pen_x += raster->width + 1; // 1 pixel padding
+    if (raster->rows + 1 > row_height) {
+      row_height = raster->rows + 1;
+    }
+  }
+  int atlas_height = (pen_y + row_height + 3) & ~3;
+
+  unsigned char* atlas_data = (unsigned char*)ui_mem_alloc(allocator, (size_t)atlas_width * atlas_height);
+  font->codepoints = extra ? (uint32_t*)ui_mem_alloc(allocator, sizeof(uint32_t) * extra) : NULL;
+  font->extra_glyphs = extra ? (ui_glyph_info*)ui_mem_alloc(allocator, sizeof(ui_glyph_info) * extra) : NULL;
+  if (!atlas_data || (extra && (!font->codepoints || !font->extra_glyphs))) {
+    fprintf(stderr, "Failed to allocate the font atlas\n");
+    ui_mem_free(allocator, atlas_data);
+    ui_mem_free(allocator, font->codepoints);
+    ui_mem_free(allocator, font->extra_glyphs);
+    font->codepoints = NULL;
+    font->extra_glyphs = NULL;
+    ui_mem_free(allocator, order);
+    return;
+  }
+  memset(atlas_data, 0, (size_t)atlas_width * atlas_height);
+  for (int y = 0; y < 4; y++) {
+    memset(atlas_data + y * atlas_width, 255, 4);
+  }
+
+  // Copy bitmaps and fill in the metrics; dropped glyphs keep zero size
+  for (int i = 0; i < packed; i++) {
+    font_raster* raster = order[i];
+    const unsigned char* bitmap = build->workers[raster->worker].pixels + raster->offset;
+    for (int row = 0; row < raster->rows; row++) {
+      memcpy(atlas_data + (size_t)(raster->atlas_y + row) * atlas_width + raster->atlas_x,
+        bitmap + (size_t)row * raster->width, (size_t)raster->width);
+    }
+  }
+
+  for (uint32_t i = 0, e = 0; i < build->raster_count; i++) {
+    const font_raster* raster = &build->rasters[i];
+    if (!raster->found) continue;
+
+    ui_glyph_info* glyph = raster->codepoint < 128 ? &font->glyphs[raster->codepoint] : &font->extra_glyphs[e];
+    if (raster->codepoint >= 128) font->codepoints[e++] = raster->codepoint;
+
+    memset(glyph, 0, sizeof(ui_glyph_info));
+    glyph->advance = raster->advance;
+    glyph->offset_x = (float)raster->left;
+    glyph->offset_y = (float)-raster->top;
+    if (raster->atlas_x >= 0) {
+      glyph->x = (float)raster->atlas_x / atlas_width;
+      glyph->y = (float)raster->atlas_y / atlas_height;
+      glyph->width = (float)raster->width / atlas_width;
+      glyph->height = (float)raster->rows / atlas_height;
+    }
+  }
+
+  font->extra_count = extra;
+  font->white_uv = (vec2){2.0f / atlas_width, 2.0f / atlas_height};
+  font->atlas_width = atlas_width;
+  font->atlas_height = atlas_height;
+  font->atlas_pixels = atlas_data;
+
+  ui_mem_free(allocator, order);
+}
+
+static void finish_build(UIFontBuild* build) {
+  if (!atomic_load_explicit(&build->cancel, memory_order_relaxed)) {
+    pack_atlas(build);
+  }
+
+  // Only the packed atlas and metrics outlive the build
+  const UIAllocator* allocator = &build->font->allocator;
+  for (int i = 0; i < build->worker_count; i++) {
+    ui_mem_free(allocator, build->workers[i].pixels);
+    build->workers[i].pixels = NULL;
+  }
+  ui_mem_free(allocator, build->rasters);
+  ui_mem_free(allocator, build->file_data);
+  build->rasters = NULL;
+  build->file_data = NULL;
+
+  atomic_store_explicit(&build->ready, true, memory_order_release);
+  pthread_mutex_lock(&build->mutex);
+  build->finished = true;
+  pthread_cond_broadcast(&build->done);
+  pthread_mutex_unlock(&build->mutex);
+}
+
+/*
+ * Font
+ */
+
+// Sorted, unique printable codepoints of the requested ranges
+static uint32_t* collect_codepoints(const UIFontDesc* desc, const UIAllocator* allocator, uint32_t* count) {
+  static const UIFontRange ascii = {32, 126};
+  const UIFontRange* ranges = desc->ranges ? desc->ranges : &ascii;
+  int range_count = desc->ranges ? desc->range_count : 1;
+
+  size_t total = 0;
+  for (int i = 0; i < range_count; i++) {
+    if (ranges[i].last >= ranges[i].first) total += (size_t)(ranges[i].last - ranges[i].first) + 1;
+  }
+
+  uint32_t* codepoints = (uint32_t*)ui_mem_alloc(allocator, sizeof(uint32_t) * (total + 1));
+  if (!codepoints) return NULL;
+
+  size_t n = 0;
+  for (int i = 0; i < range_count; i++) {
+    for (uint64_t c = ranges[i].first; c <= ranges[i].last; c++) {
+      if (c >= 32 && c != 127 && c <= 0x10FFFF) codepoints[n++] = (uint32_t)c;
+    }
+  }
+  qsort(codepoints, n, sizeof(uint32_t), compare_codepoints);
+
+  size_t unique = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (unique == 0 || codepoints[unique - 1] != codepoints[i]) codepoints[unique++] = codepoints[i];
+  }
+  *count = (uint32_t)unique;
+  return codepoints;
+}
+
+// Open the face once on the calling thread: validates the file and sizes the placeholders
+static bool probe_face(const unsigned char* data, size_t size, float pixel_size, float* placeholder_advance) {
+  FT_Library ft;
+  if (FT_Init_FreeType(&ft)) {
+    fprintf(stderr, "Could not init FreeType Library\n");
+    return false;
+  }
+
+  FT_Face face;
+  if (FT_New_Memory_Face(ft, data, (FT_Long)size, 0, &face)) {
+    FT_Done_FreeType(ft);
+    return false;
+  }
+
+  FT_Set_Pixel_Sizes(face, 0, (FT_UInt)pixel_size);
+  FT_Fixed advance = 0;
+  FT_UInt index = FT_Get_Char_Index(face, 'n');
+  if (index && FT_Get_Advance(face, index, FT_LOAD_DEFAULT, &advance) == 0 && advance > 0) {
+    *placeholder_advance = (float)(advance >> 16);
+  } else {
+    *placeholder_advance = pixel_size * 0.5f;
+  }
+
+  FT_Done_Face(face);
+  FT_Done_FreeType(ft);
+  return true;
+}
+
+static int default_thread_count(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (int)cores : 1;
+}
+
+UIFont* ui_font_create_async(const UIFontDesc* desc) {
+  const UIAllocator* allocator = desc->allocator ? desc->allocator : ui_default_allocator();
+
+  unsigned char* file_data = NULL;
+  size_t file_size = 0;
+  float placeholder_advance = 0.0f;
+  if (!load_font_file(desc->path, allocator, &file_data, &file_size) ||
+      !probe_face(file_data, file_size, desc->pixel_size, &placeholder_advance)) {
+    fprintf(stderr, "Failed to load font %s\n", desc->path ? desc->path : "from any path");
+    ui_mem_free(allocator, file_data);
+    return NULL;
+  }
+
+  uint32_t count = 0;
+  uint32_t* codepoints = collect_codepoints(desc, allocator, &count);
+  UIFont* font = (UIFont*)ui_mem_alloc(allocator, sizeof(UIFont));
+  UIFontBuild* build = (UIFontBuild*)ui_mem_alloc(allocator, sizeof(UIFontBuild));
+  font_raster* rasters = (font_raster*)ui_mem_alloc(allocator, sizeof(font_raster) * (count + 1));
+  if (!codepoints || !font || !build || !rasters) {
+    ui_mem_free(allocator, codepoints);
+    ui_mem_free(allocator, font);
+    ui_mem_free(allocator, build);
+    ui_mem_free(allocator, rasters);
+    ui_mem_free(allocator, file_data);
+    return NULL;
+  }
+
+  memset(font, 0, sizeof(UIFont));
+  font->allocator = *allocator;
+  font->size = desc->pixel_size;
+  font->placeholder_advance = placeholder_advance;
+  font->build = build;
+
+  memset(build, 0, sizeof(UIFontBuild));
+  build->font = font;
+  build->file_data = file_data;
+  build->file_size = file_size;
+  build->rasters = rasters;
+  build->raster_count = count;
+  memset(rasters, 0, sizeof(font_raster) * (count + 1));
+  for (uint32_t i = 0; i < count; i++) {
+    rasters[i].codepoint = codepoints[i];
+    rasters[i].atlas_x = rasters[i].atlas_y = -1;
+  }
+  ui_mem_free(allocator, codepoints);
+
+  atomic_init(&build->cancel, false);
+  atomic_init(&build->ready, false);
+  pthread_mutex_init(&build->mutex, NULL);
+  pthread_cond_init(&build->done, NULL);
+
+  // Disjoint slices, small glyph sets are not worth a thread each
+  int threads = desc->threads > 0 ? desc->threads : default_thread_count();
+  int useful = (int)((count + 31) / 32);
+  if (threads > useful) threads = useful;
+  if (threads > UI_FONT_MAX_THREADS) threads = UI_FONT_MAX_THREADS;
+  if (threads < 1) threads = 1;
+
+  build->worker_count = threads;
+  atomic_init(&build->remaining, threads);
+  for (int i = 0; i < threads; i++) {
+    font_worker* worker = &build->workers[i];
+    worker->build = build;
+    worker->index = i;
+    worker->first = (uint32_t)((uint64_t)count * i / threads);
+    worker->count = (uint32_t)((uint64_t)count * (i + 1) / threads) - worker->first;
+  }
+
+  // A slice whose thread cannot start is rasterized right here
+  for (int i = 0; i < threads; i++) {
+    font_worker* worker = &build->workers[i];
+    worker->started = pthread_create(&worker->thread, NULL, rasterize_slice, worker) == 0;
+    if (!worker->started) {
+      rasterize_slice(worker);
+    }
+  }
+
+  return font;
+}
+
+UIFont* ui_font_create(const char* path, float pixel_size, const UIAllocator* allocator) {
+  UIFontDesc desc = {0};
+  desc.path = path;
+  desc.pixel_size = pixel_size;
+  desc.allocator = allocator;
+
+  UIFont* font = ui_font_create_async(&desc);
+  if (font) {
+    ui_font_wait(font);
+  }
+  return font;
+}
+
+bool ui_font_ready(const UIFont* font) {
+  return !font->build || atomic_load_explicit(&font->build->ready, memory_order_acquire);
+}
+
+void ui_font_wait(const UIFont* font) {
+  UIFontBuild* build = font->build;
+  if (!build || atomic_load_explicit(&build->ready, memory_order_acquire)) return;
+
+  pthread_mutex_lock(&build->mutex);
+  while (!build->finished) {
+    pthread_cond_wait(&build->done, &build->mutex);
+  }
+  pthread_mutex_unlock(&build->mutex);
+}
+
+const ui_glyph_info* ui_font_glyph(const UIFont* font, uint32_t codepoint) {
+  if (!ui_font_ready(font)) return NULL;
+  if (codepoint < 128) return codepoint >= 32 ? &font->glyphs[codepoint] : NULL;
+
+  int lo = 0, hi = font->extra_count - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (font->codepoints[mid] == codepoint) return &font->extra_glyphs[mid];
+    if (font->codepoints[mid] < codepoint) lo = mid + 1; else hi = mid - 1;
+  }
+  return NULL;
+}
+
+float ui_font_advance(const UIFont* font, uint32_t codepoint) {
+  if (codepoint < 32) return 0.0f;
+  if (!ui_font_ready(font)) return font->placeholder_advance;
+
+  const ui_glyph_info* glyph = ui_font_glyph(font, codepoint);
+  return glyph ? glyph->advance : 0.0f;
+}
+
+int ui_utf8_decode(const char* text, size_t length, uint32_t* codepoint) {
+  const unsigned char* p = (const unsigned char*)text;
+  if (p[0] < 0x80) {
+    *codepoint = p[0];
+    return 1;
+  }
+
+  int extra = p[0] >= 0xF0 ? 3 : p[0] >= 0xE0 ? 2 : p[0] >= 0xC0 ? 1 : -1;
+  if (extra < 0 || p[0] > 0xF4 || (size_t)extra >= length) {
+    *codepoint = 0xFFFD;
+    return 1;
+  }
+
+  uint32_t c = p[0] & (0x3F >> extra);
+  for (int i = 1; i <= extra; i++) {
+    if ((p[i] & 0xC0) != 0x80) {
+      *codepoint = 0xFFFD;
+      return 1;
+    }
+    c = (c << 6) | (p[i] & 0x3F);
+  }
+
+  // Overlong forms and surrogates are malformed too
+  static const uint32_t min_value[4] = {0, 0x80, 0x800, 0x10000};
+  if (c < min_value[extra] || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+    *codepoint = 0xFFFD;
+    return 1;
+  }
+  *codepoint = c;
+  return extra + 1;
+}
+
+int ui_utf8_encode(uint32_t codepoint, char* out) {
+  unsigned char* p = (unsigned char*)out;
+  if (codepoint < 0x80) {
+    p[0] = (unsigned char)codepoint;
+    return 1;
+  }
+  if (codepoint < 0x800) {
+    p[0] = (unsigned char)(0xC0 | (codepoint >> 6));
+    p[1] = (unsigned char)(0x80 | (codepoint & 0x3F));
+    return 2;
+  }
+  if (codepoint >= 0xD800 && codepoint <= 0xDFFF) return 0;
+  if (codepoint < 0x10000) {
+    p[0] = (unsigned char)(0xE0 | (codepoint >> 12));
+    p[1] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+    p[2] = (unsigned char)(0x80 | (codepoint & 0x3F));
+    return 3;
+  }
+  if (codepoint > 0x10FFFF) return 0;
+  p[0] = (unsigned char)(0xF0 | (codepoint >> 18));
+  p[1] = (unsigned char)(0x80 | ((codepoint >> 12) & 0x3F));
+  p[2] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+  p[3] = (unsigned char)(0x80 | (codepoint & 0x3F));
+  return 4;
+}
+
+void ui_font_destroy(UIFont* font) {
+  if (!font) return;
+
+  UIAllocator allocator = font->allocator;
+  UIFontBuild* build = font->build;
+  if (build) {
+    atomic_store_explicit(&build->cancel, true, memory_order_relaxed);
+    for (int i = 0; i < build->worker_count; i++) {
+      if (build->workers[i].started) pthread_join(build->workers[i].thread, NULL);
+    }
+    pthread_cond_destroy(&build->done);
+    pthread_mutex_destroy(&build->mutex);
+    ui_mem_free(&allocator, build);
+  }
+
+  ui_mem_free(&allocator, font->atlas_pixels);
+  ui_mem_free(&allocator, font->codepoints);
+  ui_mem_free(&allocator, font->extra_glyphs);
+  ui_mem_free(&allocator, font);
+}
@@ -0,0 +1,236 @@
+/*
+ * Tridme UI Hit Testing
+ *
+ * Per-frame interactive rects in z-order, binned into a uniform grid so the
+ * next frame finds the topmost widget under a point by scanning one cell.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_hit.h>
+#include <ui_draw.h>
+#include <ui_input.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+static bool point_in_rect(vec2 p, rect r) {
+  return p.x >= r.pos.x && p.x <= r.pos.x + r.size.x &&
+         p.y >= r.pos.y && p.y <= r.pos.y + r.size.y;
+}
+
+// Grow a persistent array to hold `needed` elements, contents are not kept
+static bool reserve(const UIAllocator* allocator, void** ptr, uint32_t* capacity,
+  uint32_t needed, size_t element_size) {
+  if (needed <= *capacity) return true;
+
+  uint32_t size = *capacity ? *capacity : 64;
+  while (size < needed) size <<= 1;
+
+  void* grown = ui_mem_alloc(allocator, element_size * size);
+  if (!grown) return false;
+  ui_mem_free(allocator, *ptr);
+  *ptr = grown;
+  *capacity = size;
+  return true;
+}
+
+static int cell_coord(float v, int count) {
+  int c = (int)floorf(v / UI_HIT_CELL_SIZE);
+  return c < 0 ? 0 : (c >= count ? count - 1 : c);
+}
+
+UIHitIndex* ui_hit_index_create(const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  UIHitIndex* index = (UIHitIndex*)ui_mem_alloc(allocator, sizeof(UIHitIndex));
+  if (!index) return NULL;
+  memset(index, 0, sizeof(UIHitIndex));
+  index->allocator = *allocator;
+  return index;
+}
+
+void ui_hit_index_destroy(UIHitIndex* index) {
+  if (!index) return;
+
+  UIAllocator allocator = index->allocator;
+  ui_mem_free(&allocator, index->rects);
+  ui_mem_free(&allocator, index->cell_start);
+  ui_mem_free(&allocator, index->cell_items);
+  ui_mem_free(&allocator, index);
+}
+
+bool ui_hit_index_build(UIHitIndex* index, const UIHitRect* rects, int count,
+  int width, int height) {
+  const UIAllocator* allocator = &index->allocator;
+  index->rect_count = 0;
+  index->cols = index->rows = 0;
+  if (count <= 0) return true;
+
+  int cols = (int)ceilf((width > 0 ? width : 1) / UI_HIT_CELL_SIZE);
+  int rows = (int)ceilf((height > 0 ? height : 1) / UI_HIT_CELL_SIZE);
+  uint32_t cells = (uint32_t)(cols * rows);
+
+  if (!reserve(allocator, (void**)&index->rects, &index->rect_capacity, count, sizeof(UIHitRect)) ||
+      !reserve(allocator, (void**)&index->cell_start, &index->cell_capacity, cells + 1, sizeof(uint32_t))) {
+    fprintf(stderr, "Failed to allocate the hit test grid\n");
+    return false;
+  }
+  memcpy(index->rects, rects, sizeof(UIHitRect) * count);
+
+  // Count rects per cell, then turn the counts into start offsets
+  uint32_t* start = index->cell_start;
+  memset(start, 0, sizeof(uint32_t) * (cells + 1));
+  for (int i = 0; i < count; i++) {
+    rect r = rects[i].r;
+    int x0 = cell_coord(r.pos.x, cols), x1 = cell_coord(r.pos.x + r.size.x, cols);
+    int y0 = cell_coord(r.pos.y, rows), y1 = cell_coord(r.pos.y + r.size.y, rows);
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        start[y * cols + x + 1]++;
+      }
+    }
+  }
+  for (uint32_t c = 0; c < cells; c++) {
+    start[c + 1] += start[c];
+  }
+
+  if (!reserve(allocator, (void**)&index->cell_items, &index->item_capacity, start[cells], sizeof(uint32_t))) {
+    fprintf(stderr, "Failed to allocate the hit test grid\n");
+    return false;
+  }
+
+  // Fill in z-order, start[c] walks forward and ends on the next cell's offset
+  for (int i = 0; i < count; i++) {
+    rect r = rects[i].r;
+    int x0 = cell_coord(r.pos.x, cols), x1 = cell_coord(r.pos.x + r.size.x, cols);
+    int y0 = cell_coord(r.pos.y, rows), y1 = cell_coord(r.pos.y + r.size.y, rows);
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        index->cell_items[start[y * cols + x]++] = (uint32_t)i;
+      }
+    }
+  }
+  memmove(start + 1, start, sizeof(uint32_t) * cells);
+  start[0] = 0;
+
+  index->rect_count = (uint32_t)count;
+  index->cols = cols;
+  index->rows = rows;
+  return true;
+}
+
+void ui_hit_add(UIContext* ctx, uint32_t id, rect r) {
+  // Only the visible part of a widget can be hit
+  rect clip = ui_current_clip(ctx);
+  float x0 = fmaxf(r.pos.x, clip.pos.x);
+  float y0 = fmaxf(r.pos.y, clip.pos.y);
+  float x1 = fminf(r.pos.x + r.size.x, clip.pos.x + clip.size.x);
+  float y1 = fminf(r.pos.y + r.size.y, clip.pos.y + clip.size.y);
+  if (x1 < x0 || y1 < y0) return;
+
+  if (ctx->hit_count >= ctx->hit_capacity) {
+    int capacity = ctx->hit_capacity ? ctx->hit_capacity * 2 : 64;
+    UIHitRect* grown = (UIHitRect*)ui_arena_grow(&ctx->frame_arena, ctx->hit_rects,
+      sizeof(UIHitRect) * ctx->hit_capacity, sizeof(UIHitRect) * capacity, 0);
+    if (!grown) return;
+    ctx->hit_rects = grown;
+    ctx->hit_capacity = capacity;
+  }
+
+  ctx->hit_rects[ctx->hit_count++] = (UIHitRect){{{x0, y0}, {x1 - x0, y1 - y0}}, id};
+}
+
+uint32_t ui_hit_test(UIContext* ctx, vec2 point) {
+  const UIHitIndex* index = ctx->hit_index;
+  if (!index || index->rect_count == 0) return 0;
+
+  int cell = cell_coord(point.y, index->rows) * index->cols + cell_coord(point.x, index->cols);
+
+  // Topmost first
+  for (uint32_t i = index->cell_start[cell + 1]; i > index->cell_start[cell]; i--) {
+    const UIHitRect* hit = &index->rects[index->cell_items[i - 1]];
+    if (point_in_rect(point, hit->r)) return hit->id;
+  }
+  return 0;
+}
+
+bool ui_hit_is_topmost(UIContext* ctx, uint32_t id, vec2 point) {
+  uint32_t hit = ui_hit_test(ctx, point);
+  return hit == 0 || hit == id;
+}
+
+bool ui_widget_hovered(UIContext* ctx, uint32_t id, rect r) {
+  if (!point_in_rect(ctx->mouse_pos, r)) return false;
+  return ctx->hover_id == 0 || ctx->hover_id == id;
+}
+
+int ui_widget_click_count(UIContext* ctx, uint32_t id, rect r, int button) {
+  int count = 0;
+  for (int i = 0; i < ctx->event_count; i++) {
+    const UIInputEvent* event = &ctx->events[i];
+    if (event->type != UI_EVENT_MOUSE_BUTTON || !event->pressed || event->button != button) continue;
+
+    if (point_in_rect(event->mouse_pos, r) && ui_hit_is_topmost(ctx, id, event->mouse_pos)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+bool ui_widget_focus_begin(UIContext* ctx, uint32_t id) {
+  return ctx->frame_focused_widget == id;
+}
+
+bool ui_widget_focus_event(UIContext* ctx, uint32_t id, rect r, int index, bool focused) {
+  const UIInputEvent* event = &ctx->events[index];
+  if (event->type != UI_EVENT_MOUSE_BUTTON || !event->pressed || event->button != 0) return focused;
+
+  // Widgets that ran earlier may have seen later presses already, those win
+  bool latest = index >= ctx->focus_event;
+  if (point_in_rect(event->mouse_pos, r) && ui_hit_is_topmost(ctx, id, event->mouse_pos)) {
+    if (latest) {
+      ctx->focused_widget = id;
+      ctx->focus_event = index;
+    }
+    return true;
+  }
+  if (latest && ctx->focused_widget == id) {
+    ctx->focused_widget = 0;
+    ctx->focus_event = index;
+  }
+  return false;
+}
+
+void ui_hit_merge_regions(UIContext* ctx) {
+  int total = ctx->hit_count;
+  for (int i = 0; i < ctx->region_count; i++) {
+    total += ctx->regions[i]->hit_count;
+  }
+  if (total == ctx->hit_count) return;
+
+  UIHitRect* merged = (UIHitRect*)ui_arena_alloc(&ctx->frame_arena, sizeof(UIHitRect) * total, 0);
+  if (!merged) return;
+
+  // Same interleaving as the draw commands: each region sits where it was begun
+  int count = 0;
+  int next_region = 0;
+  for (int i = 0; i <= ctx->hit_count; i++) {
+    while (next_region < ctx->region_count &&
+           ctx->regions[next_region]->region_hit_insert_at == i) {
+      UIContext* region = ctx->regions[next_region++];
+      if (region->hit_count > 0) {
+        memcpy(merged + count, region->hit_rects, sizeof(UIHitRect) * region->hit_count);
+        count += region->hit_count;
+      }
+    }
+
+    if (i < ctx->hit_count) {
+      merged[count++] = ctx->hit_rects[i];
+    }
+  }
+
+  ctx->hit_rects = merged;
+  ctx->hit_count = count;
+  ctx->hit_capacity = total;
+}
@@ -0,0 +1,473 @@
+/*
+ * Tridme UI Images
+ *
+ * RGBA images packed at runtime into shared atlas pages with a skyline
+ * packer, reference counted and repacked once released space piles up.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_image.h>
+#include <ui_draw.h>
+#include <ui_upload.h>
+#include <ui_widgets.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define PAGE UI_IMAGE_PAGE_SIZE
+#define BORDER 1                    // Texels repeated around every image
+
+// Ids pack a slot index (plus one, so 0 is never valid) and a generation
+#define ID_INDEX_BITS 20
+#define ID_INDEX_MASK ((1u << ID_INDEX_BITS) - 1)
+
+// Top edge of the packed area from x to x + width
+typedef struct skyline_node {
+  int x, y, width;
+} skyline_node;
+
+// Every node is at least one texel wide, a page never needs more
+typedef struct skyline {
+  skyline_node nodes[PAGE];
+  int count;
+} skyline;
+
+typedef struct image_page {
+  ui_texture_id texture;
+  unsigned char* pixels;      // CPU copy the uploads read from
+  skyline packer;
+  int image_count;
+  int64_t wasted;             // Released area the skyline cannot reuse
+} image_page;
+
+typedef struct image_slot {
+  int x, y;                   // Padded block in the page
+  int width, height;          // Image size, the block is 2 * BORDER larger
+  int page;                   // -1 while free
+  int refs;
+  uint32_t generation;
+  int next_free;
+} image_slot;
+
+typedef struct UIImageAtlas {
+  UIAllocator allocator;
+  image_page* pages[UI_IMAGE_MAX_PAGES];
+  int page_count;
+  image_slot* slots;
+  int slot_count, slot_capacity;
+  int free_slot;              // Head of the free list, -1: none
+} UIImageAtlas;
+
+static void skyline_reset(skyline* s) {
+  s->nodes[0] = (skyline_node){0, 0, PAGE};
+  s->count = 1;
+}
+
+// Lowest y a width x height block can rest at with its left edge on node
+// index, -1 if it does not fit
+static int skyline_fit(const skyline* s, int index, int width, int height) {
+  int x = s->nodes[index].x;
+  if (x + width > PAGE) return -1;
+
+  int y = 0;
+  for (int i = index, remaining = width; remaining > 0; i++) {
+    if (s->nodes[i].y > y) y = s->nodes[i].y;
+    if (y + height > PAGE) return -1;
+    remaining -= s->nodes[i].width;
+  }
+  return y;
+}
+
+// Bottom-left placement: lowest top edge, then the narrowest node to waste
+// as little as possible of the gaps under the skyline
+static bool skyline_find(const skyline* s, int width, int height, int* out_index, int* out_y) {
+  int best = -1, best_y = PAGE, best_width = PAGE + 1;
+  for (int i = 0; i < s->count; i++) {
+    int y = skyline_fit(s, i, width, height);
+    if (y < 0) continue;
+    if (y < best_y || (y == best_y && s->nodes[i].width < best_width)) {
+      best = i;
+      best_y = y;
+      best_width = s->nodes[i].width;
+    }
+  }
+  if (best < 0) return false;
+
+  *out_index = best;
+  *out_y = best_y;
+  return true;
+}
+
+static void skyline_add(skyline* s, int index, int y, int width, int height) {
+  int x = s->nodes[index].x;
+
+  memmove(&s->nodes[index + 1], &s->nodes[index], sizeof(skyline_node) * (s->count - index));
+  s->nodes[index] = (skyline_node){x, y + height, width};
+  s->count++;
+
+  // Trim the nodes now covered by the new one
+  for (int i = index + 1; i < s->count;) {
+    skyline_node* node = &s->nodes[i];
+    int covered = x + width - node->x;
+    if (covered <= 0) break;
+    if (covered < node->width) {
+      node->x += covered;
+      node->width -= covered;
+      break;
+    }
+    memmove(node, node + 1, sizeof(skyline_node) * (s->count - i - 1));
+    s->count--;
+  }
+
+  // Merge neighbours at the same height
+  for (int i = 0; i + 1 < s->count;) {
+    if (s->nodes[i].y == s->nodes[i + 1].y) {
+      s->nodes[i].width += s->nodes[i + 1].width;
+      memmove(&s->nodes[i + 1], &s->nodes[i + 2], sizeof(skyline_node) * (s->count - i - 2));
+      s->count--;
+    } else {
+      i++;
+    }
+  }
+}
+
+static bool skyline_insert(skyline* s, int width, int height, int* x, int* y) {
+  int index;
+  if (!skyline_find(s, width, height, &index, y)) return false;
+  *x = s->nodes[index].x;
+  skyline_add(s, index, *y, width, height);
+  return true;
+}
+
+static int64_t block_area(const image_slot* slot) {
+  return (int64_t)(slot->width + 2 * BORDER) * (slot->height + 2 * BORDER);
+}
+
+static image_slot* find_slot(const UIImageAtlas* atlas, ui_image_id image) {
+  if (!atlas || image == 0) return NULL;
+
+  uint32_t index = (image & ID_INDEX_MASK) - 1;
+  if (index >= (uint32_t)atlas->slot_count) return NULL;
+
+  image_slot* slot = &atlas->slots[index];
+  if (slot->page < 0 || slot->generation != image >> ID_INDEX_BITS) return NULL;
+  return slot;
+}
+
+// Copy an image into its block and repeat its edge texels in the border
+static void blit_block(unsigned char* page_pixels, int x, int y, const unsigned char* src,
+  int width, int height, int stride) {
+  size_t page_stride = (size_t)PAGE * 4;
+  for (int row = -BORDER; row < height + BORDER; row++) {
+    int src_row = row < 0 ? 0 : row >= height ? height - 1 : row;
+    const unsigned char* s = src + (size_t)src_row * stride;
+    unsigned char* d = page_pixels + (size_t)(y + BORDER + row) * page_stride + (size_t)x * 4;
+
+    for (int b = 0; b < BORDER; b++) memcpy(d + b * 4, s, 4);
+    memcpy(d + BORDER * 4, s, (size_t)width * 4);
+    for (int b = 0; b < BORDER; b++) memcpy(d + (BORDER + width + b) * 4, s + (size_t)(width - 1) * 4, 4);
+  }
+}
+
+static UIImageAtlas* get_atlas(UIContext* ctx) {
+  if (ctx->images) return ctx->images;
+
+  UIImageAtlas* atlas = (UIImageAtlas*)ui_mem_alloc(&ctx->allocator, sizeof(UIImageAtlas));
+  if (!atlas) return NULL;
+  memset(atlas, 0, sizeof(UIImageAtlas));
+  atlas->allocator = ctx->allocator;
+  atlas->free_slot = -1;
+  ctx->images = atlas;
+  return atlas;
+}
+
+static image_page* add_page(UIContext* ctx, UIImageAtlas* atlas) {
+  if (atlas->page_count >= UI_IMAGE_MAX_PAGES) return NULL;
+
+  image_page* page = (image_page*)ui_mem_alloc(&atlas->allocator, sizeof(image_page));
+  if (!page) return NULL;
+  memset(page, 0, sizeof(image_page));
+
+  page->pixels = (unsigned char*)ui_mem_alloc(&atlas->allocator, (size_t)PAGE * PAGE * 4);
+  if (!page->pixels) {
+    ui_mem_free(&atlas->allocator, page);
+    return NULL;
+  }
+  memset(page->pixels, 0, (size_t)PAGE * PAGE * 4);
+
+  // Texels are only ever sampled once an image uploaded them
+  page->texture = ctx->backend->create_texture(ctx->backend->user, PAGE, PAGE, UI_TEXTURE_RGBA8, NULL);
+  if (!page->texture ||
+      !ui_texture_track(ctx, page->texture, UI_TEXTURE_RGBA8, page->pixels, PAGE, PAGE, PAGE * 4)) {
+    if (page->texture) ctx->backend->destroy_texture(ctx->backend->user, page->texture);
+    ui_mem_free(&atlas->allocator, page->pixels);
+    ui_mem_free(&atlas->allocator, page);
+    return NULL;
+  }
+
+  skyline_reset(&page->packer);
+  atlas->pages[atlas->page_count++] = page;
+  return page;
+}
+
+typedef struct repack_entry {
+  int slot;
+  int width, height;          // Padded
+  int x, y;                   // New position
+} repack_entry;
+
+static int compare_taller(const void* a, const void* b) {
+  const repack_entry* ea = (const repack_entry*)a;
+  const repack_entry* eb = (const repack_entry*)b;
+  if (ea->height != eb->height) return eb->height - ea->height;
+  return eb->width - ea->width;
+}
+
+// Pack a page's live images again from scratch, tallest first. Nothing moves
+// unless they all fit, and then the page is not retried until more is released
+static bool repack_page(UIContext* ctx, UIImageAtlas* atlas, int page_index) {
+  image_page* page = atlas->pages[page_index];
+
+  if (page->image_count == 0) {
+    skyline_reset(&page->packer);
+    page->wasted = 0;
+    return true;
+  }
+
+  repack_entry* entries = (repack_entry*)ui_mem_alloc(&atlas->allocator,
+    sizeof(repack_entry) * page->image_count);
+  skyline* packer = (skyline*)ui_mem_alloc(&atlas->allocator, sizeof(skyline));
+  unsigned char* pixels = (unsigned char*)ui_mem_alloc(&atlas->allocator, (size_t)PAGE * PAGE * 4);
+  bool packed = entries && packer && pixels;
+
+  int count = 0;
+  for (int i = 0; packed && i < atlas->slot_count; i++) {
+    const image_slot* slot = &atlas->slots[i];
+    if (slot->page != page_index) continue;
+    entries[count++] = (repack_entry){i, slot->width + 2 * BORDER, slot->height + 2 * BORDER, 0, 0};
+  }
+
+  if (packed) {
+    qsort(entries, count, sizeof(repack_entry), compare_taller);
+    skyline_reset(packer);
+    for (int i = 0; i < count && packed; i++) {
+      packed = skyline_insert(packer, entries[i].width, entries[i].height, &entries[i].x, &entries[i].y);
+    }
+  }
+
+  if (packed) {
+    memset(pixels, 0, (size_t)PAGE * PAGE * 4);
+    size_t page_stride = (size_t)PAGE * 4;
+    for (int i = 0; i < count; i++) {
+      image_slot* slot = &atlas->slots[entries[i].slot];
+      for (int row = 0; row < entries[i].height; row++) {
+        memcpy(pixels + (size_t)(entries[i].y + row) * page_stride + (size_t)entries[i].x * 4,
+          page->pixels + (size_t)(slot->y + row) * page_stride + (size_t)slot->x * 4,
+          (size_t)entries[i].width * 4);
+      }
+      slot->x = entries[i].x;
+      slot->y = entries[i].y;
+    }
+
+    unsigned char* old = page->pixels;
+    page->pixels = pixels;
+    page->packer = *packer;
+    pixels = old;
+
+    ui_texture_track(ctx, page->texture, UI_TEXTURE_RGBA8, page->pixels, PAGE, PAGE, PAGE * 4);
+    ui_texture_mark_dirty(ctx, page->texture, 0, 0, PAGE, PAGE, true);
+  }
+
+  page->wasted = 0;
+  if (entries) ui_mem_free(&atlas->allocator, entries);
+  if (packer) ui_mem_free(&atlas->allocator, packer);
+  if (pixels) ui_mem_free(&atlas->allocator, pixels);
+  return packed;
+}
+
+static int alloc_slot(UIImageAtlas* atlas) {
+  if (atlas->free_slot >= 0) {
+    int index = atlas->free_slot;
+    atlas->free_slot = atlas->slots[index].next_free;
+    return index;
+  }
+
+  if (atlas->slot_count >= (int)ID_INDEX_MASK) return -1;
+  if (atlas->slot_count == atlas->slot_capacity) {
+    int capacity = atlas->slot_capacity ? atlas->slot_capacity * 2 : 64;
+    image_slot* slots = (image_slot*)ui_mem_alloc(&atlas->allocator, sizeof(image_slot) * capacity);
+    if (!slots) return -1;
+    if (atlas->slots) {
+      memcpy(slots, atlas->slots, sizeof(image_slot) * atlas->slot_count);
+      ui_mem_free(&atlas->allocator, atlas->slots);
+    }
+    atlas->slots = slots;
+    atlas->slot_capacity = capacity;
+  }
+
+  atlas->slots[atlas->slot_count].generation = 0;
+  return atlas->slot_count++;
+}
+
+ui_image_id ui_image_create(UIContext* ctx, const void* pixels, int width, int height,
+  int stride) {
+  if (!ctx->backend || !ctx->backend->update_texture) {
+    fprintf(stderr, "Backend cannot update textures, images are unavailable\n");
+    return 0;
+  }
+  if (!pixels || width <= 0 || height <= 0 ||
+      width > PAGE - 2 * BORDER || height > PAGE - 2 * BORDER) {
+    fprintf(stderr, "Image size %dx%d does not fit an atlas page\n", width, height);
+    return 0;
+  }
+
+  UIImageAtlas* atlas = get_atlas(ctx);
+  if (!atlas) return 0;
+
+  int block_width = width + 2 * BORDER;
+  int block_height = height + 2 * BORDER;
+  int64_t needed = (int64_t)block_width * block_height;
+
+  // First fit among the pages, then a new page, then repack the page with the
+  // most released space, as long as that space could hold the image
+  int page_index = -1, x = 0, y = 0;
+  for (int i = 0; i < atlas->page_count && page_index < 0; i++) {
+    if (skyline_insert(&atlas->pages[i]->packer, block_width, block_height, &x, &y)) page_index = i;
+  }
+  if (page_index < 0 && add_page(ctx, atlas)) {
+    page_index = atlas->page_count - 1;
+    skyline_insert(&atlas->pages[page_index]->packer, block_width, block_height, &x, &y);
+  }
+  while (page_index < 0) {
+    int candidate = -1;
+    for (int i = 0; i < atlas->page_count; i++) {
+      int64_t wasted = atlas->pages[i]->wasted;
+      if (wasted >= needed && (candidate < 0 || wasted > atlas->pages[candidate]->wasted)) candidate = i;
+    }
+    if (candidate < 0) break;
+
+    if (repack_page(ctx, atlas, candidate) &&
+        skyline_insert(&atlas->pages[candidate]->packer, block_width, block_height, &x, &y)) {
+      page_index = candidate;
+    }
+  }
+  if (page_index < 0) {
+    fprintf(stderr, "Image atlas is full\n");
+    return 0;
+  }
+
+  int index = alloc_slot(atlas);
+  if (index < 0) {
+    // The block stays packed but unused, count it as released space
+    atlas->pages[page_index]->wasted += needed;
+    return 0;
+  }
+
+  image_page* page = atlas->pages[page_index];
+  blit_block(page->pixels, x, y, (const unsigned char*)pixels, width, height, stride);
+  ui_texture_mark_dirty(ctx, page->texture, x, y, block_width, block_height, true);
+  page->image_count++;
+
+  image_slot* slot = &atlas->slots[index];
+  slot->x = x;
+  slot->y = y;
+  slot->width = width;
+  slot->height = height;
+  slot->page = page_index;
+  slot->refs = 1;
+  return (slot->generation << ID_INDEX_BITS) | (uint32_t)(index + 1);
+}
+
+void ui_image_retain(UIContext* ctx, ui_image_id image) {
+  image_slot* slot = find_slot(ctx->images, image);
+  if (slot) slot->refs++;
+}
+
+void ui_image_release(UIContext* ctx, ui_image_id image) {
+  UIImageAtlas* atlas = ctx->images;
+  image_slot* slot = find_slot(atlas, image);
+  if (!slot || --slot->refs > 0) return;
+
+  image_page* page = atlas->pages[slot->page];
+  page->image_count--;
+  page->wasted += block_area(slot);
+  if (page->image_count == 0) {
+    skyline_reset(&page->packer);
+    page->wasted = 0;
+  }
+
+  // A new generation makes every copy of the id stale
+  int index = (int)(slot - atlas->slots);
+  slot->page = -1;
+  slot->generation = (slot->generation + 1) & (UINT32_MAX >> ID_INDEX_BITS);
+  slot->next_free = atlas->free_slot;
+  atlas->free_slot = index;
+}
+
+bool ui_image_size(UIContext* ctx, ui_image_id image, int* width, int* height) {
+  const image_slot* slot = find_slot(ctx->images, image);
+  if (!slot) return false;
+  if (width) *width = slot->width;
+  if (height) *height = slot->height;
+  return true;
+}
+
+void ui_image(UIContext* ctx, ui_image_id image, rect bounds, color tint) {
+  const UIImageAtlas* atlas = ctx->images;
+  const image_slot* slot = find_slot(atlas, image);
+  if (!slot || !ui_widget_visible(ctx, bounds)) return;
+
+  const float texel = 1.0f / PAGE;
+  float u0 = (float)(slot->x + BORDER) * texel;
+  float v0 = (float)(slot->y + BORDER) * texel;
+  float u1 = (float)(slot->x + BORDER + slot->width) * texel;
+  float v1 = (float)(slot->y + BORDER + slot->height) * texel;
+
+  ui_vertex vertices[4] = {
+    {{bounds.pos.x, bounds.pos.y}, {u0, v0}, tint, 0},
+    {{bounds.pos.x + bounds.size.x, bounds.pos.y}, {u1, v0}, tint, 0},
+    {{bounds.pos.x + bounds.size.x, bounds.pos.y + bounds.size.y}, {u1, v1}, tint, 0},
+    {{bounds.pos.x, bounds.pos.y + bounds.size.y}, {u0, v1}, tint, 0}
+  };
+  ui_draw_list_add_quad(ctx, atlas->pages[slot->page]->texture, UI_PIPELINE_RGBA, vertices);
+}
+
+int ui_images_defragment(UIContext* ctx) {
+  UIImageAtlas* atlas = ctx->images;
+  if (!atlas) return 0;
+
+  int repacked = 0;
+  for (int i = 0; i < atlas->page_count; i++) {
+    if (atlas->pages[i]->wasted > 0 && repack_page(ctx, atlas, i)) repacked++;
+  }
+  return repacked;
+}
+
+void ui_images_compact(UIContext* ctx) {
+  UIImageAtlas* atlas = ctx->images;
+  if (!atlas) return;
+
+  const int64_t threshold = (int64_t)((float)PAGE * PAGE * UI_IMAGE_COMPACT_WASTE);
+  for (int i = 0; i < atlas->page_count; i++) {
+    if (atlas->pages[i]->wasted >= threshold) repack_page(ctx, atlas, i);
+  }
+}
+
+void ui_images_destroy(UIContext* ctx) {
+  UIImageAtlas* atlas = ctx->images;
+  if (!atlas) return;
+
+  for (int i = 0; i < atlas->page_count; i++) {
+    image_page* page = atlas->pages[i];
+    ui_texture_untrack(ctx, page->texture);
+    ctx->backend->destroy_texture(ctx->backend->user, page->texture);
+    ui_mem_free(&atlas->allocator, page->pixels);
+    ui_mem_free(&atlas->allocator, page);
+  }
+  if (atlas->slots) ui_mem_free(&atlas->allocator, atlas->slots);
+
+  UIAllocator allocator = atlas->allocator;
+  ui_mem_free(&allocator, atlas);
+  ctx->images = NULL;
+}
@@ -0,0 +1,509 @@
+/*
+ * Tridme UI Image Loader
+ *
+ * Worker threads read, decode and scale image files; the UI thread moves
+ * the results into the image atlas under a per-frame budget.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_image_loader.h>
+#include <ui_decode.h>
+#include <ui_backend.h>
+#include <ui_widgets.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// Ids pack a slot index (plus one, so 0 is never valid) and a generation
+#define ID_INDEX_BITS 20
+#define ID_INDEX_MASK ((1u << ID_INDEX_BITS) - 1)
+
+typedef struct load_slot {
+  UIImageLoadState state;     // UI_IMAGE_LOAD_NONE while free
+  uint32_t generation;
+  int next_free;
+
+  char* path;                 // Owned by the worker while decoding
+  int raw_width, raw_height;  // Raw RGBA file when non-zero
+  int priority;
+  uint64_t order;             // Request order, older first among equals
+  uint64_t seen_frame;        // Last loader frame it was drawn in
+
+  unsigned char* pixels;      // Decoded, until moved into the atlas
+  int width, height;
+  ui_image_id image;
+} load_slot;
+
+typedef struct UIImageLoader {
+  UIContext* ctx;
+  UIAllocator allocator;
+  int max_size;
+  size_t frame_budget;
+
+  // Slots are only reallocated by the UI thread, under the mutex
+  load_slot* slots;
+  int slot_count, slot_capacity;
+  int free_slot;
+  int queued;                 // Requests in UI_IMAGE_LOAD_QUEUED
+  size_t pending_bytes;       // Decoded pixels not in the atlas yet
+  uint64_t next_order;
+  uint64_t frame;
+
+  int* scratch;               // Decoded slots sorted by update
+  int scratch_capacity;
+
+  pthread_t threads[UI_IMAGE_LOADER_MAX_THREADS];
+  int thread_count;
+  pthread_mutex_t mutex;
+  pthread_cond_t work;        // Signaled on new requests and freed pending space
+  bool stop;
+} UIImageLoader;
+
+static load_slot* find_slot(UIImageLoader* loader, ui_image_request request) {
+  if (request == 0) return NULL;
+
+  uint32_t index = (request & ID_INDEX_MASK) - 1;
+  if (index >= (uint32_t)loader->slot_count) return NULL;
+
+  load_slot* slot = &loader->slots[index];
+  if (slot->state == UI_IMAGE_LOAD_NONE || slot->generation != request >> ID_INDEX_BITS) return NULL;
+  return slot;
+}
+
+static bool visible(const UIImageLoader* loader, const load_slot* slot) {
+  return slot->seen_frame + 1 >= loader->frame && slot->seen_frame > 0;
+}
+
+// Does a go before b: visible first, then higher priority, then older
+static bool comes_first(const UIImageLoader* loader, const load_slot* a, const load_slot* b) {
+  bool va = visible(loader, a), vb = visible(loader, b);
+  if (va != vb) return va;
+  if (a->priority != b->priority) return a->priority > b->priority;
+  return a->order < b->order;
+}
+
+/*
+ * Decoding (worker threads, no lock held)
+ */
+
+static bool read_file(const char* path, const UIAllocator* allocator, unsigned char** data, size_t* size) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  *data = length > 0 ? (unsigned char*)ui_mem_alloc(allocator, (size_t)length) : NULL;
+  bool ok = *data && fread(*data, 1, (size_t)length, file) == (size_t)length;
+  fclose(file);
+
+  if (!ok) {
+    ui_mem_free(allocator, *data);
+    return false;
+  }
+  *size = (size_t)length;
+  return true;
+}
+
+// Box filter down to fit max_size, colors weighted by alpha so transparent
+// texels do not darken the edges
+static unsigned char* downscale(const UIAllocator* allocator, const unsigned char* src,
+  int width, int height, int max_size, int* out_width, int* out_height) {
+  int larger = width > height ? width : height;
+  int dw = (int)((int64_t)width * max_size / larger);
+  int dh = (int)((int64_t)height * max_size / larger);
+  if (dw < 1) dw = 1;
+  if (dh < 1) dh = 1;
+
+  unsigned char* dst = (unsigned char*)ui_mem_alloc(allocator, (size_t)dw * dh * 4);
+  if (!dst) return NULL;
+
+  for (int y = 0; y < dh; y++) {
+    int sy0 = (int)((int64_t)y * height / dh);
+    int sy1 = (int)((int64_t)(y + 1) * height / dh);
+    for (int x = 0; x < dw; x++) {
+      int sx0 = (int)((int64_t)x * width / dw);
+      int sx1 = (int)((int64_t)(x + 1) * width / dw);
+
+      uint64_t r = 0, g = 0, b = 0, a = 0, count = 0;
+      for (int sy = sy0; sy < sy1; sy++) {
+        const unsigned char* p = src + ((size_t)sy * width + sx0) * 4;
+        for (int sx = sx0; sx < sx1; sx++, p += 4) {
+          r += (uint64_t)p[0] * p[3];
+          g += (uint64_t)p[1] * p[3];
+          b += (uint64_t)p[2] * p[3];
+          a += p[3];
+          count++;
+        }
+      }
+
+      unsigned char* out = dst + ((size_t)y * dw + x) * 4;
+      out[0] = a ? (unsigned char)(r / a) : 0;
+      out[1] = a ? (unsigned char)(g / a) : 0;
+      out[2] = a ? (unsigned char)(b / a) : 0;
+      out[3] = (unsigned char)(a / count);
+    }
+  }
+
+  *out_width = dw;
+  *out_height = dh;
+  return dst;
+}
+
+static unsigned char* decode(UIImageLoader* loader, const char* path, int raw_width, int raw_height,
+  int* width, int* height) {
+  const UIAllocator* allocator = &loader->allocator;
+  unsigned char* data;
+  size_t size;
+  if (!read_file(path, allocator, &data, &size)) {
+    fprintf(stderr, "Failed to read image %s\n", path);
+    return NULL;
+  }
+
+  unsigned char* pixels = NULL;
+  if (raw_width > 0) {
+    if (size == (size_t)raw_width * raw_height * 4) {
+      pixels = data;
+      data = NULL;
+      *width = raw_width;
+      *height = raw_height;
+    } else {
+      fprintf(stderr, "Raw image %s is not %dx%d RGBA\n", path, raw_width, raw_height);
+    }
+  } else {
+    pixels = ui_decode_image(data, size, allocator, width, height);
+    if (!pixels) fprintf(stderr, "Failed to decode image %s\n", path);
+  }
+  ui_mem_free(allocator, data);
+
+  if (pixels && (*width > loader->max_size || *height > loader->max_size)) {
+    unsigned char* scaled = downscale(allocator, pixels, *width, *height, loader->max_size, width, height);
+    ui_mem_free(allocator, pixels);
+    pixels = scaled;
+  }
+  return pixels;
+}
+
+static int pick_request(UIImageLoader* loader) {
+  int best = -1;
+  for (int i = 0; i < loader->slot_count && loader->queued > 0; i++) {
+    const load_slot* slot = &loader->slots[i];
+    if (slot->state != UI_IMAGE_LOAD_QUEUED) continue;
+    if (best < 0 || comes_first(loader, slot, &loader->slots[best])) best = i;
+  }
+  return best;
+}
+
+static void* decode_requests(void* arg) {
+  UIImageLoader* loader = (UIImageLoader*)arg;
+
+  pthread_mutex_lock(&loader->mutex);
+  while (!loader->stop) {
+    int index = loader->pending_bytes < UI_IMAGE_LOADER_MAX_PENDING ? pick_request(loader) : -1;
+    if (index < 0) {
+      pthread_cond_wait(&loader->work, &loader->mutex);
+      continue;
+    }
+
+    load_slot* slot = &loader->slots[index];
+    uint32_t generation = slot->generation;
+    char* path = slot->path;
+    int raw_width = slot->raw_width, raw_height = slot->raw_height;
+    slot->path = NULL;
+    slot->state = UI_IMAGE_LOAD_DECODING;
+    loader->queued--;
+    pthread_mutex_unlock(&loader->mutex);
+
+    int width = 0, height = 0;
+    unsigned char* pixels = decode(loader, path, raw_width, raw_height, &width, &height);
+    ui_mem_free(&loader->allocator, path);
+
+    pthread_mutex_lock(&loader->mutex);
+    slot = &loader->slots[index];  // The array may have grown meanwhile
+    if (slot->state == UI_IMAGE_LOAD_DECODING && slot->generation == generation) {
+      slot->pixels = pixels;
+      slot->width = width;
+      slot->height = height;
+      slot->state = pixels ? UI_IMAGE_LOAD_DECODED : UI_IMAGE_LOAD_FAILED;
+      if (pixels) loader->pending_bytes += (size_t)width * height * 4;
+    } else {
+      ui_mem_free(&loader->allocator, pixels);  // Cancelled meanwhile
+    }
+  }
+  pthread_mutex_unlock(&loader->mutex);
+  return NULL;
+}
+
+/*
+ * UI thread
+ */
+
+static int default_thread_count(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int threads = cores > 1 ? (int)cores - 1 : 1;
+  return threads > 4 ? 4 : threads;
+}
+
+UIImageLoader* ui_image_loader_create(UIContext* ctx, const UIImageLoaderDesc* desc) {
+  UIImageLoaderDesc defaults = {0};
+  if (!desc) desc = &defaults;
+  const UIAllocator* allocator = desc->allocator ? desc->allocator : ui_default_allocator();
+
+  if (!ctx->backend || !ctx->backend->update_texture) {
+    fprintf(stderr, "Backend cannot update textures, images are unavailable\n");
+    return NULL;
+  }
+
+  UIImageLoader* loader = (UIImageLoader*)ui_mem_alloc(allocator, sizeof(UIImageLoader));
+  if (!loader) return NULL;
+  memset(loader, 0, sizeof(UIImageLoader));
+
+  loader->ctx = ctx;
+  loader->allocator = *allocator;
+  loader->max_size = desc->max_size > 0 && desc->max_size < UI_IMAGE_PAGE_SIZE - 2
+    ? desc->max_size : UI_IMAGE_PAGE_SIZE - 2;
+  loader->frame_budget = desc->frame_budget ? desc->frame_budget : ctx->upload_budget;
+  loader->free_slot = -1;
+  loader->frame = 1;
+  pthread_mutex_init(&loader->mutex, NULL);
+  pthread_cond_init(&loader->work, NULL);
+
+  int threads = desc->threads > 0 ? desc->threads : default_thread_count();
+  if (threads > UI_IMAGE_LOADER_MAX_THREADS) threads = UI_IMAGE_LOADER_MAX_THREADS;
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&loader->threads[loader->thread_count], NULL, decode_requests, loader) == 0) {
+      loader->thread_count++;
+    }
+  }
+  if (loader->thread_count == 0) {
+    fprintf(stderr, "Failed to start image loading threads\n");
+    ui_image_loader_destroy(loader);
+    return NULL;
+  }
+  return loader;
+}
+
+static void free_slot(UIImageLoader* loader, load_slot* slot) {
+  if (slot->state == UI_IMAGE_LOAD_DECODED) loader->pending_bytes -= (size_t)slot->width * slot->height * 4;
+  if (slot->state == UI_IMAGE_LOAD_QUEUED) loader->queued--;
+  if (slot->image) ui_image_release(loader->ctx, slot->image);
+  ui_mem_free(&loader->allocator, slot->path);
+  ui_mem_free(&loader->allocator, slot->pixels);
+
+  // A new generation makes every copy of the request stale, and tells a
+  // worker decoding it to throw the result away
+  uint32_t generation = (slot->generation + 1) & (UINT32_MAX >> ID_INDEX_BITS);
+  memset(slot, 0, sizeof(load_slot));
+  slot->generation = generation;
+  slot->next_free = loader->free_slot;
+  loader->free_slot = (int)(slot - loader->slots);
+}
+
+void ui_image_loader_destroy(UIImageLoader* loader) {
+  if (!loader) return;
+
+  pthread_mutex_lock(&loader->mutex);
+  loader->stop = true;
+  pthread_cond_broadcast(&loader->work);
+  pthread_mutex_unlock(&loader->mutex);
+  for (int i = 0; i < loader->thread_count; i++) {
+    pthread_join(loader->threads[i], NULL);
+  }
+
+  for (int i = 0; i < loader->slot_count; i++) {
+    if (loader->slots[i].state != UI_IMAGE_LOAD_NONE) free_slot(loader, &loader->slots[i]);
+  }
+  pthread_mutex_destroy(&loader->mutex);
+  pthread_cond_destroy(&loader->work);
+
+  UIAllocator allocator = loader->allocator;
+  ui_mem_free(&allocator, loader->slots);
+  ui_mem_free(&allocator, loader->scratch);
+  ui_mem_free(&allocator, loader);
+}
+
+static ui_image_request queue_request(UIImageLoader* loader, const char* path, int raw_width,
+  int raw_height, int priority) {
+  size_t length = strlen(path);
+  char* copy = (char*)ui_mem_alloc(&loader->allocator, length + 1);
+  if (!copy) return 0;
+  memcpy(copy, path, length + 1);
+
+  pthread_mutex_lock(&loader->mutex);
+
+  int index = loader->free_slot;
+  if (index >= 0) {
+    loader->free_slot = loader->slots[index].next_free;
+  } else {
+    if (loader->slot_count == loader->slot_capacity) {
+      int capacity = loader->slot_capacity ? loader->slot_capacity * 2 : 256;
+      load_slot* slots = capacity <= (int)ID_INDEX_MASK
+        ? (load_slot*)ui_mem_alloc(&loader->allocator, sizeof(load_slot) * capacity) : NULL;
+      if (!slots) {
+        pthread_mutex_unlock(&loader->mutex);
+        ui_mem_free(&loader->allocator, copy);
+        return 0;
+      }
+      if (loader->slots) {
+        memcpy(slots, loader->slots, sizeof(load_slot) * loader->slot_count);
+        ui_mem_free(&loader->allocator, loader->slots);
+      }
+      loader->slots = slots;
+      loader->slot_capacity = capacity;
+    }
+    index = loader->slot_count++;
+    memset(&loader->slots[index], 0, sizeof(load_slot));
+  }
+
+  load_slot* slot = &loader->slots[index];
+  slot->state = UI_IMAGE_LOAD_QUEUED;
+  slot->path = copy;
+  slot->raw_width = raw_width;
+  slot->raw_height = raw_height;
+  slot->priority = priority;
+  slot->order = loader->next_order++;
+  slot->seen_frame = 0;
+  ui_image_request request = (slot->generation << ID_INDEX_BITS) | (uint32_t)(index + 1);
+
+  loader->queued++;
+  pthread_cond_signal(&loader->work);
+  pthread_mutex_unlock(&loader->mutex);
+  return request;
+}
+
+ui_image_request ui_image_load(UIImageLoader* loader, const char* path, int priority) {
+  return queue_request(loader, path, 0, 0, priority);
+}
+
+ui_image_request ui_image_load_raw(UIImageLoader* loader, const char* path, int width,
+  int height, int priority) {
+  if (width <= 0 || height <= 0 || width > UI_DECODE_MAX_SIZE || height > UI_DECODE_MAX_SIZE) {
+    fprintf(stderr, "Raw image size %dx%d is invalid\n", width, height);
+    return 0;
+  }
+  return queue_request(loader, path, width, height, priority);
+}
+
+void ui_image_load_set_priority(UIImageLoader* loader, ui_image_request request, int priority) {
+  pthread_mutex_lock(&loader->mutex);
+  load_slot* slot = find_slot(loader, request);
+  if (slot) slot->priority = priority;
+  pthread_mutex_unlock(&loader->mutex);
+}
+
+void ui_image_load_cancel(UIImageLoader* loader, ui_image_request request) {
+  pthread_mutex_lock(&loader->mutex);
+  load_slot* slot = find_slot(loader, request);
+  if (slot) free_slot(loader, slot);
+  pthread_cond_broadcast(&loader->work);  // Pending space may have been freed
+  pthread_mutex_unlock(&loader->mutex);
+}
+
+UIImageLoadState ui_image_load_state(UIImageLoader* loader, ui_image_request request) {
+  pthread_mutex_lock(&loader->mutex);
+  load_slot* slot = find_slot(loader, request);
+  UIImageLoadState state = slot ? slot->state : UI_IMAGE_LOAD_NONE;
+  pthread_mutex_unlock(&loader->mutex);
+  return state;
+}
+
+ui_image_id ui_image_load_result(UIImageLoader* loader, ui_image_request request) {
+  pthread_mutex_lock(&loader->mutex);
+  load_slot* slot = find_slot(loader, request);
+  ui_image_id image = slot ? slot->image : 0;
+  pthread_mutex_unlock(&loader->mutex);
+  return image;
+}
+
+// Insertion sort, the decoded backlog is a handful of images
+static void sort_decoded(UIImageLoader* loader, int* order, int count) {
+  for (int i = 1; i < count; i++) {
+    int index = order[i];
+    int j = i - 1;
+    while (j >= 0 && comes_first(loader, &loader->slots[index], &loader->slots[order[j]])) {
+      order[j + 1] = order[j];
+      j--;
+    }
+    order[j + 1] = index;
+  }
+}
+
+void ui_image_loader_update(UIImageLoader* loader) {
+  // Collect the decoded images under the lock. Workers never touch a slot
+  // once it is decoded, so moving them into the atlas needs no lock
+  pthread_mutex_lock(&loader->mutex);
+  loader->frame++;
+
+  int count = 0;
+  for (int i = 0; i < loader->slot_count; i++) {
+    if (loader->slots[i].state != UI_IMAGE_LOAD_DECODED) continue;
+    if (count == loader->scratch_capacity) {
+      int capacity = loader->scratch_capacity ? loader->scratch_capacity * 2 : 64;
+      int* scratch = (int*)ui_mem_alloc(&loader->allocator, sizeof(int) * capacity);
+      if (!scratch) break;
+      if (loader->scratch) {
+        memcpy(scratch, loader->scratch, sizeof(int) * count);
+        ui_mem_free(&loader->allocator, loader->scratch);
+      }
+      loader->scratch = scratch;
+      loader->scratch_capacity = capacity;
+    }
+    loader->scratch[count++] = i;
+  }
+  sort_decoded(loader, loader->scratch, count);
+  pthread_mutex_unlock(&loader->mutex);
+
+  // At least one image per frame, however large
+  size_t spent = 0;
+  int moved = 0;
+  for (int i = 0; i < count; i++) {
+    load_slot* slot = &loader->slots[loader->scratch[i]];
+    size_t bytes = (size_t)slot->width * slot->height * 4;
+    if (moved > 0 && spent + bytes > loader->frame_budget) break;
+
+    ui_image_id image = ui_image_create(loader->ctx, slot->pixels, slot->width, slot->height,
+      slot->width * 4);
+    spent += bytes;
+    moved++;
+
+    pthread_mutex_lock(&loader->mutex);
+    ui_mem_free(&loader->allocator, slot->pixels);
+    slot->pixels = NULL;
+    slot->image = image;
+    slot->state = image ? UI_IMAGE_LOAD_READY : UI_IMAGE_LOAD_FAILED;
+    loader->pending_bytes -= bytes;
+    pthread_mutex_unlock(&loader->mutex);
+  }
+
+  if (moved > 0) {
+    pthread_mutex_lock(&loader->mutex);
+    pthread_cond_broadcast(&loader->work);
+    pthread_mutex_unlock(&loader->mutex);
+  }
+}
+
+void ui_image_async(UIContext* ctx, UIImageLoader* loader, ui_image_request request,
+  rect bounds, color tint) {
+  if (!ui_widget_visible(ctx, bounds)) return;
+
+  pthread_mutex_lock(&loader->mutex);
+  load_slot* slot = find_slot(loader, request);
+  ui_image_id image = 0;
+  bool pending = false;
+  if (slot) {
+    slot->seen_frame = loader->frame;
+    image = slot->image;
+    pending = slot->state != UI_IMAGE_LOAD_FAILED && !image;
+  }
+  pthread_mutex_unlock(&loader->mutex);
+
+  if (image) {
+    ui_image(ctx, image, bounds, tint);
+  } else if (pending) {
+    ui_draw_rect(ctx, bounds, (color){tint.r, tint.g, tint.b, tint.a * 0.08f});
+  }
+}
@@ -0,0 +1,202 @@
+/*
+ * Tridme UI Input
+ *
+ * Lock-free single-producer / single-consumer event queue. The host (or an
+ * input thread) pushes, ui_begin_frame drains.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_input.h>
+#include <ui_profile.h>
+#include <string.h>
+#include <stdio.h>
+
+UIInputQueue* ui_input_queue_create(uint32_t capacity, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  uint32_t size = 64;
+  while (size < capacity) size <<= 1;
+
+  UIInputQueue* queue = (UIInputQueue*)ui_mem_alloc(allocator, sizeof(UIInputQueue));
+  if (!queue) return NULL;
+  memset(queue, 0, sizeof(UIInputQueue));
+
+  queue->events = (UIInputEvent*)ui_mem_alloc(allocator, sizeof(UIInputEvent) * size);
+  if (!queue->events) {
+    ui_mem_free(allocator, queue);
+    return NULL;
+  }
+
+  queue->allocator = *allocator;
+  queue->capacity = size;
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+  atomic_init(&queue->dropped, 0);
+  return queue;
+}
+
+void ui_input_queue_destroy(UIInputQueue* queue) {
+  if (!queue) return;
+
+  UIAllocator allocator = queue->allocator;
+  ui_mem_free(&allocator, queue->events);
+  ui_mem_free(&allocator, queue);
+}
+
+bool ui_input_queue_push(UIInputQueue* queue, const UIInputEvent* event) {
+  uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+  if (head - tail >= queue->capacity) {
+    atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+    return false;
+  }
+
+  queue->events[head & (queue->capacity - 1)] = *event;
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return true;
+}
+
+uint32_t ui_input_queue_pop(UIInputQueue* queue, UIInputEvent* out, uint32_t max) {
+  uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+  uint32_t count = head - tail;
+  if (count > max) count = max;
+
+  for (uint32_t i = 0; i < count; i++) {
+    out[i] = queue->events[(tail + i) & (queue->capacity - 1)];
+  }
+
+  // Slots are free for the producer only once they have been copied out
+  atomic_store_explicit(&queue->tail, tail + count, memory_order_release);
+  return count;
+}
+
+bool ui_push_event(UIContext* ctx, const UIInputEvent* event) {
+  if (!ctx->input_queue) return false;
+
+  UIInputEvent copy = *event;
+  if (copy.time_ns == 0) copy.time_ns = ui_profile_now_ns();
+  return ui_input_queue_push(ctx->input_queue, &copy);
+}
+
+const UIInputEvent* ui_get_events(UIContext* ctx, int* count) {
+  *count = ctx->event_count;
+  return ctx->events;
+}
+
+void ui_set_mouse_position(UIContext* ctx, float x, float y) {
+  UIInputQueue* queue = ctx->input_queue;
+  if (!queue) return;
+
+  // Hosts usually poll every frame, only real movement becomes an event
+  if (queue->has_mouse_pos && queue->last_mouse_pos.x == x && queue->last_mouse_pos.y == y) {
+    return;
+  }
+
+  UIInputEvent event = {
+    .type = UI_EVENT_MOUSE_MOVE,
+    .mouse_pos = {x, y}
+  };
+  if (ui_push_event(ctx, &event)) {
+    queue->last_mouse_pos = event.mouse_pos;
+    queue->has_mouse_pos = true;
+  }
+}
+
+void ui_set_mouse_button(UIContext* ctx, int button, bool pressed) {
+  UIInputQueue* queue = ctx->input_queue;
+  if (!queue || button < 0 || button >= 3) return;
+  if (queue->last_buttons[button] == pressed) return;
+
+  UIInputEvent event = {
+    .type = UI_EVENT_MOUSE_BUTTON,
+    .button = button,
+    .pressed = pressed
+  };
+  if (ui_push_event(ctx, &event)) {
+    queue->last_buttons[button] = pressed;
+  }
+}
+
+void ui_set_key(UIContext* ctx, int key, bool pressed) {
+  ui_set_key_mods(ctx, key, pressed, 0);
+}
+
+void ui_set_key_mods(UIContext* ctx, int key, bool pressed, int mods) {
+  UIInputEvent event = {
+    .type = UI_EVENT_KEY,
+    .key = key,
+    .mods = mods,
+    .pressed = pressed
+  };
+  ui_push_event(ctx, &event);
+}
+
+void ui_set_scroll(UIContext* ctx, float offset) {
+  UIInputEvent event = {
+    .type = UI_EVENT_SCROLL,
+    .scroll = offset
+  };
+  ui_push_event(ctx, &event);
+}
+
+void ui_input_char(UIContext* ctx, unsigned int codepoint) {
+  UIInputEvent event = {
+    .type = UI_EVENT_CHAR,
+    .codepoint = codepoint
+  };
+  ui_push_event(ctx, &event);
+}
+
+void ui_input_begin_frame(UIContext* ctx) {
+  // Button state as the last frame ended, for edge detection by polling widgets
+  memcpy(ctx->prev_mouse_buttons, ctx->mouse_buttons, sizeof(ctx->mouse_buttons));
+  ctx->scroll_offset = 0;
+  ctx->events = NULL;
+  ctx->event_count = 0;
+
+  UIInputQueue* queue = ctx->input_queue;
+  if (!queue) return;
+
+  // Take what is there now, later pushes wait for the next frame
+  uint32_t available = atomic_load_explicit(&queue->head, memory_order_acquire) -
+    atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  if (available == 0) return;
+
+  UIInputEvent* events = (UIInputEvent*)ui_arena_alloc(&ctx->frame_arena,
+    sizeof(UIInputEvent) * available, 0);
+  if (!events) {
+    fprintf(stderr, "Failed to allocate %u input events\n", available);
+    return;
+  }
+  uint32_t count = ui_input_queue_pop(queue, events, available);
+
+  // Replay in order so the state after the frame's input matches the host's
+  for (uint32_t i = 0; i < count; i++) {
+    UIInputEvent* event = &events[i];
+    switch (event->type) {
+      case UI_EVENT_MOUSE_MOVE:
+        ctx->mouse_pos = event->mouse_pos;
+        break;
+      case UI_EVENT_MOUSE_BUTTON:
+        if (event->button >= 0 && event->button < 3) {
+          ctx->mouse_buttons[event->button] = event->pressed;
+        }
+        break;
+      case UI_EVENT_SCROLL:
+        ctx->scroll_offset += event->scroll;
+        break;
+      default:
+        break;
+    }
+    event->mouse_pos = ctx->mouse_pos;
+  }
+
+  ctx->events = events;
+  ctx->event_count = (int)count;
+  UI_STAT_ADD(ctx, input_events, count);
+  UI_STAT_ADD(ctx, input_dropped, atomic_exchange_explicit(&queue->dropped, 0, memory_order_relaxed));
+}
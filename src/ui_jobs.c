@@ -0,0 +1,181 @@
+/*
+ * Tridme UI Jobs
+ *
+ * Minimal fork-join thread pool behind the UIJobSystem interface.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_jobs.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <stdio.h>
+
+struct UIThreadPool {
+  UIAllocator allocator;
+  pthread_t* threads;
+  int thread_count;
+
+  pthread_mutex_t batch_lock;   // Held by the caller for the whole batch
+  pthread_mutex_t mutex;        // Guards everything below
+  pthread_cond_t wake;
+  pthread_cond_t done;
+
+  // Current batch
+  ui_job_fn fn;
+  void** args;
+  int count;
+  atomic_int next;
+  atomic_int remaining;
+  int active;                   // Workers still inside the batch
+  unsigned int generation;
+  bool quit;
+};
+
+static void execute_jobs(UIThreadPool* pool, ui_job_fn fn, void** args, int count) {
+  int i;
+  while ((i = atomic_fetch_add(&pool->next, 1)) < count) {
+    fn(args[i]);
+    atomic_fetch_sub(&pool->remaining, 1);
+  }
+}
+
+static void* worker_main(void* arg) {
+  UIThreadPool* pool = (UIThreadPool*)arg;
+  unsigned int seen = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+  for (;;) {
+    while (!pool->quit && pool->generation == seen) {
+      pthread_cond_wait(&pool->wake, &pool->mutex);
+    }
+    if (pool->quit) break;
+
+    // Copy the batch under the lock, the caller cannot start another until we leave
+    seen = pool->generation;
+    ui_job_fn fn = pool->fn;
+    void** args = pool->args;
+    int count = pool->count;
+    pool->active++;
+    pthread_mutex_unlock(&pool->mutex);
+
+    execute_jobs(pool, fn, args, count);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->active--;
+    pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+UIThreadPool* ui_thread_pool_create(int thread_count, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+  if (thread_count < 0) thread_count = 0;
+
+  UIThreadPool* pool = (UIThreadPool*)ui_mem_alloc(allocator, sizeof(UIThreadPool));
+  if (!pool) return NULL;
+  memset(pool, 0, sizeof(UIThreadPool));
+
+  pool->allocator = *allocator;
+  pthread_mutex_init(&pool->batch_lock, NULL);
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  if (thread_count > 0) {
+    pool->threads = (pthread_t*)ui_mem_alloc(allocator, sizeof(pthread_t) * thread_count);
+    if (!pool->threads) {
+      ui_thread_pool_destroy(pool);
+      return NULL;
+    }
+  }
+
+  for (int i = 0; i < thread_count; i++) {
+    if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+      fprintf(stderr, "Failed to create UI worker thread\n");
+      break;
+    }
+    pool->thread_count++;
+  }
+
+  return pool;
+}
+
+void ui_thread_pool_destroy(UIThreadPool* pool) {
+  if (!pool) return;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->quit = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (int i = 0; i < pool->thread_count; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_mutex_destroy(&pool->batch_lock);
+
+  UIAllocator allocator = pool->allocator;
+  ui_mem_free(&allocator, pool->threads);
+  ui_mem_free(&allocator, pool);
+}
+
+void ui_thread_pool_run(UIThreadPool* pool, ui_job_fn fn, void** args, int count) {
+  if (count <= 0) return;
+
+  if (pool->thread_count == 0 || count == 1) {
+    for (int i = 0; i < count; i++) fn(args[i]);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->batch_lock);
+
+  pthread_mutex_lock(&pool->mutex);
+  // A worker that woke up late for the previous batch may still hold its arguments
+  while (pool->active > 0) {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+
+  pool->fn = fn;
+  pool->args = args;
+  pool->count = count;
+  atomic_store(&pool->next, 0);
+  atomic_store(&pool->remaining, count);
+  pool->generation++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  // The calling thread works on the batch too
+  execute_jobs(pool, fn, args, count);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (atomic_load(&pool->remaining) > 0 || pool->active > 0) {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  pthread_mutex_unlock(&pool->batch_lock);
+}
+
+static void pool_run(void* user, ui_job_fn fn, void** args, int count) {
+  ui_thread_pool_run((UIThreadPool*)user, fn, args, count);
+}
+
+UIJobSystem ui_thread_pool_jobs(UIThreadPool* pool) {
+  UIJobSystem jobs = { pool_run, pool };
+  return jobs;
+}
+
+void ui_jobs_run(const UIJobSystem* jobs, ui_job_fn fn, void** args, int count) {
+  if (jobs && jobs->run) {
+    jobs->run(jobs->user, fn, args, count);
+    return;
+  }
+
+  for (int i = 0; i < count; i++) fn(args[i]);
+}
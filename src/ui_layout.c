@@ -1,37 +1,40 @@
 #include <ui_layout.h>
+#include <ui_draw.h>
+#include <ui_widgets.h>
+#include <ui_profile.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <math.h>
 
-#define MAX_VBOXES 32
-static VBoxState g_vboxes[MAX_VBOXES];
-static int g_active_vbox_count = 0;
+// Find or create vbox state, the slots live in the context
+static VBoxState* get_vbox_state(UIContext* ctx, const char* id) {
+  VBoxState* vboxes = ctx->vboxes;
 
-// Find or create vbox state
-static VBoxState* get_vbox_state(const char* id) {
   // Hash the ID to find slot (simplified)
   uint32_t hash = 0;
   for (const char* p = id; *p; p++) {
     hash = (hash * 31) + *p;
   }
-  int slot = hash % MAX_VBOXES;
+  int slot = hash % UI_MAX_VBOXES;
   
   // Linear probe if slot is occupied by different ID
-  for (int i = 0; i < MAX_VBOXES; i++) {
-    int idx = (slot + i) % MAX_VBOXES;
-    if (!g_vboxes[idx].is_active || strcmp(g_vboxes[idx].id, id) == 0) {
-      return &g_vboxes[idx];
+  for (int i = 0; i < UI_MAX_VBOXES; i++) {
+    int idx = (slot + i) % UI_MAX_VBOXES;
+    if (!vboxes[idx].is_active || strcmp(vboxes[idx].id, id) == 0) {
+      return &vboxes[idx];
     }
   }
   return NULL; // No space (shouldn't happen with reasonable usage)
 }
 
 void ui_vbox_begin_ex(UIContext* ctx, const char* id, rect bounds, const VBoxConfig* config) {
-  VBoxState* vbox = get_vbox_state(id);
+  VBoxState* vbox = get_vbox_state(ctx, id);
   if (!vbox) return;
   
   // Initialize or reset
   vbox->is_active = true;
+  vbox->bounds = bounds;
   vbox->cursor = (vec2){bounds.pos.x + (config ? config->padding_left : 0),
                         bounds.pos.y + (config ? config->padding_top : 0)};
   vbox->max_widget_width = 0;
@@ -54,14 +57,16 @@ void ui_vbox_begin_ex(UIContext* ctx, const char* id, rect bounds, const VBoxCon
       };
   }
   
-  // Store ID
-  size_t len = strlen(id);
-  vbox->id = malloc(len + 1);
-  strcpy(vbox->id, id);
+  // Store ID, it only has to live until ui_vbox_end so the frame arena owns it
+  vbox->id = ui_arena_strdup(&ctx->frame_arena, id);
   
+  if (vbox->config.fixed_height > 0) {
+    vbox->bounds.size.y = vbox->config.fixed_height;
+  }
+
   // Set clipping if enabled
   if (vbox->config.clip_overflow) {
-    ui_push_clip(ctx, bounds);
+    ui_push_clip(ctx, vbox->bounds);
   }
   
   // Push this vbox as current layout
@@ -69,26 +74,20 @@ void ui_vbox_begin_ex(UIContext* ctx, const char* id, rect bounds, const VBoxCon
 }
 
 rect ui_vbox_next(UIContext* ctx, const char* id, float widget_height) {
-  VBoxState* vbox = get_vbox_state(id);
+  VBoxState* vbox = get_vbox_state(ctx, id);
   if (!vbox || !vbox->is_active) {
-      return (rect){0, 0, 0, 0};
+      return (rect){{0, 0}, {0, 0}};
   }
   
-  // Calculate widget width
+  // Widgets span the vbox's width, or the rest of the window without one
   float widget_width;
-  if (vbox->config.fixed_height > 0) {
-      // Fixed height mode
-      widget_width = vbox->config.fixed_height - 
-                    vbox->config.padding_left - vbox->config.padding_right;
-  } else {
-      // Auto width (use available space)
-      widget_width = ctx->width - 
+  if (vbox->bounds.size.x > 0) {
+      widget_width = vbox->bounds.size.x -
                      vbox->config.padding_left - vbox->config.padding_right;
+  } else {
+      widget_width = ctx->width - vbox->cursor.x - vbox->config.padding_right;
   }
-  
-  if (vbox->config.expand_width) {
-      widget_width = widget_width; // Use full width
-  }
+  widget_width = fmaxf(widget_width, 0.0f);
   
   // Create rect for this widget
   rect widget_rect = {
@@ -111,7 +110,7 @@ rect ui_vbox_next(UIContext* ctx, const char* id, float widget_height) {
 }
 
 void ui_vbox_end(UIContext* ctx, const char* id) {
-  VBoxState* vbox = get_vbox_state(id);
+  VBoxState* vbox = get_vbox_state(ctx, id);
   if (!vbox || !vbox->is_active) return;
   
   // Pop the layout we pushed in begin
@@ -123,7 +122,581 @@ void ui_vbox_end(UIContext* ctx, const char* id) {
   }
   
   // Cleanup
-  free(vbox->id);
   vbox->is_active = false;
   vbox->id = NULL;
-}
\ No newline at end of file
+}
+
+/*
+ * Flex and grid layout
+ */
+
+#define LAYOUT_MIN_NODES 64
+
+typedef struct {
+  ui_id key;              // Node key, 0 for nothing
+  UILayoutItem item;      // Inputs, text not kept
+  vec2 basis;             // Preferred size within min/max
+} layout_entry;
+
+typedef struct {
+  ui_id key;              // Id scoped by the parent layout, 0: empty slot
+  uint64_t frame;         // Last frame it was declared in
+
+  // As an item
+  rect placed;            // Relative to the layout's position
+  bool has_rect;
+  uint32_t text_hash;     // Text measured into text_size
+  const struct UIFont* text_font;
+  float text_font_size;
+  vec2 text_size;
+  bool has_text_size;
+
+  // As a layout
+  vec2 content;           // Preferred size of the layout's items, for its own item
+  bool has_content;
+  uint32_t arrange_key;   // Inputs of the last arrange
+  vec2 arranged_size;
+  UILayoutDesc desc;
+  layout_entry* entries;  // Items of the last arrange
+  int entry_count, entry_capacity;
+} layout_node;
+
+typedef struct {
+  ui_id key;
+  rect bounds;
+  UILayoutDesc desc;
+  layout_entry* entries;  // Frame arena
+  rect* given;            // Rects handed out, relative, frame arena
+  int count, capacity;
+  float cursor;           // Main axis position for items without a rect yet
+} layout_frame;
+
+typedef struct UILayoutCache {
+  layout_node* nodes;     // Open addressing, power of two
+  uint32_t capacity, count;
+  layout_frame stack[UI_LAYOUT_MAX_DEPTH];
+  int depth;
+  uint64_t unsettled_frame; // Frame that handed out a rect its item did not end up with
+} UILayoutCache;
+
+static uint32_t hash_bytes(uint32_t hash, const void* data, size_t size) {
+  const unsigned char* bytes = (const unsigned char*)data;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static ui_id layout_key(ui_id parent, const char* id) {
+  uint32_t hash = hash_bytes(2166136261u ^ parent, id, strlen(id));
+  return hash ? hash : 1;
+}
+
+static void free_node(UIContext* ctx, layout_node* node) {
+  ui_mem_free(&ctx->allocator, node->entries);
+}
+
+static bool stale_node(UIContext* ctx, const layout_node* node) {
+  return node->frame + 2 < ctx->frame_index;
+}
+
+// Rehash, leaving out nodes unused for a couple of frames, into a table a
+// quarter full at most once another node is added
+static bool rebuild_nodes(UIContext* ctx, UILayoutCache* cache) {
+  uint32_t live = 1;
+  for (uint32_t i = 0; i < cache->capacity; i++) {
+    if (cache->nodes[i].key && !stale_node(ctx, &cache->nodes[i])) live++;
+  }
+  uint32_t capacity = LAYOUT_MIN_NODES;
+  while (live * 4 > capacity) capacity *= 2;
+
+  layout_node* nodes = (layout_node*)ui_mem_alloc(&ctx->allocator, sizeof(layout_node) * capacity);
+  if (!nodes) {
+    fprintf(stderr, "Failed to allocate %u layout nodes\n", capacity);
+    return false;
+  }
+  memset(nodes, 0, sizeof(layout_node) * capacity);
+
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < cache->capacity; i++) {
+    layout_node* node = &cache->nodes[i];
+    if (!node->key) continue;
+    if (stale_node(ctx, node)) {
+      free_node(ctx, node);
+      continue;
+    }
+    uint32_t slot = node->key & (capacity - 1);
+    while (nodes[slot].key) slot = (slot + 1) & (capacity - 1);
+    nodes[slot] = *node;
+    count++;
+  }
+
+  ui_mem_free(&ctx->allocator, cache->nodes);
+  cache->nodes = nodes;
+  cache->capacity = capacity;
+  cache->count = count;
+  return true;
+}
+
+static layout_node* find_node(UILayoutCache* cache, ui_id key) {
+  uint32_t mask = cache->capacity - 1;
+  for (uint32_t slot = key & mask; cache->nodes[slot].key; slot = (slot + 1) & mask) {
+    if (cache->nodes[slot].key == key) return &cache->nodes[slot];
+  }
+  return NULL;
+}
+
+// Pointers stay valid until the next call
+static layout_node* get_node(UIContext* ctx, UILayoutCache* cache, ui_id key) {
+  layout_node* node = find_node(cache, key);
+  if (!node) {
+    if ((cache->count + 1) * 2 > cache->capacity) {
+      if (!rebuild_nodes(ctx, cache)) return NULL;
+    }
+    uint32_t mask = cache->capacity - 1;
+    uint32_t slot = key & mask;
+    while (cache->nodes[slot].key) slot = (slot + 1) & mask;
+    node = &cache->nodes[slot];
+    memset(node, 0, sizeof(layout_node));
+    node->key = key;
+    cache->count++;
+  }
+  node->frame = ctx->frame_index;
+  return node;
+}
+
+static UILayoutCache* get_cache(UIContext* ctx) {
+  if (ctx->layout_cache) return ctx->layout_cache;
+
+  UILayoutCache* cache = (UILayoutCache*)ui_mem_alloc(&ctx->allocator, sizeof(UILayoutCache));
+  if (!cache) {
+    fprintf(stderr, "Failed to allocate the layout cache\n");
+    return NULL;
+  }
+  memset(cache, 0, sizeof(UILayoutCache));
+  cache->unsettled_frame = UINT64_MAX;
+  if (!rebuild_nodes(ctx, cache)) {
+    ui_mem_free(&ctx->allocator, cache);
+    return NULL;
+  }
+  ctx->layout_cache = cache;
+  return cache;
+}
+
+void ui_layout_cache_destroy(UIContext* ctx) {
+  UILayoutCache* cache = ctx->layout_cache;
+  if (!cache) return;
+
+  for (uint32_t i = 0; i < cache->capacity; i++) {
+    if (cache->nodes[i].key) free_node(ctx, &cache->nodes[i]);
+  }
+  ui_mem_free(&ctx->allocator, cache->nodes);
+  ui_mem_free(&ctx->allocator, cache);
+  ctx->layout_cache = NULL;
+}
+
+static float axis(vec2 v, int a) {
+  return a == 0 ? v.x : v.y;
+}
+
+static void set_axis(vec2* v, int a, float value) {
+  if (a == 0) v->x = value; else v->y = value;
+}
+
+static float clamp_axis(const UILayoutItem* item, int a, float value) {
+  float max = axis(item->max_size, a);
+  if (max > 0 && value > max) value = max;
+  float min = axis(item->min_size, a);
+  return value < min ? min : value;
+}
+
+static UILayoutAlign item_align(const UILayoutDesc* desc, const UILayoutItem* item) {
+  UILayoutAlign align = item->align ? item->align : desc->align;
+  return align ? align : UI_ALIGN_STRETCH;
+}
+
+// Place an item across the main axis (or within a grid cell on one axis)
+static void align_axis(const layout_entry* e, UILayoutAlign align, int a, float start, float space,
+  rect* out) {
+  float size = align == UI_ALIGN_STRETCH ? clamp_axis(&e->item, a, space) : axis(e->basis, a);
+  float offset = 0;
+  if (align == UI_ALIGN_CENTER) offset = (space - size) * 0.5f;
+  else if (align == UI_ALIGN_END) offset = space - size;
+  set_axis(&out->pos, a, start + offset);
+  set_axis(&out->size, a, size);
+}
+
+/*
+ * Share out space along the main axis: items with weight grow or shrink
+ * from their basis in proportion, items hitting min or max freeze there
+ * and the others share what is left, until none hits its limit.
+ */
+static void flex_resolve(UIContext* ctx, const layout_entry* entries, int count, int a, float space,
+  bool growing, float* sizes) {
+  bool* frozen = (bool*)ui_arena_alloc(&ctx->frame_arena, sizeof(bool) * count, 1);
+  float* weights = (float*)ui_arena_alloc(&ctx->frame_arena, sizeof(float) * count, 4);
+  if (!frozen || !weights) return;
+
+  for (int i = 0; i < count; i++) {
+    const UILayoutItem* item = &entries[i].item;
+    float base = axis(entries[i].basis, a);
+    weights[i] = growing ? item->grow : item->shrink * base;
+    frozen[i] = weights[i] <= 0;
+  }
+
+  for (int pass = 0; pass <= count; pass++) {
+    float remaining = space, weight_sum = 0;
+    for (int i = 0; i < count; i++) {
+      remaining -= frozen[i] ? sizes[i] : axis(entries[i].basis, a);
+      if (!frozen[i]) weight_sum += weights[i];
+    }
+    if (weight_sum <= 0) break;
+
+    bool clamped = false;
+    for (int i = 0; i < count; i++) {
+      if (frozen[i]) continue;
+      float target = axis(entries[i].basis, a) + remaining * weights[i] / weight_sum;
+      float limited = clamp_axis(&entries[i].item, a, target);
+      if (target < 0 && limited < 0) limited = 0;
+      sizes[i] = limited;
+      if (limited != target) {
+        frozen[i] = true;
+        clamped = true;
+      }
+    }
+    if (!clamped) break;
+
+    // Undo the unclamped items of this pass, they share again
+    for (int i = 0; i < count; i++) {
+      if (!frozen[i]) sizes[i] = axis(entries[i].basis, a);
+    }
+  }
+}
+
+static void arrange_flex(UIContext* ctx, const layout_entry* entries, int count, vec2 size,
+  const UILayoutDesc* desc, rect* out, vec2* content) {
+  int main = desc->direction == UI_LAYOUT_COLUMN ? 1 : 0;
+  int cross = 1 - main;
+  float inner_main = axis(size, main) - desc->padding * 2;
+  float inner_cross = axis(size, cross) - desc->padding * 2;
+  float gaps = count > 1 ? desc->gap * (count - 1) : 0;
+
+  float* sizes = (float*)ui_arena_alloc(&ctx->frame_arena, sizeof(float) * count, 4);
+  if (!sizes) return;
+
+  float used = gaps, widest = 0;
+  for (int i = 0; i < count; i++) {
+    sizes[i] = axis(entries[i].basis, main);
+    used += sizes[i];
+    widest = fmaxf(widest, axis(entries[i].basis, cross));
+  }
+  set_axis(content, main, used + desc->padding * 2);
+  set_axis(content, cross, widest + desc->padding * 2);
+
+  if (used < inner_main) flex_resolve(ctx, entries, count, main, inner_main - gaps, true, sizes);
+  else if (used > inner_main) flex_resolve(ctx, entries, count, main, inner_main - gaps, false, sizes);
+
+  float total = gaps;
+  for (int i = 0; i < count; i++) total += sizes[i];
+  float left = inner_main - total, position = desc->padding, spacing = desc->gap;
+  if (left > 0) {
+    if (desc->justify == UI_JUSTIFY_CENTER) position += left * 0.5f;
+    else if (desc->justify == UI_JUSTIFY_END) position += left;
+    else if (desc->justify == UI_JUSTIFY_SPACE_BETWEEN && count > 1) spacing += left / (count - 1);
+  }
+
+  for (int i = 0; i < count; i++) {
+    set_axis(&out[i].pos, main, position);
+    set_axis(&out[i].size, main, sizes[i]);
+    align_axis(&entries[i], item_align(desc, &entries[i].item), cross, desc->padding, inner_cross,
+      &out[i]);
+    position += sizes[i] + spacing;
+  }
+}
+
+// Share the space left over between tracks by the largest grow among their items
+static void grow_tracks(float* tracks, const float* grow, int count, float space) {
+  float total = 0, grow_sum = 0;
+  for (int i = 0; i < count; i++) {
+    total += tracks[i];
+    grow_sum += grow[i];
+  }
+  if (total >= space || grow_sum <= 0) return;
+  for (int i = 0; i < count; i++) tracks[i] += (space - total) * grow[i] / grow_sum;
+}
+
+static void arrange_grid(UIContext* ctx, const layout_entry* entries, int count, vec2 size,
+  const UILayoutDesc* desc, rect* out, vec2* content) {
+  int columns = desc->columns > 0 ? desc->columns : 1;
+  int rows = (count + columns - 1) / columns;
+
+  float* widths = (float*)ui_arena_alloc(&ctx->frame_arena, sizeof(float) * (columns * 2 + rows * 2), 4);
+  if (!widths) return;
+  float* column_grow = widths + columns;
+  float* heights = column_grow + columns;
+  float* row_grow = heights + rows;
+  memset(widths, 0, sizeof(float) * (columns * 2 + rows * 2));
+
+  for (int i = 0; i < count; i++) {
+    int c = i % columns, r = i / columns;
+    widths[c] = fmaxf(widths[c], entries[i].basis.x);
+    heights[r] = fmaxf(heights[r], entries[i].basis.y);
+    column_grow[c] = fmaxf(column_grow[c], entries[i].item.grow);
+    row_grow[r] = fmaxf(row_grow[r], entries[i].item.grow);
+  }
+
+  float column_gaps = desc->gap * (columns - 1), row_gaps = rows > 1 ? desc->gap * (rows - 1) : 0;
+  content->x = column_gaps + desc->padding * 2;
+  content->y = row_gaps + desc->padding * 2;
+  for (int c = 0; c < columns; c++) content->x += widths[c];
+  for (int r = 0; r < rows; r++) content->y += heights[r];
+
+  grow_tracks(widths, column_grow, columns, size.x - desc->padding * 2 - column_gaps);
+  grow_tracks(heights, row_grow, rows, size.y - desc->padding * 2 - row_gaps);
+
+  float y = desc->padding;
+  for (int r = 0, i = 0; r < rows; r++) {
+    float x = desc->padding;
+    for (int c = 0; c < columns && i < count; c++, i++) {
+      UILayoutAlign align = item_align(desc, &entries[i].item);
+      align_axis(&entries[i], align, 0, x, widths[c], &out[i]);
+      align_axis(&entries[i], align, 1, y, heights[r], &out[i]);
+      x += widths[c] + desc->gap;
+    }
+    y += heights[r] + desc->gap;
+  }
+}
+
+static bool desc_equal(const UILayoutDesc* a, const UILayoutDesc* b) {
+  return a->direction == b->direction && a->gap == b->gap && a->padding == b->padding &&
+         a->justify == b->justify && a->align == b->align && a->columns == b->columns &&
+         a->clip == b->clip;
+}
+
+// Field by field, struct padding is whatever the caller left there
+static uint32_t arrange_key(vec2 size, const UILayoutDesc* desc, const layout_entry* entries, int count) {
+  float sizes[2] = {size.x, size.y};
+  int32_t modes[6] = {desc->direction, desc->justify, desc->align, desc->columns, desc->clip, count};
+  float spacing[2] = {desc->gap, desc->padding};
+  uint32_t hash = hash_bytes(2166136261u, sizes, sizeof(sizes));
+  hash = hash_bytes(hash, modes, sizeof(modes));
+  hash = hash_bytes(hash, spacing, sizeof(spacing));
+
+  for (int i = 0; i < count; i++) {
+    const UILayoutItem* item = &entries[i].item;
+    float values[9] = {
+      entries[i].basis.x, entries[i].basis.y, item->min_size.x, item->min_size.y,
+      item->max_size.x, item->max_size.y, item->grow, item->shrink,
+      (float)item->align
+    };
+    hash = hash_bytes(hash, &entries[i].key, sizeof(ui_id));
+    hash = hash_bytes(hash, values, sizeof(values));
+  }
+  return hash;
+}
+
+// Place a layout's entries and store the rects in its items' nodes
+static void arrange(UIContext* ctx, UILayoutCache* cache, ui_id key, const layout_entry* entries,
+  int count, vec2 size, const UILayoutDesc* desc) {
+  UI_PROFILE_BEGIN(ctx, "ui_layout_arrange");
+  rect* out = (rect*)ui_arena_alloc(&ctx->frame_arena, sizeof(rect) * (count ? count : 1), 4);
+  vec2 content = {desc->padding * 2, desc->padding * 2};
+
+  if (out) {
+    memset(out, 0, sizeof(rect) * count);
+    if (desc->direction == UI_LAYOUT_GRID) arrange_grid(ctx, entries, count, size, desc, out, &content);
+    else if (count > 0) arrange_flex(ctx, entries, count, size, desc, out, &content);
+
+    for (int i = 0; i < count; i++) {
+      layout_node* child = find_node(cache, entries[i].key);
+      if (!child) continue;
+      child->placed = out[i];
+      child->has_rect = true;
+    }
+  }
+
+  layout_node* node = find_node(cache, key);
+  if (node) {
+    node->content = content;
+    node->has_content = true;
+    node->arranged_size = size;
+    node->desc = *desc;
+    node->arrange_key = arrange_key(size, desc, entries, count);
+  }
+  UI_PROFILE_END(ctx);
+}
+
+void ui_layout_begin(UIContext* ctx, const char* id, rect bounds, const UILayoutDesc* desc) {
+  UILayoutCache* cache = get_cache(ctx);
+  if (!cache) return;
+  if (cache->depth == UI_LAYOUT_MAX_DEPTH) {
+    fprintf(stderr, "Layouts nested deeper than %d\n", UI_LAYOUT_MAX_DEPTH);
+    cache->depth++;
+    return;
+  }
+
+  ui_id parent = cache->depth > 0 ? cache->stack[cache->depth - 1].key : 0;
+  ui_id key = layout_key(parent, id);
+  layout_node* node = get_node(ctx, cache, key);
+  if (!node) return;
+
+  // Only the bounds or the description changed: place last frame's items again now
+  if (node->entry_count > 0 &&
+      (node->arranged_size.x != bounds.size.x || node->arranged_size.y != bounds.size.y ||
+       !desc_equal(&node->desc, desc))) {
+    arrange(ctx, cache, key, node->entries, node->entry_count, bounds.size, desc);
+  }
+
+  layout_frame* frame = &cache->stack[cache->depth++];
+  memset(frame, 0, sizeof(layout_frame));
+  frame->key = key;
+  frame->bounds = bounds;
+  frame->desc = *desc;
+  frame->cursor = desc->padding;
+
+  if (desc->clip) {
+    ui_push_clip(ctx, bounds);
+  }
+}
+
+// Preferred size of an item: its own, its text's or its nested layout's, within min/max
+static vec2 measure_item(UIContext* ctx, layout_node* node, const UILayoutItem* item) {
+  vec2 measured = {0, 0};
+  if (item->text && (item->size.x <= 0 || item->size.y <= 0)) {
+    uint32_t text_hash = hash_bytes(2166136261u, item->text, strlen(item->text));
+    if (!node->has_text_size || node->text_hash != text_hash || node->text_font != ctx->font ||
+        node->text_font_size != ctx->font_size) {
+      node->text_size = ui_button_size(ctx, item->text);
+      node->text_hash = text_hash;
+      node->text_font = ctx->font;
+      node->text_font_size = ctx->font_size;
+      node->has_text_size = true;
+    }
+    measured = node->text_size;
+  } else if (node->has_content) {
+    measured = node->content;
+  }
+
+  vec2 basis = {
+    item->size.x > 0 ? item->size.x : measured.x,
+    item->size.y > 0 ? item->size.y : measured.y
+  };
+  return (vec2){clamp_axis(item, 0, basis.x), clamp_axis(item, 1, basis.y)};
+}
+
+rect ui_layout_item(UIContext* ctx, const char* id, const UILayoutItem* item) {
+  UILayoutCache* cache = ctx->layout_cache;
+  if (!cache || cache->depth == 0 || cache->depth > UI_LAYOUT_MAX_DEPTH) {
+    return (rect){{0, 0}, {0, 0}};
+  }
+  layout_frame* frame = &cache->stack[cache->depth - 1];
+
+  ui_id key = layout_key(frame->key, id);
+  layout_node* node = get_node(ctx, cache, key);
+  if (!node) return (rect){{0, 0}, {0, 0}};
+
+  layout_entry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.key = key;
+  entry.item = *item;
+  entry.item.text = NULL;
+  entry.basis = measure_item(ctx, node, item);
+
+  // Items new to the layout follow the previous one until the layout arranges them
+  rect placed = node->placed;
+  if (!node->has_rect) {
+    const UILayoutDesc* desc = &frame->desc;
+    float inner_w = frame->bounds.size.x - desc->padding * 2;
+    float inner_h = frame->bounds.size.y - desc->padding * 2;
+    if (desc->direction == UI_LAYOUT_COLUMN) {
+      placed = (rect){{desc->padding, frame->cursor}, {inner_w, entry.basis.y}};
+      frame->cursor += entry.basis.y + desc->gap;
+    } else if (desc->direction == UI_LAYOUT_ROW) {
+      placed = (rect){{frame->cursor, desc->padding}, {entry.basis.x, inner_h}};
+      frame->cursor += entry.basis.x + desc->gap;
+    } else {
+      int columns = desc->columns > 0 ? desc->columns : 1;
+      float cell = (inner_w - desc->gap * (columns - 1)) / columns;
+      int row = frame->count / columns;
+      placed = (rect){{desc->padding + (frame->count % columns) * (cell + desc->gap),
+                       desc->padding + row * (entry.basis.y + desc->gap)}, {cell, entry.basis.y}};
+    }
+  }
+
+  if (frame->count == frame->capacity) {
+    int capacity = frame->capacity ? frame->capacity * 2 : 16;
+    layout_entry* entries = (layout_entry*)ui_arena_grow(&ctx->frame_arena, frame->entries,
+      sizeof(layout_entry) * frame->capacity, sizeof(layout_entry) * capacity, _Alignof(layout_entry));
+    rect* given = (rect*)ui_arena_grow(&ctx->frame_arena, frame->given,
+      sizeof(rect) * frame->capacity, sizeof(rect) * capacity, _Alignof(rect));
+    if (!entries || !given) {
+      fprintf(stderr, "Failed to record layout item %s\n", id);
+      return (rect){{frame->bounds.pos.x + placed.pos.x, frame->bounds.pos.y + placed.pos.y}, placed.size};
+    }
+    frame->entries = entries;
+    frame->given = given;
+    frame->capacity = capacity;
+  }
+  frame->entries[frame->count] = entry;
+  frame->given[frame->count] = placed;
+  frame->count++;
+
+  return (rect){{frame->bounds.pos.x + placed.pos.x, frame->bounds.pos.y + placed.pos.y}, placed.size};
+}
+
+static bool rect_moved(rect a, rect b) {
+  return fabsf(a.pos.x - b.pos.x) > 0.01f || fabsf(a.pos.y - b.pos.y) > 0.01f ||
+         fabsf(a.size.x - b.size.x) > 0.01f || fabsf(a.size.y - b.size.y) > 0.01f;
+}
+
+void ui_layout_end(UIContext* ctx) {
+  UILayoutCache* cache = ctx->layout_cache;
+  if (!cache || cache->depth == 0) return;
+  if (cache->depth-- > UI_LAYOUT_MAX_DEPTH) return;
+  layout_frame* frame = &cache->stack[cache->depth];
+
+  if (frame->desc.clip) {
+    ui_pop_clip(ctx);
+  }
+
+  layout_node* node = find_node(cache, frame->key);
+  if (!node) return;
+
+  // Same bounds, same items measuring the same: last arrange still holds
+  uint32_t key = arrange_key(frame->bounds.size, &frame->desc, frame->entries, frame->count);
+  if (node->has_content && node->arrange_key == key && node->entry_count == frame->count) {
+    return;
+  }
+
+  // Keep the items for ui_layout_begin to place again when only the bounds change
+  if (frame->count > node->entry_capacity) {
+    layout_entry* entries = (layout_entry*)ui_mem_alloc(&ctx->allocator,
+      sizeof(layout_entry) * frame->count);
+    if (!entries) {
+      fprintf(stderr, "Failed to keep %d layout items\n", frame->count);
+      return;
+    }
+    ui_mem_free(&ctx->allocator, node->entries);
+    node->entries = entries;
+    node->entry_capacity = frame->count;
+  }
+  if (frame->count > 0) {
+    memcpy(node->entries, frame->entries, sizeof(layout_entry) * frame->count);
+  }
+  node->entry_count = frame->count;
+
+  arrange(ctx, cache, frame->key, frame->entries, frame->count, frame->bounds.size, &frame->desc);
+
+  for (int i = 0; i < frame->count; i++) {
+    layout_node* child = find_node(cache, frame->entries[i].key);
+    if (child && rect_moved(child->placed, frame->given[i])) {
+      cache->unsettled_frame = ctx->frame_index;
+      break;
+    }
+  }
+}
+
+bool ui_layout_settled(UIContext* ctx) {
+  UILayoutCache* cache = ctx->layout_cache;
+  return !cache || cache->unsettled_frame != ctx->frame_index;
+}
@@ -0,0 +1,612 @@
+/*
+ * Tridme UI Log Viewer
+ *
+ * Memory-mapped read-only text view. A background thread scans the file for
+ * newlines into a sparse line index and follows appends; the widget draws
+ * only the visible lines straight out of the mapping.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#define _POSIX_C_SOURCE 200809L  // pread, nanosleep
+
+#include <ui_logview.h>
+#include <ui_widgets.h>
+#include <ui_font.h>
+#include <ui_draw.h>
+#include <ui_hit.h>
+#include <ui_input.h>
+#include <ui_profile.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+  #define UI_LOGVIEW_SSE2 1
+#endif
+
+#define LOGVIEW_CHUNK      65536      // Checkpoints per index chunk
+#define LOGVIEW_MAX_CHUNKS 4096       // 64 * 65536 * 4096 lines
+#define LOGVIEW_BLOCK      (1 << 20)  // Indexer read size
+#define LOGVIEW_POLL_MS    50         // Indexer sleep at the end of the file
+#define LOGVIEW_PADDING    5.0f
+
+// What the indexer has published, read as one consistent set
+typedef struct {
+  uint64_t lines;           // Newlines seen
+  uint64_t last_start;      // Start of the line after the last newline
+  uint64_t size;            // Bytes scanned
+  uint32_t generation;      // Restarts of the indexer so far
+} log_snapshot;
+
+struct UILogView {
+  UIAllocator allocator;
+  int fd;
+
+  // Indexer thread
+  pthread_t thread;
+  bool thread_started;
+  _Atomic bool stop;
+  _Atomic uint32_t restart_requests; // Raised by the UI thread when the file shrank
+
+  // Checkpoint k is the offset of line k * UI_LOGVIEW_STRIDE. Chunks are
+  // filled by the indexer before the lines they hold are published
+  uint64_t* chunks[LOGVIEW_MAX_CHUNKS];
+
+  // Seqlock around the published snapshot, odd while the indexer writes
+  _Atomic uint32_t seq;
+  _Atomic uint64_t published_lines;
+  _Atomic uint64_t published_last_start;
+  _Atomic uint64_t published_size;
+  _Atomic uint32_t published_generation;
+
+  // UI thread only
+  const char* data;
+  size_t mapped_size;
+  log_snapshot snap;
+  bool restarting;          // Ignore snapshots of snap.generation, they index the old file
+  double top_line;          // First visible line, fractional while scrolling
+  bool follow;              // Stick to the end as the file grows
+  uint64_t select_offset;
+  size_t select_length;
+  bool center_selection;
+};
+
+/*
+ * Indexer
+ */
+
+static void publish(UILogView* view, uint64_t lines, uint64_t last_start, uint64_t size,
+  uint32_t generation) {
+  uint32_t seq = atomic_load_explicit(&view->seq, memory_order_relaxed);
+  atomic_store_explicit(&view->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  atomic_store_explicit(&view->published_lines, lines, memory_order_relaxed);
+  atomic_store_explicit(&view->published_last_start, last_start, memory_order_relaxed);
+  atomic_store_explicit(&view->published_size, size, memory_order_relaxed);
+  atomic_store_explicit(&view->published_generation, generation, memory_order_relaxed);
+
+  atomic_store_explicit(&view->seq, seq + 2, memory_order_release);
+}
+
+static log_snapshot read_snapshot(UILogView* view) {
+  log_snapshot snap;
+  uint32_t before, after;
+  do {
+    before = atomic_load_explicit(&view->seq, memory_order_acquire);
+    snap.lines = atomic_load_explicit(&view->published_lines, memory_order_relaxed);
+    snap.last_start = atomic_load_explicit(&view->published_last_start, memory_order_relaxed);
+    snap.size = atomic_load_explicit(&view->published_size, memory_order_relaxed);
+    snap.generation = atomic_load_explicit(&view->published_generation, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    after = atomic_load_explicit(&view->seq, memory_order_relaxed);
+  } while (before != after || (before & 1));
+  return snap;
+}
+
+static bool add_line(UILogView* view, uint64_t start, uint64_t* lines) {
+  (*lines)++;
+  if (*lines % UI_LOGVIEW_STRIDE != 0) return true;
+
+  uint64_t k = *lines / UI_LOGVIEW_STRIDE;
+  uint64_t chunk = k / LOGVIEW_CHUNK;
+  if (chunk >= LOGVIEW_MAX_CHUNKS) {
+    fprintf(stderr, "Log file has too many lines to index\n");
+    return false;
+  }
+  if (!view->chunks[chunk]) {
+    view->chunks[chunk] = (uint64_t*)ui_mem_alloc(&view->allocator, sizeof(uint64_t) * LOGVIEW_CHUNK);
+    if (!view->chunks[chunk]) {
+      fprintf(stderr, "Failed to allocate the log line index\n");
+      return false;
+    }
+  }
+  view->chunks[chunk][k % LOGVIEW_CHUNK] = start;
+  return true;
+}
+
+static bool scan_newlines(UILogView* view, const char* block, size_t n, uint64_t base,
+  uint64_t* lines, uint64_t* last_start) {
+  size_t i = 0;
+
+#ifdef UI_LOGVIEW_SSE2
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; i + 16 <= n; i += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)(block + i));
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline));
+    while (mask) {
+      uint64_t start = base + i + (unsigned)__builtin_ctz(mask) + 1;
+      if (!add_line(view, start, lines)) return false;
+      *last_start = start;
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  while (i < n) {
+    const char* found = (const char*)memchr(block + i, '\n', n - i);
+    if (!found) break;
+    i = (size_t)(found - block) + 1;
+    if (!add_line(view, base + i, lines)) return false;
+    *last_start = base + i;
+  }
+  return true;
+}
+
+static void* index_thread(void* arg) {
+  UILogView* view = (UILogView*)arg;
+  char* block = (char*)ui_mem_alloc(&view->allocator, LOGVIEW_BLOCK);
+  if (!block) {
+    fprintf(stderr, "Failed to allocate the log indexer buffer\n");
+    return NULL;
+  }
+
+  uint64_t offset = 0, lines = 0, last_start = 0;
+  uint32_t generation = 0, handled_requests = 0;
+  while (!atomic_load_explicit(&view->stop, memory_order_relaxed)) {
+    // A file that shrank (rotated with copytruncate, or truncated) is indexed
+    // again from the start. Checkpoints get overwritten only past the lines
+    // the new generation published, the UI reads no others
+    uint32_t requests = atomic_load_explicit(&view->restart_requests, memory_order_relaxed);
+    struct stat st;
+    bool shrank = requests != handled_requests ||
+      (fstat(view->fd, &st) == 0 && (uint64_t)st.st_size < offset);
+    if (shrank) {
+      handled_requests = requests;
+      generation++;
+      offset = lines = last_start = 0;
+      publish(view, 0, 0, 0, generation);
+    }
+
+    ssize_t n = pread(view->fd, block, LOGVIEW_BLOCK, (off_t)offset);
+    if (n < 0) {
+      perror("Failed to read the log file");
+      break;
+    }
+
+    // At the end: wait for appends
+    if (n == 0) {
+      struct timespec pause = {0, LOGVIEW_POLL_MS * 1000000L};
+      nanosleep(&pause, NULL);
+      continue;
+    }
+
+    if (!scan_newlines(view, block, (size_t)n, offset, &lines, &last_start)) break;
+    offset += (uint64_t)n;
+    publish(view, lines, last_start, offset, generation);
+  }
+
+  ui_mem_free(&view->allocator, block);
+  return NULL;
+}
+
+/*
+ * View
+ */
+
+UILogView* ui_logview_open(const char* path, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open log file %s\n", path);
+    return NULL;
+  }
+
+  UILogView* view = (UILogView*)ui_mem_alloc(allocator, sizeof(UILogView));
+  if (!view) {
+    close(fd);
+    return NULL;
+  }
+  memset(view, 0, sizeof(UILogView));
+  view->allocator = *allocator;
+  view->fd = fd;
+  view->follow = true;
+  atomic_init(&view->stop, false);
+  atomic_init(&view->restart_requests, 0);
+  atomic_init(&view->seq, 0);
+  atomic_init(&view->published_lines, 0);
+  atomic_init(&view->published_last_start, 0);
+  atomic_init(&view->published_size, 0);
+  atomic_init(&view->published_generation, 0);
+
+  // Checkpoint 0, line 0 starts the file
+  view->chunks[0] = (uint64_t*)ui_mem_alloc(allocator, sizeof(uint64_t) * LOGVIEW_CHUNK);
+  if (!view->chunks[0]) {
+    ui_logview_close(view);
+    return NULL;
+  }
+  view->chunks[0][0] = 0;
+
+  if (pthread_create(&view->thread, NULL, index_thread, view) != 0) {
+    fprintf(stderr, "Failed to start the log indexer\n");
+    ui_logview_close(view);
+    return NULL;
+  }
+  view->thread_started = true;
+  return view;
+}
+
+void ui_logview_close(UILogView* view) {
+  if (!view) return;
+
+  if (view->thread_started) {
+    atomic_store_explicit(&view->stop, true, memory_order_relaxed);
+    pthread_join(view->thread, NULL);
+  }
+
+  if (view->data) munmap((void*)view->data, view->mapped_size);
+  close(view->fd);
+
+  UIAllocator allocator = view->allocator;
+  for (int i = 0; i < LOGVIEW_MAX_CHUNKS && view->chunks[i]; i++) {
+    ui_mem_free(&allocator, view->chunks[i]);
+  }
+  ui_mem_free(&allocator, view);
+}
+
+// Forget the old file's lines, the mapping may reach past the new end of file
+static void reset_view(UILogView* view, uint32_t generation) {
+  if (view->data) munmap((void*)view->data, view->mapped_size);
+  view->data = NULL;
+  view->mapped_size = 0;
+  memset(&view->snap, 0, sizeof(log_snapshot));
+  view->snap.generation = generation;
+  view->top_line = 0.0;
+  view->select_offset = 0;
+  view->select_length = 0;
+  view->center_selection = false;
+}
+
+// Take the indexer's progress and make sure the mapping covers it. Pages
+// past the end of the file fault (SIGBUS), so nothing is read beyond the
+// file's current size
+static void refresh(UILogView* view) {
+  log_snapshot snap = read_snapshot(view);
+  struct stat st;
+  if (fstat(view->fd, &st) != 0) return;
+
+  if (view->restarting && snap.generation == view->snap.generation) return;
+  if (snap.generation != view->snap.generation) {
+    // The indexer started over, on our request or after seeing the file shrink
+    reset_view(view, snap.generation);
+    view->restarting = false;
+  }
+
+  if ((uint64_t)st.st_size < snap.size) {
+    // Shrank since the indexer published: drop everything until it starts over
+    reset_view(view, snap.generation);
+    view->restarting = true;
+    atomic_fetch_add_explicit(&view->restart_requests, 1, memory_order_relaxed);
+    return;
+  }
+
+  if (snap.size > view->mapped_size) {
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, view->fd, 0);
+    if (data == MAP_FAILED) {
+      fprintf(stderr, "Failed to map the log file\n");
+      return;
+    }
+    if (view->data) munmap((void*)view->data, view->mapped_size);
+    view->data = (const char*)data;
+    view->mapped_size = (size_t)st.st_size;
+  }
+
+  view->snap = snap;
+}
+
+static uint64_t display_lines(const UILogView* view) {
+  return view->snap.lines + (view->snap.size > view->snap.last_start ? 1 : 0);
+}
+
+static uint64_t checkpoint(const UILogView* view, uint64_t k) {
+  return view->chunks[k / LOGVIEW_CHUNK][k % LOGVIEW_CHUNK];
+}
+
+static uint64_t next_line(const UILogView* view, uint64_t offset) {
+  const char* found = (const char*)memchr(view->data + offset, '\n', view->snap.size - offset);
+  return found ? (uint64_t)(found - view->data) + 1 : view->snap.size;
+}
+
+// Start of a line, line <= snap.lines
+static uint64_t line_start(const UILogView* view, uint64_t line) {
+  uint64_t k = line / UI_LOGVIEW_STRIDE;
+  uint64_t offset = checkpoint(view, k);
+  for (uint64_t l = k * UI_LOGVIEW_STRIDE; l < line; l++) {
+    offset = next_line(view, offset);
+  }
+  return offset;
+}
+
+static uint64_t line_end(const UILogView* view, uint64_t start) {
+  const char* found = (const char*)memchr(view->data + start, '\n', view->snap.size - start);
+  return found ? (uint64_t)(found - view->data) : view->snap.size;
+}
+
+uint64_t ui_logview_line_count(UILogView* view) {
+  refresh(view);
+  return display_lines(view);
+}
+
+uint64_t ui_logview_size(UILogView* view) {
+  refresh(view);
+  return view->snap.size;
+}
+
+size_t ui_logview_line(UILogView* view, uint64_t line, const char** text) {
+  refresh(view);
+  if (line >= display_lines(view)) {
+    *text = NULL;
+    return 0;
+  }
+
+  uint64_t start = line_start(view, line);
+  *text = view->data + start;
+  return (size_t)(line_end(view, start) - start);
+}
+
+uint64_t ui_logview_line_of(UILogView* view, uint64_t offset) {
+  refresh(view);
+  if (offset > view->snap.size) offset = view->snap.size;
+
+  // Last checkpoint at or before the offset, then count the few lines after it
+  uint64_t lo = 0, hi = view->snap.lines / UI_LOGVIEW_STRIDE;
+  while (lo < hi) {
+    uint64_t mid = (lo + hi + 1) / 2;
+    if (checkpoint(view, mid) <= offset) lo = mid; else hi = mid - 1;
+  }
+
+  uint64_t line = lo * UI_LOGVIEW_STRIDE;
+  uint64_t start = checkpoint(view, lo);
+  while (line < view->snap.lines) {
+    uint64_t next = next_line(view, start);
+    if (next > offset) break;
+    start = next;
+    line++;
+  }
+  return line;
+}
+
+/*
+ * Search
+ */
+
+static const char* find_bytes(const char* haystack, size_t n, const char* needle, size_t m) {
+  if (m == 0 || m > n) return NULL;
+  if (m == 1) return (const char*)memchr(haystack, needle[0], n);
+
+  size_t i = 0;
+#ifdef UI_LOGVIEW_SSE2
+  // Candidates must match the first and the last byte, then get compared in full
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[m - 1]);
+  for (; i + m - 1 + 16 <= n; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(haystack + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(haystack + i + m - 1));
+    unsigned mask = (unsigned)_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+    while (mask) {
+      size_t at = i + (unsigned)__builtin_ctz(mask);
+      if (memcmp(haystack + at + 1, needle + 1, m - 2) == 0) return haystack + at;
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  for (; i + m <= n; i++) {
+    const char* candidate = (const char*)memchr(haystack + i, needle[0], n - m + 1 - i);
+    if (!candidate) return NULL;
+    i = (size_t)(candidate - haystack);
+    if (memcmp(candidate + 1, needle + 1, m - 1) == 0) return candidate;
+  }
+  return NULL;
+}
+
+UILogSearch ui_logview_find(UILogView* view, const char* needle, uint64_t* cursor, size_t budget) {
+  refresh(view);
+  size_t m = strlen(needle);
+  uint64_t size = view->snap.size;
+  uint64_t start = *cursor;
+  if (m == 0 || start >= size) {
+    *cursor = size;
+    return UI_LOG_SEARCH_END;
+  }
+
+  // Overlap by the needle length so matches across calls are not missed
+  uint64_t end = start + budget + m - 1;
+  if (end > size || end < start) end = size;
+
+  const char* found = find_bytes(view->data + start, (size_t)(end - start), needle, m);
+  if (found) {
+    *cursor = (uint64_t)(found - view->data);
+    return UI_LOG_SEARCH_FOUND;
+  }
+  if (end == size) {
+    *cursor = size > m - 1 ? size - (m - 1) : 0;
+    return UI_LOG_SEARCH_END;
+  }
+  *cursor = end - (m - 1);
+  return UI_LOG_SEARCH_MORE;
+}
+
+void ui_logview_select(UILogView* view, uint64_t offset, size_t length) {
+  view->select_offset = offset;
+  view->select_length = length;
+  if (length > 0) {
+    view->center_selection = true;
+    view->follow = false;
+  }
+}
+
+/*
+ * Widget
+ */
+
+static float measure_bytes(const UIFont* font, const char* text, size_t n) {
+  float width = 0.0f;
+  for (size_t i = 0; i < n;) {
+    uint32_t ch = (unsigned char)text[i];
+    if (ch < 128) i++; else i += ui_utf8_decode(text + i, n - i, &ch);
+    width += ui_font_advance(font, ch);
+  }
+  return width;
+}
+
+// Bytes of a line needed to fill max_width, the partly visible last glyph included
+static size_t fit_bytes(const UIFont* font, const char* text, size_t n, float max_width) {
+  float width = 0.0f;
+  for (size_t i = 0; i < n;) {
+    uint32_t ch = (unsigned char)text[i];
+    if (ch < 128) i++; else i += ui_utf8_decode(text + i, n - i, &ch);
+    width += ui_font_advance(font, ch);
+    if (width > max_width) return i;
+  }
+  return n;
+}
+
+static bool point_in_rect(vec2 p, rect r) {
+  return p.x >= r.pos.x && p.x <= r.pos.x + r.size.x &&
+         p.y >= r.pos.y && p.y <= r.pos.y + r.size.y;
+}
+
+void ui_log_view(UIContext* ctx, const char* id, rect bounds, UILogView* view) {
+  if (!ctx->font) return;
+  UI_PROFILE_BEGIN(ctx, "ui_log_view");
+  ui_id widget_id = ui_get_id(id);
+  refresh(view);
+
+  ui_hit_add(ctx, widget_id, bounds);
+  bool hovered = ui_widget_hovered(ctx, widget_id, bounds);
+
+  float line_height = ctx->font_size + 4.0f;
+  rect area = {
+    {bounds.pos.x + LOGVIEW_PADDING, bounds.pos.y + LOGVIEW_PADDING},
+    {bounds.size.x - LOGVIEW_PADDING * 2, bounds.size.y - LOGVIEW_PADDING * 2}
+  };
+  double page = area.size.y / line_height;
+  uint64_t total = display_lines(view);
+  double max_top = total > page ? (double)total - page : 0.0;
+
+  // Scrolling, in lines
+  bool scrolled = false;
+  for (int i = 0; i < ctx->event_count; i++) {
+    const UIInputEvent* event = &ctx->events[i];
+    bool over = point_in_rect(event->mouse_pos, bounds) &&
+      ui_hit_is_topmost(ctx, widget_id, event->mouse_pos);
+
+    if (event->type == UI_EVENT_MOUSE_BUTTON && event->pressed && event->button == 0 && over) {
+      ctx->focused_widget = widget_id;
+    } else if (event->type == UI_EVENT_SCROLL && over) {
+      view->top_line -= event->scroll * 3.0;
+      scrolled = true;
+    } else if (event->type == UI_EVENT_KEY && event->pressed && ctx->focused_widget == widget_id) {
+      switch (event->key) {
+        case UI_KEY_PAGE_UP:   view->top_line -= page; scrolled = true; break;
+        case UI_KEY_PAGE_DOWN: view->top_line += page; scrolled = true; break;
+        case UI_KEY_UP:        view->top_line -= 1.0; scrolled = true; break;
+        case UI_KEY_DOWN:      view->top_line += 1.0; scrolled = true; break;
+        case UI_KEY_HOME:      view->top_line = 0.0; scrolled = true; break;
+        case UI_KEY_END:       view->top_line = max_top; scrolled = true; break;
+        default: break;
+      }
+    }
+  }
+
+  if (view->center_selection) {
+    view->top_line = (double)ui_logview_line_of(view, view->select_offset) - page * 0.5;
+    view->center_selection = false;
+  }
+  if (scrolled) view->follow = view->top_line >= max_top;
+  if (view->follow) view->top_line = max_top;
+  if (view->top_line > max_top) view->top_line = max_top;
+  if (view->top_line < 0.0) view->top_line = 0.0;
+
+  bool is_focused = ctx->focused_widget == widget_id;
+  rect border = {{bounds.pos.x - 1, bounds.pos.y - 1}, {bounds.size.x + 2, bounds.size.y + 2}};
+  if (!ui_widget_visible(ctx, border)) {
+    UI_PROFILE_END(ctx);
+    return;
+  }
+
+  ui_draw_rect(ctx, border, is_focused ?
+    (color){0.3f, 0.3f, 0.8f, 1.0f} :
+    (color){0.0f, 0.0f, 0.0f, 1.0f});
+  color bg_color = {0.1f, 0.1f, 0.1f, 1.0f};
+  if (hovered) {
+    bg_color.r += 0.03f;
+    bg_color.g += 0.03f;
+    bg_color.b += 0.03f;
+  }
+  ui_draw_rect(ctx, bounds, bg_color);
+
+  ui_push_clip(ctx, area);
+
+  // Walk the visible lines from one checkpoint lookup
+  uint64_t line = (uint64_t)view->top_line;
+  float y = area.pos.y - (float)(view->top_line - (double)line) * line_height;
+  uint64_t offset = line < total ? line_start(view, line) : view->snap.size;
+  uint64_t select_end = view->select_offset + view->select_length;
+
+  for (; line < total && y < area.pos.y + area.size.y; line++, y += line_height) {
+    uint64_t end = line_end(view, offset);
+    const char* text = view->data + offset;
+    size_t length = (size_t)(end - offset);
+
+    if (view->select_length > 0 && view->select_offset < end + 1 && select_end > offset) {
+      uint64_t from = view->select_offset > offset ? view->select_offset : offset;
+      uint64_t to = select_end < end ? select_end : end;
+      float x0 = measure_bytes(ctx->font, text, (size_t)(from - offset));
+      float x1 = x0 + measure_bytes(ctx->font, view->data + from, (size_t)(to - from));
+      ui_draw_rect(ctx, (rect){{area.pos.x + x0, y}, {x1 - x0, line_height}},
+        (color){0.6f, 0.5f, 0.1f, 1.0f});
+    }
+
+    size_t visible = fit_bytes(ctx->font, text, length, area.size.x);
+    ui_draw_text_n(ctx, text, visible, (vec2){area.pos.x, y + line_height * 0.5f + 4.0f},
+      (color){0.85f, 0.85f, 0.85f, 1.0f});
+    offset = end + 1;
+  }
+
+  ui_pop_clip(ctx);
+
+  // Scrollbar thumb, position only
+  if (max_top > 0.0) {
+    float thumb = area.size.y * (float)(page / (double)total);
+    if (thumb < 16.0f) thumb = 16.0f;
+    float thumb_y = area.pos.y + (area.size.y - thumb) * (float)(view->top_line / max_top);
+    ui_draw_rect(ctx, (rect){{bounds.pos.x + bounds.size.x - 4.0f, thumb_y}, {3.0f, thumb}},
+      (color){0.5f, 0.5f, 0.5f, 1.0f});
+  }
+
+  UI_PROFILE_END(ctx);
+}
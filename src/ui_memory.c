@@ -0,0 +1,188 @@
+/*
+ * Tridme UI Memory
+ *
+ * Host allocator plumbing and the linear arena used for per-frame data.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_memory.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define UI_ARENA_DEFAULT_ALIGN (sizeof(void*))
+
+static void* default_alloc(size_t size, void* user) {
+  (void)user;
+  return malloc(size);
+}
+
+static void default_free(void* ptr, void* user) {
+  (void)user;
+  free(ptr);
+}
+
+static const UIAllocator g_default_allocator = { default_alloc, default_free, NULL };
+
+const UIAllocator* ui_default_allocator(void) {
+  return &g_default_allocator;
+}
+
+void* ui_mem_alloc(const UIAllocator* allocator, size_t size) {
+  if (!allocator) allocator = &g_default_allocator;
+  return allocator->alloc(size, allocator->user);
+}
+
+void ui_mem_free(const UIAllocator* allocator, void* ptr) {
+  if (!ptr) return;
+  if (!allocator) allocator = &g_default_allocator;
+  allocator->free(ptr, allocator->user);
+}
+
+static inline unsigned char* block_data(UIArenaBlock* block) {
+  return (unsigned char*)(block + 1);
+}
+
+static inline size_t align_up(size_t value, size_t align) {
+  return (value + align - 1) & ~(align - 1);
+}
+
+static UIArenaBlock* new_block(UIArena* arena, size_t capacity) {
+  UIArenaBlock* block = (UIArenaBlock*)ui_mem_alloc(&arena->allocator,
+    sizeof(UIArenaBlock) + capacity);
+  if (!block) return NULL;
+
+  block->next = NULL;
+  block->capacity = capacity;
+  block->used = 0;
+
+  arena->reserved += capacity;
+  arena->block_count++;
+  return block;
+}
+
+bool ui_arena_init(UIArena* arena, const UIAllocator* allocator, size_t block_size,
+  bool allow_growth) {
+  memset(arena, 0, sizeof(*arena));
+  arena->allocator = allocator ? *allocator : g_default_allocator;
+  arena->block_size = block_size ? block_size : 64 * 1024;
+  arena->allow_growth = allow_growth;
+
+  arena->first = new_block(arena, arena->block_size);
+  arena->current = arena->first;
+  return arena->first != NULL;
+}
+
+void ui_arena_release(UIArena* arena) {
+  UIArenaBlock* block = arena->first;
+  while (block) {
+    UIArenaBlock* next = block->next;
+    ui_mem_free(&arena->allocator, block);
+    block = next;
+  }
+
+  arena->first = NULL;
+  arena->current = NULL;
+  arena->used = 0;
+  arena->reserved = 0;
+  arena->block_count = 0;
+}
+
+void ui_arena_reset(UIArena* arena) {
+  for (UIArenaBlock* block = arena->first; block; block = block->next) {
+    block->used = 0;
+  }
+
+  arena->current = arena->first;
+  arena->used = 0;
+}
+
+void* ui_arena_alloc(UIArena* arena, size_t size, size_t align) {
+  if (!align) align = UI_ARENA_DEFAULT_ALIGN;
+
+  UIArenaBlock* block = arena->current;
+  while (block) {
+    // Alignment is computed on the address, block payloads are only pointer aligned
+    uintptr_t base = (uintptr_t)block_data(block);
+    size_t offset = align_up(base + block->used, align) - base;
+
+    if (offset + size <= block->capacity) {
+      arena->used += offset + size - block->used;
+      if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+      }
+
+      block->used = offset + size;
+      arena->current = block;
+      return block_data(block) + offset;
+    }
+
+    // Blocks after the current one were emptied by the last reset, try them in order
+    if (block->next) {
+      arena->used += block->capacity - block->used; // The tail of this block is lost
+      block->used = block->capacity;
+    }
+    block = block->next;
+  }
+
+  if (!arena->allow_growth || !arena->current) {
+    fprintf(stderr, "UI arena exhausted (%zu bytes requested)\n", size);
+    return NULL;
+  }
+
+  // Double the total reservation so a growing frame chains O(log n) blocks
+  size_t capacity = arena->reserved > arena->block_size ? arena->reserved : arena->block_size;
+  if (size + align > capacity) {
+    capacity = size + align;
+  }
+
+  // Chained blocks are appended after the last one so the chain order stays stable
+  UIArenaBlock* tail = arena->current;
+  while (tail->next) tail = tail->next;
+
+  UIArenaBlock* grown = new_block(arena, capacity);
+  if (!grown) return NULL;
+
+  arena->used += tail->capacity - tail->used;
+  tail->used = tail->capacity;
+  tail->next = grown;
+  arena->current = grown;
+
+  return ui_arena_alloc(arena, size, align);
+}
+
+void* ui_arena_grow(UIArena* arena, void* ptr, size_t old_size, size_t new_size,
+  size_t align) {
+  if (!ptr) return ui_arena_alloc(arena, new_size, align);
+  if (new_size <= old_size) return ptr;
+
+  // Extend in place when `ptr` is the newest allocation of the current block
+  UIArenaBlock* block = arena->current;
+  if (block && (unsigned char*)ptr + old_size == block_data(block) + block->used) {
+    size_t offset = (size_t)((unsigned char*)ptr - block_data(block));
+    if (offset + new_size <= block->capacity) {
+      arena->used += new_size - old_size;
+      if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+      }
+      block->used = offset + new_size;
+      return ptr;
+    }
+  }
+
+  void* moved = ui_arena_alloc(arena, new_size, align);
+  if (moved) {
+    memcpy(moved, ptr, old_size);
+  }
+  return moved;
+}
+
+char* ui_arena_strdup(UIArena* arena, const char* str) {
+  size_t len = strlen(str);
+  char* copy = (char*)ui_arena_alloc(arena, len + 1, 1);
+  if (copy) {
+    memcpy(copy, str, len + 1);
+  }
+  return copy;
+}
@@ -0,0 +1,342 @@
+/*
+ * Tridme UI Plot
+ *
+ * Dense sample plots. Visible samples are decimated into per-pixel-column
+ * min/max envelopes, cached across frames on a grid fixed in sample space,
+ * and drawn as one triangle strip.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_plot.h>
+#include <ui_series.h>
+#include <ui_widgets.h>
+#include <ui_draw.h>
+#include <ui_profile.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+  #define UI_PLOT_SSE2 1
+#endif
+
+#define PLOT_DIRECT_SPP 2.0  // Fewer samples per pixel than this are drawn as they are
+
+struct UIPlot {
+  UIAllocator allocator;
+
+  // What the cached columns were decimated from. Column c covers samples
+  // [floor(c * spp), floor((c + 1) * spp)), plus the sample before so
+  // neighbouring columns always overlap
+  const void* source;     // Sample array or series
+  uint64_t version;
+  double spp;
+  size_t complete;        // Sample count when cached; columns reaching past it are redone
+
+  int64_t first;          // Grid index of mins[0] / maxs[0]
+  int count, capacity;
+  float* mins;
+  float* maxs;
+  float* spare_mins;      // Next window, swapped in once built
+  float* spare_maxs;
+};
+
+UIPlot* ui_plot_create(const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  UIPlot* plot = (UIPlot*)ui_mem_alloc(allocator, sizeof(UIPlot));
+  if (!plot) return NULL;
+  memset(plot, 0, sizeof(UIPlot));
+  plot->allocator = *allocator;
+  return plot;
+}
+
+static void free_columns(UIPlot* plot) {
+  ui_mem_free(&plot->allocator, plot->mins);
+  ui_mem_free(&plot->allocator, plot->maxs);
+  ui_mem_free(&plot->allocator, plot->spare_mins);
+  ui_mem_free(&plot->allocator, plot->spare_maxs);
+  plot->mins = plot->maxs = plot->spare_mins = plot->spare_maxs = NULL;
+  plot->count = plot->capacity = 0;
+}
+
+void ui_plot_destroy(UIPlot* plot) {
+  if (!plot) return;
+
+  free_columns(plot);
+  UIAllocator allocator = plot->allocator;
+  ui_mem_free(&allocator, plot);
+}
+
+static void min_max(const float* v, size_t n, float* out_min, float* out_max) {
+  float lo = v[0], hi = v[0];
+  size_t i = 0;
+
+#ifdef UI_PLOT_SSE2
+  if (n >= 8) {
+    // Two accumulators each so consecutive min/max do not wait on each other
+    __m128 min0 = _mm_loadu_ps(v), min1 = _mm_loadu_ps(v + 4);
+    __m128 max0 = min0, max1 = min1;
+    for (i = 8; i + 8 <= n; i += 8) {
+      __m128 a = _mm_loadu_ps(v + i);
+      __m128 b = _mm_loadu_ps(v + i + 4);
+      min0 = _mm_min_ps(min0, a);
+      max0 = _mm_max_ps(max0, a);
+      min1 = _mm_min_ps(min1, b);
+      max1 = _mm_max_ps(max1, b);
+    }
+    __m128 mins = _mm_min_ps(min0, min1);
+    __m128 maxs = _mm_max_ps(max0, max1);
+    mins = _mm_min_ps(mins, _mm_shuffle_ps(mins, mins, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxs = _mm_max_ps(maxs, _mm_shuffle_ps(maxs, maxs, _MM_SHUFFLE(2, 3, 0, 1)));
+    mins = _mm_min_ps(mins, _mm_shuffle_ps(mins, mins, _MM_SHUFFLE(1, 0, 3, 2)));
+    maxs = _mm_max_ps(maxs, _mm_shuffle_ps(maxs, maxs, _MM_SHUFFLE(1, 0, 3, 2)));
+    lo = _mm_cvtss_f32(mins);
+    hi = _mm_cvtss_f32(maxs);
+  }
+#endif
+
+  for (; i < n; i++) {
+    if (v[i] < lo) lo = v[i];
+    if (v[i] > hi) hi = v[i];
+  }
+  *out_min = lo;
+  *out_max = hi;
+}
+
+static size_t column_start(double spp, int64_t column) {
+  return (size_t)floor((double)column * spp);
+}
+
+// Samples [first, end) of an array or a series snapshot
+typedef struct {
+  const float* samples;
+  const UISeriesSnapshot* series;
+  size_t first, end;
+} plot_source;
+
+static void source_min_max(const plot_source* source, size_t first, size_t last, float* out_min,
+  float* out_max) {
+  if (source->series) {
+    ui_series_min_max(source->series, first, last, out_min, out_max);
+  } else {
+    min_max(source->samples + first, last - first, out_min, out_max);
+  }
+}
+
+// Samples from index on that are contiguous in memory, at most max
+static size_t source_span(const plot_source* source, size_t index, size_t max, const float** samples) {
+  size_t count = max;
+  if (source->series) {
+    count = ui_series_span(source->series, index, samples);
+    if (count > max) count = max;
+  } else {
+    *samples = source->samples + index;
+  }
+  return count;
+}
+
+// Bring the cache to columns [c0, c1), reusing every complete column it has
+static bool update_columns(UIPlot* plot, const UIPlotDesc* desc, const plot_source* source,
+  double spp, int64_t c0, int64_t c1) {
+  const void* key = source->series ? (const void*)source->series->series : (const void*)source->samples;
+  if (plot->source != key || plot->version != desc->version || plot->spp != spp) {
+    plot->source = key;
+    plot->version = desc->version;
+    plot->spp = spp;
+    plot->count = 0;
+  }
+
+  int count = (int)(c1 - c0);
+  if (count > plot->capacity) {
+    free_columns(plot);
+    const UIAllocator* allocator = &plot->allocator;
+    size_t size = sizeof(float) * count;
+    plot->mins = (float*)ui_mem_alloc(allocator, size);
+    plot->maxs = (float*)ui_mem_alloc(allocator, size);
+    plot->spare_mins = (float*)ui_mem_alloc(allocator, size);
+    plot->spare_maxs = (float*)ui_mem_alloc(allocator, size);
+    if (!plot->mins || !plot->maxs || !plot->spare_mins || !plot->spare_maxs) {
+      fprintf(stderr, "Failed to allocate %d plot columns\n", count);
+      free_columns(plot);
+      return false;
+    }
+    plot->capacity = count;
+  }
+
+  float* mins = plot->spare_mins;
+  float* maxs = plot->spare_maxs;
+  for (int64_t c = c0; c < c1; c++) {
+    int64_t cached = c - plot->first;
+    if (cached >= 0 && cached < plot->count && column_start(spp, c + 1) <= plot->complete) {
+      mins[c - c0] = plot->mins[cached];
+      maxs[c - c0] = plot->maxs[cached];
+      continue;
+    }
+
+    size_t start = column_start(spp, c);
+    size_t end = column_start(spp, c + 1);
+    if (end > source->end) end = source->end;
+    if (start > source->first) start--;
+    if (start < source->first) start = source->first;
+    source_min_max(source, start, end, &mins[c - c0], &maxs[c - c0]);
+  }
+
+  plot->spare_mins = plot->mins;
+  plot->spare_maxs = plot->maxs;
+  plot->mins = mins;
+  plot->maxs = maxs;
+  plot->first = c0;
+  plot->count = count;
+  plot->complete = source->end;
+
+  // Lapped by the series' producer: draw what was read once, redo it next frame
+  if (source->series && !ui_series_snapshot_valid(source->series)) plot->count = 0;
+  return true;
+}
+
+typedef struct {
+  float top, bottom;      // Pixel rows of the range drawn
+  float scale;            // Pixels per value unit
+  float y_max;
+  float half_width;       // UI_PLOT_LINE: half the minimum thickness
+  bool area;
+} plot_mapping;
+
+// Write the two vertices of one strip column, value range lo..hi
+static void emit_column(ui_vertex* v, const plot_mapping* map, float x, float lo, float hi) {
+  float top = map->top + (map->y_max - hi) * map->scale;
+  float bottom = map->area ? map->bottom : map->top + (map->y_max - lo) * map->scale;
+  if (!map->area && bottom - top < map->half_width * 2) {
+    float mid = (top + bottom) * 0.5f;
+    top = mid - map->half_width;
+    bottom = mid + map->half_width;
+  }
+  v[0].position = (vec2){x, top};
+  v[1].position = (vec2){x, bottom};
+}
+
+static bool setup_mapping(plot_mapping* map, const UIPlotDesc* desc, rect bounds, float lo, float hi) {
+  float y_min = desc->y_min, y_max = desc->y_max;
+  if (y_min == y_max) {
+    y_min = lo;
+    y_max = hi;
+    if (y_min == y_max) {
+      y_min -= 0.5f;
+      y_max += 0.5f;
+    }
+  }
+  if (!(y_max > y_min)) return false;
+
+  map->top = bounds.pos.y;
+  map->bottom = bounds.pos.y + bounds.size.y;
+  map->scale = bounds.size.y / (y_max - y_min);
+  map->y_max = y_max;
+  map->half_width = (desc->line_width > 0 ? desc->line_width : 1.0f) * 0.5f;
+  map->area = desc->mode == UI_PLOT_AREA;
+  return true;
+}
+
+static ui_vertex* add_strip(UIContext* ctx, const UIPlotDesc* desc, uint32_t columns) {
+  ui_vertex* v = ui_draw_list_add_strip(ctx, ctx->texture_atlas, UI_PIPELINE_ALPHA, columns * 2);
+  if (!v) return NULL;
+
+  for (uint32_t i = 0; i < columns * 2; i++) {
+    v[i].texcoord = ctx->white_uv;
+    v[i].col = desc->foreground;
+  }
+  return v;
+}
+
+// Zoomed in: one strip column per sample, one sample past each edge
+static void draw_samples(UIContext* ctx, rect bounds, const UIPlotDesc* desc,
+  const plot_source* source, double start, double spp) {
+  double first = floor(start) - 1;
+  double last = ceil(start + bounds.size.x * spp) + 1;
+  size_t i0 = first > (double)source->first ? (size_t)first : source->first;
+  size_t i1 = last < (double)source->end ? (size_t)last + 1 : source->end;
+  if (i1 < i0 + 2) return;
+
+  float lo, hi;
+  source_min_max(source, i0, i1, &lo, &hi);
+  plot_mapping map;
+  if (!setup_mapping(&map, desc, bounds, lo, hi)) return;
+
+  ui_vertex* v = add_strip(ctx, desc, (uint32_t)(i1 - i0));
+  if (!v) return;
+  for (size_t i = i0; i < i1;) {
+    const float* samples;
+    size_t count = source_span(source, i, i1 - i, &samples);
+    for (size_t j = 0; j < count; j++, i++, v += 2) {
+      float x = bounds.pos.x + (float)(((double)i - start) / spp);
+      emit_column(v, &map, x, samples[j], samples[j]);
+    }
+  }
+}
+
+// Zoomed out: one strip column per pixel column, from the cached envelope
+static void draw_envelope(UIContext* ctx, UIPlot* plot, rect bounds, const UIPlotDesc* desc,
+  const plot_source* source, double start, double spp) {
+  double first = start > (double)source->first ? start : (double)source->first;
+  double last = ceil((start + bounds.size.x * spp) / spp);
+  double data_end = ceil((double)source->end / spp);
+  int64_t c0 = (int64_t)floor(first / spp);
+  int64_t c1 = (int64_t)(last < data_end ? last : data_end);
+  if (c1 < c0 + 2) return;
+
+  UI_PROFILE_BEGIN(ctx, "plot_decimate");
+  bool ok = update_columns(plot, desc, source, spp, c0, c1);
+  UI_PROFILE_END(ctx);
+  if (!ok) return;
+
+  int count = plot->count;
+  float lo = plot->mins[0], hi = plot->maxs[0];
+  for (int i = 1; i < count; i++) {
+    if (plot->mins[i] < lo) lo = plot->mins[i];
+    if (plot->maxs[i] > hi) hi = plot->maxs[i];
+  }
+  plot_mapping map;
+  if (!setup_mapping(&map, desc, bounds, lo, hi)) return;
+
+  ui_vertex* v = add_strip(ctx, desc, (uint32_t)count);
+  if (!v) return;
+  for (int i = 0; i < count; i++, v += 2) {
+    // Center of the samples the column covers
+    int64_t c = c0 + i;
+    double center = ((double)column_start(spp, c) + (double)column_start(spp, c + 1)) * 0.5;
+    float x = bounds.pos.x + (float)((center - start) / spp);
+    emit_column(v, &map, x, plot->mins[i], plot->maxs[i]);
+  }
+}
+
+void ui_plot(UIContext* ctx, UIPlot* plot, rect bounds, const UIPlotDesc* desc) {
+  if (!ui_widget_visible(ctx, bounds)) return;
+  UI_PROFILE_BEGIN(ctx, "ui_plot");
+
+  if (desc->background.a > 0.0f) ui_draw_rect(ctx, bounds, desc->background);
+
+  plot_source source = {desc->samples, desc->series, 0, desc->count};
+  if (desc->series) {
+    source.first = (size_t)desc->series->begin;
+    source.end = (size_t)desc->series->end;
+  }
+
+  double start = desc->view_start;
+  double end = desc->view_end > 0 ? desc->view_end : (double)source.end;
+  if ((source.samples || source.series) && source.end > source.first && end > start &&
+      bounds.size.x >= 1.0f && bounds.size.y > 0.0f) {
+    double spp = (end - start) / bounds.size.x;
+
+    ui_push_clip(ctx, bounds);
+    if (spp < PLOT_DIRECT_SPP) {
+      draw_samples(ctx, bounds, desc, &source, start, spp);
+    } else {
+      draw_envelope(ctx, plot, bounds, desc, &source, start, spp);
+    }
+    ui_pop_clip(ctx);
+  }
+
+  UI_PROFILE_END(ctx);
+}
@@ -0,0 +1,194 @@
+/*
+ * Tridme UI Profiler
+ *
+ * Per-context scope recording into single-writer rings, and Chrome trace
+ * export.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_profile.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+uint64_t ui_profile_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+UIProfiler* ui_profiler_create(uint32_t capacity, uint16_t track, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  uint32_t size = 64;
+  while (size < capacity) size <<= 1;
+
+  UIProfiler* profiler = (UIProfiler*)ui_mem_alloc(allocator, sizeof(UIProfiler));
+  if (!profiler) return NULL;
+  memset(profiler, 0, sizeof(UIProfiler));
+
+  profiler->events = (UIProfileEvent*)ui_mem_alloc(allocator, sizeof(UIProfileEvent) * size);
+  if (!profiler->events) {
+    ui_mem_free(allocator, profiler);
+    return NULL;
+  }
+
+  profiler->allocator = *allocator;
+  profiler->track = track;
+  profiler->capacity = size;
+  atomic_init(&profiler->head, 0);
+  for (int i = 0; i < UI_MAX_REGIONS; i++) {
+    atomic_init(&profiler->children[i], NULL);
+  }
+  return profiler;
+}
+
+void ui_profiler_destroy(UIProfiler* profiler) {
+  if (!profiler) return;
+
+  for (int i = 0; i < UI_MAX_REGIONS; i++) {
+    ui_profiler_destroy(atomic_load_explicit(&profiler->children[i], memory_order_relaxed));
+  }
+
+  UIAllocator allocator = profiler->allocator;
+  ui_mem_free(&allocator, profiler->events);
+  ui_mem_free(&allocator, profiler);
+}
+
+void ui_profile_record(UIProfiler* profiler, const UIProfileEvent* event) {
+  // Only the writer moves head, so a relaxed load of our own counter is enough
+  uint64_t head = atomic_load_explicit(&profiler->head, memory_order_relaxed);
+  profiler->events[head & (profiler->capacity - 1)] = *event;
+  atomic_store_explicit(&profiler->head, head + 1, memory_order_release);
+}
+
+void ui_profile_begin(UIProfiler* profiler, const char* name) {
+  if (profiler->depth >= UI_PROFILE_MAX_DEPTH) {
+    // Too deep to record, still count it so the matching end stays balanced
+    profiler->depth++;
+    return;
+  }
+
+  profiler->stack[profiler->depth].name = name;
+  profiler->stack[profiler->depth].start_ns = ui_profile_now_ns();
+  profiler->depth++;
+}
+
+void ui_profile_end(UIProfiler* profiler) {
+  if (profiler->depth == 0) return;
+  profiler->depth--;
+  if (profiler->depth >= UI_PROFILE_MAX_DEPTH) return;
+
+  UIProfileEvent event = {
+    .name = profiler->stack[profiler->depth].name,
+    .start_ns = profiler->stack[profiler->depth].start_ns,
+    .frame = profiler->frame,
+    .depth = (uint16_t)profiler->depth,
+    .track = profiler->track
+  };
+  event.duration_ns = ui_profile_now_ns() - event.start_ns;
+  ui_profile_record(profiler, &event);
+}
+
+uint32_t ui_profile_read(UIProfiler* profiler, UIProfileEvent* out, uint32_t max, uint64_t min_frame) {
+  uint32_t mask = profiler->capacity - 1;
+  uint64_t head = atomic_load_explicit(&profiler->head, memory_order_acquire);
+  uint64_t first = head > profiler->capacity ? head - profiler->capacity : 0;
+
+  // Copy optimistically, then drop whatever the writer may have lapped meanwhile
+  uint32_t count = 0;
+  for (uint64_t i = first; i < head && count < max; i++) {
+    out[count++] = profiler->events[i & mask];
+  }
+
+  atomic_thread_fence(memory_order_acquire);
+  uint64_t new_head = atomic_load_explicit(&profiler->head, memory_order_relaxed);
+  uint64_t valid_from = new_head >= profiler->capacity ? new_head - profiler->capacity + 1 : 0;
+
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t index = first + i;
+    if (index < valid_from || out[i].frame < min_frame) continue;
+    out[kept++] = out[i];
+  }
+  return kept;
+}
+
+static void write_event(FILE* file, const UIProfileEvent* event, bool* first) {
+  // Chrome trace timestamps are microseconds
+  fprintf(file, "%s\n    {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+    "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %llu, \"depth\": %u}}",
+    *first ? "" : ",",
+    event->name ? event->name : "?",
+    event->track == UI_PROFILE_TRACK_GPU ? "gpu" : "cpu",
+    (unsigned)event->track,
+    event->start_ns / 1000.0, event->duration_ns / 1000.0,
+    (unsigned long long)event->frame, (unsigned)event->depth);
+  *first = false;
+}
+
+static void write_thread_name(FILE* file, unsigned track, const char* name, int index, bool* first) {
+  fprintf(file, "%s\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+    "\"args\": {\"name\": \"%s", *first ? "" : ",", track, name);
+  if (index >= 0) fprintf(file, " %d", index);
+  fprintf(file, "\"}}");
+  *first = false;
+}
+
+static void write_profiler(FILE* file, UIProfiler* profiler, UIProfileEvent* scratch,
+  uint64_t min_frame, bool* first) {
+  uint32_t count = ui_profile_read(profiler, scratch, profiler->capacity, min_frame);
+  for (uint32_t i = 0; i < count; i++) {
+    write_event(file, &scratch[i], first);
+  }
+}
+
+bool ui_profile_write_chrome_trace(UIContext* ctx, const char* path, int frames) {
+  UIProfiler* profiler = ctx->profiler;
+  if (!profiler) {
+    fprintf(stderr, "Profiling is not enabled on this context\n");
+    return false;
+  }
+
+  // One scratch buffer big enough for any ring of this context
+  uint32_t capacity = profiler->capacity;
+  for (int i = 0; i < UI_MAX_REGIONS; i++) {
+    UIProfiler* child = atomic_load_explicit(&profiler->children[i], memory_order_acquire);
+    if (child && child->capacity > capacity) capacity = child->capacity;
+  }
+
+  UIProfileEvent* scratch = (UIProfileEvent*)ui_mem_alloc(&ctx->allocator,
+    sizeof(UIProfileEvent) * capacity);
+  if (!scratch) return false;
+
+  FILE* file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "Failed to open %s for writing\n", path);
+    ui_mem_free(&ctx->allocator, scratch);
+    return false;
+  }
+
+  uint64_t current = ctx->frame_index;
+  uint64_t min_frame = frames > 0 && current > (uint64_t)frames ? current - frames + 1 : 0;
+  bool first = true;
+
+  fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+  write_thread_name(file, profiler->track, "UI", -1, &first);
+  write_thread_name(file, UI_PROFILE_TRACK_GPU, "GPU", -1, &first);
+  write_profiler(file, profiler, scratch, min_frame, &first);
+
+  for (int i = 0; i < UI_MAX_REGIONS; i++) {
+    UIProfiler* child = atomic_load_explicit(&profiler->children[i], memory_order_acquire);
+    if (!child) continue;
+    write_thread_name(file, child->track, "UI region", i, &first);
+    write_profiler(file, child, scratch, min_frame, &first);
+  }
+
+  fprintf(file, "\n]}\n");
+  bool ok = ferror(file) == 0;
+  fclose(file);
+
+  ui_mem_free(&ctx->allocator, scratch);
+  return ok;
+}
@@ -0,0 +1,358 @@
+/*
+ * Tridme UI Record
+ *
+ * Binary input logs: written by ui_begin_frame while recording, fed back
+ * into a context frame by frame for replay.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_record.h>
+#include <ui_input.h>
+#include <string.h>
+#include <stdio.h>
+
+#define RECORD_PRESSED 0x80  // Type byte flag of UI_EVENT_MOUSE_BUTTON and UI_EVENT_KEY
+#define RECORD_HEADER_SIZE 16
+
+typedef struct UIRecorder {
+  UIAllocator allocator;
+  FILE* file;
+  uint64_t last_time_ns;  // Events store the time since the previous one
+  bool failed;
+} UIRecorder;
+
+struct UIReplay {
+  UIAllocator allocator;
+  unsigned char* data;
+  size_t size;
+  size_t cursor;          // Next frame
+  uint64_t last_time_ns;
+  uint32_t frame;
+  uint32_t dropped;       // Events the context's queue had no room for
+  UIReplayInfo info;
+};
+
+/*
+ * Encoding
+ */
+
+typedef struct {
+  unsigned char bytes[256];
+  size_t used;
+} record_buffer;
+
+static void put_u8(record_buffer* buffer, unsigned int value) {
+  buffer->bytes[buffer->used++] = (unsigned char)value;
+}
+
+static void put_u32(record_buffer* buffer, uint32_t value) {
+  for (int i = 0; i < 4; i++) put_u8(buffer, (value >> (i * 8)) & 0xff);
+}
+
+static void put_f32(record_buffer* buffer, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  put_u32(buffer, bits);
+}
+
+static void put_varint(record_buffer* buffer, uint64_t value) {
+  while (value >= 0x80) {
+    put_u8(buffer, (value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  put_u8(buffer, value);
+}
+
+// Small negative numbers stay small: 0, -1, 1, -2 ... become 0, 1, 2, 3 ...
+static void put_signed(record_buffer* buffer, int64_t value) {
+  put_varint(buffer, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void flush_buffer(UIRecorder* recorder, record_buffer* buffer) {
+  if (buffer->used > 0 && fwrite(buffer->bytes, 1, buffer->used, recorder->file) != buffer->used) {
+    recorder->failed = true;
+  }
+  buffer->used = 0;
+}
+
+static void encode_event(UIRecorder* recorder, record_buffer* buffer, const UIInputEvent* event) {
+  unsigned int type = (unsigned int)event->type;
+  if ((event->type == UI_EVENT_MOUSE_BUTTON || event->type == UI_EVENT_KEY) && event->pressed) {
+    type |= RECORD_PRESSED;
+  }
+  put_u8(buffer, type);
+  put_signed(buffer, (int64_t)(event->time_ns - recorder->last_time_ns));
+  recorder->last_time_ns = event->time_ns;
+
+  switch (event->type) {
+    case UI_EVENT_MOUSE_MOVE:
+      put_f32(buffer, event->mouse_pos.x);
+      put_f32(buffer, event->mouse_pos.y);
+      break;
+    case UI_EVENT_MOUSE_BUTTON:
+      put_u8(buffer, (unsigned int)event->button);
+      break;
+    case UI_EVENT_KEY:
+      put_signed(buffer, event->key);
+      put_signed(buffer, event->mods);
+      break;
+    case UI_EVENT_CHAR:
+      put_varint(buffer, event->codepoint);
+      break;
+    case UI_EVENT_SCROLL:
+      put_f32(buffer, event->scroll);
+      break;
+  }
+}
+
+bool ui_record_begin(UIContext* ctx, const char* path) {
+  if (ctx->parent) {
+    fprintf(stderr, "Regions cannot record input, record their context\n");
+    return false;
+  }
+  ui_record_end(ctx);
+
+  UIRecorder* recorder = (UIRecorder*)ui_mem_alloc(&ctx->allocator, sizeof(UIRecorder));
+  if (!recorder) return false;
+  memset(recorder, 0, sizeof(UIRecorder));
+  recorder->allocator = ctx->allocator;
+
+  recorder->file = fopen(path, "wb");
+  if (!recorder->file) {
+    fprintf(stderr, "Failed to create input log %s\n", path);
+    ui_mem_free(&ctx->allocator, recorder);
+    return false;
+  }
+
+  record_buffer header = {.used = 0};
+  memcpy(header.bytes, "TUIR", 4);
+  header.used = 4;
+  put_u32(&header, UI_RECORD_VERSION);
+  put_u32(&header, (uint32_t)ctx->width);
+  put_u32(&header, (uint32_t)ctx->height);
+  flush_buffer(recorder, &header);
+
+  ctx->recorder = recorder;
+  return true;
+}
+
+bool ui_record_end(UIContext* ctx) {
+  UIRecorder* recorder = ctx->recorder;
+  if (!recorder) return true;
+
+  bool ok = !recorder->failed;
+  if (fclose(recorder->file) != 0) ok = false;
+  if (!ok) fprintf(stderr, "Failed to write the input log\n");
+
+  UIAllocator allocator = recorder->allocator;
+  ui_mem_free(&allocator, recorder);
+  ctx->recorder = NULL;
+  return ok;
+}
+
+void ui_record_frame(UIContext* ctx) {
+  UIRecorder* recorder = ctx->recorder;
+  if (recorder->failed) return;
+
+  record_buffer buffer = {.used = 0};
+  put_varint(&buffer, (uint64_t)ctx->event_count);
+  put_f32(&buffer, ctx->delta_time);
+
+  for (int i = 0; i < ctx->event_count; i++) {
+    // Longest event: type, time and two 64-bit varints
+    if (sizeof(buffer.bytes) - buffer.used < 32) flush_buffer(recorder, &buffer);
+    encode_event(recorder, &buffer, &ctx->events[i]);
+  }
+  flush_buffer(recorder, &buffer);
+}
+
+/*
+ * Decoding
+ */
+
+typedef struct {
+  const unsigned char* p;
+  const unsigned char* end;
+  bool ok;  // Cleared on reading past the end or malformed data
+} record_reader;
+
+static unsigned int get_u8(record_reader* reader) {
+  if (reader->p >= reader->end) {
+    reader->ok = false;
+    return 0;
+  }
+  return *reader->p++;
+}
+
+static uint32_t get_u32(record_reader* reader) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) value |= (uint32_t)get_u8(reader) << (i * 8);
+  return value;
+}
+
+static float get_f32(record_reader* reader) {
+  uint32_t bits = get_u32(reader);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static uint64_t get_varint(record_reader* reader) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    unsigned int byte = get_u8(reader);
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return value;
+  }
+  reader->ok = false;
+  return 0;
+}
+
+static int64_t get_signed(record_reader* reader) {
+  uint64_t value = get_varint(reader);
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static bool decode_event(record_reader* reader, uint64_t* time_ns, UIInputEvent* event) {
+  unsigned int type = get_u8(reader);
+  memset(event, 0, sizeof(UIInputEvent));
+  event->type = (UIInputEventType)(type & ~RECORD_PRESSED);
+  event->pressed = (type & RECORD_PRESSED) != 0;
+  *time_ns += (uint64_t)get_signed(reader);
+  event->time_ns = *time_ns;
+
+  switch (event->type) {
+    case UI_EVENT_MOUSE_MOVE:
+      event->mouse_pos.x = get_f32(reader);
+      event->mouse_pos.y = get_f32(reader);
+      break;
+    case UI_EVENT_MOUSE_BUTTON:
+      event->button = (int)get_u8(reader);
+      break;
+    case UI_EVENT_KEY:
+      event->key = (int)get_signed(reader);
+      event->mods = (int)get_signed(reader);
+      break;
+    case UI_EVENT_CHAR:
+      event->codepoint = (unsigned int)get_varint(reader);
+      break;
+    case UI_EVENT_SCROLL:
+      event->scroll = get_f32(reader);
+      break;
+    default:
+      reader->ok = false;
+      break;
+  }
+  return reader->ok;
+}
+
+// Read one frame, queueing its events into ctx unless it is NULL
+static bool decode_frame(UIReplay* replay, record_reader* reader, UIContext* ctx,
+  float* delta_time, uint32_t* event_count) {
+  uint64_t count = get_varint(reader);
+  *delta_time = get_f32(reader);
+  // Every event takes at least two bytes, larger counts are garbage
+  if (!reader->ok || count > (uint64_t)(reader->end - reader->p) / 2) return false;
+
+  UIInputEvent event;
+  for (uint64_t i = 0; i < count; i++) {
+    if (!decode_event(reader, &replay->last_time_ns, &event)) return false;
+    if (ctx && !ui_push_event(ctx, &event)) replay->dropped++;
+  }
+  *event_count = (uint32_t)count;
+  return true;
+}
+
+UIReplay* ui_replay_open(const char* path, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Failed to open input log %s\n", path);
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  UIReplay* replay = (UIReplay*)ui_mem_alloc(allocator, sizeof(UIReplay));
+  unsigned char* data = length >= RECORD_HEADER_SIZE ?
+    (unsigned char*)ui_mem_alloc(allocator, (size_t)length) : NULL;
+  bool ok = replay && data && fread(data, 1, (size_t)length, file) == (size_t)length;
+  fclose(file);
+
+  record_reader reader = {data, data + (ok ? length : 0), true};
+  if (ok && memcmp(data, "TUIR", 4) == 0) {
+    reader.p += 4;
+    ok = get_u32(&reader) == UI_RECORD_VERSION;
+  } else {
+    ok = false;
+  }
+  if (!ok) {
+    fprintf(stderr, "%s is not an input log this version can read\n", path);
+    ui_mem_free(allocator, data);
+    ui_mem_free(allocator, replay);
+    return NULL;
+  }
+
+  memset(replay, 0, sizeof(UIReplay));
+  replay->allocator = *allocator;
+  replay->data = data;
+  replay->size = (size_t)length;
+  replay->info.width = (int)get_u32(&reader);
+  replay->info.height = (int)get_u32(&reader);
+
+  // Count the complete frames, a log cut short ends at the last one
+  float delta_time;
+  uint32_t count;
+  while (reader.p < reader.end) {
+    if (!decode_frame(replay, &reader, NULL, &delta_time, &count)) {
+      fprintf(stderr, "Input log %s is cut short after %u frames\n", path,
+        replay->info.frame_count);
+      break;
+    }
+    replay->info.frame_count++;
+    replay->info.event_count += count;
+    if (count > replay->info.max_frame_events) replay->info.max_frame_events = count;
+  }
+
+  ui_replay_rewind(replay);
+  return replay;
+}
+
+void ui_replay_close(UIReplay* replay) {
+  if (!replay) return;
+
+  UIAllocator allocator = replay->allocator;
+  ui_mem_free(&allocator, replay->data);
+  ui_mem_free(&allocator, replay);
+}
+
+UIReplayInfo ui_replay_info(const UIReplay* replay) {
+  return replay->info;
+}
+
+bool ui_replay_frame(UIReplay* replay, UIContext* ctx, float* delta_time) {
+  if (replay->frame >= replay->info.frame_count) return false;
+
+  // Frames were validated by ui_replay_open
+  record_reader reader = {replay->data + replay->cursor, replay->data + replay->size, true};
+  uint32_t count;
+  decode_frame(replay, &reader, ctx, delta_time, &count);
+  replay->cursor = (size_t)(reader.p - replay->data);
+  replay->frame++;
+
+  if (replay->dropped > 0) {
+    fprintf(stderr, "Replay dropped %u input events, the context needs input_events >= %u\n",
+      replay->dropped, replay->info.max_frame_events);
+    replay->dropped = 0;
+  }
+  return true;
+}
+
+void ui_replay_rewind(UIReplay* replay) {
+  replay->cursor = RECORD_HEADER_SIZE;
+  replay->last_time_ns = 0;
+  replay->frame = 0;
+}
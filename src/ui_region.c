@@ -0,0 +1,215 @@
+/*
+ * Tridme UI Regions
+ *
+ * Child contexts recorded on worker threads and merged into the parent's
+ * draw list at the end of the frame.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_region.h>
+#include <ui_draw.h>
+#include <ui_widgets.h>
+#include <ui_profile.h>
+#include <ui_hit.h>
+#include <string.h>
+#include <stdio.h>
+
+static UIContext* acquire_region(UIContext* ctx, int index) {
+  if (ctx->regions[index]) return ctx->regions[index];
+
+  // Region contexts are created on first use and reused every frame after that
+  UIContext* region = (UIContext*)ui_mem_alloc(&ctx->allocator, sizeof(UIContext));
+  if (!region) return NULL;
+
+  if (!ui_context_init_state(region, &ctx->allocator, ctx->frame_arena.block_size,
+        ctx->frame_arena.allow_growth)) {
+    ui_mem_free(&ctx->allocator, region);
+    return NULL;
+  }
+
+  // Each region records on its own thread, so it gets its own ring under the parent's profiler
+  if (ctx->profiler) {
+    region->profiler = ui_profiler_create(ctx->profiler->capacity, (uint16_t)(index + 1),
+      &ctx->allocator);
+    atomic_store_explicit(&ctx->profiler->children[index], region->profiler, memory_order_release);
+  }
+
+  region->parent = ctx;
+  ctx->regions[index] = region;
+  return region;
+}
+
+// Read-only snapshot of everything widgets read from the parent
+static void copy_frame_state(UIContext* region, const UIContext* ctx) {
+  region->width = ctx->width;
+  region->height = ctx->height;
+
+  region->mouse_pos = ctx->mouse_pos;
+  memcpy(region->mouse_buttons, ctx->mouse_buttons, sizeof(ctx->mouse_buttons));
+  memcpy(region->prev_mouse_buttons, ctx->prev_mouse_buttons, sizeof(ctx->prev_mouse_buttons));
+  region->scroll_offset = ctx->scroll_offset;
+
+  // The parent's frame arena holds the events until its next ui_begin_frame
+  region->events = ctx->events;
+  region->event_count = ctx->event_count;
+
+  region->texture_atlas = ctx->texture_atlas;
+  region->white_uv = ctx->white_uv;
+  region->images = ctx->images;
+  region->font = ctx->font;
+  region->font_size = ctx->font_size;
+
+  region->hit_index = ctx->hit_index;
+  region->hover_id = ctx->hover_id;
+
+  region->hot_widget = ctx->hot_widget;
+  region->active_widget = ctx->active_widget;
+  region->focused_widget = ctx->focused_widget;
+  region->frame_focused_widget = ctx->frame_focused_widget;
+  region->focus_event = ctx->focus_event;
+
+  region->frame_index = ctx->frame_index;
+  if (region->profiler) region->profiler->frame = ctx->frame_index;
+
+  region->time = ctx->time;
+  region->delta_time = ctx->delta_time;
+  region->margin = ctx->margin;
+}
+
+UIContext* ui_region_begin(UIContext* ctx, rect bounds) {
+  if (ctx->region_count >= UI_MAX_REGIONS) {
+    fprintf(stderr, "Too many UI regions in one frame (max %d)\n", UI_MAX_REGIONS);
+    return NULL;
+  }
+
+  UIContext* region = acquire_region(ctx, ctx->region_count);
+  if (!region) return NULL;
+
+  copy_frame_state(region, ctx);
+
+  ui_arena_reset(&region->frame_arena);
+  ui_draw_list_reset(region->draw_list, &region->frame_arena);
+  region->layout_stack_size = 0;
+  region->clip_stack_size = 0;
+  region->hit_rects = NULL;
+  region->hit_count = region->hit_capacity = 0;
+  memset(&region->frame_stats, 0, sizeof(UIFrameStats));
+
+  // The region is clipped to its bounds inside whatever the parent clips to
+  region->clip_stack[region->clip_stack_size++] = ui_current_clip(ctx);
+  ui_push_clip(region, bounds);
+  ui_push_layout(region, bounds.pos);
+
+  // Draw order: the region goes before whatever the parent records next
+  region->region_insert_at = ctx->draw_list->command_count;
+  region->region_hit_insert_at = ctx->hit_count;
+  ctx->draw_list->split = true;
+
+  region->region_start_ids[0] = region->hot_widget;
+  region->region_start_ids[1] = region->active_widget;
+  region->region_start_ids[2] = region->focused_widget;
+  region->region_open = true;
+
+  ctx->region_count++;
+  return region;
+}
+
+void ui_region_end(UIContext* region) {
+  if (!region || !region->region_open) return;
+
+  region->layout_stack_size = 0;
+  region->clip_stack_size = 0;
+  region->region_open = false;
+}
+
+typedef struct {
+  UIContext* region;
+  const UIRegionDesc* desc;
+} region_job;
+
+static void build_region_job(void* arg) {
+  region_job* job = (region_job*)arg;
+  UI_PROFILE_BEGIN(job->region, "region");
+  job->desc->build(job->region, job->desc->user);
+  UI_PROFILE_END(job->region);
+  ui_region_end(job->region);
+}
+
+void ui_build_regions(UIContext* ctx, const UIRegionDesc* regions, int count,
+  const UIJobSystem* jobs) {
+  region_job* job_data = (region_job*)ui_arena_alloc(&ctx->frame_arena,
+    sizeof(region_job) * count, 0);
+  void** args = (void**)ui_arena_alloc(&ctx->frame_arena, sizeof(void*) * count, 0);
+  if (!job_data || !args) return;
+
+  int job_count = 0;
+  for (int i = 0; i < count; i++) {
+    UIContext* region = ui_region_begin(ctx, regions[i].bounds);
+    if (!region) break;
+
+    job_data[job_count].region = region;
+    job_data[job_count].desc = &regions[i];
+    args[job_count] = &job_data[job_count];
+    job_count++;
+  }
+
+  ui_jobs_run(jobs, build_region_job, args, job_count);
+}
+
+void ui_regions_merge(UIContext* ctx) {
+  if (ctx->region_count == 0) return;
+
+  ui_hit_merge_regions(ctx);
+
+  UIDrawList* list = ctx->draw_list;
+  UIArena* arena = &ctx->frame_arena;
+
+  // Keep the parent's commands aside and rebuild the command order around the regions
+  int parent_count = list->command_count;
+  UIDrawCmd* parent_cmds = NULL;
+  if (parent_count > 0) {
+    parent_cmds = (UIDrawCmd*)ui_arena_alloc(arena, sizeof(UIDrawCmd) * parent_count, 0);
+    if (!parent_cmds) return;
+    memcpy(parent_cmds, list->commands, sizeof(UIDrawCmd) * parent_count);
+  }
+  list->command_count = 0;
+
+  int next_region = 0;
+  for (int i = 0; i <= parent_count; i++) {
+    while (next_region < ctx->region_count &&
+           ctx->regions[next_region]->region_insert_at == i) {
+      UIContext* region = ctx->regions[next_region++];
+      if (region->region_open) {
+        fprintf(stderr, "UI region %d was not ended before ui_end_frame\n", next_region - 1);
+      }
+
+      ui_draw_list_append(list, arena, region->draw_list);
+
+      UI_STAT_ADD(ctx, glyphs_drawn, region->frame_stats.glyphs_drawn);
+      UI_STAT_ADD(ctx, glyph_misses, region->frame_stats.glyph_misses);
+      UI_STAT_ADD(ctx, widgets_processed, region->frame_stats.widgets_processed);
+      UI_STAT_ADD(ctx, widgets_culled, region->frame_stats.widgets_culled);
+
+      // Widget state the region changed wins over what the parent had
+      if (region->hot_widget != region->region_start_ids[0]) {
+        ctx->hot_widget = region->hot_widget;
+      }
+      if (region->active_widget != region->region_start_ids[1]) {
+        ctx->active_widget = region->active_widget;
+      }
+      if (region->focused_widget != region->region_start_ids[2] &&
+          region->focus_event >= ctx->focus_event) {
+        ctx->focused_widget = region->focused_widget;
+        ctx->focus_event = region->focus_event;
+      }
+    }
+
+    if (i < parent_count) {
+      ui_draw_list_push_command(list, arena, &parent_cmds[i]);
+    }
+  }
+
+  list->split = true;
+  ctx->region_count = 0;
+}
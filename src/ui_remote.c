@@ -0,0 +1,1051 @@
+/*
+ * Tridme UI Remote
+ *
+ * Shared-memory transport between a tool process recording UI frames and
+ * the engine process rendering them. The tool side is a render backend
+ * writing messages into a ring, the engine side reads them in place.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#define _GNU_SOURCE  // syscall, kill
+
+#include <ui_remote.h>
+#include <ui_profile.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <limits.h>
+#endif
+
+#define REMOTE_MAGIC 0x54554952u  // "RIUT"
+#define REMOTE_ALIGN 16           // Messages start on this boundary
+#define REMOTE_MIN_RING (1 << 20)
+#define REMOTE_MAX_TEXTURE_SIZE 16384
+
+enum {
+  MSG_PAD = 1,          // Filler up to the end of the ring, messages never wrap
+  MSG_HELLO,            // A tool connected, what came before belongs to an earlier one
+  MSG_BYE,              // The tool disconnected
+  MSG_TEXTURE_CREATE,
+  MSG_TEXTURE_UPDATE,
+  MSG_TEXTURE_DESTROY,
+  MSG_FRAME
+};
+
+#define FRAME_REUSE_VERTICES 0x1  // Draw with the vertices of the previous frame message
+#define FRAME_REUSE_INDICES  0x2
+
+typedef struct remote_msg {
+  uint32_t type;
+  uint32_t size;        // Whole message with this header, a multiple of REMOTE_ALIGN
+  uint32_t reserved[2];
+} remote_msg;
+
+// MSG_TEXTURE_*, MSG_TEXTURE_UPDATE is followed by tightly packed rows
+typedef struct remote_texture_msg {
+  uint32_t id;
+  uint32_t format;
+  uint32_t x, y, width, height;
+  uint32_t reserved[2];
+} remote_texture_msg;
+
+// MSG_FRAME, followed by the commands, then the vertices (padded to
+// REMOTE_ALIGN) and the indices unless reused
+typedef struct remote_frame_msg {
+  uint64_t frame;
+  float display_width, display_height;
+  uint32_t command_count, vertex_count, index_count;
+  uint32_t flags;
+} remote_frame_msg;
+
+// UIDrawCmd with the tool's texture ids
+typedef struct remote_cmd {
+  float clip[4];
+  uint32_t textures[UI_DRAW_MAX_TEXTURES];
+  uint32_t texture_count, index_offset, index_count;
+  uint32_t reserved;
+} remote_cmd;
+
+// Start of the segment, then the input events, then the draw ring. The
+// atomics are lock-free, which makes them usable across processes
+typedef struct remote_header {
+  _Atomic uint32_t magic;       // Stored last, once the rest is set up
+  uint32_t version;
+  uint64_t ring_size;
+  uint32_t input_capacity;      // Power of two
+  _Atomic int32_t server_pid;
+  _Atomic int32_t client_pid;
+  _Atomic uint32_t reset_generation; // Bumped when the engine drops the tool's state
+
+  // Draw ring, tool to engine. Positions count bytes since creation
+  _Alignas(64) _Atomic uint64_t head;   // Published by the tool
+  _Atomic uint32_t head_seq;            // Futex word, bumped with head
+  _Atomic uint32_t head_waiters;
+  _Alignas(64) _Atomic uint64_t tail;   // Released by the engine
+  _Atomic uint32_t tail_seq;
+  _Atomic uint32_t tail_waiters;
+
+  // Input ring, engine to tool. input_head doubles as the futex word
+  _Alignas(64) _Atomic uint32_t input_head;
+  _Atomic uint32_t input_waiters;
+  _Alignas(64) _Atomic uint32_t input_tail;
+} remote_header;
+
+static size_t align_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t input_offset(void) {
+  return align_up(sizeof(remote_header), 64);
+}
+
+static size_t ring_offset(uint32_t input_capacity) {
+  return align_up(input_offset() + sizeof(UIInputEvent) * input_capacity, 64);
+}
+
+static bool process_alive(int32_t pid) {
+  return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+/*
+ * Signalling: a waiter registers, rechecks and sleeps on a 32-bit word; the
+ * other side bumps the word and only makes a system call if someone waits
+ */
+
+static void wake_word(_Atomic uint32_t* word, _Atomic uint32_t* waiters) {
+  if (atomic_load(waiters) == 0) return;
+#ifdef __linux__
+  syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+  (void)word;
+#endif
+}
+
+// Sleep while *word == seen, at most timeout_ms
+static void wait_word(_Atomic uint32_t* word, _Atomic uint32_t* waiters, uint32_t seen,
+  int timeout_ms) {
+  atomic_fetch_add(waiters, 1);
+  if (atomic_load(word) == seen) {
+#ifdef __linux__
+    struct timespec timeout = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L};
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, seen, &timeout, NULL, 0);
+#else
+    // No cross-process futex: poll in short sleeps
+    for (int slept = 0; slept < timeout_ms && atomic_load(word) == seen; slept++) {
+      struct timespec ms = {0, 1000000L};
+      nanosleep(&ms, NULL);
+    }
+#endif
+  }
+  atomic_fetch_sub(waiters, 1);
+}
+
+/*
+ * Engine side
+ */
+
+typedef struct remote_texture {
+  ui_texture_id texture;        // Backend texture, 0: the id is free
+  int width, height;
+  UITextureFormat format;
+} remote_texture;
+
+struct UIRemoteServer {
+  UIAllocator allocator;
+  UIRenderBackend* backend;
+  char name[256];
+
+  remote_header* shm;
+  size_t map_size;
+  unsigned char* ring;
+  UIInputEvent* input;
+  uint64_t read;                // Next message to apply
+
+  remote_texture* textures;     // UI_REMOTE_MAX_TEXTURES, indexed by the tool's ids
+  bool textures_changed;        // The frame has to be mapped again
+
+  // Latest frame. Its commands, vertices and indices are read in place, the
+  // messages holding them are only released once newer ones replace them
+  bool has_frame, has_vertices, has_indices;
+  uint64_t frame_pos, vertex_pos, index_pos;
+  remote_frame_msg frame;
+  const remote_cmd* frame_commands;
+  const ui_vertex* vertices;
+  uint32_t vertex_count;
+  const uint32_t* indices;
+  uint32_t index_count;
+  bool geometry_checked;        // Indices and slots validated against the current arrays
+
+  // What gets rendered: the latest frame mapped to backend textures
+  UIDrawCmd* commands;
+  int command_count, command_capacity;
+  bool frame_ready;
+};
+
+static void server_reset(UIRemoteServer* server) {
+  for (int i = 0; i < UI_REMOTE_MAX_TEXTURES; i++) {
+    if (server->textures[i].texture) {
+      server->backend->destroy_texture(server->backend->user, server->textures[i].texture);
+    }
+  }
+  memset(server->textures, 0, sizeof(remote_texture) * UI_REMOTE_MAX_TEXTURES);
+  server->has_frame = server->has_vertices = server->has_indices = false;
+  server->frame_ready = false;
+  server->textures_changed = false;
+}
+
+UIRemoteServer* ui_remote_server_create(const char* name, UIRenderBackend* backend,
+  const UIRemoteDesc* desc) {
+  UIRemoteDesc defaults = {0};
+  if (!desc) desc = &defaults;
+  const UIAllocator* allocator = desc->allocator ? desc->allocator : ui_default_allocator();
+
+  if (strlen(name) >= sizeof(((UIRemoteServer*)0)->name)) {
+    fprintf(stderr, "Shared memory name too long: %s\n", name);
+    return NULL;
+  }
+
+  uint32_t input_capacity = 64;
+  while (input_capacity < (desc->input_events ? desc->input_events : 1024)) input_capacity <<= 1;
+  size_t ring_size = align_up(desc->ring_size ? desc->ring_size : UI_REMOTE_DEFAULT_RING, 4096);
+  if (ring_size < REMOTE_MIN_RING) ring_size = REMOTE_MIN_RING;
+  size_t map_size = ring_offset(input_capacity) + ring_size;
+
+  // A segment of the same name outlived a crashed engine, take it over
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    shm_unlink(name);
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  }
+  if (fd < 0) {
+    fprintf(stderr, "Failed to create shared memory %s: %s\n", name, strerror(errno));
+    return NULL;
+  }
+
+  void* map = MAP_FAILED;
+  if (ftruncate(fd, (off_t)map_size) == 0) {
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Failed to map shared memory %s: %s\n", name, strerror(errno));
+    shm_unlink(name);
+    return NULL;
+  }
+
+  UIRemoteServer* server = (UIRemoteServer*)ui_mem_alloc(allocator, sizeof(UIRemoteServer));
+  remote_texture* textures = (remote_texture*)ui_mem_alloc(allocator,
+    sizeof(remote_texture) * UI_REMOTE_MAX_TEXTURES);
+  if (!server || !textures) {
+    ui_mem_free(allocator, server);
+    ui_mem_free(allocator, textures);
+    munmap(map, map_size);
+    shm_unlink(name);
+    return NULL;
+  }
+  memset(server, 0, sizeof(UIRemoteServer));
+  memset(textures, 0, sizeof(remote_texture) * UI_REMOTE_MAX_TEXTURES);
+
+  server->allocator = *allocator;
+  server->backend = backend;
+  strcpy(server->name, name);
+  server->shm = (remote_header*)map;
+  server->map_size = map_size;
+  server->input = (UIInputEvent*)((unsigned char*)map + input_offset());
+  server->ring = (unsigned char*)map + ring_offset(input_capacity);
+  server->textures = textures;
+
+  // A fresh segment is zero-filled, only the layout has to be written
+  remote_header* shm = server->shm;
+  shm->version = UI_REMOTE_VERSION;
+  shm->ring_size = ring_size;
+  shm->input_capacity = input_capacity;
+  atomic_store(&shm->server_pid, (int32_t)getpid());
+  atomic_store_explicit(&shm->magic, REMOTE_MAGIC, memory_order_release);
+  return server;
+}
+
+void ui_remote_server_destroy(UIRemoteServer* server) {
+  if (!server) return;
+
+  server_reset(server);
+  atomic_store(&server->shm->server_pid, 0);
+  wake_word(&server->shm->tail_seq, &server->shm->tail_waiters);
+  munmap(server->shm, server->map_size);
+  shm_unlink(server->name);
+
+  UIAllocator allocator = server->allocator;
+  ui_mem_free(&allocator, server->commands);
+  ui_mem_free(&allocator, server->textures);
+  ui_mem_free(&allocator, server);
+}
+
+static remote_texture* server_texture(UIRemoteServer* server, uint32_t id) {
+  if (id == 0 || id >= UI_REMOTE_MAX_TEXTURES || !server->textures[id].texture) return NULL;
+  return &server->textures[id];
+}
+
+// Texture messages, returns false if the message is malformed
+static bool apply_texture(UIRemoteServer* server, uint32_t type, const unsigned char* payload,
+  size_t size) {
+  if (size < sizeof(remote_texture_msg)) return false;
+  remote_texture_msg msg;
+  memcpy(&msg, payload, sizeof(msg));
+  UIRenderBackend* backend = server->backend;
+
+  if (type == MSG_TEXTURE_CREATE) {
+    if (msg.id == 0 || msg.id >= UI_REMOTE_MAX_TEXTURES || msg.format > UI_TEXTURE_RGBA8 ||
+        msg.width == 0 || msg.height == 0 ||
+        msg.width > REMOTE_MAX_TEXTURE_SIZE || msg.height > REMOTE_MAX_TEXTURE_SIZE) {
+      return false;
+    }
+    remote_texture* texture = &server->textures[msg.id];
+    if (texture->texture) backend->destroy_texture(backend->user, texture->texture);
+    texture->texture = backend->create_texture(backend->user, (int)msg.width, (int)msg.height,
+      (UITextureFormat)msg.format, NULL);
+    texture->width = (int)msg.width;
+    texture->height = (int)msg.height;
+    texture->format = (UITextureFormat)msg.format;
+    server->textures_changed = true;
+    return true;
+  }
+
+  // Edits in flight when the engine dropped the tool's textures are skipped,
+  // the tool sends the textures again once it sees the reset
+  if (msg.id == 0 || msg.id >= UI_REMOTE_MAX_TEXTURES) return false;
+  remote_texture* texture = server_texture(server, msg.id);
+  if (!texture) return true;
+
+  if (type == MSG_TEXTURE_DESTROY) {
+    backend->destroy_texture(backend->user, texture->texture);
+    memset(texture, 0, sizeof(remote_texture));
+    server->textures_changed = true;
+    return true;
+  }
+
+  // Update, the rect must lie inside the texture and its rows inside the message
+  size_t bpp = texture->format == UI_TEXTURE_A8 ? 1 : 4;
+  if ((uint64_t)msg.x + msg.width > (uint64_t)texture->width ||
+      (uint64_t)msg.y + msg.height > (uint64_t)texture->height ||
+      (uint64_t)msg.width * msg.height * bpp > size - sizeof(remote_texture_msg)) {
+    return false;
+  }
+  if (backend->update_texture && msg.width > 0 && msg.height > 0) {
+    backend->update_texture(backend->user, texture->texture, texture->format, (int)msg.x,
+      (int)msg.y, (int)msg.width, (int)msg.height, payload + sizeof(remote_texture_msg),
+      (int)(msg.width * bpp));
+  }
+  return true;
+}
+
+// Take a frame message as the latest frame, returns false if it is malformed.
+// *taken tells whether it became the latest frame
+static bool accept_frame(UIRemoteServer* server, uint64_t pos, const unsigned char* payload,
+  size_t size, bool* taken) {
+  *taken = false;
+  if (size < sizeof(remote_frame_msg)) return false;
+  remote_frame_msg frame;
+  memcpy(&frame, payload, sizeof(frame));
+
+  bool new_vertices = !(frame.flags & FRAME_REUSE_VERTICES);
+  bool new_indices = !(frame.flags & FRAME_REUSE_INDICES);
+  uint64_t vertex_bytes = new_vertices ?
+    align_up((uint64_t)frame.vertex_count * sizeof(ui_vertex), REMOTE_ALIGN) : 0;
+  uint64_t index_bytes = new_indices ? (uint64_t)frame.index_count * sizeof(uint32_t) : 0;
+  uint64_t command_bytes = (uint64_t)frame.command_count * sizeof(remote_cmd);
+  if (sizeof(remote_frame_msg) + command_bytes + vertex_bytes + index_bytes > size) return false;
+
+  // Reused arrays must exist and still have the size the tool thinks. After
+  // a reset they do not until the tool notices it, the frame is skipped
+  if ((!new_vertices && (!server->has_vertices || server->vertex_count != frame.vertex_count)) ||
+      (!new_indices && (!server->has_indices || server->index_count != frame.index_count))) {
+    return true;
+  }
+
+  const unsigned char* data = payload + sizeof(remote_frame_msg);
+  server->frame = frame;
+  server->frame_pos = pos;
+  server->frame_commands = (const remote_cmd*)data;
+  server->has_frame = true;
+  data += command_bytes;
+
+  if (new_vertices) {
+    server->vertices = (const ui_vertex*)data;
+    server->vertex_count = frame.vertex_count;
+    server->vertex_pos = pos;
+    server->has_vertices = true;
+    server->geometry_checked = false;
+    data += vertex_bytes;
+  }
+  if (new_indices) {
+    server->indices = (const uint32_t*)data;
+    server->index_count = frame.index_count;
+    server->index_pos = pos;
+    server->has_indices = true;
+    server->geometry_checked = false;
+  }
+  *taken = true;
+  return true;
+}
+
+// Map the latest frame to backend textures, checking everything a backend
+// would trust: index ranges, vertex slots and texture ids
+static void build_frame(UIRemoteServer* server) {
+  server->frame_ready = false;
+  if (!server->has_frame) return;
+
+  if (!server->geometry_checked) {
+    for (uint32_t i = 0; i < server->index_count; i++) {
+      if (server->indices[i] >= server->vertex_count) {
+        fprintf(stderr, "Remote frame %llu indexes past its vertices, dropped\n",
+          (unsigned long long)server->frame.frame);
+        return;
+      }
+    }
+    for (uint32_t i = 0; i < server->vertex_count; i++) {
+      if (UI_VERTEX_TEXTURE(server->vertices[i].slot) >= UI_DRAW_MAX_TEXTURES) {
+        fprintf(stderr, "Remote frame %llu has a bad texture slot, dropped\n",
+          (unsigned long long)server->frame.frame);
+        return;
+      }
+    }
+    server->geometry_checked = true;
+  }
+
+  int count = (int)server->frame.command_count;
+  if (count > server->command_capacity) {
+    UIDrawCmd* commands = (UIDrawCmd*)ui_mem_alloc(&server->allocator, sizeof(UIDrawCmd) * count);
+    if (!commands) return;
+    ui_mem_free(&server->allocator, server->commands);
+    server->commands = commands;
+    server->command_capacity = count;
+  }
+
+  server->command_count = 0;
+  for (int i = 0; i < count; i++) {
+    remote_cmd cmd;
+    memcpy(&cmd, &server->frame_commands[i], sizeof(cmd));
+    if ((uint64_t)cmd.index_offset + cmd.index_count > server->index_count) {
+      fprintf(stderr, "Remote frame %llu draws past its indices, dropped\n",
+        (unsigned long long)server->frame.frame);
+      return;
+    }
+    if (cmd.texture_count == 0 || cmd.texture_count > UI_DRAW_MAX_TEXTURES) continue;
+
+    // A command sampling a texture that is gone is skipped; unused slots
+    // repeat the first texture so no slot ever reaches an invalid one
+    UIDrawCmd* out = &server->commands[server->command_count];
+    bool resolved = true;
+    for (uint32_t t = 0; t < UI_DRAW_MAX_TEXTURES; t++) {
+      remote_texture* texture = server_texture(server, cmd.textures[t < cmd.texture_count ? t : 0]);
+      if (!texture) {
+        resolved = false;
+        break;
+      }
+      out->textures[t] = texture->texture;
+    }
+    if (!resolved) continue;
+
+    out->clip = (rect){{cmd.clip[0], cmd.clip[1]}, {cmd.clip[2], cmd.clip[3]}};
+    out->texture_count = (int)cmd.texture_count;
+    out->index_offset = cmd.index_offset;
+    out->index_count = cmd.index_count;
+    server->command_count++;
+  }
+  server->frame_ready = true;
+}
+
+bool ui_remote_server_update(UIRemoteServer* server) {
+  remote_header* shm = server->shm;
+  uint64_t ring_size = shm->ring_size;
+  uint64_t head = atomic_load_explicit(&shm->head, memory_order_acquire);
+  bool new_frame = false;
+
+  while (server->read < head) {
+    uint64_t pos = server->read;
+    uint64_t offset = pos % ring_size;
+
+    // Headers are copied before use, nothing in the ring is read twice
+    remote_msg msg;
+    memcpy(&msg, server->ring + offset, sizeof(msg));
+    bool ok = msg.size >= sizeof(remote_msg) && msg.size % REMOTE_ALIGN == 0 &&
+      msg.size <= head - pos && offset + msg.size <= ring_size;
+
+    const unsigned char* payload = server->ring + offset + sizeof(remote_msg);
+    size_t payload_size = ok ? msg.size - sizeof(remote_msg) : 0;
+    if (ok) {
+      switch (msg.type) {
+        case MSG_PAD:
+          break;
+        case MSG_HELLO:
+        case MSG_BYE:
+          server_reset(server);
+          break;
+        case MSG_TEXTURE_CREATE:
+        case MSG_TEXTURE_UPDATE:
+        case MSG_TEXTURE_DESTROY:
+          ok = apply_texture(server, msg.type, payload, payload_size);
+          break;
+        case MSG_FRAME: {
+          bool taken;
+          ok = accept_frame(server, pos, payload, payload_size, &taken);
+          new_frame = new_frame || (ok && taken);
+          break;
+        }
+        default:
+          ok = false;
+          break;
+      }
+    }
+
+    if (!ok) {
+      // The stream cannot be trusted past this point, drop the tool's state
+      fprintf(stderr, "Malformed remote UI message at %llu, resetting\n", (unsigned long long)pos);
+      server->read = head;
+      ui_remote_server_reset(server);
+      break;
+    }
+    server->read = pos + msg.size;
+  }
+
+  if (new_frame || server->textures_changed) {
+    build_frame(server);
+    server->textures_changed = false;
+  }
+
+  // Everything read is released, but for the messages the latest frame still draws from
+  uint64_t release = server->read;
+  if (server->has_frame && server->frame_pos < release) release = server->frame_pos;
+  if (server->has_vertices && server->vertex_pos < release) release = server->vertex_pos;
+  if (server->has_indices && server->index_pos < release) release = server->index_pos;
+  if (release != atomic_load_explicit(&shm->tail, memory_order_relaxed)) {
+    atomic_store_explicit(&shm->tail, release, memory_order_release);
+    atomic_fetch_add(&shm->tail_seq, 1);
+    wake_word(&shm->tail_seq, &shm->tail_waiters);
+  }
+  return new_frame;
+}
+
+void ui_remote_server_reset(UIRemoteServer* server) {
+  server_reset(server);
+  atomic_fetch_add_explicit(&server->shm->reset_generation, 1, memory_order_release);
+}
+
+void ui_remote_server_render(UIRemoteServer* server) {
+  if (!server->frame_ready) return;
+
+  UIDrawData data = {
+    .display_size = {server->frame.display_width, server->frame.display_height},
+    .vertices = server->vertices,
+    .vertex_count = server->vertex_count,
+    .indices = server->indices,
+    .index_count = server->index_count,
+    .commands = server->commands,
+    .command_count = server->command_count,
+    .frame = server->frame.frame
+  };
+  server->backend->render(server->backend->user, &data);
+}
+
+bool ui_remote_server_push_event(UIRemoteServer* server, const UIInputEvent* event) {
+  remote_header* shm = server->shm;
+  uint32_t head = atomic_load_explicit(&shm->input_head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&shm->input_tail, memory_order_acquire);
+  if (head - tail >= shm->input_capacity) return false;
+
+  UIInputEvent* slot = &server->input[head & (shm->input_capacity - 1)];
+  *slot = *event;
+  if (slot->time_ns == 0) slot->time_ns = ui_profile_now_ns();
+
+  atomic_store(&shm->input_head, head + 1);
+  wake_word(&shm->input_head, &shm->input_waiters);
+  return true;
+}
+
+bool ui_remote_server_connected(UIRemoteServer* server) {
+  return process_alive(atomic_load(&server->shm->client_pid));
+}
+
+bool ui_remote_server_wait(UIRemoteServer* server, int timeout_ms) {
+  remote_header* shm = server->shm;
+  uint32_t seen = atomic_load(&shm->head_seq);
+  if (atomic_load_explicit(&shm->head, memory_order_acquire) != server->read) return true;
+
+  wait_word(&shm->head_seq, &shm->head_waiters, seen, timeout_ms);
+  return atomic_load_explicit(&shm->head, memory_order_acquire) != server->read;
+}
+
+/*
+ * Tool side
+ */
+
+// The tool's copy of a texture, to send again after an engine reset
+typedef struct remote_shadow {
+  unsigned char* pixels;        // NULL: the id is not in use
+  int width, height;
+  UITextureFormat format;
+} remote_shadow;
+
+typedef struct ui_remote_backend {
+  UIRenderBackend base;
+  UIAllocator allocator;
+
+  remote_header* shm;
+  size_t map_size;
+  unsigned char* ring;
+  UIInputEvent* input;
+  uint64_t head;                // Where the next message goes
+  uint64_t pending;             // Size of the reserved message, published by ring_publish
+
+  uint32_t next_id;             // Texture ids, freed ones are reused first
+  uint32_t* free_ids;
+  uint32_t free_count;
+  remote_shadow* shadows;       // UI_REMOTE_MAX_TEXTURES, indexed by id
+  uint32_t reset_generation;    // Last engine reset the textures were sent again for
+
+  // The last frame sent, read back from the ring for deltas. The engine
+  // keeps it until a newer frame arrives, so it stays intact. Reused arrays
+  // hold the ring's tail at the message they came in (*_pos)
+  bool has_last;
+  float last_size[2];
+  const remote_cmd* last_commands;
+  uint32_t last_command_count;
+  const ui_vertex* last_vertices;
+  uint32_t last_vertex_count;
+  uint64_t last_vertex_pos;
+  const uint32_t* last_indices;
+  uint32_t last_index_count;
+  uint64_t last_index_pos;
+
+  bool warned_size;
+  UIBackendCounters counters;
+} ui_remote_backend;
+
+// Reserve a message of size payload bytes, waiting for room if asked to.
+// Returns its payload, or NULL if there is no room or the engine is gone
+static unsigned char* ring_reserve(ui_remote_backend* remote, uint32_t type, size_t payload,
+  bool wait) {
+  remote_header* shm = remote->shm;
+  uint64_t ring_size = shm->ring_size;
+  uint64_t size = align_up(sizeof(remote_msg) + payload, REMOTE_ALIGN);
+  if (size > ring_size / 2) {
+    if (!remote->warned_size) {
+      fprintf(stderr, "Remote UI message of %llu bytes does not fit the ring, raise ring_size\n",
+        (unsigned long long)size);
+      remote->warned_size = true;
+    }
+    return NULL;
+  }
+
+  for (;;) {
+    uint32_t seen = atomic_load(&shm->tail_seq);
+    uint64_t offset = remote->head % ring_size;
+    uint64_t pad = offset + size > ring_size ? ring_size - offset : 0;
+    uint64_t tail = atomic_load_explicit(&shm->tail, memory_order_acquire);
+
+    if (ring_size - (remote->head - tail) >= pad + size) {
+      // Messages never wrap, the space left at the end is skipped
+      if (pad) {
+        remote_msg filler = {MSG_PAD, (uint32_t)pad, {0, 0}};
+        memcpy(remote->ring + offset, &filler, sizeof(filler));
+        remote->head += pad;
+        offset = 0;
+      }
+      remote_msg header = {type, (uint32_t)size, {0, 0}};
+      memcpy(remote->ring + offset, &header, sizeof(header));
+      remote->pending = size;
+      remote->counters.bytes_uploaded += size;
+      return remote->ring + offset + sizeof(remote_msg);
+    }
+
+    if (!wait || !process_alive(atomic_load(&shm->server_pid))) return NULL;
+    wait_word(&shm->tail_seq, &shm->tail_waiters, seen, 50);
+  }
+}
+
+static void ring_publish(ui_remote_backend* remote) {
+  remote_header* shm = remote->shm;
+  remote->head += remote->pending;
+  remote->pending = 0;
+  atomic_store_explicit(&shm->head, remote->head, memory_order_release);
+  atomic_fetch_add(&shm->head_seq, 1);
+  wake_word(&shm->head_seq, &shm->head_waiters);
+}
+
+static size_t texel_bytes(UITextureFormat format) {
+  return format == UI_TEXTURE_A8 ? 1 : 4;
+}
+
+static bool send_texture_create(ui_remote_backend* remote, uint32_t id, const remote_shadow* shadow) {
+  unsigned char* payload = ring_reserve(remote, MSG_TEXTURE_CREATE, sizeof(remote_texture_msg), true);
+  if (!payload) return false;
+  remote_texture_msg msg = {id, (uint32_t)shadow->format, 0, 0, (uint32_t)shadow->width,
+    (uint32_t)shadow->height, {0, 0}};
+  memcpy(payload, &msg, sizeof(msg));
+  ring_publish(remote);
+  return true;
+}
+
+static void send_texture_rows(ui_remote_backend* remote, uint32_t id, UITextureFormat format,
+  int x, int y, int width, int height, const unsigned char* pixels, size_t stride) {
+  size_t row_bytes = (size_t)width * texel_bytes(format);
+  if (row_bytes == 0) return;
+
+  // Large edits go in bands so each message stays well within the ring
+  int band = (int)(remote->shm->ring_size / 4 / row_bytes);
+  if (band < 1) band = 1;
+
+  for (int row = 0; row < height; row += band) {
+    int rows = height - row < band ? height - row : band;
+    unsigned char* payload = ring_reserve(remote, MSG_TEXTURE_UPDATE,
+      sizeof(remote_texture_msg) + row_bytes * rows, true);
+    if (!payload) return;
+
+    remote_texture_msg msg = {id, (uint32_t)format, (uint32_t)x, (uint32_t)(y + row),
+      (uint32_t)width, (uint32_t)rows, {0, 0}};
+    memcpy(payload, &msg, sizeof(msg));
+    for (int r = 0; r < rows; r++) {
+      memcpy(payload + sizeof(msg) + row_bytes * r, pixels + (size_t)(row + r) * stride, row_bytes);
+    }
+    ring_publish(remote);
+  }
+}
+
+// Once the engine has dropped the tool's state, send every texture again and
+// have the next frame carry all its arrays. Returns true if it did
+static bool resync(ui_remote_backend* remote) {
+  uint32_t generation = atomic_load_explicit(&remote->shm->reset_generation, memory_order_acquire);
+  if (generation == remote->reset_generation) return false;
+  remote->reset_generation = generation;
+  remote->has_last = false;
+
+  for (uint32_t id = 1; id < remote->next_id; id++) {
+    const remote_shadow* shadow = &remote->shadows[id];
+    if (!shadow->pixels || !send_texture_create(remote, id, shadow)) continue;
+    send_texture_rows(remote, id, shadow->format, 0, 0, shadow->width, shadow->height,
+      shadow->pixels, (size_t)shadow->width * texel_bytes(shadow->format));
+  }
+  return true;
+}
+
+static void remote_update_texture(void* user, ui_texture_id texture, UITextureFormat format,
+  int x, int y, int width, int height, const void* pixels, int stride) {
+  ui_remote_backend* remote = (ui_remote_backend*)user;
+  if (texture == 0 || texture >= UI_REMOTE_MAX_TEXTURES || width <= 0 || height <= 0) return;
+  remote_shadow* shadow = &remote->shadows[texture];
+  if (!shadow->pixels || format != shadow->format || x < 0 || y < 0 ||
+      x + width > shadow->width || y + height > shadow->height) {
+    fprintf(stderr, "Remote texture update outside of texture %u\n", (unsigned)texture);
+    return;
+  }
+
+  size_t bpp = texel_bytes(format);
+  size_t shadow_stride = (size_t)shadow->width * bpp;
+  for (int row = 0; row < height; row++) {
+    memcpy(shadow->pixels + (size_t)(y + row) * shadow_stride + (size_t)x * bpp,
+      (const unsigned char*)pixels + (size_t)row * stride, (size_t)width * bpp);
+  }
+
+  // A resync sends the whole texture, this edit included
+  if (!resync(remote)) {
+    send_texture_rows(remote, (uint32_t)texture, format, x, y, width, height, pixels, (size_t)stride);
+  }
+}
+
+static ui_texture_id remote_create_texture(void* user, int width, int height,
+  UITextureFormat format, const void* pixels) {
+  ui_remote_backend* remote = (ui_remote_backend*)user;
+  if (width <= 0 || height <= 0 || width > REMOTE_MAX_TEXTURE_SIZE || height > REMOTE_MAX_TEXTURE_SIZE) {
+    fprintf(stderr, "Remote texture of %dx%d is too large (max %d)\n", width, height,
+      REMOTE_MAX_TEXTURE_SIZE);
+    return 0;
+  }
+  resync(remote);
+
+  uint32_t id;
+  if (remote->free_count > 0) {
+    id = remote->free_ids[--remote->free_count];
+  } else if (remote->next_id < UI_REMOTE_MAX_TEXTURES) {
+    id = remote->next_id++;
+  } else {
+    fprintf(stderr, "Too many remote textures (max %d)\n", UI_REMOTE_MAX_TEXTURES - 1);
+    return 0;
+  }
+
+  size_t size = (size_t)width * height * texel_bytes(format);
+  remote_shadow* shadow = &remote->shadows[id];
+  shadow->pixels = (unsigned char*)ui_mem_alloc(&remote->allocator, size);
+  if (!shadow->pixels) {
+    fprintf(stderr, "Failed to allocate a remote texture of %dx%d\n", width, height);
+    remote->free_ids[remote->free_count++] = id;
+    return 0;
+  }
+  if (pixels) memcpy(shadow->pixels, pixels, size); else memset(shadow->pixels, 0, size);
+  shadow->width = width;
+  shadow->height = height;
+  shadow->format = format;
+
+  if (!send_texture_create(remote, id, shadow)) {
+    ui_mem_free(&remote->allocator, shadow->pixels);
+    memset(shadow, 0, sizeof(remote_shadow));
+    remote->free_ids[remote->free_count++] = id;
+    return 0;
+  }
+  if (pixels) {
+    send_texture_rows(remote, id, format, 0, 0, width, height, shadow->pixels,
+      (size_t)width * texel_bytes(format));
+  }
+  return id;
+}
+
+static void remote_destroy_texture(void* user, ui_texture_id texture) {
+  ui_remote_backend* remote = (ui_remote_backend*)user;
+  if (texture == 0 || texture >= UI_REMOTE_MAX_TEXTURES || !remote->shadows[texture].pixels) return;
+
+  unsigned char* payload = ring_reserve(remote, MSG_TEXTURE_DESTROY, sizeof(remote_texture_msg), true);
+  if (payload) {
+    remote_texture_msg msg = {(uint32_t)texture, 0, 0, 0, 0, 0, {0, 0}};
+    memcpy(payload, &msg, sizeof(msg));
+    ring_publish(remote);
+  }
+  ui_mem_free(&remote->allocator, remote->shadows[texture].pixels);
+  memset(&remote->shadows[texture], 0, sizeof(remote_shadow));
+  remote->free_ids[remote->free_count++] = (uint32_t)texture;
+}
+
+static void to_remote_cmd(remote_cmd* out, const UIDrawCmd* cmd) {
+  memset(out, 0, sizeof(remote_cmd));
+  out->clip[0] = cmd->clip.pos.x;
+  out->clip[1] = cmd->clip.pos.y;
+  out->clip[2] = cmd->clip.size.x;
+  out->clip[3] = cmd->clip.size.y;
+  for (int t = 0; t < cmd->texture_count; t++) out->textures[t] = (uint32_t)cmd->textures[t];
+  out->texture_count = (uint32_t)cmd->texture_count;
+  out->index_offset = cmd->index_offset;
+  out->index_count = cmd->index_count;
+}
+
+static void remote_render(void* user, const UIDrawData* data) {
+  ui_remote_backend* remote = (ui_remote_backend*)user;
+  uint32_t command_count = (uint32_t)data->command_count;
+  size_t vertex_bytes = sizeof(ui_vertex) * data->vertex_count;
+  size_t index_bytes = sizeof(uint32_t) * data->index_count;
+  resync(remote);
+
+  // Delta against the frame the engine holds, compared where it lies in the ring.
+  // An array reused for long would keep the tail from moving until the ring
+  // fills up, once it is a quarter of the ring behind it is sent again
+  uint64_t max_age = remote->shm->ring_size / 4;
+  bool same_vertices = remote->has_last && data->vertex_count == remote->last_vertex_count &&
+    remote->head - remote->last_vertex_pos <= max_age &&
+    (vertex_bytes == 0 || memcmp(data->vertices, remote->last_vertices, vertex_bytes) == 0);
+  bool same_indices = remote->has_last && data->index_count == remote->last_index_count &&
+    remote->head - remote->last_index_pos <= max_age &&
+    (index_bytes == 0 || memcmp(data->indices, remote->last_indices, index_bytes) == 0);
+  bool same_commands = remote->has_last && command_count == remote->last_command_count &&
+    data->display_size.x == remote->last_size[0] && data->display_size.y == remote->last_size[1];
+  for (uint32_t i = 0; same_commands && i < command_count; i++) {
+    remote_cmd cmd;
+    to_remote_cmd(&cmd, &data->commands[i]);
+    same_commands = memcmp(&cmd, &remote->last_commands[i], sizeof(cmd)) == 0;
+  }
+  if (same_vertices && same_indices && same_commands) return;
+
+  size_t command_bytes = sizeof(remote_cmd) * command_count;
+  size_t payload = sizeof(remote_frame_msg) + command_bytes +
+    (same_vertices ? 0 : align_up(vertex_bytes, REMOTE_ALIGN)) + (same_indices ? 0 : index_bytes);
+
+  // The engine is behind: drop the frame rather than wait, a newer one follows
+  unsigned char* out = ring_reserve(remote, MSG_FRAME, payload, false);
+  if (!out) return;
+  uint64_t pos = remote->head;  // Past any padding ring_reserve put in front
+
+  remote_frame_msg frame = {
+    .frame = data->frame,
+    .display_width = data->display_size.x,
+    .display_height = data->display_size.y,
+    .command_count = command_count,
+    .vertex_count = data->vertex_count,
+    .index_count = data->index_count,
+    .flags = (same_vertices ? FRAME_REUSE_VERTICES : 0) | (same_indices ? FRAME_REUSE_INDICES : 0)
+  };
+  memcpy(out, &frame, sizeof(frame));
+  out += sizeof(frame);
+
+  remote->last_commands = (const remote_cmd*)out;
+  for (uint32_t i = 0; i < command_count; i++) {
+    remote_cmd cmd;
+    to_remote_cmd(&cmd, &data->commands[i]);
+    memcpy(out, &cmd, sizeof(cmd));
+    out += sizeof(cmd);
+  }
+  if (!same_vertices) {
+    memcpy(out, data->vertices, vertex_bytes);
+    remote->last_vertices = (const ui_vertex*)out;
+    remote->last_vertex_pos = pos;
+    out += align_up(vertex_bytes, REMOTE_ALIGN);
+  }
+  if (!same_indices) {
+    memcpy(out, data->indices, index_bytes);
+    remote->last_indices = (const uint32_t*)out;
+    remote->last_index_pos = pos;
+  }
+  ring_publish(remote);
+
+  remote->has_last = true;
+  remote->last_size[0] = data->display_size.x;
+  remote->last_size[1] = data->display_size.y;
+  remote->last_command_count = command_count;
+  remote->last_vertex_count = data->vertex_count;
+  remote->last_index_count = data->index_count;
+  remote->counters.draw_calls += command_count;
+}
+
+static void remote_get_counters(void* user, UIBackendCounters* out) {
+  *out = ((ui_remote_backend*)user)->counters;
+}
+
+static void remote_destroy(UIRenderBackend* backend) {
+  ui_remote_backend* remote = (ui_remote_backend*)backend;
+
+  if (remote->shm) {
+    // Best effort, a missing goodbye only delays the cleanup to the next tool
+    if (ring_reserve(remote, MSG_BYE, 0, false)) ring_publish(remote);
+    atomic_store(&remote->shm->client_pid, 0);
+    munmap(remote->shm, remote->map_size);
+  }
+
+  UIAllocator allocator = remote->allocator;
+  if (remote->shadows) {
+    for (uint32_t id = 1; id < remote->next_id; id++) {
+      ui_mem_free(&allocator, remote->shadows[id].pixels);
+    }
+  }
+  ui_mem_free(&allocator, remote->shadows);
+  ui_mem_free(&allocator, remote->free_ids);
+  ui_mem_free(&allocator, remote);
+}
+
+UIRenderBackend* ui_backend_remote_create(const char* name, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open shared memory %s: %s\n", name, strerror(errno));
+    return NULL;
+  }
+  struct stat st;
+  void* map = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(remote_header)) {
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Failed to map shared memory %s\n", name);
+    return NULL;
+  }
+
+  remote_header* shm = (remote_header*)map;
+  size_t map_size = (size_t)st.st_size;
+  bool valid = atomic_load_explicit(&shm->magic, memory_order_acquire) == REMOTE_MAGIC &&
+    shm->version == UI_REMOTE_VERSION && shm->input_capacity > 0 &&
+    (shm->input_capacity & (shm->input_capacity - 1)) == 0 &&
+    ring_offset(shm->input_capacity) + shm->ring_size == map_size;
+  if (!valid) {
+    fprintf(stderr, "Shared memory %s is not a UI segment of this version\n", name);
+    munmap(map, map_size);
+    return NULL;
+  }
+
+  // One tool at a time, a dead one's place can be taken
+  int32_t current = atomic_load(&shm->client_pid);
+  if (process_alive(current) ||
+      !atomic_compare_exchange_strong(&shm->client_pid, &current, (int32_t)getpid())) {
+    fprintf(stderr, "Another tool is connected to %s\n", name);
+    munmap(map, map_size);
+    return NULL;
+  }
+
+  ui_remote_backend* remote = (ui_remote_backend*)ui_mem_alloc(allocator, sizeof(ui_remote_backend));
+  uint32_t* free_ids = (uint32_t*)ui_mem_alloc(allocator, sizeof(uint32_t) * UI_REMOTE_MAX_TEXTURES);
+  remote_shadow* shadows = (remote_shadow*)ui_mem_alloc(allocator,
+    sizeof(remote_shadow) * UI_REMOTE_MAX_TEXTURES);
+  if (!remote || !free_ids || !shadows) {
+    ui_mem_free(allocator, remote);
+    ui_mem_free(allocator, free_ids);
+    ui_mem_free(allocator, shadows);
+    atomic_store(&shm->client_pid, 0);
+    munmap(map, map_size);
+    return NULL;
+  }
+  memset(remote, 0, sizeof(ui_remote_backend));
+
+  remote->allocator = *allocator;
+  remote->shm = shm;
+  remote->map_size = map_size;
+  remote->input = (UIInputEvent*)((unsigned char*)map + input_offset());
+  remote->ring = (unsigned char*)map + ring_offset(shm->input_capacity);
+  remote->head = atomic_load_explicit(&shm->head, memory_order_acquire);
+  remote->free_ids = free_ids;
+  remote->next_id = 1;
+  remote->shadows = shadows;
+  memset(shadows, 0, sizeof(remote_shadow) * UI_REMOTE_MAX_TEXTURES);
+  remote->reset_generation = atomic_load_explicit(&shm->reset_generation, memory_order_acquire);
+
+  remote->base.user = remote;
+  remote->base.create_texture = remote_create_texture;
+  remote->base.destroy_texture = remote_destroy_texture;
+  remote->base.update_texture = remote_update_texture;
+  remote->base.render = remote_render;
+  remote->base.get_counters = remote_get_counters;
+  remote->base.destroy = remote_destroy;
+
+  // Input meant for an earlier tool is not ours
+  atomic_store(&shm->input_tail, atomic_load(&shm->input_head));
+
+  // Whatever an earlier tool left in the engine goes away first
+  if (!ring_reserve(remote, MSG_HELLO, 0, true)) {
+    remote_destroy(&remote->base);
+    return NULL;
+  }
+  ring_publish(remote);
+  return &remote->base;
+}
+
+int ui_backend_remote_poll_input(UIRenderBackend* backend, UIContext* ctx) {
+  ui_remote_backend* remote = (ui_remote_backend*)backend;
+  remote_header* shm = remote->shm;
+  uint32_t tail = atomic_load_explicit(&shm->input_tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&shm->input_head, memory_order_acquire);
+
+  int count = 0;
+  for (; tail != head; tail++, count++) {
+    UIInputEvent event = remote->input[tail & (shm->input_capacity - 1)];
+    ui_push_event(ctx, &event);
+  }
+  atomic_store_explicit(&shm->input_tail, tail, memory_order_release);
+  return count;
+}
+
+bool ui_backend_remote_wait(UIRenderBackend* backend, int timeout_ms) {
+  remote_header* shm = ((ui_remote_backend*)backend)->shm;
+  uint32_t tail = atomic_load_explicit(&shm->input_tail, memory_order_relaxed);
+
+  wait_word(&shm->input_head, &shm->input_waiters, tail, timeout_ms);
+  return atomic_load(&shm->input_head) != tail;
+}
+
+bool ui_backend_remote_connected(UIRenderBackend* backend) {
+  return process_alive(atomic_load(&((ui_remote_backend*)backend)->shm->server_pid));
+}
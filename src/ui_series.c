@@ -0,0 +1,194 @@
+/*
+ * Tridme UI Series
+ *
+ * Single-producer, multi-reader sample ring with a min/max pyramid kept up
+ * to date as samples arrive. Readers work in place and validate afterwards,
+ * seqlock style, instead of taking a lock.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_series.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <stdio.h>
+
+#define SERIES_MAX_LEVELS 64
+
+typedef struct {
+  float min, max;
+} series_range;
+
+struct UISeries {
+  UIAllocator allocator;
+  float* samples;
+  uint64_t capacity;      // Power of two
+  uint64_t reserve;       // Newest part of the ring never handed to readers
+  uint64_t chunk;         // Most samples written between two publications
+
+  // Level k (1..levels-1) holds capacity >> k blocks of 2^k samples, level 0
+  // is the samples themselves
+  int levels;
+  series_range* pyramid[SERIES_MAX_LEVELS];
+
+  _Alignas(64) _Atomic uint64_t head;    // Samples published
+  _Atomic uint64_t writing;              // Samples that may be partly written, head or more
+};
+
+UISeries* ui_series_create(size_t capacity, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  uint64_t size = 64;
+  while (size < capacity) size <<= 1;
+
+  UISeries* series = (UISeries*)ui_mem_alloc(allocator, sizeof(UISeries));
+  if (!series) return NULL;
+  memset(series, 0, sizeof(UISeries));
+
+  // Every level above 0 together holds size - 1 blocks
+  series->samples = (float*)ui_mem_alloc(allocator, sizeof(float) * size);
+  series_range* blocks = (series_range*)ui_mem_alloc(allocator, sizeof(series_range) * (size - 1));
+  if (!series->samples || !blocks) {
+    fprintf(stderr, "Failed to allocate a series of %llu samples\n", (unsigned long long)size);
+    ui_mem_free(allocator, blocks);
+    ui_mem_free(allocator, series->samples);
+    ui_mem_free(allocator, series);
+    return NULL;
+  }
+
+  series->allocator = *allocator;
+  series->capacity = size;
+  series->reserve = size / 16;
+  series->chunk = series->reserve / 2;
+  series->levels = 1;
+  for (uint64_t count = size >> 1; count > 0; count >>= 1) {
+    series->pyramid[series->levels++] = blocks;
+    blocks += count;
+  }
+  atomic_init(&series->head, 0);
+  atomic_init(&series->writing, 0);
+  return series;
+}
+
+void ui_series_destroy(UISeries* series) {
+  if (!series) return;
+
+  UIAllocator allocator = series->allocator;
+  ui_mem_free(&allocator, series->pyramid[1]);
+  ui_mem_free(&allocator, series->samples);
+  ui_mem_free(&allocator, series);
+}
+
+static series_range get_block(const UISeries* series, int level, uint64_t block) {
+  if (level == 0) {
+    float value = series->samples[block & (series->capacity - 1)];
+    return (series_range){value, value};
+  }
+  return series->pyramid[level][block & ((series->capacity >> level) - 1)];
+}
+
+// Sample index was just written: fill in every block it completes
+static void complete_blocks(UISeries* series, uint64_t index) {
+  uint64_t next = index + 1;
+  for (int level = 1; level < series->levels && (next & ((1ull << level) - 1)) == 0; level++) {
+    uint64_t block = index >> level;
+    series_range a = get_block(series, level - 1, block * 2);
+    series_range b = get_block(series, level - 1, block * 2 + 1);
+    series->pyramid[level][block & ((series->capacity >> level) - 1)] = (series_range){
+      a.min < b.min ? a.min : b.min,
+      a.max > b.max ? a.max : b.max
+    };
+  }
+}
+
+void ui_series_push(UISeries* series, float value) {
+  ui_series_push_many(series, &value, 1);
+}
+
+void ui_series_push_many(UISeries* series, const float* values, size_t count) {
+  uint64_t head = atomic_load_explicit(&series->head, memory_order_relaxed);
+  uint64_t mask = series->capacity - 1;
+
+  while (count > 0) {
+    size_t n = count < series->chunk ? count : (size_t)series->chunk;
+
+    // Announce the slots about to be reused before touching them
+    atomic_store_explicit(&series->writing, head + n, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (size_t i = 0; i < n; i++, head++) {
+      series->samples[head & mask] = values[i];
+      complete_blocks(series, head);
+    }
+    atomic_store_explicit(&series->head, head, memory_order_release);
+
+    values += n;
+    count -= n;
+  }
+}
+
+UISeriesSnapshot ui_series_snapshot(const UISeries* series) {
+  UISeries* mutable_series = (UISeries*)series;
+  uint64_t end = atomic_load_explicit(&mutable_series->head, memory_order_acquire);
+  uint64_t writing = atomic_load_explicit(&mutable_series->writing, memory_order_relaxed);
+
+  // Keep clear of the slots the producer will reuse next
+  uint64_t limit = series->capacity - series->reserve;
+  uint64_t begin = writing > limit ? writing - limit : 0;
+  if (begin > end) begin = end;
+  return (UISeriesSnapshot){series, begin, end};
+}
+
+bool ui_series_snapshot_valid(const UISeriesSnapshot* snapshot) {
+  UISeries* series = (UISeries*)snapshot->series;
+  atomic_thread_fence(memory_order_acquire);
+  uint64_t writing = atomic_load_explicit(&series->writing, memory_order_relaxed);
+  return writing <= snapshot->begin + series->capacity;
+}
+
+size_t ui_series_span(const UISeriesSnapshot* snapshot, uint64_t index, const float** samples) {
+  const UISeries* series = snapshot->series;
+  uint64_t offset = index & (series->capacity - 1);
+  uint64_t count = series->capacity - offset;
+  if (count > snapshot->end - index) count = snapshot->end - index;
+
+  *samples = series->samples + offset;
+  return (size_t)count;
+}
+
+void ui_series_min_max(const UISeriesSnapshot* snapshot, uint64_t first, uint64_t last,
+  float* out_min, float* out_max) {
+  const UISeries* series = snapshot->series;
+  series_range range = get_block(series, 0, first);
+
+  // Bottom-up over the pyramid: peel the unaligned ends off each level, the
+  // rest continues one level up as half as many blocks
+  int level = 0;
+  while (first < last) {
+    if (first & 1) {
+      series_range block = get_block(series, level, first++);
+      if (block.min < range.min) range.min = block.min;
+      if (block.max > range.max) range.max = block.max;
+    }
+    if (last & 1) {
+      series_range block = get_block(series, level, --last);
+      if (block.min < range.min) range.min = block.min;
+      if (block.max > range.max) range.max = block.max;
+    }
+    if (level == series->levels - 1) {
+      // A range is shorter than the ring, so at the top at most one block remains
+      if (first < last) {
+        series_range block = get_block(series, level, first);
+        if (block.min < range.min) range.min = block.min;
+        if (block.max > range.max) range.max = block.max;
+      }
+      break;
+    }
+    first >>= 1;
+    last >>= 1;
+    level++;
+  }
+
+  *out_min = range.min;
+  *out_max = range.max;
+}
@@ -4,6 +4,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#ifdef _WIN32
+  #include <direct.h>
+#else
+  #include <sys/stat.h>
+#endif
 
 // Vertex shader source
 static const char* vertex_shader_source = 
@@ -11,9 +18,11 @@ static const char* vertex_shader_source =
 "layout(location = 0) in vec2 aPos;\n"
 "layout(location = 1) in vec2 aTexCoord;\n"
 "layout(location = 2) in vec4 aColor;\n"
+"layout(location = 3) in uint aSlot;\n"
 "\n"
 "out vec2 TexCoord;\n"
 "out vec4 Color;\n"
+"flat out uint Slot;\n"
 "\n"
 "uniform mat4 projection;\n"
 "\n"
@@ -21,23 +30,45 @@ static const char* vertex_shader_source =
 "  gl_Position = projection * vec4(aPos, 0.0, 1.0);\n"
 "  TexCoord = aTexCoord;\n"
 "  Color = aColor;\n"
+"  Slot = aSlot;\n"
 "}\n";
 
-// Fragment shader source
+// Fragment shader source. Slot holds the texture unit (UI_DRAW_MAX_TEXTURES of
+// them) and the pipeline in its low bit; GLSL 3.30 only indexes sampler arrays
+// with constants, hence the switch. Textures have no mipmaps, textureLod keeps
+// the branches free of derivatives
 static const char* fragment_shader_source = 
 "#version 330 core\n"
 "\n"
 "in vec2 TexCoord;\n"
 "in vec4 Color;\n"
+"flat in uint Slot;\n"
 "\n"
 "out vec4 FragColor;\n"
 "\n"
-"uniform sampler2D tex;\n"
+"uniform sampler2D textures[8];\n"
 "uniform vec4 color;\n"
 "\n"
+"vec4 sample_unit(uint unit) {\n"
+"  switch (unit) {\n"
+"    case 0u: return textureLod(textures[0], TexCoord, 0.0);\n"
+"    case 1u: return textureLod(textures[1], TexCoord, 0.0);\n"
+"    case 2u: return textureLod(textures[2], TexCoord, 0.0);\n"
+"    case 3u: return textureLod(textures[3], TexCoord, 0.0);\n"
+"    case 4u: return textureLod(textures[4], TexCoord, 0.0);\n"
+"    case 5u: return textureLod(textures[5], TexCoord, 0.0);\n"
+"    case 6u: return textureLod(textures[6], TexCoord, 0.0);\n"
+"    default: return textureLod(textures[7], TexCoord, 0.0);\n"
+"  }\n"
+"}\n"
+"\n"
 "void main() {\n"
-"  float alpha = texture(tex, TexCoord).r;\n"
-"  FragColor = vec4(color.rgb, color.a * alpha) * Color;\n"
+"  vec4 texel = sample_unit(Slot >> 1u);\n"
+"  if ((Slot & 1u) == 0u) {\n"  // Red channel is coverage
+"    FragColor = vec4(color.rgb, color.a * texel.r) * Color;\n"
+"  } else {\n"                  // Texture is color
+"    FragColor = color * texel * Color;\n"
+"  }\n"
 "}\n";
 
 // Fragment shader for solid colors (no texture)
@@ -133,23 +164,14 @@ static unsigned int compile_shader(GLenum type, const char* source) {
   return shader;
 }
 
-// Create a shader program from source strings
-unsigned int ui_compile_shader(const char* vertex_src, const char* fragment_src) {
-  unsigned int vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_src);
-  if (!vertex_shader) {
-    return 0;
-  }
-  
-  unsigned int fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_src);
-  if (!fragment_shader) {
-    glDeleteShader(vertex_shader);
-    return 0;
-  }
-  
-  // Link shaders
+// Link two compiled shaders, the shaders are deleted either way
+static unsigned int link_program(unsigned int vertex_shader, unsigned int fragment_shader, bool retrievable) {
   unsigned int program = glCreateProgram();
   glAttachShader(program, vertex_shader);
   glAttachShader(program, fragment_shader);
+  if (retrievable) {
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
   glLinkProgram(program);
   
   // Check linking status
@@ -157,19 +179,226 @@ unsigned int ui_compile_shader(const char* vertex_src, const char* fragment_src)
   char info_log[512];
   glGetProgramiv(program, GL_LINK_STATUS, &success);
   
+  // Clean up shaders
+  glDeleteShader(vertex_shader);
+  glDeleteShader(fragment_shader);
+  
   if (!success) {
     glGetProgramInfoLog(program, 512, NULL, info_log);
     fprintf(stderr, "Shader program linking failed:\n%s\n", info_log);
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
     glDeleteProgram(program);
     return 0;
   }
   
-  // Clean up shaders
-  glDeleteShader(vertex_shader);
-  glDeleteShader(fragment_shader);
+  return program;
+}
+
+static unsigned int compile_program(const char* vertex_src, const char* fragment_src, bool retrievable) {
+  unsigned int vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_src);
+  if (!vertex_shader) {
+    return 0;
+  }
+  
+  unsigned int fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_src);
+  if (!fragment_shader) {
+    glDeleteShader(vertex_shader);
+    return 0;
+  }
   
+  return link_program(vertex_shader, fragment_shader, retrievable);
+}
+
+/*
+ * Program binary cache
+ *
+ * A linked program is saved with glGetProgramBinary as
+ * <dir>/ui_program_<key>.bin, the key hashing both sources and the driver's
+ * vendor, renderer and version strings. A driver update changes the key, and
+ * a binary the driver still rejects is recompiled and overwritten.
+ */
+
+#define SHADER_CACHE_MAGIC   0x42505554u  // "TUPB"
+#define SHADER_CACHE_VERSION 1u
+#define SHADER_CACHE_PATH    1024
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t format;      // Driver's binary format enum
+  uint32_t length;      // Bytes of binary that follow
+} shader_cache_header;
+
+static uint64_t hash_string(uint64_t hash, const char* text) {
+  // FNV-1a, the terminator included so "ab"+"c" differs from "a"+"bc"
+  const unsigned char* p = (const unsigned char*)(text ? text : "");
+  do {
+    hash ^= *p;
+    hash *= 1099511628211ull;
+  } while (*p++);
+  return hash;
+}
+
+static uint64_t program_key(const char* vertex_src, const char* fragment_src) {
+  uint64_t hash = 14695981039346656037ull;
+  hash = hash_string(hash, vertex_src);
+  hash = hash_string(hash, fragment_src);
+  hash = hash_string(hash, (const char*)glGetString(GL_VENDOR));
+  hash = hash_string(hash, (const char*)glGetString(GL_RENDERER));
+  hash = hash_string(hash, (const char*)glGetString(GL_VERSION));
+  return hash;
+}
+
+// Program binaries need GL 4.1 or ARB_get_program_binary and at least one format
+static bool program_binaries_supported(void) {
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  while (glGetError() != GL_NO_ERROR) {}
+  return formats > 0;
+}
+
+static bool make_dir(const char* path) {
+#ifdef _WIN32
+  return _mkdir(path) == 0 || errno == EEXIST;
+#else
+  return mkdir(path, 0700) == 0 || errno == EEXIST;
+#endif
+}
+
+// Per-user cache directory, created if missing: %LOCALAPPDATA%\TridmeUI,
+// $XDG_CACHE_HOME/tridme-ui or ~/.cache/tridme-ui
+static bool default_cache_dir(char* path, size_t size) {
+#ifdef _WIN32
+  const char* base = getenv("LOCALAPPDATA");
+  if (!base || !base[0]) return false;
+  int length = snprintf(path, size, "%s\\TridmeUI", base);
+#else
+  const char* base = getenv("XDG_CACHE_HOME");
+  int length;
+  if (base && base[0]) {
+    length = snprintf(path, size, "%s/tridme-ui", base);
+  } else {
+    const char* home = getenv("HOME");
+    if (!home || !home[0]) return false;
+    length = snprintf(path, size, "%s/.cache", home);
+    if (length < 0 || (size_t)length >= size || !make_dir(path)) return false;
+    length = snprintf(path, size, "%s/.cache/tridme-ui", home);
+  }
+#endif
+  return length > 0 && (size_t)length < size && make_dir(path);
+}
+
+static void cache_path(char* path, size_t size, const char* dir, uint64_t key, const char* suffix) {
+  snprintf(path, size, "%s/ui_program_%016llx.bin%s", dir, (unsigned long long)key, suffix);
+}
+
+static unsigned int load_cached_program(const char* dir, uint64_t key, const UIAllocator* allocator) {
+  char path[SHADER_CACHE_PATH + 64];
+  cache_path(path, sizeof(path), dir, key, "");
+
+  FILE* file = fopen(path, "rb");
+  if (!file) return 0;
+
+  shader_cache_header header;
+  void* binary = NULL;
+  unsigned int program = 0;
+
+  if (fread(&header, sizeof(header), 1, file) == 1 &&
+      header.magic == SHADER_CACHE_MAGIC && header.version == SHADER_CACHE_VERSION &&
+      header.key == key && header.length > 0) {
+    binary = ui_mem_alloc(allocator, header.length);
+    if (binary && fread(binary, 1, header.length, file) == header.length) {
+      program = glCreateProgram();
+      glProgramBinary(program, (GLenum)header.format, binary, (GLsizei)header.length);
+
+      int success = 0;
+      glGetProgramiv(program, GL_LINK_STATUS, &success);
+      if (!success) {
+        // Driver changed in a way the key did not catch, recompile. A rejected
+        // binary may leave GL_INVALID_ENUM behind, it is not the caller's error
+        glDeleteProgram(program);
+        program = 0;
+        while (glGetError() != GL_NO_ERROR) {}
+      }
+    }
+  }
+
+  ui_mem_free(allocator, binary);
+  fclose(file);
+  return program;
+}
+
+static void save_cached_program(unsigned int program, const char* dir, uint64_t key,
+  const UIAllocator* allocator) {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+
+  void* binary = ui_mem_alloc(allocator, (size_t)length);
+  if (!binary) return;
+
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary);
+
+  // Written aside and renamed, a crash never leaves a torn binary behind
+  char path[SHADER_CACHE_PATH + 64], temp[SHADER_CACHE_PATH + 64];
+  cache_path(path, sizeof(path), dir, key, "");
+  cache_path(temp, sizeof(temp), dir, key, ".tmp");
+
+  FILE* file = fopen(temp, "wb");
+  if (!file) {
+    fprintf(stderr, "Failed to write shader cache file: %s\n", temp);
+    ui_mem_free(allocator, binary);
+    return;
+  }
+
+  shader_cache_header header = {SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, key, (uint32_t)format, (uint32_t)length};
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(binary, 1, (size_t)length, file) == (size_t)length;
+  written = fclose(file) == 0 && written;
+  ui_mem_free(allocator, binary);
+
+  if (written) {
+    remove(path);
+    written = rename(temp, path) == 0;
+  }
+  if (!written) {
+    fprintf(stderr, "Failed to write shader cache file: %s\n", path);
+    remove(temp);
+  }
+}
+
+// Create a shader program from source strings, cached in the per-user directory
+unsigned int ui_compile_shader(const char* vertex_src, const char* fragment_src) {
+  return ui_compile_shader_cached(vertex_src, fragment_src, NULL, NULL);
+}
+
+unsigned int ui_compile_shader_cached(const char* vertex_src, const char* fragment_src,
+  const char* cache_dir, const UIAllocator* allocator) {
+  // The default directory is looked up every time, nothing is shared between callers
+  char default_dir[SHADER_CACHE_PATH];
+  if (!cache_dir) {
+    cache_dir = default_cache_dir(default_dir, sizeof(default_dir)) ? default_dir : "";
+  }
+  if (!cache_dir[0] || !program_binaries_supported()) {
+    return compile_program(vertex_src, fragment_src, false);
+  }
+  if (strlen(cache_dir) >= SHADER_CACHE_PATH) {
+    fprintf(stderr, "Shader cache directory path is too long: %s\n", cache_dir);
+    return compile_program(vertex_src, fragment_src, false);
+  }
+  if (!allocator) allocator = ui_default_allocator();
+
+  uint64_t key = program_key(vertex_src, fragment_src);
+  unsigned int program = load_cached_program(cache_dir, key, allocator);
+  if (program) {
+    return program;
+  }
+
+  program = compile_program(vertex_src, fragment_src, true);
+  if (program) {
+    save_cached_program(program, cache_dir, key, allocator);
+  }
   return program;
 }
 
@@ -195,18 +424,20 @@ unsigned int ui_compile_shader_from_files(const char* vertex_file, const char* f
 }
 
 // Create the default UI shader
-unsigned int ui_create_ui_shader(void) {
-  return ui_compile_shader(vertex_shader_source, fragment_shader_source);
+unsigned int ui_create_ui_shader(const char* cache_dir, const UIAllocator* allocator) {
+  return ui_compile_shader_cached(vertex_shader_source, fragment_shader_source, cache_dir, allocator);
 }
 
 // Create a solid color shader (no texture)
-unsigned int ui_create_solid_shader(void) {
-  return ui_compile_shader(vertex_shader_source, fragment_shader_solid_source);
+unsigned int ui_create_solid_shader(const char* cache_dir, const UIAllocator* allocator) {
+  return ui_compile_shader_cached(vertex_shader_source, fragment_shader_solid_source, cache_dir,
+    allocator);
 }
 
 // Create a rounded rectangle shader
-unsigned int ui_create_rounded_shader(void) {
-  return ui_compile_shader(vertex_shader_source, fragment_shader_rounded_source);
+unsigned int ui_create_rounded_shader(const char* cache_dir, const UIAllocator* allocator) {
+  return ui_compile_shader_cached(vertex_shader_source, fragment_shader_rounded_source, cache_dir,
+    allocator);
 }
 
 // Get uniform location
@@ -305,7 +536,7 @@ void ui_set_rounded_uniforms(unsigned int shader, float width, float height, flo
 }
 
 // Create a batch rendering shader (for drawing multiple quads)
-unsigned int ui_create_batch_shader(void) {
+unsigned int ui_create_batch_shader(const char* cache_dir, const UIAllocator* allocator) {
   const char* batch_vertex_source = 
   "#version 330 core\n"
   "layout(location = 0) in vec2 aPos;\n"
@@ -325,32 +556,37 @@ unsigned int ui_create_batch_shader(void) {
   "  Color = aColor;\n"
   "}\n";
   
-  return ui_compile_shader(batch_vertex_source, fragment_shader_source);
+  return ui_compile_shader_cached(batch_vertex_source, fragment_shader_source, cache_dir, allocator);
 }
 
 // Shader manager structure (optional, for managing multiple shaders)
 typedef struct {
+  UIAllocator allocator;
   unsigned int ui_shader;
   unsigned int solid_shader;
   unsigned int rounded_shader;
   unsigned int batch_shader;
 } shader_manager;
 
+void ui_destroy_shader_manager(shader_manager* manager);
+
 // Create and initialize shader manager
-shader_manager* ui_create_shader_manager(void) {
-  shader_manager* manager = (shader_manager*)malloc(sizeof(shader_manager));
+shader_manager* ui_create_shader_manager(const char* cache_dir, const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+  shader_manager* manager = (shader_manager*)ui_mem_alloc(allocator, sizeof(shader_manager));
   if (!manager) return NULL;
   
-  manager->ui_shader = ui_create_ui_shader();
-  manager->solid_shader = ui_create_solid_shader();
-  manager->rounded_shader = ui_create_rounded_shader();
-  manager->batch_shader = ui_create_batch_shader();
+  manager->allocator = *allocator;
+  manager->ui_shader = ui_create_ui_shader(cache_dir, allocator);
+  manager->solid_shader = ui_create_solid_shader(cache_dir, allocator);
+  manager->rounded_shader = ui_create_rounded_shader(cache_dir, allocator);
+  manager->batch_shader = ui_create_batch_shader(cache_dir, allocator);
   
   // Check if all shaders were created successfully
   if (!manager->ui_shader || !manager->solid_shader || 
     !manager->rounded_shader || !manager->batch_shader) {
     fprintf(stderr, "Failed to create one or more shaders\n");
-    free(manager);
+    ui_destroy_shader_manager(manager);
     return NULL;
   }
   
@@ -366,7 +602,8 @@ void ui_destroy_shader_manager(shader_manager* manager) {
   if (manager->rounded_shader) glDeleteProgram(manager->rounded_shader);
   if (manager->batch_shader) glDeleteProgram(manager->batch_shader);
   
-  free(manager);
+  UIAllocator allocator = manager->allocator;
+  ui_mem_free(&allocator, manager);
 }
 
 // Set projection matrix for all shaders in manager
@@ -0,0 +1,778 @@
+/*
+ * Tridme UI Table
+ *
+ * Virtualized table. Only the cells in view are fetched and drawn; auto-fit
+ * column widths are measured once, incrementally, and kept; sorting permutes
+ * row indices.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_table.h>
+#include <ui_widgets.h>
+#include <ui_font.h>
+#include <ui_draw.h>
+#include <ui_hit.h>
+#include <ui_input.h>
+#include <ui_profile.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#define TABLE_MAX_CHANGES 1024  // Reported cells kept until the next frame
+#define TABLE_PADDING     5.0f  // Cell text inset
+#define TABLE_MIN_WIDTH   24.0f
+#define TABLE_SCROLL_X    40.0f // Pixels per wheel notch or arrow key
+
+typedef struct {
+  bool fixed;             // Width set by the host, nothing measured
+  float width;            // Auto-fit width in use, padding included
+  uint32_t widest_row;    // Row whose cell set width, UI_TABLE_NONE: the header
+
+  // Pass over every row, measuring the rows from scan_row on
+  uint32_t scan_row;      // UI_TABLE_NONE: no pass running
+  float scan_width;
+  uint32_t scan_widest;
+} table_column;
+
+typedef struct {
+  uint32_t row, column;
+} table_change;
+
+// Sort key of one data row, fetched when the row is sorted
+typedef struct {
+  double number;          // NAN when the cell is not a number
+  uint32_t text;          // Offset of the cell text in the table's key text
+  uint32_t length;
+} sort_key;
+
+struct UITable {
+  UIAllocator allocator;
+  const UIFont* font;     // Widths were measured with it
+
+  table_column* columns;
+  uint32_t column_count;
+  float* offsets;         // column_count + 1 left edges, rebuilt when a width changes
+  bool layout_dirty;
+  uint32_t row_count;
+
+  table_change changes[TABLE_MAX_CHANGES];
+  int change_count;
+  bool changed_all;
+
+  uint32_t* order;        // Display row -> data row while sorted
+  uint32_t order_capacity;
+  uint32_t sort_column;   // UI_TABLE_NONE: data order
+  bool descending;
+  bool sort_dirty;        // The whole order has to be sorted again
+
+  // Keys of the sort column by data row, kept so a changed or appended row
+  // is moved into place alone. NULL when the host compares rows
+  sort_key* keys;
+  uint32_t key_capacity;
+  char* key_text;
+  size_t text_used, text_capacity;
+  size_t text_garbage;    // Bytes of replaced keys still in key_text
+
+  double top_row;         // First visible row, fractional while scrolling
+  float scroll_x;
+  uint32_t selection;
+};
+
+UITable* ui_table_create(const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  UITable* table = (UITable*)ui_mem_alloc(allocator, sizeof(UITable));
+  if (!table) return NULL;
+  memset(table, 0, sizeof(UITable));
+  table->allocator = *allocator;
+  table->sort_column = UI_TABLE_NONE;
+  table->selection = UI_TABLE_NONE;
+  return table;
+}
+
+void ui_table_destroy(UITable* table) {
+  if (!table) return;
+
+  UIAllocator allocator = table->allocator;
+  ui_mem_free(&allocator, table->columns);
+  ui_mem_free(&allocator, table->offsets);
+  ui_mem_free(&allocator, table->order);
+  ui_mem_free(&allocator, table->keys);
+  ui_mem_free(&allocator, table->key_text);
+  ui_mem_free(&allocator, table);
+}
+
+void ui_table_cell_changed(UITable* table, uint32_t row, uint32_t column) {
+  if (row == UI_TABLE_NONE || table->change_count == TABLE_MAX_CHANGES) {
+    table->changed_all = true;
+    return;
+  }
+  table->changes[table->change_count++] = (table_change){row, column};
+}
+
+void ui_table_sort(UITable* table, uint32_t column, bool descending) {
+  table->sort_column = column;
+  table->descending = descending;
+  table->sort_dirty = true;
+}
+
+uint32_t ui_table_data_row(const UITable* table, uint32_t display_row) {
+  if (table->sort_column == UI_TABLE_NONE || table->sort_dirty || display_row >= table->row_count) {
+    return display_row;
+  }
+  return table->order[display_row];
+}
+
+uint32_t ui_table_selection(const UITable* table) {
+  return table->selection;
+}
+
+/*
+ * Measuring
+ */
+
+static size_t get_cell(const UITableDesc* desc, uint32_t row, uint32_t column, char* buffer) {
+  size_t length = desc->cell(desc->user, row, column, buffer, UI_TABLE_MAX_CELL);
+  return length < UI_TABLE_MAX_CELL ? length : UI_TABLE_MAX_CELL;
+}
+
+static float measure_bytes(const UIFont* font, const char* text, size_t n) {
+  float width = 0.0f;
+  for (size_t i = 0; i < n;) {
+    uint32_t ch = (unsigned char)text[i];
+    if (ch < 128) i++; else i += ui_utf8_decode(text + i, n - i, &ch);
+    width += ui_font_advance(font, ch);
+  }
+  return width;
+}
+
+// Bytes of whole glyphs that fit in max_width, and the width of all of the text
+static size_t fit_bytes(const UIFont* font, const char* text, size_t n, float max_width,
+  float* out_width) {
+  float width = 0.0f;
+  size_t fit = 0;
+  for (size_t i = 0; i < n;) {
+    uint32_t ch = (unsigned char)text[i];
+    if (ch < 128) i++; else i += ui_utf8_decode(text + i, n - i, &ch);
+    width += ui_font_advance(font, ch);
+    if (width <= max_width) fit = i;
+  }
+  *out_width = width;
+  return fit;
+}
+
+static float cell_width(const UIFont* font, const char* text, size_t n) {
+  return measure_bytes(font, text, n) + TABLE_PADDING * 2;
+}
+
+static float header_width(const UIContext* ctx, const UITableColumn* column) {
+  float width = column->title ? cell_width(ctx->font, column->title, strlen(column->title)) : 0.0f;
+  width += ui_font_advance(ctx->font, '^') + TABLE_PADDING;  // Room for the sort marker
+  return width > TABLE_MIN_WIDTH ? width : TABLE_MIN_WIDTH;
+}
+
+static void start_pass(UITable* table, const UIContext* ctx, const UITableDesc* desc, uint32_t c) {
+  table_column* column = &table->columns[c];
+  column->scan_row = 0;
+  column->scan_width = header_width(ctx, &desc->columns[c]);
+  column->scan_widest = UI_TABLE_NONE;
+}
+
+// A cell was measured: widen the column and the running pass if needed
+static void observe(UITable* table, table_column* column, uint32_t row, float width) {
+  if (column->scan_row != UI_TABLE_NONE && row < column->scan_row && width > column->scan_width) {
+    column->scan_width = width;
+    column->scan_widest = row;
+  }
+  if (width > column->width) {
+    column->width = width;
+    column->widest_row = row;
+    table->layout_dirty = true;
+  }
+}
+
+static void apply_change(UITable* table, const UIContext* ctx, const UITableDesc* desc,
+  uint32_t row, uint32_t c, char* buffer) {
+  table_column* column = &table->columns[c];
+  if (column->fixed || row >= desc->row_count) return;
+
+  float width = cell_width(ctx->font, buffer, get_cell(desc, row, c, buffer));
+  bool was_widest = row == column->widest_row ||
+    (column->scan_row != UI_TABLE_NONE && row < column->scan_row && row == column->scan_widest);
+  observe(table, column, row, width);
+
+  // The widest cell may have shrunk: only a new pass can tell the new width
+  if (was_widest && width < column->width) start_pass(table, ctx, desc, c);
+}
+
+static void update_order(UITable* table, const UITableDesc* desc, uint32_t old_count);
+
+// Bring the column state in line with desc and apply the reported changes
+static bool sync_columns(UITable* table, const UIContext* ctx, const UITableDesc* desc) {
+  bool reset = table->changed_all || ctx->font != table->font;
+  if (desc->column_count != table->column_count) {
+    ui_mem_free(&table->allocator, table->columns);
+    ui_mem_free(&table->allocator, table->offsets);
+    table->columns = (table_column*)ui_mem_alloc(&table->allocator,
+      sizeof(table_column) * desc->column_count);
+    table->offsets = (float*)ui_mem_alloc(&table->allocator, sizeof(float) * (desc->column_count + 1));
+    if (!table->columns || !table->offsets) {
+      fprintf(stderr, "Failed to allocate %u table columns\n", desc->column_count);
+      ui_mem_free(&table->allocator, table->columns);
+      ui_mem_free(&table->allocator, table->offsets);
+      table->columns = NULL;
+      table->offsets = NULL;
+      table->column_count = 0;
+      return false;
+    }
+    memset(table->columns, 0, sizeof(table_column) * desc->column_count);
+    for (uint32_t c = 0; c < desc->column_count; c++) table->columns[c].fixed = true;
+    table->column_count = desc->column_count;
+    reset = true;
+  }
+  table->font = ctx->font;
+
+  for (uint32_t c = 0; c < table->column_count; c++) {
+    table_column* column = &table->columns[c];
+    bool fixed = desc->columns[c].width > 0.0f;
+    if (fixed) {
+      if (!column->fixed || column->width != desc->columns[c].width) table->layout_dirty = true;
+      column->fixed = true;
+      column->width = desc->columns[c].width;
+      column->scan_row = UI_TABLE_NONE;
+    } else if (column->fixed || reset) {
+      column->fixed = false;
+      column->width = header_width(ctx, &desc->columns[c]);
+      column->widest_row = UI_TABLE_NONE;
+      start_pass(table, ctx, desc, c);
+      table->layout_dirty = true;
+    } else if (desc->row_count > table->row_count && column->scan_row == UI_TABLE_NONE) {
+      // Appended rows: measure just those, the rest is known
+      column->scan_row = table->row_count;
+      column->scan_width = column->width;
+      column->scan_widest = column->widest_row;
+    } else if (desc->row_count < table->row_count &&
+               ((column->widest_row != UI_TABLE_NONE && column->widest_row >= desc->row_count) ||
+                (column->scan_row != UI_TABLE_NONE && column->scan_widest != UI_TABLE_NONE &&
+                 column->scan_widest >= desc->row_count))) {
+      start_pass(table, ctx, desc, c);
+    }
+  }
+
+  if (reset) {
+    table->sort_dirty = true;
+  } else {
+    update_order(table, desc, table->row_count);
+  }
+  table->row_count = desc->row_count;
+
+  if (!reset) {
+    char buffer[UI_TABLE_MAX_CELL];
+    for (int i = 0; i < table->change_count; i++) {
+      const table_change* change = &table->changes[i];
+      if (change->column == UI_TABLE_NONE) {
+        for (uint32_t c = 0; c < table->column_count; c++) {
+          apply_change(table, ctx, desc, change->row, c, buffer);
+        }
+      } else if (change->column < table->column_count) {
+        apply_change(table, ctx, desc, change->row, change->column, buffer);
+      }
+    }
+  }
+  table->change_count = 0;
+  table->changed_all = false;
+  return true;
+}
+
+// Advance the auto-fit passes by up to UI_TABLE_FIT_BUDGET cells
+static void run_passes(UITable* table, const UIContext* ctx, const UITableDesc* desc) {
+  char buffer[UI_TABLE_MAX_CELL];
+  int budget = UI_TABLE_FIT_BUDGET;
+
+  for (uint32_t c = 0; c < table->column_count && budget > 0; c++) {
+    table_column* column = &table->columns[c];
+    if (column->scan_row == UI_TABLE_NONE) continue;
+
+    while (column->scan_row < desc->row_count && budget > 0) {
+      uint32_t row = column->scan_row++;
+      float width = cell_width(ctx->font, buffer, get_cell(desc, row, c, buffer));
+      if (width > column->scan_width) {
+        column->scan_width = width;
+        column->scan_widest = row;
+      }
+      budget--;
+    }
+
+    // Grow as the pass goes, shrink only once it has seen every row
+    if (column->scan_row >= desc->row_count) {
+      if (column->width != column->scan_width) table->layout_dirty = true;
+      column->width = column->scan_width;
+      column->widest_row = column->scan_widest;
+      column->scan_row = UI_TABLE_NONE;
+    } else if (column->scan_width > column->width) {
+      column->width = column->scan_width;
+      column->widest_row = column->scan_widest;
+      table->layout_dirty = true;
+    }
+  }
+}
+
+/*
+ * Sorting
+ */
+
+typedef struct {
+  const UITableDesc* desc;
+  uint32_t column;
+  bool descending;
+  const sort_key* keys;
+  const char* text;
+} sort_context;
+
+static bool parse_number(const char* text, double* value) {
+  char* end;
+  *value = strtod(text, &end);
+  if (end == text) return false;
+  while (*end == ' ') end++;
+  return *end == '\0';
+}
+
+static int compare_rows(const sort_context* sort, uint32_t a, uint32_t b) {
+  const UITableDesc* desc = sort->desc;
+  int result;
+  if (desc->compare) {
+    result = desc->compare(desc->user, a, b, sort->column);
+  } else {
+    const sort_key* x = &sort->keys[a];
+    const sort_key* y = &sort->keys[b];
+    bool x_number = !isnan(x->number), y_number = !isnan(y->number);
+    if (x_number && y_number) {
+      result = (x->number > y->number) - (x->number < y->number);
+    } else if (x_number != y_number) {
+      result = x_number ? -1 : 1;  // Numbers before text
+    } else {
+      uint32_t n = x->length < y->length ? x->length : y->length;
+      result = memcmp(sort->text + x->text, sort->text + y->text, n);
+      if (result == 0) result = (x->length > y->length) - (x->length < y->length);
+    }
+  }
+  return sort->descending ? -result : result;
+}
+
+// Stable bottom-up merge sort of row indices
+static void merge_sort(const sort_context* sort, uint32_t* rows, uint32_t* scratch, uint32_t count) {
+  uint32_t* from = rows;
+  uint32_t* to = scratch;
+  for (uint32_t width = 1; width < count; width *= 2) {
+    for (uint32_t lo = 0; lo < count; lo += width * 2) {
+      uint32_t mid = lo + width < count ? lo + width : count;
+      uint32_t hi = mid + width < count ? mid + width : count;
+      uint32_t i = lo, j = mid, k = lo;
+      while (i < mid && j < hi) {
+        to[k++] = compare_rows(sort, from[j], from[i]) < 0 ? from[j++] : from[i++];
+      }
+      while (i < mid) to[k++] = from[i++];
+      while (j < hi) to[k++] = from[j++];
+    }
+    uint32_t* swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from != rows) memcpy(rows, from, sizeof(uint32_t) * count);
+}
+
+// Room for count keys and one more cell of text, keeping the keys there are.
+// False when out of memory, or when the text is mostly replaced keys and a
+// full sort should compact it instead of growing it
+static bool reserve_keys(UITable* table, uint32_t count) {
+  if (count > table->key_capacity) {
+    uint32_t capacity = table->key_capacity < count / 2 ? count : table->key_capacity * 2;
+    if (capacity < count) capacity = count;
+    sort_key* keys = (sort_key*)ui_mem_alloc(&table->allocator, sizeof(sort_key) * capacity);
+    if (!keys) return false;
+    if (table->keys) memcpy(keys, table->keys, sizeof(sort_key) * table->key_capacity);
+    ui_mem_free(&table->allocator, table->keys);
+    table->keys = keys;
+    table->key_capacity = capacity;
+  }
+
+  if (table->text_capacity - table->text_used < UI_TABLE_MAX_CELL + 1) {
+    if (table->text_garbage > table->text_used / 2) return false;
+    size_t capacity = table->text_capacity ? table->text_capacity * 2 :
+      (size_t)count * 16 + UI_TABLE_MAX_CELL + 1;
+    if (capacity > UINT32_MAX) return false;
+    char* text = (char*)ui_mem_alloc(&table->allocator, capacity);
+    if (!text) return false;
+    if (table->key_text) memcpy(text, table->key_text, table->text_used);
+    ui_mem_free(&table->allocator, table->key_text);
+    table->key_text = text;
+    table->text_capacity = capacity;
+  }
+  return true;
+}
+
+// Fetch a row's cell of the sort column once: number parsed, text appended to the key text
+static void fetch_key(UITable* table, const UITableDesc* desc, uint32_t row) {
+  char* cell = table->key_text + table->text_used;
+  size_t n = get_cell(desc, row, table->sort_column, cell);
+  cell[n] = '\0';
+  sort_key* key = &table->keys[row];
+  if (!parse_number(cell, &key->number)) key->number = NAN;
+  key->text = (uint32_t)table->text_used;
+  key->length = (uint32_t)n;
+  table->text_used += n;
+}
+
+static void drop_keys(UITable* table) {
+  ui_mem_free(&table->allocator, table->keys);
+  ui_mem_free(&table->allocator, table->key_text);
+  table->keys = NULL;
+  table->key_text = NULL;
+  table->key_capacity = 0;
+  table->text_used = table->text_capacity = table->text_garbage = 0;
+}
+
+static bool grow_order(UITable* table, uint32_t count) {
+  if (count <= table->order_capacity) return true;
+  uint32_t capacity = table->order_capacity < count / 2 ? count : table->order_capacity * 2;
+  if (capacity < count) capacity = count;
+  uint32_t* order = (uint32_t*)ui_mem_alloc(&table->allocator, sizeof(uint32_t) * capacity);
+  if (!order) return false;
+  if (table->order) memcpy(order, table->order, sizeof(uint32_t) * table->order_capacity);
+  ui_mem_free(&table->allocator, table->order);
+  table->order = order;
+  table->order_capacity = capacity;
+  return true;
+}
+
+static void sort_rows(UITable* table, const UITableDesc* desc) {
+  table->sort_dirty = false;
+  if (table->sort_column == UI_TABLE_NONE) return;
+  if (table->sort_column >= desc->column_count) {
+    table->sort_column = UI_TABLE_NONE;
+    return;
+  }
+
+  // Every key is fetched again, the old text goes
+  uint32_t count = desc->row_count;
+  table->text_used = table->text_garbage = 0;
+  bool ok = grow_order(table, count);
+  if (ok && desc->compare) {
+    drop_keys(table);
+  } else {
+    for (uint32_t row = 0; ok && row < count; row++) {
+      ok = reserve_keys(table, count);
+      if (ok) fetch_key(table, desc, row);
+    }
+  }
+  uint32_t* scratch = (uint32_t*)ui_mem_alloc(&table->allocator, sizeof(uint32_t) * count);
+  sort_context sort = {desc, table->sort_column, table->descending, table->keys, table->key_text};
+
+  if (ok && scratch) {
+    for (uint32_t row = 0; row < count; row++) table->order[row] = row;
+    merge_sort(&sort, table->order, scratch, count);
+  } else {
+    fprintf(stderr, "Failed to allocate the order of %u table rows\n", count);
+    table->sort_column = UI_TABLE_NONE;
+    drop_keys(table);
+  }
+  ui_mem_free(&table->allocator, scratch);
+}
+
+// Display order of two different rows, ties kept in data order like the full sort
+static bool sorts_before(const sort_context* sort, uint32_t a, uint32_t b) {
+  int result = compare_rows(sort, a, b);
+  return result < 0 || (result == 0 && a < b);
+}
+
+/*
+ * Keep a sorted order sorted after the frame's changes: rows past the new
+ * row count leave it, and the appended rows and rows whose sort cell was
+ * reported changed are taken out, sorted among themselves and put back by
+ * binary search. That costs O(k log n) comparisons and one pass over the
+ * order for k such rows, where sorting again would fetch and compare all n.
+ */
+static void update_order(UITable* table, const UITableDesc* desc, uint32_t old_count) {
+  if (table->sort_column == UI_TABLE_NONE || table->sort_dirty) return;
+  if (table->sort_column >= desc->column_count || (!desc->compare && !table->keys)) {
+    table->sort_dirty = true;
+    return;
+  }
+
+  uint32_t count = desc->row_count;
+  uint32_t kept = old_count < count ? old_count : count;
+  bool changed = false;
+  for (int i = 0; i < table->change_count && !changed; i++) {
+    const table_change* change = &table->changes[i];
+    changed = change->row < kept &&
+      (change->column == table->sort_column || change->column == UI_TABLE_NONE);
+  }
+  if (!changed && count == old_count) return;
+
+  // Rows to place: flags for the removal pass, then a list in data order
+  unsigned char* moved = (unsigned char*)ui_mem_alloc(&table->allocator, count ? count : 1);
+  if (!moved || !grow_order(table, count)) {
+    ui_mem_free(&table->allocator, moved);
+    table->sort_dirty = true;
+    return;
+  }
+  memset(moved, 0, count);
+  for (int i = 0; i < table->change_count; i++) {
+    const table_change* change = &table->changes[i];
+    if (change->row < kept &&
+        (change->column == table->sort_column || change->column == UI_TABLE_NONE)) {
+      moved[change->row] = 1;
+    }
+  }
+  for (uint32_t row = kept; row < count; row++) moved[row] = 1;
+
+  uint32_t moved_count = 0;
+  for (uint32_t row = 0; row < count; row++) moved_count += moved[row];
+  uint32_t* rows = (uint32_t*)ui_mem_alloc(&table->allocator, sizeof(uint32_t) * (moved_count * 2 + 1));
+  bool ok = rows != NULL;
+  for (uint32_t row = 0, k = 0; ok && row < count; row++) {
+    if (!moved[row]) continue;
+    rows[k++] = row;
+    if (!desc->compare) {
+      if (row < old_count) table->text_garbage += table->keys[row].length;
+      ok = reserve_keys(table, count);
+      if (ok) fetch_key(table, desc, row);
+    }
+  }
+  if (!ok) {
+    ui_mem_free(&table->allocator, rows);
+    ui_mem_free(&table->allocator, moved);
+    table->sort_dirty = true;
+    return;
+  }
+
+  // The rest of the order keeps its relative order, so it is still sorted
+  uint32_t* order = table->order;
+  uint32_t rest = 0;
+  for (uint32_t i = 0; i < old_count; i++) {
+    uint32_t row = order[i];
+    if (row < count && !moved[row]) order[rest++] = row;
+  }
+
+  sort_context sort = {desc, table->sort_column, table->descending, table->keys, table->key_text};
+  merge_sort(&sort, rows, rows + moved_count, moved_count);
+
+  // Merge from the back, each moved row after the rest that sorts before it
+  uint32_t end = rest;
+  for (uint32_t k = moved_count; k-- > 0;) {
+    uint32_t lo = 0, hi = end;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (sorts_before(&sort, order[mid], rows[k])) lo = mid + 1; else hi = mid;
+    }
+    memmove(order + lo + k + 1, order + lo, sizeof(uint32_t) * (end - lo));
+    order[lo + k] = rows[k];
+    end = lo;
+  }
+
+  ui_mem_free(&table->allocator, rows);
+  ui_mem_free(&table->allocator, moved);
+}
+
+/*
+ * Widget
+ */
+
+static bool point_in_rect(vec2 p, rect r) {
+  return p.x >= r.pos.x && p.x <= r.pos.x + r.size.x &&
+         p.y >= r.pos.y && p.y <= r.pos.y + r.size.y;
+}
+
+// Last column whose left edge is at or before x
+static uint32_t column_at(const UITable* table, float x) {
+  uint32_t lo = 0, hi = table->column_count - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi + 1) / 2;
+    if (table->offsets[mid] <= x) lo = mid; else hi = mid - 1;
+  }
+  return lo;
+}
+
+void ui_table(UIContext* ctx, const char* id, rect bounds, UITable* table, const UITableDesc* desc) {
+  if (!ctx->font || desc->column_count == 0) return;
+  UI_PROFILE_BEGIN(ctx, "ui_table");
+  ui_id widget_id = ui_get_id(id);
+
+  if (!sync_columns(table, ctx, desc)) {
+    UI_PROFILE_END(ctx);
+    return;
+  }
+  run_passes(table, ctx, desc);
+  if (table->sort_dirty) sort_rows(table, desc);
+  if (table->layout_dirty) {
+    table->offsets[0] = 0.0f;
+    for (uint32_t c = 0; c < table->column_count; c++) {
+      table->offsets[c + 1] = table->offsets[c] + table->columns[c].width;
+    }
+    table->layout_dirty = false;
+  }
+
+  ui_hit_add(ctx, widget_id, bounds);
+  bool hovered = ui_widget_hovered(ctx, widget_id, bounds);
+
+  float line_height = ctx->font_size + 4.0f;
+  rect header = {bounds.pos, {bounds.size.x, line_height}};
+  rect body = {
+    {bounds.pos.x, bounds.pos.y + line_height},
+    {bounds.size.x, bounds.size.y - line_height}
+  };
+  double page = body.size.y / line_height;
+  double max_top = desc->row_count > page ? (double)desc->row_count - page : 0.0;
+  float total_width = table->offsets[table->column_count];
+  float max_x = total_width > bounds.size.x ? total_width - bounds.size.x : 0.0f;
+
+  for (int i = 0; i < ctx->event_count; i++) {
+    const UIInputEvent* event = &ctx->events[i];
+    bool over = point_in_rect(event->mouse_pos, bounds) &&
+      ui_hit_is_topmost(ctx, widget_id, event->mouse_pos);
+
+    if (event->type == UI_EVENT_MOUSE_BUTTON && event->pressed && event->button == 0 && over) {
+      ctx->focused_widget = widget_id;
+      float x = event->mouse_pos.x - bounds.pos.x + table->scroll_x;
+      if (point_in_rect(event->mouse_pos, header)) {
+        if (x < total_width) {
+          uint32_t c = column_at(table, x);
+          ui_table_sort(table, c, table->sort_column == c && !table->descending);
+        }
+      } else {
+        double row = table->top_row + (event->mouse_pos.y - body.pos.y) / line_height;
+        if (row >= 0.0 && row < (double)desc->row_count) {
+          table->selection = ui_table_data_row(table, (uint32_t)row);
+        }
+      }
+    } else if (event->type == UI_EVENT_SCROLL && over) {
+      if (point_in_rect(event->mouse_pos, header)) {
+        table->scroll_x -= event->scroll * TABLE_SCROLL_X;
+      } else {
+        table->top_row -= event->scroll * 3.0;
+      }
+    } else if (event->type == UI_EVENT_KEY && event->pressed && ctx->focused_widget == widget_id) {
+      switch (event->key) {
+        case UI_KEY_PAGE_UP:   table->top_row -= page; break;
+        case UI_KEY_PAGE_DOWN: table->top_row += page; break;
+        case UI_KEY_UP:        table->top_row -= 1.0; break;
+        case UI_KEY_DOWN:      table->top_row += 1.0; break;
+        case UI_KEY_LEFT:      table->scroll_x -= TABLE_SCROLL_X; break;
+        case UI_KEY_RIGHT:     table->scroll_x += TABLE_SCROLL_X; break;
+        case UI_KEY_HOME:      table->top_row = 0.0; break;
+        case UI_KEY_END:       table->top_row = max_top; break;
+        default: break;
+      }
+    }
+  }
+  if (table->sort_dirty) sort_rows(table, desc);
+
+  if (table->top_row > max_top) table->top_row = max_top;
+  if (table->top_row < 0.0) table->top_row = 0.0;
+  if (table->scroll_x > max_x) table->scroll_x = max_x;
+  if (table->scroll_x < 0.0f) table->scroll_x = 0.0f;
+
+  bool is_focused = ctx->focused_widget == widget_id;
+  rect border = {{bounds.pos.x - 1, bounds.pos.y - 1}, {bounds.size.x + 2, bounds.size.y + 2}};
+  if (!ui_widget_visible(ctx, border)) {
+    UI_PROFILE_END(ctx);
+    return;
+  }
+
+  ui_draw_rect(ctx, border, is_focused ?
+    (color){0.3f, 0.3f, 0.8f, 1.0f} :
+    (color){0.0f, 0.0f, 0.0f, 1.0f});
+  color bg_color = {0.1f, 0.1f, 0.1f, 1.0f};
+  if (hovered) {
+    bg_color.r += 0.03f;
+    bg_color.g += 0.03f;
+    bg_color.b += 0.03f;
+  }
+  ui_draw_rect(ctx, bounds, bg_color);
+  ui_draw_rect(ctx, header, (color){0.2f, 0.2f, 0.2f, 1.0f});
+
+  // Visible columns, the same for the header and every row
+  uint32_t c0 = column_at(table, table->scroll_x);
+  uint32_t c1 = c0;
+  while (c1 < table->column_count && table->offsets[c1] < table->scroll_x + bounds.size.x) c1++;
+  float origin = bounds.pos.x - table->scroll_x;
+  color text_color = {0.85f, 0.85f, 0.85f, 1.0f};
+  char buffer[UI_TABLE_MAX_CELL];
+
+  ui_push_clip(ctx, header);
+  for (uint32_t c = c0; c < c1; c++) {
+    const char* title = desc->columns[c].title ? desc->columns[c].title : "";
+    float x = origin + table->offsets[c];
+    float width = table->columns[c].width;
+    size_t length = strlen(title);
+    if (length > UI_TABLE_MAX_CELL - 2) length = UI_TABLE_MAX_CELL - 2;
+    memcpy(buffer, title, length);
+    if (c == table->sort_column) {
+      buffer[length++] = ' ';
+      buffer[length++] = table->descending ? 'v' : '^';
+    }
+
+    float text_width;
+    size_t fit = fit_bytes(ctx->font, buffer, length, width - TABLE_PADDING * 2, &text_width);
+    ui_draw_text_n(ctx, buffer, fit,
+      (vec2){x + TABLE_PADDING, header.pos.y + line_height * 0.5f + 4.0f}, text_color);
+    ui_draw_rect(ctx, (rect){{x + width - 1.0f, header.pos.y}, {1.0f, line_height}},
+      (color){0.35f, 0.35f, 0.35f, 1.0f});
+  }
+  ui_pop_clip(ctx);
+
+  ui_push_clip(ctx, body);
+  uint32_t row = (uint32_t)table->top_row;
+  float y = body.pos.y - (float)(table->top_row - (double)row) * line_height;
+  for (; row < desc->row_count && y < body.pos.y + body.size.y; row++, y += line_height) {
+    uint32_t data_row = ui_table_data_row(table, row);
+    if (data_row == table->selection) {
+      ui_draw_rect(ctx, (rect){{body.pos.x, y}, {body.size.x, line_height}},
+        (color){0.25f, 0.3f, 0.5f, 1.0f});
+    } else if (row & 1) {
+      ui_draw_rect(ctx, (rect){{body.pos.x, y}, {body.size.x, line_height}},
+        (color){0.13f, 0.13f, 0.13f, 1.0f});
+    }
+
+    for (uint32_t c = c0; c < c1; c++) {
+      table_column* column = &table->columns[c];
+      size_t length = get_cell(desc, data_row, c, buffer);
+      float text_width;
+      size_t fit = fit_bytes(ctx->font, buffer, length, column->width - TABLE_PADDING * 2,
+        &text_width);
+      ui_draw_text_n(ctx, buffer, fit,
+        (vec2){origin + table->offsets[c] + TABLE_PADDING, y + line_height * 0.5f + 4.0f},
+        text_color);
+
+      // Visible cells are measured anyway, they widen their column at once
+      if (!column->fixed) observe(table, column, data_row, text_width + TABLE_PADDING * 2);
+    }
+  }
+
+  for (uint32_t c = c0; c < c1; c++) {
+    float x = origin + table->offsets[c] + table->columns[c].width - 1.0f;
+    ui_draw_rect(ctx, (rect){{x, body.pos.y}, {1.0f, body.size.y}},
+      (color){0.2f, 0.2f, 0.2f, 1.0f});
+  }
+  ui_pop_clip(ctx);
+
+  // Scrollbar thumbs, position only
+  if (max_top > 0.0) {
+    float thumb = body.size.y * (float)(page / (double)desc->row_count);
+    if (thumb < 16.0f) thumb = 16.0f;
+    float thumb_y = body.pos.y + (body.size.y - thumb) * (float)(table->top_row / max_top);
+    ui_draw_rect(ctx, (rect){{bounds.pos.x + bounds.size.x - 4.0f, thumb_y}, {3.0f, thumb}},
+      (color){0.5f, 0.5f, 0.5f, 1.0f});
+  }
+  if (max_x > 0.0f) {
+    float thumb = bounds.size.x * (bounds.size.x / total_width);
+    if (thumb < 16.0f) thumb = 16.0f;
+    float thumb_x = bounds.pos.x + (bounds.size.x - thumb) * (table->scroll_x / max_x);
+    ui_draw_rect(ctx, (rect){{thumb_x, bounds.pos.y + bounds.size.y - 4.0f}, {thumb, 3.0f}},
+      (color){0.5f, 0.5f, 0.5f, 1.0f});
+  }
+
+  UI_PROFILE_END(ctx);
+}
@@ -0,0 +1,557 @@
+/*
+ * Tridme UI Tree
+ *
+ * Lazy tree view. Expanded nodes are kept as records with the number of
+ * rows below them; rows are found by walking those counts from the root,
+ * and the host is asked for children only on the rows in view.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_tree.h>
+#include <ui_widgets.h>
+#include <ui_font.h>
+#include <ui_draw.h>
+#include <ui_hit.h>
+#include <ui_input.h>
+#include <ui_profile.h>
+#include <string.h>
+#include <stdio.h>
+
+#define TREE_NONE         UINT32_MAX
+#define TREE_MAX_CHANGES  256         // Reported nodes kept until the next frame
+#define TREE_INDENT       16.0f
+#define TREE_PADDING      5.0f
+#define TREE_DOUBLE_CLICK 400000000ull // Nanoseconds between the clicks of a double click
+
+// A node that is or was expanded
+typedef struct {
+  uint64_t id;
+  uint32_t parent;        // Record of the parent, TREE_NONE for the root
+  uint32_t index;         // Position among the parent's children
+  uint32_t depth;
+  uint32_t child_count;
+  uint64_t rows;          // Rows below it while open: children and their open subtrees
+  bool open;
+  bool live;              // Record in use, free records are chained through parent
+
+  // Records of its children, sorted by index
+  uint32_t* children;
+  uint32_t child_records, child_capacity;
+} tree_node;
+
+// Where a row is: the child at index of the parent record
+typedef struct {
+  uint64_t id;
+  uint32_t parent;
+  uint32_t index;
+  uint32_t depth;
+} tree_row;
+
+struct UITree {
+  UIAllocator allocator;
+
+  tree_node* nodes;
+  uint32_t node_count, node_capacity;
+  uint32_t free_node;
+  uint32_t root;          // TREE_NONE until the first ui_tree
+  uint64_t root_id;
+
+  // Node id -> record, open addressing with linear probing
+  uint32_t* slots;
+  uint32_t slot_capacity; // Power of two
+  uint32_t used_slots;
+
+  uint64_t changes[TREE_MAX_CHANGES];
+  int change_count;
+  bool changed_all;
+
+  double top_row;
+  uint64_t selection;
+  uint64_t click_node;    // Last click, for double clicks
+  uint64_t click_time_ns;
+};
+
+UITree* ui_tree_create(const UIAllocator* allocator) {
+  if (!allocator) allocator = ui_default_allocator();
+
+  UITree* tree = (UITree*)ui_mem_alloc(allocator, sizeof(UITree));
+  if (!tree) return NULL;
+  memset(tree, 0, sizeof(UITree));
+  tree->allocator = *allocator;
+  tree->free_node = TREE_NONE;
+  tree->root = TREE_NONE;
+  tree->selection = UI_TREE_NONE;
+  tree->click_node = UI_TREE_NONE;
+  return tree;
+}
+
+static void free_records(UITree* tree) {
+  for (uint32_t i = 0; i < tree->node_count; i++) {
+    ui_mem_free(&tree->allocator, tree->nodes[i].children);
+  }
+  ui_mem_free(&tree->allocator, tree->nodes);
+  ui_mem_free(&tree->allocator, tree->slots);
+  tree->nodes = NULL;
+  tree->slots = NULL;
+  tree->node_count = tree->node_capacity = 0;
+  tree->slot_capacity = tree->used_slots = 0;
+  tree->free_node = TREE_NONE;
+  tree->root = TREE_NONE;
+}
+
+void ui_tree_destroy(UITree* tree) {
+  if (!tree) return;
+
+  free_records(tree);
+  UIAllocator allocator = tree->allocator;
+  ui_mem_free(&allocator, tree);
+}
+
+void ui_tree_node_changed(UITree* tree, uint64_t node) {
+  if (node == UI_TREE_NONE || tree->change_count == TREE_MAX_CHANGES) {
+    tree->changed_all = true;
+    return;
+  }
+  tree->changes[tree->change_count++] = node;
+}
+
+uint64_t ui_tree_selection(const UITree* tree) {
+  return tree->selection;
+}
+
+/*
+ * Records
+ */
+
+static uint32_t hash_id(uint64_t id) {
+  id ^= id >> 33;
+  id *= 0xff51afd7ed558ccdull;
+  id ^= id >> 33;
+  return (uint32_t)id;
+}
+
+static uint32_t find_record(const UITree* tree, uint64_t id) {
+  if (tree->slot_capacity == 0) return TREE_NONE;
+
+  uint32_t mask = tree->slot_capacity - 1;
+  for (uint32_t slot = hash_id(id) & mask;; slot = (slot + 1) & mask) {
+    uint32_t record = tree->slots[slot];
+    if (record == TREE_NONE || tree->nodes[record].id == id) return record;
+  }
+}
+
+bool ui_tree_expanded(const UITree* tree, uint64_t node) {
+  uint32_t record = find_record(tree, node);
+  return record != TREE_NONE && tree->nodes[record].open;
+}
+
+static void insert_slot(UITree* tree, uint32_t record) {
+  uint32_t mask = tree->slot_capacity - 1;
+  uint32_t slot = hash_id(tree->nodes[record].id) & mask;
+  while (tree->slots[slot] != TREE_NONE) slot = (slot + 1) & mask;
+  tree->slots[slot] = record;
+}
+
+static bool grow_slots(UITree* tree) {
+  uint32_t capacity = tree->slot_capacity ? tree->slot_capacity * 2 : 256;
+  uint32_t* slots = (uint32_t*)ui_mem_alloc(&tree->allocator, sizeof(uint32_t) * capacity);
+  if (!slots) return false;
+  memset(slots, 0xff, sizeof(uint32_t) * capacity);
+
+  uint32_t* old = tree->slots;
+  uint32_t old_capacity = tree->slot_capacity;
+  tree->slots = slots;
+  tree->slot_capacity = capacity;
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old[i] != TREE_NONE) insert_slot(tree, old[i]);
+  }
+  ui_mem_free(&tree->allocator, old);
+  return true;
+}
+
+static void remove_slot(UITree* tree, uint64_t id) {
+  uint32_t mask = tree->slot_capacity - 1;
+  uint32_t slot = hash_id(id) & mask;
+  while (tree->nodes[tree->slots[slot]].id != id) slot = (slot + 1) & mask;
+
+  // Backward shift: pull later entries of the probe run into the hole
+  uint32_t hole = slot;
+  for (uint32_t next = (hole + 1) & mask; tree->slots[next] != TREE_NONE; next = (next + 1) & mask) {
+    uint32_t home = hash_id(tree->nodes[tree->slots[next]].id) & mask;
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      tree->slots[hole] = tree->slots[next];
+      hole = next;
+    }
+  }
+  tree->slots[hole] = TREE_NONE;
+  tree->used_slots--;
+}
+
+static uint32_t new_record(UITree* tree, uint64_t id) {
+  if ((tree->used_slots + 1) * 2 > tree->slot_capacity && !grow_slots(tree)) return TREE_NONE;
+
+  uint32_t record = tree->free_node;
+  if (record != TREE_NONE) {
+    tree->free_node = tree->nodes[record].parent;
+  } else {
+    if (tree->node_count == tree->node_capacity) {
+      uint32_t capacity = tree->node_capacity ? tree->node_capacity * 2 : 64;
+      tree_node* nodes = (tree_node*)ui_mem_alloc(&tree->allocator, sizeof(tree_node) * capacity);
+      if (!nodes) return TREE_NONE;
+      if (tree->node_count > 0) memcpy(nodes, tree->nodes, sizeof(tree_node) * tree->node_count);
+      ui_mem_free(&tree->allocator, tree->nodes);
+      tree->nodes = nodes;
+      tree->node_capacity = capacity;
+    }
+    record = tree->node_count++;
+  }
+
+  tree_node* node = &tree->nodes[record];
+  memset(node, 0, sizeof(tree_node));
+  node->id = id;
+  node->live = true;
+  insert_slot(tree, record);
+  tree->used_slots++;
+  return record;
+}
+
+static void release_record(UITree* tree, uint32_t record) {
+  tree_node* node = &tree->nodes[record];
+  for (uint32_t i = 0; i < node->child_records; i++) release_record(tree, node->children[i]);
+
+  node = &tree->nodes[record];
+  remove_slot(tree, node->id);
+  ui_mem_free(&tree->allocator, node->children);
+  node->children = NULL;
+  node->child_records = node->child_capacity = 0;
+  node->live = false;
+  node->parent = tree->free_node;
+  tree->free_node = record;
+}
+
+// Add delta rows below a record, and to each ancestor it is visible from
+static void adjust_rows(UITree* tree, uint32_t record, int64_t delta) {
+  while (record != TREE_NONE) {
+    tree_node* node = &tree->nodes[record];
+    node->rows += (uint64_t)delta;
+    if (!node->open) break;
+    record = node->parent;
+  }
+}
+
+static bool link_child(UITree* tree, uint32_t parent, uint32_t child) {
+  tree_node* node = &tree->nodes[parent];
+  if (node->child_records == node->child_capacity) {
+    uint32_t capacity = node->child_capacity ? node->child_capacity * 2 : 4;
+    uint32_t* children = (uint32_t*)ui_mem_alloc(&tree->allocator, sizeof(uint32_t) * capacity);
+    if (!children) return false;
+    if (node->child_records > 0) memcpy(children, node->children, sizeof(uint32_t) * node->child_records);
+    ui_mem_free(&tree->allocator, node->children);
+    node->children = children;
+    node->child_capacity = capacity;
+  }
+
+  uint32_t index = tree->nodes[child].index;
+  uint32_t at = node->child_records;
+  while (at > 0 && tree->nodes[node->children[at - 1]].index > index) {
+    node->children[at] = node->children[at - 1];
+    at--;
+  }
+  node->children[at] = child;
+  node->child_records++;
+  return true;
+}
+
+static void unlink_child(UITree* tree, uint32_t parent, uint32_t child) {
+  tree_node* node = &tree->nodes[parent];
+  for (uint32_t i = 0; i < node->child_records; i++) {
+    if (node->children[i] != child) continue;
+    memmove(node->children + i, node->children + i + 1, sizeof(uint32_t) * (node->child_records - i - 1));
+    node->child_records--;
+    return;
+  }
+}
+
+static void toggle(UITree* tree, const UITreeDesc* desc, const tree_row* row) {
+  uint32_t record = find_record(tree, row->id);
+  if (record == TREE_NONE) {
+    uint32_t child_count = desc->child_count(desc->user, row->id);
+    if (child_count == 0) return;
+
+    record = new_record(tree, row->id);
+    if (record != TREE_NONE) {
+      tree_node* node = &tree->nodes[record];
+      node->parent = row->parent;
+      node->index = row->index;
+      node->depth = row->depth + 1;
+      node->child_count = child_count;
+      node->rows = child_count;
+    }
+    if (record == TREE_NONE || !link_child(tree, row->parent, record)) {
+      fprintf(stderr, "Failed to allocate tree expansion state\n");
+      if (record != TREE_NONE) release_record(tree, record);
+      return;
+    }
+  }
+
+  tree_node* node = &tree->nodes[record];
+  node->open = !node->open;
+  adjust_rows(tree, node->parent, node->open ? (int64_t)node->rows : -(int64_t)node->rows);
+
+  // A closed node with nothing open below it needs no record
+  if (!node->open && node->child_records == 0) {
+    unlink_child(tree, node->parent, record);
+    release_record(tree, record);
+  }
+}
+
+// Re-read a record's children from the host, keeping the records of those still there
+static void refresh_record(UITree* tree, const UITreeDesc* desc, uint32_t record) {
+  tree_node* node = &tree->nodes[record];
+  uint32_t child_count = desc->child_count(desc->user, node->id);
+  adjust_rows(tree, record, (int64_t)child_count - (int64_t)node->child_count);
+  node->child_count = child_count;
+
+  for (uint32_t i = 0; i < tree->nodes[record].child_records;) {
+    node = &tree->nodes[record];
+    tree_node* child = &tree->nodes[node->children[i]];
+    if (child->index >= child_count || desc->child(desc->user, node->id, child->index) != child->id) {
+      uint32_t found = TREE_NONE;
+      for (uint32_t j = 0; j < child_count && found == TREE_NONE; j++) {
+        if (desc->child(desc->user, node->id, j) == child->id) found = j;
+      }
+      if (found == TREE_NONE) {
+        uint32_t gone = node->children[i];
+        if (child->open) adjust_rows(tree, record, -(int64_t)child->rows);
+        unlink_child(tree, record, gone);
+        release_record(tree, gone);
+        continue;
+      }
+      child->index = found;
+    }
+    i++;
+  }
+
+  // Indices may have moved, keep the children sorted
+  node = &tree->nodes[record];
+  for (uint32_t i = 1; i < node->child_records; i++) {
+    uint32_t moving = node->children[i];
+    uint32_t at = i;
+    while (at > 0 && tree->nodes[node->children[at - 1]].index > tree->nodes[moving].index) {
+      node->children[at] = node->children[at - 1];
+      at--;
+    }
+    node->children[at] = moving;
+  }
+}
+
+static void apply_changes(UITree* tree, const UITreeDesc* desc) {
+  if (tree->root != TREE_NONE && tree->root_id != desc->root) free_records(tree);
+  if (tree->root == TREE_NONE) {
+    tree->root = new_record(tree, desc->root);
+    if (tree->root == TREE_NONE) return;
+    tree_node* root = &tree->nodes[tree->root];
+    root->parent = TREE_NONE;
+    root->open = true;
+    root->child_count = desc->child_count(desc->user, desc->root);
+    root->rows = root->child_count;
+    tree->root_id = desc->root;
+    tree->change_count = 0;
+    tree->changed_all = false;
+    return;
+  }
+
+  if (tree->changed_all) {
+    // Records released along the way are skipped, none are added
+    for (uint32_t record = 0; record < tree->node_count; record++) {
+      if (tree->nodes[record].live) refresh_record(tree, desc, record);
+    }
+  } else {
+    for (int i = 0; i < tree->change_count; i++) {
+      uint32_t record = find_record(tree, tree->changes[i]);
+      if (record != TREE_NONE) refresh_record(tree, desc, record);
+    }
+  }
+  tree->change_count = 0;
+  tree->changed_all = false;
+}
+
+// Find the node on a row, row < rows of the root
+static tree_row locate(const UITree* tree, const UITreeDesc* desc, uint64_t row) {
+  uint32_t record = tree->root;
+  for (;;) {
+    const tree_node* node = &tree->nodes[record];
+    uint32_t next_index = 0;  // First child not accounted for
+    uint32_t into = TREE_NONE;
+
+    for (uint32_t i = 0; i < node->child_records; i++) {
+      const tree_node* child = &tree->nodes[node->children[i]];
+      uint64_t before = child->index - next_index;  // Plain rows up to the child's own row
+      if (row < before) break;
+      row -= before;
+      if (row == 0) {
+        return (tree_row){child->id, record, child->index, node->depth};
+      }
+      row--;
+      next_index = child->index + 1;
+      if (child->open) {
+        if (row < child->rows) {
+          into = node->children[i];
+          break;
+        }
+        row -= child->rows;
+      }
+    }
+
+    if (into == TREE_NONE) {
+      uint32_t index = next_index + (uint32_t)row;
+      return (tree_row){desc->child(desc->user, node->id, index), record, index, node->depth};
+    }
+    record = into;
+  }
+}
+
+/*
+ * Widget
+ */
+
+static bool point_in_rect(vec2 p, rect r) {
+  return p.x >= r.pos.x && p.x <= r.pos.x + r.size.x &&
+         p.y >= r.pos.y && p.y <= r.pos.y + r.size.y;
+}
+
+// Bytes of whole glyphs that fit in max_width
+static size_t fit_bytes(const UIFont* font, const char* text, size_t n, float max_width) {
+  float width = 0.0f;
+  for (size_t i = 0; i < n;) {
+    size_t start = i;
+    uint32_t ch = (unsigned char)text[i];
+    if (ch < 128) i++; else i += ui_utf8_decode(text + i, n - i, &ch);
+    width += ui_font_advance(font, ch);
+    if (width > max_width) return start;
+  }
+  return n;
+}
+
+void ui_tree(UIContext* ctx, const char* id, rect bounds, UITree* tree, const UITreeDesc* desc) {
+  if (!ctx->font) return;
+  UI_PROFILE_BEGIN(ctx, "ui_tree");
+  ui_id widget_id = ui_get_id(id);
+
+  apply_changes(tree, desc);
+  if (tree->root == TREE_NONE) {
+    UI_PROFILE_END(ctx);
+    return;
+  }
+
+  ui_hit_add(ctx, widget_id, bounds);
+  bool hovered = ui_widget_hovered(ctx, widget_id, bounds);
+
+  float line_height = ctx->font_size + 4.0f;
+  rect area = {
+    {bounds.pos.x + TREE_PADDING, bounds.pos.y + TREE_PADDING},
+    {bounds.size.x - TREE_PADDING * 2, bounds.size.y - TREE_PADDING * 2}
+  };
+  double page = area.size.y / line_height;
+
+  for (int i = 0; i < ctx->event_count; i++) {
+    const UIInputEvent* event = &ctx->events[i];
+    bool over = point_in_rect(event->mouse_pos, bounds) &&
+      ui_hit_is_topmost(ctx, widget_id, event->mouse_pos);
+    uint64_t total = tree->nodes[tree->root].rows;
+
+    if (event->type == UI_EVENT_MOUSE_BUTTON && event->pressed && event->button == 0 && over) {
+      ctx->focused_widget = widget_id;
+      double at = tree->top_row + (event->mouse_pos.y - area.pos.y) / line_height;
+      if (at < 0.0 || at >= (double)total) continue;
+
+      tree_row row = locate(tree, desc, (uint64_t)at);
+      float arrow_x = area.pos.x + row.depth * TREE_INDENT;
+      bool on_arrow = event->mouse_pos.x >= arrow_x && event->mouse_pos.x < arrow_x + TREE_INDENT;
+      bool double_click = row.id == tree->click_node &&
+        event->time_ns - tree->click_time_ns < TREE_DOUBLE_CLICK;
+      if (on_arrow || double_click) toggle(tree, desc, &row);
+
+      tree->selection = row.id;
+      tree->click_node = double_click ? UI_TREE_NONE : row.id;
+      tree->click_time_ns = event->time_ns;
+    } else if (event->type == UI_EVENT_SCROLL && over) {
+      tree->top_row -= event->scroll * 3.0;
+    } else if (event->type == UI_EVENT_KEY && event->pressed && ctx->focused_widget == widget_id) {
+      switch (event->key) {
+        case UI_KEY_PAGE_UP:   tree->top_row -= page; break;
+        case UI_KEY_PAGE_DOWN: tree->top_row += page; break;
+        case UI_KEY_UP:        tree->top_row -= 1.0; break;
+        case UI_KEY_DOWN:      tree->top_row += 1.0; break;
+        case UI_KEY_HOME:      tree->top_row = 0.0; break;
+        case UI_KEY_END:       tree->top_row = (double)total; break;
+        default: break;
+      }
+    }
+  }
+
+  uint64_t total = tree->nodes[tree->root].rows;
+  double max_top = total > page ? (double)total - page : 0.0;
+  if (tree->top_row > max_top) tree->top_row = max_top;
+  if (tree->top_row < 0.0) tree->top_row = 0.0;
+
+  bool is_focused = ctx->focused_widget == widget_id;
+  rect border = {{bounds.pos.x - 1, bounds.pos.y - 1}, {bounds.size.x + 2, bounds.size.y + 2}};
+  if (!ui_widget_visible(ctx, border)) {
+    UI_PROFILE_END(ctx);
+    return;
+  }
+
+  ui_draw_rect(ctx, border, is_focused ?
+    (color){0.3f, 0.3f, 0.8f, 1.0f} :
+    (color){0.0f, 0.0f, 0.0f, 1.0f});
+  color bg_color = {0.1f, 0.1f, 0.1f, 1.0f};
+  if (hovered) {
+    bg_color.r += 0.03f;
+    bg_color.g += 0.03f;
+    bg_color.b += 0.03f;
+  }
+  ui_draw_rect(ctx, bounds, bg_color);
+
+  ui_push_clip(ctx, area);
+  color text_color = {0.85f, 0.85f, 0.85f, 1.0f};
+  char buffer[UI_TREE_MAX_LABEL];
+  uint64_t line = (uint64_t)tree->top_row;
+  float y = area.pos.y - (float)(tree->top_row - (double)line) * line_height;
+
+  for (; line < total && y < area.pos.y + area.size.y; line++, y += line_height) {
+    tree_row row = locate(tree, desc, line);
+    float x = area.pos.x + row.depth * TREE_INDENT;
+    float baseline = y + line_height * 0.5f + 4.0f;
+
+    if (row.id == tree->selection) {
+      ui_draw_rect(ctx, (rect){{area.pos.x, y}, {area.size.x, line_height}},
+        (color){0.25f, 0.3f, 0.5f, 1.0f});
+    }
+
+    uint32_t record = find_record(tree, row.id);
+    bool open = record != TREE_NONE && tree->nodes[record].open;
+    if (open || desc->child_count(desc->user, row.id) > 0) {
+      ui_draw_text_n(ctx, open ? "v" : ">", 1, (vec2){x + 3.0f, baseline}, text_color);
+    }
+
+    x += TREE_INDENT;
+    size_t length = desc->label(desc->user, row.id, buffer, sizeof(buffer));
+    if (length > sizeof(buffer)) length = sizeof(buffer);
+    size_t fit = fit_bytes(ctx->font, buffer, length, area.pos.x + area.size.x - x);
+    ui_draw_text_n(ctx, buffer, fit, (vec2){x, baseline}, text_color);
+  }
+  ui_pop_clip(ctx);
+
+  // Scrollbar thumb, position only
+  if (max_top > 0.0) {
+    float thumb = area.size.y * (float)(page / (double)total);
+    if (thumb < 16.0f) thumb = 16.0f;
+    float thumb_y = area.pos.y + (area.size.y - thumb) * (float)(tree->top_row / max_top);
+    ui_draw_rect(ctx, (rect){{bounds.pos.x + bounds.size.x - 4.0f, thumb_y}, {3.0f, thumb}},
+      (color){0.5f, 0.5f, 0.5f, 1.0f});
+  }
+
+  UI_PROFILE_END(ctx);
+}
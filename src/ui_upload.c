@@ -0,0 +1,215 @@
+/*
+ * Tridme UI Texture Uploads
+ *
+ * Dirty rectangle tracking for textures with a CPU copy, flushed through the
+ * backend under a per-frame byte budget.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_upload.h>
+#include <string.h>
+#include <stdio.h>
+
+static UITrackedTexture* find_texture(UIUploadQueue* queue, ui_texture_id texture) {
+  if (!queue) return NULL;
+  for (int i = 0; i < queue->texture_count; i++) {
+    if (queue->textures[i].texture == texture) return &queue->textures[i];
+  }
+  return NULL;
+}
+
+static size_t bytes_per_pixel(UITextureFormat format) {
+  return format == UI_TEXTURE_A8 ? 1 : 4;
+}
+
+static UIDirtyRect merge(UIDirtyRect a, UIDirtyRect b) {
+  int x0 = a.x < b.x ? a.x : b.x;
+  int y0 = a.y < b.y ? a.y : b.y;
+  int x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+  int y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+  return (UIDirtyRect){x0, y0, x1 - x0, y1 - y0, a.urgent || b.urgent};
+}
+
+static bool touches(UIDirtyRect a, UIDirtyRect b) {
+  return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+         a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+static int64_t area(UIDirtyRect r) {
+  return (int64_t)r.width * r.height;
+}
+
+static void remove_rect(UITrackedTexture* tracked, int index) {
+  memmove(&tracked->dirty[index], &tracked->dirty[index + 1],
+    sizeof(UIDirtyRect) * (tracked->dirty_count - index - 1));
+  tracked->dirty_count--;
+}
+
+bool ui_texture_track(UIContext* ctx, ui_texture_id texture, UITextureFormat format,
+  const void* pixels, int width, int height, int stride) {
+  if (!ctx->backend || !ctx->backend->update_texture) {
+    fprintf(stderr, "Backend cannot update textures\n");
+    return false;
+  }
+
+  if (!ctx->uploads) {
+    ctx->uploads = (UIUploadQueue*)ui_mem_alloc(&ctx->allocator, sizeof(UIUploadQueue));
+    if (!ctx->uploads) return false;
+    memset(ctx->uploads, 0, sizeof(UIUploadQueue));
+    ctx->uploads->allocator = ctx->allocator;
+  }
+
+  UIUploadQueue* queue = ctx->uploads;
+  UITrackedTexture* tracked = find_texture(queue, texture);
+  if (!tracked) {
+    if (queue->texture_count >= UI_UPLOAD_MAX_TEXTURES) {
+      fprintf(stderr, "Too many textures tracked for uploads\n");
+      return false;
+    }
+    tracked = &queue->textures[queue->texture_count++];
+    tracked->dirty_count = 0;
+  }
+
+  tracked->texture = texture;
+  tracked->format = format;
+  tracked->pixels = (const unsigned char*)pixels;
+  tracked->width = width;
+  tracked->height = height;
+  tracked->stride = stride;
+  return true;
+}
+
+void ui_texture_untrack(UIContext* ctx, ui_texture_id texture) {
+  UIUploadQueue* queue = ctx->uploads;
+  UITrackedTexture* tracked = find_texture(queue, texture);
+  if (!tracked) return;
+
+  *tracked = queue->textures[--queue->texture_count];
+  if (queue->next_texture >= queue->texture_count) queue->next_texture = 0;
+}
+
+void ui_texture_mark_dirty(UIContext* ctx, ui_texture_id texture, int x, int y,
+  int width, int height, bool urgent) {
+  UITrackedTexture* tracked = find_texture(ctx->uploads, texture);
+  if (!tracked) return;
+
+  // Clip to the texture
+  int x1 = x + width, y1 = y + height;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > tracked->width) x1 = tracked->width;
+  if (y1 > tracked->height) y1 = tracked->height;
+  if (x1 <= x || y1 <= y) return;
+
+  UIDirtyRect r = {x, y, x1 - x, y1 - y, urgent};
+
+  // Absorb every rect of the same urgency the new one touches (an urgent rect
+  // must not drag deferred work along); when the list is full, fold the new
+  // one into the rect it grows least and try again
+  for (;;) {
+    bool merged = false;
+    for (int i = 0; i < tracked->dirty_count; i++) {
+      if (tracked->dirty[i].urgent == r.urgent && touches(tracked->dirty[i], r)) {
+        r = merge(tracked->dirty[i], r);
+        remove_rect(tracked, i);
+        merged = true;
+        break;
+      }
+    }
+    if (merged) continue;
+
+    if (tracked->dirty_count < UI_UPLOAD_MAX_RECTS) break;
+
+    int best = 0;
+    int64_t best_growth = INT64_MAX;
+    for (int i = 0; i < tracked->dirty_count; i++) {
+      int64_t growth = area(merge(tracked->dirty[i], r)) - area(tracked->dirty[i]);
+      if (growth < best_growth) {
+        best_growth = growth;
+        best = i;
+      }
+    }
+    r = merge(tracked->dirty[best], r);
+    remove_rect(tracked, best);
+  }
+
+  tracked->dirty[tracked->dirty_count++] = r;
+}
+
+size_t ui_texture_pending_bytes(UIContext* ctx) {
+  UIUploadQueue* queue = ctx->uploads;
+  if (!queue) return 0;
+
+  size_t bytes = 0;
+  for (int i = 0; i < queue->texture_count; i++) {
+    const UITrackedTexture* tracked = &queue->textures[i];
+    for (int j = 0; j < tracked->dirty_count; j++) {
+      bytes += (size_t)area(tracked->dirty[j]) * bytes_per_pixel(tracked->format);
+    }
+  }
+  return bytes;
+}
+
+static void upload_rows(UIContext* ctx, const UITrackedTexture* tracked, const UIDirtyRect* r, int rows) {
+  size_t bpp = bytes_per_pixel(tracked->format);
+  const unsigned char* src = tracked->pixels + (size_t)r->y * tracked->stride + (size_t)r->x * bpp;
+  ctx->backend->update_texture(ctx->backend->user, tracked->texture, tracked->format,
+    r->x, r->y, r->width, rows, src, tracked->stride);
+}
+
+void ui_uploads_flush(UIContext* ctx) {
+  UIUploadQueue* queue = ctx->uploads;
+  if (!queue || queue->texture_count == 0) return;
+
+  size_t budget = ctx->upload_budget;
+  size_t spent = 0;
+
+  // Urgent rects first, whatever they cost
+  for (int t = 0; t < queue->texture_count; t++) {
+    UITrackedTexture* tracked = &queue->textures[t];
+    for (int i = 0; i < tracked->dirty_count;) {
+      UIDirtyRect* r = &tracked->dirty[i];
+      if (!r->urgent) {
+        i++;
+        continue;
+      }
+      upload_rows(ctx, tracked, r, r->height);
+      spent += (size_t)area(*r) * bytes_per_pixel(tracked->format);
+      remove_rect(tracked, i);
+    }
+  }
+
+  // Then the oldest deferred rects, whole rows while the budget lasts. The
+  // starting texture rotates so no texture starves another
+  int deferred = 0;
+  for (int n = 0; n < queue->texture_count; n++) {
+    UITrackedTexture* tracked = &queue->textures[(queue->next_texture + n) % queue->texture_count];
+    while (tracked->dirty_count > 0) {
+      UIDirtyRect* r = &tracked->dirty[0];
+      size_t row_bytes = (size_t)r->width * bytes_per_pixel(tracked->format);
+
+      size_t rows = spent < budget ? (budget - spent) / row_bytes : 0;
+      if (rows == 0 && spent == 0) rows = 1;
+      if (rows == 0) break;
+      if (rows > (size_t)r->height) rows = (size_t)r->height;
+
+      upload_rows(ctx, tracked, r, (int)rows);
+      spent += rows * row_bytes;
+      r->y += (int)rows;
+      r->height -= (int)rows;
+      if (r->height == 0) remove_rect(tracked, 0);
+    }
+    deferred += tracked->dirty_count;
+  }
+  queue->next_texture = (queue->next_texture + 1) % queue->texture_count;
+
+  UI_STAT_ADD(ctx, uploads_deferred, (uint32_t)deferred);
+}
+
+void ui_upload_queue_destroy(UIUploadQueue* queue) {
+  if (!queue) return;
+
+  UIAllocator allocator = queue->allocator;
+  ui_mem_free(&allocator, queue);
+}
@@ -2,7 +2,11 @@
 #include "ui_styles.h"
 #include <stdio.h>
 #include <ui_widgets.h>
-#include <GL/glew.h>
+#include <ui_draw.h>
+#include <ui_profile.h>
+#include <ui_hit.h>
+#include <ui_input.h>
+#include <math.h>
 
 static ui_id hash_string(const char* str) {
   ui_id hash = 5381;
@@ -13,24 +17,89 @@ static ui_id hash_string(const char* str) {
   return hash;
 }
 
+/*
+ * Count the widget and tell whether anything of `extent` (the area the widget
+ * draws into) survives the current clip. Culled widgets still handle input.
+ */
+static bool widget_visible(UIContext* ctx, rect extent) {
+  rect clip = ui_current_clip(ctx);
+  bool visible = extent.pos.x < clip.pos.x + clip.size.x &&
+                 extent.pos.y < clip.pos.y + clip.size.y &&
+                 extent.pos.x + extent.size.x > clip.pos.x &&
+                 extent.pos.y + extent.size.y > clip.pos.y;
+
+  UI_STAT_ADD(ctx, widgets_processed, 1);
+  if (!visible) UI_STAT_ADD(ctx, widgets_culled, 1);
+  return visible;
+}
+
+ui_id ui_get_id(const char* str) {
+  return hash_string(str);
+}
+
+bool ui_widget_visible(UIContext* ctx, rect extent) {
+  return widget_visible(ctx, extent);
+}
+
+static rect expand_rect(rect r, float amount) {
+  return (rect){{r.pos.x - amount, r.pos.y - amount}, {r.size.x + amount * 2, r.size.y + amount * 2}};
+}
+
+// Area a centered label can cover, text wider than its bounds overflows both sides.
+// Takes the width draw_label is given, so culling costs no second measurement
+static rect label_extent(UIContext* ctx, float text_width, rect bounds) {
+  float overflow = (text_width - bounds.size.x) * 0.5f;
+  if (overflow < 0.0f) overflow = 0.0f;
+  return (rect){
+    {bounds.pos.x - overflow, bounds.pos.y - ctx->font_size},
+    {bounds.size.x + overflow * 2.0f, bounds.size.y + ctx->font_size * 2.0f}
+  };
+}
+
+static rect union_rect(rect a, rect b) {
+  float x0 = fminf(a.pos.x, b.pos.x), y0 = fminf(a.pos.y, b.pos.y);
+  float x1 = fmaxf(a.pos.x + a.size.x, b.pos.x + b.size.x);
+  float y1 = fmaxf(a.pos.y + a.size.y, b.pos.y + b.size.y);
+  return (rect){{x0, y0}, {x1 - x0, y1 - y0}};
+}
+
+static void draw_label(UIContext* ctx, const char* text, float text_width, rect bounds,
+  color text_color) {
+  // Center text horizontally and vertically
+  // For vertical: position baseline at center, then adjust for typical ascent
+  vec2 text_pos = {
+    bounds.pos.x + (bounds.size.x - text_width) * 0.5f,
+    bounds.pos.y + bounds.size.y * 0.5f + 4.0f  // Center baseline with offset
+  };
+  ui_draw_text(ctx, text, text_pos, text_color);
+}
+
+static vec2 button_size(UIContext* ctx, float text_width) {
+  float padding = 10;
+  return (vec2){text_width + padding * 2, ctx->font_size + padding * 2};
+}
+
+vec2 ui_button_size(UIContext* ctx, const char* label) {
+  return button_size(ctx, ui_measure_text(ctx, label));
+}
+
 bool ui_button(UIContext* ctx, const char* label, rect bounds) {
+  UI_PROFILE_BEGIN(ctx, "ui_button");
   ui_id id = hash_string(label);
+  float text_width = ui_measure_text(ctx, label);
 
   /*
    * If the rect bounds is (0, 0), we count the size for the label's length
    * and measure the size based of that.
    */ 
   if (bounds.size.x == 0 && bounds.size.y == 0) {
-    float text_width = ui_measure_text(ctx, label);
-    float padding = 10;
-
-    bounds.size.x = text_width + padding * 2;
-    bounds.size.y = ctx->font_size + padding * 2;
+    bounds.size = button_size(ctx, text_width);
   }
 
-  // Check interaction
-  bool hovered = ui_is_hovered(ctx, bounds);
-  bool clicked = ui_is_clicked(ctx, bounds, 0);
+  // Check interaction, only when nothing recorded later covered the button
+  ui_hit_add(ctx, id, bounds);
+  bool hovered = ui_widget_hovered(ctx, id, bounds);
+  bool clicked = ui_widget_click_count(ctx, id, bounds, 0) > 0;
   
   // Visual state
   color bg_color = {0.2f, 0.2f, 0.2f, 1.0f};
@@ -39,6 +108,11 @@ bool ui_button(UIContext* ctx, const char* label, rect bounds) {
     bg_color.g += 0.1f;
     bg_color.b += 0.1f;
   }
+
+  if (!widget_visible(ctx, union_rect(expand_rect(bounds, 1), label_extent(ctx, text_width, bounds)))) {
+    UI_PROFILE_END(ctx);
+    return clicked;
+  }
   
   // Draw border first (background)
   rect border = {
@@ -54,48 +128,44 @@ bool ui_button(UIContext* ctx, const char* label, rect bounds) {
   
   // Draw label (simplified - would use actual text rendering)
   color text_color = {1.0f, 1.0f, 1.0f, 1.0f};
-  ui_label(ctx, label, bounds, text_color);
+  draw_label(ctx, label, text_width, bounds, text_color);
   
+  UI_PROFILE_END(ctx);
   return clicked;
 }
 
 void ui_label(UIContext* ctx, const char* text, rect bounds, color text_color) {
-  // Measure text width
+  UI_PROFILE_BEGIN(ctx, "ui_label");
   float text_width = ui_measure_text(ctx, text);
-  
-  // Center text horizontally and vertically
-  // For vertical: position baseline at center, then adjust for typical ascent
-  vec2 text_pos = {
-    bounds.pos.x + (bounds.size.x - text_width) * 0.5f,
-    bounds.pos.y + bounds.size.y * 0.5f + 4.0f  // Center baseline with offset
-  };
-  ui_draw_text(ctx, text, text_pos, text_color);
+  if (widget_visible(ctx, label_extent(ctx, text_width, bounds))) {
+    draw_label(ctx, text, text_width, bounds, text_color);
+  }
+  UI_PROFILE_END(ctx);
 }
 
 void ui_label_with_style(UIContext* ctx, const char* text, rect bounds, TextStyle style) {
-  // Measure text width
+  UI_PROFILE_BEGIN(ctx, "ui_label");
   float text_width = ui_measure_text(ctx, text);
-  
-  // Center text horizontally and vertically
-  // For vertical: position baseline at center, then adjust for typical ascent
-  vec2 text_pos = {
-    bounds.pos.x + (bounds.size.x - text_width) * 0.5f,
-    bounds.pos.y + bounds.size.y * 0.5f + 4.0f  // Center baseline with offset
-  };
-  ui_draw_text(ctx, text, text_pos, style.color);
+  if (widget_visible(ctx, label_extent(ctx, text_width, bounds))) {
+    draw_label(ctx, text, text_width, bounds, style.color);
+  }
+  UI_PROFILE_END(ctx);
 }
 
 bool ui_slider_float(UIContext* ctx, const char* id, rect bounds, float* value, float min_val, float max_val) {
+  UI_PROFILE_BEGIN(ctx, "ui_slider_float");
   ui_id widget_id = hash_string(id);
   bool value_changed = false;
   
   // Track state
-  if (ui_is_hovered(ctx, bounds)) {
+  ui_hit_add(ctx, widget_id, bounds);
+  if (ui_widget_hovered(ctx, widget_id, bounds)) {
     ctx->hot_widget = widget_id;
   }
   
   // Handle dragging
-  if (ctx->active_widget == widget_id || (ctx->hot_widget == widget_id && ui_is_clicked(ctx, bounds, 0))) {
+  if (ctx->active_widget == widget_id ||
+      (ctx->hot_widget == widget_id && ui_widget_click_count(ctx, widget_id, bounds, 0) > 0)) {
     if (!ctx->active_widget) {
       ctx->active_widget = widget_id;
     }
@@ -114,6 +184,12 @@ bool ui_slider_float(UIContext* ctx, const char* id, rect bounds, float* value,
   if (!ctx->mouse_buttons[0]) {
     ctx->active_widget = 0;
   }
+
+  // The thumb sticks out 5 pixels past either end of the track
+  if (!widget_visible(ctx, (rect){{bounds.pos.x - 5.0f, bounds.pos.y}, {bounds.size.x + 10.0f, bounds.size.y}})) {
+    UI_PROFILE_END(ctx);
+    return value_changed;
+  }
   
   // Draw slider track
   color track_color = {0.3f, 0.3f, 0.3f, 1.0f};
@@ -133,18 +209,21 @@ bool ui_slider_float(UIContext* ctx, const char* id, rect bounds, float* value,
 
   ui_draw_rect(ctx, thumb, thumb_color);
   
+  UI_PROFILE_END(ctx);
   return value_changed;
 }
 
 bool ui_checkbox(UIContext* ctx, const char* label, rect bounds, bool* checked) {
+  UI_PROFILE_BEGIN(ctx, "ui_checkbox");
   ui_id id = hash_string(label);
   bool value_changed = false;
   
   // Check interaction
-  bool hovered = ui_is_hovered(ctx, bounds);
-  bool clicked = ui_is_clicked(ctx, bounds, 0);
+  ui_hit_add(ctx, id, bounds);
+  bool hovered = ui_widget_hovered(ctx, id, bounds);
   
-  if (clicked) {
+  // Every click toggles, a slow frame may carry several
+  if (ui_widget_click_count(ctx, id, bounds, 0) % 2) {
     *checked = !(*checked);
     value_changed = true;
   }
@@ -158,6 +237,18 @@ bool ui_checkbox(UIContext* ctx, const char* label, rect bounds, bool* checked)
     {bounds.pos.x, bounds.pos.y + (bounds.size.y - box_size) * 0.5f},
     {box_size, box_size}
   };
+
+  rect label_bounds = {
+    {bounds.pos.x + box_size + 5.0f, bounds.pos.y},
+    {bounds.size.x - box_size - 5.0f, bounds.size.y}
+  };
+
+  float text_width = ui_measure_text(ctx, label);
+  if (!widget_visible(ctx, union_rect(expand_rect(checkbox_box, 1),
+        label_extent(ctx, text_width, label_bounds)))) {
+    UI_PROFILE_END(ctx);
+    return value_changed;
+  }
   
   // Draw border first
   rect border = {
@@ -188,52 +279,53 @@ bool ui_checkbox(UIContext* ctx, const char* label, rect bounds, bool* checked)
   }
   
   // Draw label
-  rect label_bounds = {
-    {bounds.pos.x + box_size + 5.0f, bounds.pos.y},
-    {bounds.size.x - box_size - 5.0f, bounds.size.y}
-  };
   color text_color = {1.0f, 1.0f, 1.0f, 1.0f};
-  ui_label(ctx, label, label_bounds, text_color);
+  draw_label(ctx, label, text_width, label_bounds, text_color);
   
+  UI_PROFILE_END(ctx);
   return value_changed;
 }
 
 bool ui_text_input(UIContext* ctx, const char* id, rect bounds, char* buffer, size_t buffer_size) {
+  UI_PROFILE_BEGIN(ctx, "ui_text_input");
   ui_id widget_id = hash_string(id);
   bool value_changed = false;
   
   // Check interaction
-  bool hovered = ui_is_hovered(ctx, bounds);
-  bool clicked = ui_is_clicked(ctx, bounds, 0);
+  ui_hit_add(ctx, widget_id, bounds);
+  bool hovered = ui_widget_hovered(ctx, widget_id, bounds);
 
-  // Handle focus
-  if (clicked) {
-    ctx->focused_widget = widget_id;
-  }
-  
-  bool is_focused = (ctx->focused_widget == widget_id);
-  
-  // Process keyboard input if focused
-  if (is_focused) {
-    size_t len = 0;
-    while (buffer[len] != '\0') len++;
-    
-    // Handle backspace
-    if (ctx->key_backspace && len > 0) {
-      buffer[len - 1] = '\0';
-      value_changed = true;
-    }
-    
-    // Handle character input
-    for (int i = 0; i < ctx->input_char_count; i++) {
+  // Typing belongs to this widget between a press on it and a press elsewhere
+  size_t len = 0;
+  while (buffer[len] != '\0') len++;
+  bool focused = ui_widget_focus_begin(ctx, widget_id);
+
+  for (int i = 0; i < ctx->event_count; i++) {
+    const UIInputEvent* event = &ctx->events[i];
+    focused = ui_widget_focus_event(ctx, widget_id, bounds, i, focused);
+    if (!focused) continue;
+
+    if (event->type == UI_EVENT_KEY && event->pressed && event->key == UI_KEY_BACKSPACE) {
+      if (len > 0) {
+        buffer[--len] = '\0';
+        value_changed = true;
+      }
+    } else if (event->type == UI_EVENT_CHAR && event->codepoint >= 32 && event->codepoint < 128) {
       if (len < buffer_size - 1) {
-        buffer[len++] = ctx->input_chars[i];
+        buffer[len++] = (char)event->codepoint;
         buffer[len] = '\0';
         value_changed = true;
       }
     }
   }
+
+  bool is_focused = (ctx->focused_widget == widget_id);
   
+  if (!widget_visible(ctx, expand_rect(bounds, 1))) {
+    UI_PROFILE_END(ctx);
+    return value_changed;
+  }
+
   // Draw border first
   rect border = {
     {bounds.pos.x - 1, bounds.pos.y - 1},
@@ -271,12 +363,11 @@ bool ui_text_input(UIContext* ctx, const char* id, rect bounds, char* buffer, si
     text_offset = available_width - text_width;
   }
   
-  // Enable scissor test to clip text to bounds
-  glEnable(GL_SCISSOR_TEST);
-  glScissor((int)(bounds.pos.x + 5.0f), 
-            (int)(ctx->height - (bounds.pos.y + bounds.size.y)), 
-            (int)(bounds.size.x - 10.0f), 
-            (int)bounds.size.y);
+  // Clip text to bounds
+  ui_push_clip(ctx, (rect){
+    {bounds.pos.x + 5.0f, bounds.pos.y},
+    {bounds.size.x - 10.0f, bounds.size.y}
+  });
   
   // Draw text content with scroll offset
   vec2 text_pos = {
@@ -301,23 +392,20 @@ bool ui_text_input(UIContext* ctx, const char* id, rect bounds, char* buffer, si
     }
   }
   
-  // Disable scissor test
-  glDisable(GL_SCISSOR_TEST);
+  ui_pop_clip(ctx);
   
+  UI_PROFILE_END(ctx);
   return value_changed;
 }
 
 void ui_panel_begin(UIContext *ctx, const char *id, rect bounds, color bg_color) {
-  static bool is_printed = false;
-
-  if (!is_printed) {
-    is_printed = true;
-  }
-  
   // Push layout offset for child widgets
   vec2 panel_offset = {bounds.pos.x, bounds.pos.y};
   ui_push_layout(ctx, panel_offset);
 
+  // The panel takes the clicks its children don't, nothing under it sees them
+  ui_hit_add(ctx, hash_string(id), bounds);
+
   // Draw panel background
   ui_draw_rect(ctx, bounds, bg_color);
 }
@@ -0,0 +1,99 @@
+/*
+ * Tridme UI Editor Check
+ *
+ * Types into a headless text editor through the input queue, the way a
+ * host does: ASCII and multi-byte characters, then Left, Backspace and
+ * Delete around them, and checks the buffer after every step. The buffer
+ * must stay valid UTF-8 with exactly the characters typed and not deleted.
+ *
+ * Usage:
+ *   tridme-ui-editor-check
+ *
+ * Exits with 0 when every step left the expected text.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_core.h>
+#include <ui_editor.h>
+#include <ui_font.h>
+#include <ui_input.h>
+#include <stdio.h>
+#include <string.h>
+
+static const rect editor_bounds = {{10, 10}, {300, 100}};
+
+static void run_frame(UIContext* ctx, UITextEditor* editor) {
+  ui_begin_frame(ctx, 1.0f / 60.0f);
+  ui_text_editor(ctx, "editor", editor_bounds, editor);
+  ui_end_frame(ctx);
+}
+
+static void press_key(UIContext* ctx, int key) {
+  ui_set_key(ctx, key, true);
+  ui_set_key(ctx, key, false);
+}
+
+// Compare the buffer with the expected text, reporting the step on a mismatch
+static bool expect(UITextEditor* editor, const char* step, const char* expected) {
+  char text[256];
+  size_t length = ui_editor_copy(editor, 0, text, sizeof(text) - 1);
+  text[length] = '\0';
+  if (strcmp(text, expected) == 0) return true;
+  fprintf(stderr, "After %s: got \"%s\", expected \"%s\"\n", step, text, expected);
+  return false;
+}
+
+int main(void) {
+  UIContextDesc desc = {.width = 400, .height = 300, .headless = true};
+  UIContext* ctx = ui_create_context_ex(&desc);
+  UITextEditor* editor = ctx ? ui_editor_create(NULL) : NULL;
+  if (!editor) {
+    fprintf(stderr, "Failed to set up the editor check\n");
+    return 1;
+  }
+  ui_font_wait(ctx->font);
+  run_frame(ctx, editor);
+
+  // Focus the empty editor
+  ui_set_mouse_position(ctx, editor_bounds.pos.x + 20, editor_bounds.pos.y + 20);
+  ui_set_mouse_button(ctx, 0, true);
+  ui_set_mouse_button(ctx, 0, false);
+  run_frame(ctx, editor);
+
+  // a, e acute (2 bytes), euro sign (3 bytes), grinning face (4 bytes), b
+  const unsigned int typed[] = {'a', 0xE9, 0x20AC, 0x1F600, 'b'};
+  for (size_t i = 0; i < sizeof(typed) / sizeof(typed[0]); i++) ui_input_char(ctx, typed[i]);
+  run_frame(ctx, editor);
+  bool ok = expect(editor, "typing", "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80" "b");
+
+  // Before b, Backspace removes the whole 4-byte character
+  press_key(ctx, UI_KEY_LEFT);
+  press_key(ctx, UI_KEY_BACKSPACE);
+  run_frame(ctx, editor);
+  ok &= expect(editor, "Left, Backspace", "a\xC3\xA9\xE2\x82\xAC" "b");
+
+  // Before the euro sign, Delete removes it whole
+  press_key(ctx, UI_KEY_LEFT);
+  press_key(ctx, UI_KEY_DELETE);
+  run_frame(ctx, editor);
+  ok &= expect(editor, "Left, Delete", "a\xC3\xA9" "b");
+
+  // Typing between multi-byte characters, surrogates and DEL are ignored
+  press_key(ctx, UI_KEY_LEFT);
+  ui_input_char(ctx, 0x3B1);
+  ui_input_char(ctx, 0xD800);
+  ui_input_char(ctx, 127);
+  run_frame(ctx, editor);
+  ok &= expect(editor, "typing in the middle", "a\xCE\xB1\xC3\xA9" "b");
+
+  press_key(ctx, UI_KEY_BACKSPACE);
+  press_key(ctx, UI_KEY_BACKSPACE);
+  run_frame(ctx, editor);
+  ok &= expect(editor, "Backspace twice", "\xC3\xA9" "b");
+
+  printf("Editor check: %s\n", ok ? "ok" : "FAILED");
+  ui_editor_destroy(editor);
+  ui_destroy_context(ctx);
+  return ok ? 0 : 1;
+}
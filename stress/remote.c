@@ -0,0 +1,201 @@
+/*
+ * Tridme UI Remote Stress
+ *
+ * Ring stress test for the remote backend. The engine and the tool side run
+ * in one process on a small ring: the tool sends thousands of frames where
+ * only the vertices change (the indices are reused), then thousands where
+ * only the indices change, with a texture edit every few frames, and the
+ * engine applies each one right away.
+ *
+ * An array the engine keeps reusing must not hold the ring's tail: every
+ * frame has to arrive, and the bytes sent have to be many times the ring's
+ * size. Were the tail held, frames would be dropped for a full ring and the
+ * next texture edit would wait for room forever.
+ *
+ * Then the engine resets with a frame reusing arrays still in flight: that
+ * frame is skipped, and once the tool sends its texture and a whole frame
+ * again the engine must draw the same pixels as before the reset.
+ *
+ * Usage:
+ *   tridme-ui-remote-stress [--frames n] [--vertices n]
+ *
+ * Exits with 0 when every frame arrived.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_remote.h>
+#include <ui_backend.h>
+#include <ui_backend_soft.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define REMOTE_STRESS_RING    (1 << 20)
+#define REMOTE_STRESS_WIDTH   256
+#define REMOTE_STRESS_HEIGHT  256
+#define REMOTE_STRESS_TEXTURE 64
+#define REMOTE_STRESS_PIXELS  (REMOTE_STRESS_WIDTH * REMOTE_STRESS_HEIGHT * 4)
+
+// Draw the engine's latest frame on a cleared target and copy the pixels out
+static void render_pixels(UIRemoteServer* server, UIRenderBackend* soft, unsigned char* out) {
+  ui_backend_soft_clear(soft, (color){0, 0, 0, 1});
+  ui_remote_server_render(server);
+  memcpy(out, ui_backend_soft_pixels(soft, NULL, NULL), REMOTE_STRESS_PIXELS);
+}
+
+// Quads in a grid; odd steps move them by a pixel so the vertices differ
+static void fill_vertices(ui_vertex* vertices, uint32_t quads, int step) {
+  float offset = (float)(step & 1);
+  for (uint32_t q = 0; q < quads; q++) {
+    float x = (float)(q % 64) * 4 + offset, y = (float)(q / 64 % 64) * 4;
+    for (int v = 0; v < 4; v++) {
+      ui_vertex* out = &vertices[q * 4 + v];
+      out->position = (vec2){x + (v & 1 ? 3 : 0), y + (v & 2 ? 3 : 0)};
+      out->texcoord = (vec2){v & 1 ? 1.0f : 0.0f, v & 2 ? 1.0f : 0.0f};
+      out->col = (color){1, 1, 1, 1};
+      out->slot = 0;
+    }
+  }
+}
+
+// Two triangles per quad; odd steps split the quads along the other diagonal
+static void fill_indices(uint32_t* indices, uint32_t quads, int step) {
+  static const uint32_t split[2][6] = {{0, 1, 2, 2, 1, 3}, {0, 1, 3, 0, 3, 2}};
+  for (uint32_t q = 0; q < quads; q++) {
+    for (int i = 0; i < 6; i++) indices[q * 6 + i] = q * 4 + split[step & 1][i];
+  }
+}
+
+int main(int argc, char** argv) {
+  int frames = 4000;
+  int quads = 512;
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(argv[i], "--frames") == 0 && value) {
+      frames = atoi(value);
+      i++;
+    } else if (strcmp(argv[i], "--vertices") == 0 && value) {
+      quads = atoi(value) / 4;
+      i++;
+    } else {
+      fprintf(stderr, "Usage: tridme-ui-remote-stress [--frames n] [--vertices n]\n");
+      return 1;
+    }
+  }
+  if (frames <= 0 || quads <= 0) {
+    fprintf(stderr, "Frames and vertices must be positive\n");
+    return 1;
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "/tridme-ui-remote-stress-%d", (int)getpid());
+
+  UIRenderBackend* soft = ui_backend_soft_create(REMOTE_STRESS_WIDTH, REMOTE_STRESS_HEIGHT, NULL, NULL);
+  UIRemoteDesc desc = {.ring_size = REMOTE_STRESS_RING};
+  UIRemoteServer* server = soft ? ui_remote_server_create(name, soft, &desc) : NULL;
+  UIRenderBackend* tool = server ? ui_backend_remote_create(name, NULL) : NULL;
+  ui_vertex* vertices = (ui_vertex*)malloc(sizeof(ui_vertex) * 4 * quads);
+  uint32_t* indices = (uint32_t*)malloc(sizeof(uint32_t) * 6 * quads);
+  unsigned char pixels[REMOTE_STRESS_TEXTURE * REMOTE_STRESS_TEXTURE];
+  if (!tool || !vertices || !indices) {
+    fprintf(stderr, "Failed to set up the remote stress test\n");
+    return 1;
+  }
+
+  ui_texture_id texture = tool->create_texture(tool->user, REMOTE_STRESS_TEXTURE,
+    REMOTE_STRESS_TEXTURE, UI_TEXTURE_A8, NULL);
+  UIDrawCmd cmd = {
+    .clip = {{0, 0}, {REMOTE_STRESS_WIDTH, REMOTE_STRESS_HEIGHT}},
+    .textures = {texture},
+    .texture_count = 1,
+    .index_offset = 0,
+    .index_count = (uint32_t)quads * 6
+  };
+
+  // First half: only the vertices change, then only the indices
+  int arrived = 0;
+  for (int frame = 0; frame < frames; frame++) {
+    bool vertex_phase = frame < frames / 2;
+    fill_vertices(vertices, (uint32_t)quads, vertex_phase ? frame : 0);
+    fill_indices(indices, (uint32_t)quads, vertex_phase ? 0 : frame);
+
+    if (frame % 16 == 0) {
+      memset(pixels, frame & 0xff, sizeof(pixels));
+      tool->update_texture(tool->user, texture, UI_TEXTURE_A8, 0, 0, REMOTE_STRESS_TEXTURE,
+        REMOTE_STRESS_TEXTURE, pixels, REMOTE_STRESS_TEXTURE);
+    }
+
+    UIDrawData data = {
+      .display_size = {REMOTE_STRESS_WIDTH, REMOTE_STRESS_HEIGHT},
+      .vertices = vertices,
+      .vertex_count = (uint32_t)quads * 4,
+      .indices = indices,
+      .index_count = (uint32_t)quads * 6,
+      .commands = &cmd,
+      .command_count = 1,
+      .frame = (uint64_t)frame
+    };
+    tool->render(tool->user, &data);
+
+    if (ui_remote_server_update(server)) {
+      arrived++;
+      ui_remote_server_render(server);
+    } else {
+      fprintf(stderr, "Frame %d (%s changed) did not arrive\n", frame,
+        vertex_phase ? "vertices" : "indices");
+      break;
+    }
+  }
+
+  UIBackendCounters counters = {0};
+  tool->get_counters(tool->user, &counters);
+  double rings = (double)counters.bytes_uploaded / REMOTE_STRESS_RING;
+  bool ok = arrived == frames;
+  printf("%d of %d frames arrived, %.1f rings of messages: %s\n", arrived, frames, rings,
+    ok ? "ok" : "FAILED");
+
+  // Reset: a frame before, one reusing its indices in flight, then the same frame again
+  static unsigned char before[REMOTE_STRESS_PIXELS], after[REMOTE_STRESS_PIXELS];
+  UIDrawData data = {
+    .display_size = {REMOTE_STRESS_WIDTH, REMOTE_STRESS_HEIGHT},
+    .vertices = vertices,
+    .vertex_count = (uint32_t)quads * 4,
+    .indices = indices,
+    .index_count = (uint32_t)quads * 6,
+    .commands = &cmd,
+    .command_count = 1
+  };
+  memset(pixels, 200, sizeof(pixels));
+  tool->update_texture(tool->user, texture, UI_TEXTURE_A8, 0, 0, REMOTE_STRESS_TEXTURE,
+    REMOTE_STRESS_TEXTURE, pixels, REMOTE_STRESS_TEXTURE);
+  fill_vertices(vertices, (uint32_t)quads, 0);
+  fill_indices(indices, (uint32_t)quads, 0);
+  tool->render(tool->user, &data);
+  bool reset_ok = ui_remote_server_update(server);
+  render_pixels(server, soft, before);
+
+  fill_vertices(vertices, (uint32_t)quads, 1);
+  data.frame++;
+  tool->render(tool->user, &data);
+  ui_remote_server_reset(server);
+  reset_ok = reset_ok && !ui_remote_server_update(server);
+
+  fill_vertices(vertices, (uint32_t)quads, 0);
+  data.frame++;
+  tool->render(tool->user, &data);
+  reset_ok = reset_ok && ui_remote_server_update(server);
+  render_pixels(server, soft, after);
+  reset_ok = reset_ok && memcmp(before, after, REMOTE_STRESS_PIXELS) == 0;
+  printf("Engine reset: %s\n", reset_ok ? "ok" : "FAILED");
+  ok = ok && reset_ok;
+
+  tool->destroy_texture(tool->user, texture);
+  tool->destroy(tool);
+  ui_remote_server_destroy(server);
+  soft->destroy(soft);
+  free(vertices);
+  free(indices);
+  return ok ? 0 : 1;
+}
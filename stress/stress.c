@@ -0,0 +1,331 @@
+/*
+ * Tridme UI Stress
+ *
+ * Threading stress test. Runs the same scripted frames on N contexts at
+ * once, each on its own thread with its own software backend, all sharing
+ * one UIFont, and checks every frame's UIDrawData byte for byte against a
+ * single-threaded run of the same script, and the final pixels too.
+ *
+ * Texture ids are backend handles, different in every context, so they are
+ * compared by order of first use instead of by value.
+ *
+ * Usage:
+ *   tridme-ui-stress [--threads n] [--frames n] [--rounds n]
+ *
+ * Exits with 0 when every context matched the reference on every frame.
+ *
+ * (C) Kincir Angin Studio
+ */
+
+#include <ui_core.h>
+#include <ui_widgets.h>
+#include <ui_layout.h>
+#include <ui_draw.h>
+#include <ui_font.h>
+#include <ui_region.h>
+#include <ui_backend.h>
+#include <ui_backend_soft.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRESS_WIDTH  640
+#define STRESS_HEIGHT 480
+#define STRESS_MAX_TEXTURES 64
+
+/*
+ * Script. Like the bench scenes, a pure function of the frame number.
+ */
+
+typedef struct {
+  char text[4][64];
+  bool checks[8];
+  float sliders[8];
+} stress_state;
+
+static void script_input(UIContext* ctx, int frame) {
+  ui_set_mouse_position(ctx, (float)((frame * 37) % ctx->width), (float)((frame * 23) % ctx->height));
+  ui_set_mouse_button(ctx, 0, frame % 8 == 0);
+  if (frame % 3 == 0) ui_input_char(ctx, 'a' + frame % 26);
+  if (frame % 29 == 0) ui_set_scroll(ctx, (frame % 2) ? 1.0f : -1.0f);
+}
+
+static void script_frame(UIContext* ctx, stress_state* state, int frame) {
+  char id[32], label[32];
+
+  // Fixed widgets in a vbox: labels, checkboxes, sliders and text fields
+  VBoxConfig column = {.spacing = 4, .padding_top = 4, .padding_left = 4, .padding_right = 4,
+                       .clip_overflow = true};
+  ui_vbox_begin_ex(ctx, "column", (rect){{0, 0}, {220, (float)ctx->height}}, &column);
+  for (int i = 0; i < 8; i++) {
+    snprintf(label, sizeof(label), "Row %d at %d", i, frame);
+    ui_label(ctx, label, ui_vbox_next(ctx, "column", 20), (color){1, 1, 1, 1});
+    snprintf(label, sizeof(label), "Check %d", i);
+    ui_checkbox(ctx, label, ui_vbox_next(ctx, "column", 20), &state->checks[i]);
+    snprintf(id, sizeof(id), "slider%d", i);
+    ui_slider_float(ctx, id, ui_vbox_next(ctx, "column", 20), &state->sliders[i], 0, 1);
+    if (i < 4) {
+      snprintf(id, sizeof(id), "field%d", i);
+      ui_text_input(ctx, id, ui_vbox_next(ctx, "column", 24), state->text[i], sizeof(state->text[i]));
+    }
+  }
+  ui_vbox_end(ctx, "column");
+
+  // Flex rows of auto-sized buttons whose labels change length
+  UILayoutDesc grid = {.direction = UI_LAYOUT_GRID, .columns = 3, .gap = 4, .padding = 4};
+  ui_layout_begin(ctx, "grid", (rect){{224, 0}, {(float)ctx->width - 224, 240}}, &grid);
+  for (int i = 0; i < 12; i++) {
+    snprintf(id, sizeof(id), "button%d", i);
+    snprintf(label, sizeof(label), (frame / 16 + i) % 3 ? "B%d" : "Button %d", i);
+    ui_button(ctx, label, ui_layout_item(ctx, id, &(UILayoutItem){.text = label, .grow = 1}));
+  }
+  ui_layout_end(ctx);
+
+  // A region recorded on the same thread, merged back in ui_end_frame
+  UIContext* region = ui_region_begin(ctx, (rect){{224, 240}, {(float)ctx->width - 224, 240}});
+  if (region) {
+    for (int i = 0; i < 40; i++) {
+      snprintf(label, sizeof(label), "Region line %d", (i + frame) % 97);
+      ui_draw_text(region, label, (vec2){232.0f + (i % 2) * 200, 256.0f + (i / 2) * 11},
+        (color){0.8f, 0.9f, 1.0f, 1.0f});
+    }
+    ui_region_end(region);
+  }
+}
+
+/*
+ * Frame capture
+ */
+
+typedef struct {
+  unsigned char* data;
+  size_t size, capacity;
+  ui_texture_id textures[STRESS_MAX_TEXTURES]; // Seen so far, in order of first use
+  int texture_count;
+} capture;
+
+static bool capture_bytes(capture* c, const void* bytes, size_t size) {
+  if (c->size + size > c->capacity) {
+    size_t capacity = c->capacity ? c->capacity : 4096;
+    while (capacity < c->size + size) capacity *= 2;
+    unsigned char* data = (unsigned char*)realloc(c->data, capacity);
+    if (!data) return false;
+    c->data = data;
+    c->capacity = capacity;
+  }
+  memcpy(c->data + c->size, bytes, size);
+  c->size += size;
+  return true;
+}
+
+static uint32_t texture_ordinal(capture* c, ui_texture_id texture) {
+  for (int i = 0; i < c->texture_count; i++) {
+    if (c->textures[i] == texture) return (uint32_t)i;
+  }
+  if (c->texture_count == STRESS_MAX_TEXTURES) return UINT32_MAX;
+  c->textures[c->texture_count] = texture;
+  return (uint32_t)c->texture_count++;
+}
+
+// Serialize a frame field by field, struct padding is not part of the output
+static bool capture_frame(capture* c, const UIDrawData* data) {
+  c->size = 0;
+  bool ok = capture_bytes(c, &data->display_size, sizeof(vec2)) &&
+            capture_bytes(c, &data->frame, sizeof(data->frame)) &&
+            capture_bytes(c, &data->vertex_count, sizeof(uint32_t)) &&
+            capture_bytes(c, data->vertices, sizeof(ui_vertex) * data->vertex_count) &&
+            capture_bytes(c, &data->index_count, sizeof(uint32_t)) &&
+            capture_bytes(c, data->indices, sizeof(uint32_t) * data->index_count) &&
+            capture_bytes(c, &data->command_count, sizeof(int));
+
+  for (int i = 0; ok && i < data->command_count; i++) {
+    const UIDrawCmd* cmd = &data->commands[i];
+    ok = capture_bytes(c, &cmd->clip, sizeof(rect)) &&
+         capture_bytes(c, &cmd->texture_count, sizeof(int)) &&
+         capture_bytes(c, &cmd->index_offset, sizeof(uint32_t)) &&
+         capture_bytes(c, &cmd->index_count, sizeof(uint32_t));
+    for (int t = 0; ok && t < cmd->texture_count; t++) {
+      uint32_t ordinal = texture_ordinal(c, cmd->textures[t]);
+      ok = capture_bytes(c, &ordinal, sizeof(uint32_t));
+    }
+  }
+  return ok;
+}
+
+/*
+ * Runs
+ */
+
+typedef struct {
+  const UIFont* font;
+  int frames;
+  unsigned char** frames_out;   // Reference run: a copy of every frame, NULL otherwise
+  size_t* sizes_out;
+  unsigned char* const* expected; // Checked runs: the reference frames
+  const size_t* expected_sizes;
+  unsigned char* pixels;        // Final frame, STRESS_WIDTH * STRESS_HEIGHT * 4
+  int first_mismatch;           // Frame, -1: none
+  bool ok;
+} stress_run;
+
+static void* run_script(void* arg) {
+  stress_run* run = (stress_run*)arg;
+  run->first_mismatch = -1;
+  run->ok = false;
+
+  UIRenderBackend* backend = ui_backend_soft_create(STRESS_WIDTH, STRESS_HEIGHT, NULL, NULL);
+  if (!backend) return NULL;
+  UIContextDesc desc = {
+    .width = STRESS_WIDTH,
+    .height = STRESS_HEIGHT,
+    .font = run->font,
+    .backend = backend
+  };
+  UIContext* ctx = ui_create_context_ex(&desc);
+  if (!ctx) {
+    backend->destroy(backend);
+    return NULL;
+  }
+
+  stress_state* state = (stress_state*)calloc(1, sizeof(stress_state));
+  capture frame_capture = {0};
+  bool ok = state != NULL;
+
+  for (int frame = 0; ok && frame < run->frames; frame++) {
+    ui_backend_soft_clear(backend, (color){0.1f, 0.1f, 0.1f, 1.0f});
+    script_input(ctx, frame);
+    ui_begin_frame(ctx, 1.0f / 60.0f);
+    script_frame(ctx, state, frame);
+    ui_end_frame(ctx);
+
+    UIDrawData data = ui_get_draw_data(ctx);
+    if (!capture_frame(&frame_capture, &data)) {
+      fprintf(stderr, "Out of memory capturing frame %d\n", frame);
+      ok = false;
+      break;
+    }
+
+    if (run->frames_out) {
+      run->frames_out[frame] = (unsigned char*)malloc(frame_capture.size ? frame_capture.size : 1);
+      if (!run->frames_out[frame]) {
+        ok = false;
+        break;
+      }
+      memcpy(run->frames_out[frame], frame_capture.data, frame_capture.size);
+      run->sizes_out[frame] = frame_capture.size;
+    } else if (run->first_mismatch < 0 &&
+               (frame_capture.size != run->expected_sizes[frame] ||
+                memcmp(frame_capture.data, run->expected[frame], frame_capture.size) != 0)) {
+      run->first_mismatch = frame;
+    }
+  }
+
+  if (ok) {
+    memcpy(run->pixels, ui_backend_soft_pixels(backend, NULL, NULL),
+      (size_t)STRESS_WIDTH * STRESS_HEIGHT * 4);
+  }
+  run->ok = ok;
+
+  free(frame_capture.data);
+  free(state);
+  ui_destroy_context(ctx);
+  backend->destroy(backend);
+  return NULL;
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: tridme-ui-stress [--threads n] [--frames n] [--rounds n]\n");
+}
+
+int main(int argc, char** argv) {
+  int threads = 8, frames = 240, rounds = 4;
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!value) {
+      usage();
+      return 1;
+    }
+    if (strcmp(argv[i], "--threads") == 0) threads = atoi(value);
+    else if (strcmp(argv[i], "--frames") == 0) frames = atoi(value);
+    else if (strcmp(argv[i], "--rounds") == 0) rounds = atoi(value);
+    else {
+      usage();
+      return 1;
+    }
+    i++;
+  }
+  if (threads < 1 || frames < 1 || rounds < 1) {
+    usage();
+    return 1;
+  }
+
+  UIFont* font = ui_font_create(NULL, 16.0f, NULL);
+  if (!font) return 1;
+
+  // Reference: the same script on this thread alone
+  size_t pixel_size = (size_t)STRESS_WIDTH * STRESS_HEIGHT * 4;
+  unsigned char** reference = (unsigned char**)calloc(frames, sizeof(unsigned char*));
+  size_t* reference_sizes = (size_t*)calloc(frames, sizeof(size_t));
+  stress_run* runs = (stress_run*)calloc(threads + 1, sizeof(stress_run));
+  pthread_t* ids = (pthread_t*)calloc(threads, sizeof(pthread_t));
+  bool ok = reference && reference_sizes && runs && ids;
+  for (int i = 0; ok && i <= threads; i++) {
+    runs[i].pixels = (unsigned char*)malloc(pixel_size);
+    ok = runs[i].pixels != NULL;
+  }
+
+  stress_run* base = ok ? &runs[threads] : NULL;
+  if (ok) {
+    base->font = font;
+    base->frames = frames;
+    base->frames_out = reference;
+    base->sizes_out = reference_sizes;
+    run_script(base);
+    ok = base->ok;
+  }
+
+  int failures = 0;
+  for (int round = 0; ok && round < rounds; round++) {
+    int started = 0;
+    for (int i = 0; i < threads; i++, started++) {
+      runs[i].font = font;
+      runs[i].frames = frames;
+      runs[i].expected = reference;
+      runs[i].expected_sizes = reference_sizes;
+      if (pthread_create(&ids[i], NULL, run_script, &runs[i]) != 0) {
+        fprintf(stderr, "Failed to start thread %d\n", i);
+        ok = false;
+        break;
+      }
+    }
+    for (int i = 0; i < started; i++) {
+      pthread_join(ids[i], NULL);
+      if (!runs[i].ok) {
+        fprintf(stderr, "Round %d, thread %d: run failed\n", round, i);
+        failures++;
+      } else if (runs[i].first_mismatch >= 0) {
+        fprintf(stderr, "Round %d, thread %d: draw data differs from frame %d\n", round, i,
+          runs[i].first_mismatch);
+        failures++;
+      } else if (memcmp(runs[i].pixels, base->pixels, pixel_size) != 0) {
+        fprintf(stderr, "Round %d, thread %d: final pixels differ\n", round, i);
+        failures++;
+      }
+    }
+  }
+
+  if (ok) {
+    printf("%d rounds of %d threads x %d frames: %s\n", rounds, threads, frames,
+      failures ? "MISMATCH" : "identical");
+  }
+
+  for (int i = 0; reference && i < frames; i++) free(reference[i]);
+  for (int i = 0; runs && i <= threads; i++) free(runs[i].pixels);
+  free(reference);
+  free(reference_sizes);
+  free(runs);
+  free(ids);
+  ui_font_destroy(font);
+  return ok && failures == 0 ? 0 : 1;
+}